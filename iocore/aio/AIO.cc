@@ -27,7 +27,13 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "I_Tasks.h"
+#endif
+
+#if AIO_MODE != AIO_MODE_THREAD
 #define AIO_PERIOD -HRTIME_MSECONDS(10)
 #else
 
@@ -46,7 +52,7 @@ volatile int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE != AIO_MODE_THREAD
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk = 12;
 
@@ -156,7 +162,7 @@ ink_aio_init(ModuleVersion v)
                      (int)AIO_STAT_KB_READ_PER_SEC, aio_stats_cb);
   RecRegisterRawStat(aio_rsb, RECT_PROCESS, "proxy.process.cache.KB_write_per_sec", RECD_FLOAT, RECP_PERSISTENT,
                      (int)AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex, NULL);
 #endif
@@ -173,25 +179,57 @@ ink_aio_start()
   return 0;
 }
 
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_IO_URING
+// Files registered with ink_aio_register_fd, each ring registers them lazily at the same index.
+static int aio_fixed_fd[MAX_AIO_FIXED_FILES];
+static volatile int aio_fixed_fd_count = 0;
+static ink_mutex aio_fixed_fd_mutex = INK_MUTEX_INIT;
+#endif
+
+void
+ink_aio_register_fd(int fd)
+{
+#if AIO_MODE == AIO_MODE_IO_URING
+  ink_mutex_acquire(&aio_fixed_fd_mutex);
+  int i = 0;
+  while (i < aio_fixed_fd_count && aio_fixed_fd[i] != fd)
+    ++i;
+  if (i == aio_fixed_fd_count && i < MAX_AIO_FIXED_FILES) {
+    aio_fixed_fd[i] = fd;
+    ink_atomic_increment(&aio_fixed_fd_count, 1);
+  }
+  ink_mutex_release(&aio_fixed_fd_mutex);
+#else
+  (void)fd;
+#endif
+}
+
+#if AIO_MODE == AIO_MODE_THREAD
 
 static void *aio_thread_main(void *arg);
 
 struct AIOThreadInfo : public Continuation {
   AIO_Reqs *req;
   int sleep_wait;
+  int numa_node;
 
   int
   start(int event, Event *e)
   {
     (void)event;
     (void)e;
+    if (numa_node >= 0) {
+      this_ethread()->numa_node = numa_node;
+      ink_numa_bind_thread(numa_node);
+      ink_freelist_set_thread_node(numa_node);
+    }
     aio_thread_main(this);
     delete this;
     return EVENT_DONE;
   }
 
-  AIOThreadInfo(AIO_Reqs *thr_req, int sleep) : Continuation(new_ProxyMutex()), req(thr_req), sleep_wait(sleep)
+  AIOThreadInfo(AIO_Reqs *thr_req, int sleep, int node)
+    : Continuation(new_ProxyMutex()), req(thr_req), sleep_wait(sleep), numa_node(node)
   {
     SET_HANDLER(&AIOThreadInfo::start);
   }
@@ -239,6 +277,9 @@ aio_init_fildes(int fildes, int fromAPI = 0)
     thread_num = cache_config_threads_per_disk;
   }
 
+  /* in NUMA mode serve the disk from the node nearest to its controller */
+  int numa_node = (thread_numa_nodes && !fromAPI) ? ink_numa_node_of_fd(fildes) : -1;
+
   /* create the main thread */
   AIOThreadInfo *thr_info;
   size_t stacksize;
@@ -246,9 +287,9 @@ aio_init_fildes(int fildes, int fromAPI = 0)
   REC_ReadConfigInteger(stacksize, "proxy.config.thread.default.stacksize");
   for (i = 0; i < thread_num; i++) {
     if (i == (thread_num - 1))
-      thr_info = new AIOThreadInfo(request, 1);
+      thr_info = new AIOThreadInfo(request, 1, numa_node);
     else
-      thr_info = new AIOThreadInfo(request, 0);
+      thr_info = new AIOThreadInfo(request, 0, numa_node);
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[ET_AIO %d:%d]", i, fildes);
     ink_assert(eventProcessor.spawn_thread(thr_info, thr_name, stacksize));
   }
@@ -512,7 +553,7 @@ aio_thread_main(void *arg)
   }
   return 0;
 }
-#else
+#elif AIO_MODE == AIO_MODE_NATIVE
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
 {
@@ -666,4 +707,285 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+#else // AIO_MODE == AIO_MODE_IO_URING
+
+static int
+aio_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+aio_uring_enter(int fd, unsigned to_submit)
+{
+  return syscall(__NR_io_uring_enter, fd, to_submit, 0, 0, NULL, 0);
+}
+
+static int
+aio_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+  return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+DiskHandler::DiskHandler() : trigger_event(0), ring_fd(-1), inflight(0), fixed_files(-1), failed(false)
+{
+  SET_HANDLER(&DiskHandler::startAIOEvent);
+
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  if ((ring_fd = aio_uring_setup(MAX_AIO_EVENTS, &p)) < 0)
+    Fatal("io_uring_setup failed: %s (%d)", strerror(errno), errno);
+
+  size_t sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  size_t cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    sq_len = cq_len = MAX(sq_len, cq_len);
+  char *sq = (char *)mmap(NULL, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  char *cq = sq;
+  if (!(p.features & IORING_FEAT_SINGLE_MMAP) && sq != MAP_FAILED)
+    cq = (char *)mmap(NULL, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+  sqes = (struct io_uring_sqe *)mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED)
+    Fatal("io_uring ring mmap failed: %s (%d)", strerror(errno), errno);
+
+  sq_head = (unsigned *)(sq + p.sq_off.head);
+  sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  sq_entries = (unsigned *)(sq + p.sq_off.ring_entries);
+  sq_array = (unsigned *)(sq + p.sq_off.array);
+  cq_head = (unsigned *)(cq + p.cq_off.head);
+  cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  cq_entries = p.cq_entries;
+  cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+  // Sparse file table, filled in from ink_aio_register_fd as files show up.
+  int files[MAX_AIO_FIXED_FILES];
+  for (int i = 0; i < MAX_AIO_FIXED_FILES; ++i)
+    files[i] = -1;
+  if (aio_uring_register(ring_fd, IORING_REGISTER_FILES, files, MAX_AIO_FIXED_FILES) == 0)
+    fixed_files = 0;
+  else
+    Debug("aio", "io_uring file registration unavailable: %s (%d)", strerror(errno), errno);
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+#ifdef HAVE_EVENTFD
+  // Wake the event loop of this thread when completions are posted.
+  if (aio_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &e->ethread->evfd, 1) < 0)
+    Warning("io_uring eventfd registration failed, completions wait for the next poll timeout: %s (%d)", strerror(errno), errno);
+#endif
+  // Without an eventfd, completions are reaped by the periodic mainAIOEvent.
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+static inline void
+aio_uring_prep(DiskHandler *dh, struct io_uring_sqe *sqe, AIOCallback *op)
+{
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = op->aiocb.aio_lio_opcode == LIO_WRITE ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = op->aiocb.aio_fildes;
+  for (int i = 0; i < dh->fixed_files; ++i) {
+    if (aio_fixed_fd[i] == op->aiocb.aio_fildes) {
+      sqe->fd = i;
+      sqe->flags = IOSQE_FIXED_FILE;
+      break;
+    }
+  }
+  sqe->addr = (uintptr_t)op->aiocb.aio_buf;
+  sqe->len = op->aiocb.aio_nbytes;
+  sqe->off = op->aiocb.aio_offset;
+  sqe->user_data = (uintptr_t)op;
+}
+
+/** Runs an operation the ring cannot take with pread or pwrite on an ET_TASK thread,
+    then hands it back to the thread which queued it.
+*/
+struct AIOUringFallback : public Continuation {
+  AIOCallback *op;
+  EThread *origin;
+
+  AIOUringFallback(AIOCallback *o, EThread *t) : Continuation(NULL), op(o), origin(t)
+  {
+    SET_HANDLER(&AIOUringFallback::mainEvent);
+  }
+
+  int
+  mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    ink_aiocb_t *a = &op->aiocb;
+    ssize_t err = 0, res = 0;
+
+    while (a->aio_nbytes - res > 0) {
+      do {
+        if (a->aio_lio_opcode == LIO_WRITE)
+          err = pwrite(a->aio_fildes, ((char *)a->aio_buf) + res, a->aio_nbytes - res, a->aio_offset + res);
+        else
+          err = pread(a->aio_fildes, ((char *)a->aio_buf) + res, a->aio_nbytes - res, a->aio_offset + res);
+      } while (err < 0 && errno == EINTR);
+      if (err <= 0)
+        break;
+      res += err;
+    }
+    op->aio_result = err < 0 ? -errno : res;
+    if (res > 0) {
+      if (a->aio_lio_opcode == LIO_WRITE) {
+        ink_atomic_increment(&aio_num_write, 1);
+        ink_atomic_increment(&aio_bytes_written, res);
+      } else {
+        ink_atomic_increment(&aio_num_read, 1);
+        ink_atomic_increment(&aio_bytes_read, res);
+      }
+    }
+    op->mutex = op->action.mutex;
+    origin->schedule_imm_signal(op);
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
+int
+DiskHandler::mainAIOEvent(int event, Event *e)
+{
+  AIOCallback *op = NULL;
+
+  // The kernel advances the completion tail, this thread owns the head.
+  unsigned head = *cq_head;
+  unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+    op = (AIOCallback *)(uintptr_t)cqe->user_data;
+    op->aio_result = cqe->res;
+    ink_assert(op->action.continuation);
+    if (cqe->res > 0) {
+      if (op->aiocb.aio_lio_opcode == LIO_WRITE) {
+        ink_atomic_increment(&aio_num_write, 1);
+        ink_atomic_increment(&aio_bytes_written, cqe->res);
+      } else {
+        ink_atomic_increment(&aio_num_read, 1);
+        ink_atomic_increment(&aio_bytes_read, cqe->res);
+      }
+    }
+    complete_list.enqueue(op);
+    --inflight;
+  }
+  __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+  if (fixed_files >= 0 && fixed_files < aio_fixed_fd_count) {
+    struct io_uring_files_update up;
+    int n = aio_fixed_fd_count - fixed_files;
+    memset(&up, 0, sizeof(up));
+    up.offset = fixed_files;
+    up.fds = (uintptr_t)&aio_fixed_fd[fixed_files];
+    if (aio_uring_register(ring_fd, IORING_REGISTER_FILES_UPDATE, &up, n) == n)
+      fixed_files += n;
+    else
+      Debug("aio", "io_uring file update failed: %s (%d)", strerror(errno), errno);
+  }
+
+  // Queue everything that arrived during this loop iteration, bounded so the completion ring cannot overflow.
+  unsigned sq_tail_local = *sq_tail;
+  while (!failed && inflight < (int)cq_entries && sq_tail_local - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) < *sq_entries &&
+         (op = ready_list.dequeue()) != NULL) {
+    unsigned idx = sq_tail_local & *sq_mask;
+    aio_uring_prep(this, &sqes[idx], op);
+    sq_array[idx] = idx;
+    ++sq_tail_local;
+    ++inflight;
+  }
+
+  unsigned to_submit = sq_tail_local - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+  if (to_submit > 0) {
+    __atomic_store_n(sq_tail, sq_tail_local, __ATOMIC_RELEASE);
+    int ret;
+    do {
+      ret = aio_uring_enter(ring_fd, to_submit);
+    } while (ret < 0 && errno == EINTR);
+    // Anything the kernel did not take yet stays in the submission ring for the next iteration, unless the ring is
+    // broken: then the kernel consumed none of it, so take it back and run it and all later operations on ET_TASK.
+    if (ret < 0 && errno != EAGAIN && errno != EBUSY) {
+      Warning("io_uring_enter failed, disk I/O falls back to task threads: %s (%d)", strerror(errno), errno);
+      failed = true;
+      unsigned sq_head_local = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+      for (; sq_head_local != sq_tail_local; ++sq_head_local) {
+        op = (AIOCallback *)(uintptr_t)sqes[sq_array[sq_head_local & *sq_mask]].user_data;
+        eventProcessor.schedule_imm(new AIOUringFallback(op, e->ethread), ET_TASK);
+        --inflight;
+      }
+      __atomic_store_n(sq_tail, sq_head_local, __ATOMIC_RELEASE);
+    }
+  }
+  // With the ring broken, new operations go straight to ET_TASK, the ones the kernel took still complete through it.
+  while (failed && (op = ready_list.dequeue()) != NULL)
+    eventProcessor.schedule_imm(new AIOUringFallback(op, e->ethread), ET_TASK);
+
+  while ((op = complete_list.dequeue()) != NULL) {
+    op->handleEvent(event, e);
+  }
+  return EVENT_CONT;
+}
+
+static inline int
+aio_uring_queue(AIOCallback *op, int opcode)
+{
+  EThread *t = this_ethread();
+  AIOCallback *io = op;
+  int sz = 0;
+
+  while (io) {
+    io->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+    io->aiocb.aio_lio_opcode = opcode;
+    t->diskHandler->ready_list.enqueue(io);
+    ++sz;
+    io = io->then;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    while (--sz >= 0) {
+      op->action = vec;
+      op = op->then;
+    }
+  }
+  return 1;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+  op->aiocb.aio_lio_opcode = LIO_READ;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY;
+  op->aiocb.aio_lio_opcode = LIO_WRITE;
+  this_ethread()->diskHandler->ready_list.enqueue(op);
+
+  return 1;
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_WRITE);
+}
+#endif // AIO_MODE
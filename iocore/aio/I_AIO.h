@@ -43,8 +43,11 @@
 
 #define AIO_MODE_THREAD 0
 #define AIO_MODE_NATIVE 1
+#define AIO_MODE_IO_URING 2
 
-#if TS_USE_LINUX_NATIVE_AIO
+#if TS_USE_LINUX_IO_URING
+#define AIO_MODE AIO_MODE_IO_URING
+#elif TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE AIO_MODE_NATIVE
 #else
 #define AIO_MODE AIO_MODE_THREAD
@@ -81,8 +84,10 @@ typedef struct ink_aiocb {
   int aio__pad[1];    /* extension padding */
 } ink_aiocb_t;
 
-bool ink_aio_thread_num_set(int thread_num);
+#endif
 
+#if AIO_MODE == AIO_MODE_THREAD
+bool ink_aio_thread_num_set(int thread_num);
 #endif
 
 // AIOCallback::thread special values
@@ -105,7 +110,7 @@ struct AIOCallback : public Continuation {
   AIOCallback() : thread(AIO_CALLBACK_THREAD_ANY), then(0) { aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY; }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 
 struct AIOVec : public Continuation {
   Action action;
@@ -122,6 +127,10 @@ struct AIOVec : public Continuation {
   int mainEvent(int event, Event *e);
 };
 
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
+
 struct DiskHandler : public Continuation {
   Event *trigger_event;
   io_context_t ctx;
@@ -140,11 +149,54 @@ struct DiskHandler : public Continuation {
     }
   }
 };
+
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+#include <linux/io_uring.h>
+
+#define MAX_AIO_EVENTS 1024
+#define MAX_AIO_FIXED_FILES 64
+
+/** Per ET_NET thread io_uring instance.
+
+    Operations queued on @a ready_list during an event loop iteration are
+    submitted together with a single @c io_uring_enter when the handler
+    runs at the end of the iteration. Completions are reaped from the
+    shared completion ring on the same thread, the thread's event fd is
+    registered with the ring so the poll wakes up when I/O finishes.
+*/
+struct DiskHandler : public Continuation {
+  Event *trigger_event;
+  int ring_fd;
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_entries;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  unsigned cq_entries;
+  struct io_uring_cqe *cqes;
+  int inflight;    ///< Submitted but not yet reaped.
+  int fixed_files; ///< Number of ink_aio_register_fd files registered with this ring.
+  bool failed;     ///< io_uring_enter failed hard, operations go to ET_TASK threads instead.
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+  DiskHandler();
+};
 #endif
 
 void ink_aio_init(ModuleVersion version);
 int ink_aio_start();
 void ink_aio_set_callback(Continuation *error_callback);
+/** Declare @a fd as open for the life of the process.
+    Backends that can pre-register files with the kernel do so, @a fd must not be closed afterwards.
+*/
+void ink_aio_register_fd(int fd);
 
 int ink_aio_read(AIOCallback *op,
                  int fromAPI = 0); // fromAPI is a boolean to indicate if this is from a API call such as upload proxy feature
@@ -46,7 +46,7 @@ AIOCallback::ok()
   return (off_t)aiocb.aio_nbytes == (off_t)aio_result;
 }
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 
 extern Continuation *aio_err_callbck;
 
@@ -91,7 +91,7 @@ AIOVec::mainEvent(int /* event */, Event *)
   return EVENT_ERROR;
 }
 
-#else /* AIO_MODE != AIO_MODE_NATIVE */
+#else /* AIO_MODE == AIO_MODE_THREAD */
 
 struct AIO_Reqs;
 
@@ -133,7 +133,7 @@ struct AIO_Reqs {
   volatile int requests_queued;
 };
 
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE != AIO_MODE_THREAD
 #ifdef AIO_STATS
 class AIOTestData : public Continuation
 {
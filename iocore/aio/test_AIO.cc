@@ -84,6 +84,17 @@ int seq_read_size = 0;
 int seq_write_size = 0;
 int rand_read_size = 0;
 
+// Completion latency histogram, bucket i counts operations that took less than 2^i microseconds.
+#define LATENCY_BUCKETS 32
+
+#if AIO_MODE == AIO_MODE_IO_URING
+const char *aio_mode_name = "io_uring";
+#elif AIO_MODE == AIO_MODE_NATIVE
+const char *aio_mode_name = "native";
+#else
+const char *aio_mode_name = "thread";
+#endif
+
 struct AIO_Device : public Continuation {
   char *path;
   int fd;
@@ -96,13 +107,37 @@ struct AIO_Device : public Continuation {
   int hotset_idx;
   int mode;
   AIOCallback *io;
+  ink_hrtime io_start;
+  ink_hrtime latency_max;
+  double latency_total;
+  int64_t latency_hist[LATENCY_BUCKETS];
   AIO_Device(ProxyMutex *m) : Continuation(m)
   {
     hotset_idx = 0;
     io = new_AIOCallback();
     time_start = 0;
+    io_start = 0;
+    latency_max = 0;
+    latency_total = 0.0;
+    memset(latency_hist, 0, sizeof(latency_hist));
     SET_HANDLER(&AIO_Device::do_hotset);
   }
+  void
+  record_latency()
+  {
+    if (!io_start)
+      return;
+    ink_hrtime lat = Thread::get_hrtime_updated() - io_start;
+    int64_t usec = ink_hrtime_to_usec(lat);
+    int b = 0;
+    while (b < LATENCY_BUCKETS - 1 && (1LL << b) <= usec)
+      b++;
+    latency_hist[b]++;
+    latency_total += lat;
+    if (lat > latency_max)
+      latency_max = lat;
+    io_start = 0;
+  }
   int
   select_mode(double p)
   {
@@ -205,6 +240,35 @@ dump_summary(void)
   printf("%f ops %0.2f mbytes/sec %0.1f ops/sec %0.1f ops/sec/disk rand_read\n", total_rand_reads, rr,
          total_rand_reads / total_secs, total_rand_reads / total_secs / n_disk_path);
   printf("%0.2f total mbytes/sec\n", sr + sw + rr);
+
+  // Compare modes by running the same configuration against each AIO build.
+  int64_t hist[LATENCY_BUCKETS] = {0};
+  int64_t n_ops = 0;
+  double lat_total = 0.0;
+  ink_hrtime lat_max = 0;
+  for (int i = 0; i < orig_n_accessors; i++) {
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      hist[b] += dev[i]->latency_hist[b];
+      n_ops += dev[i]->latency_hist[b];
+    }
+    lat_total += dev[i]->latency_total;
+    if (dev[i]->latency_max > lat_max)
+      lat_max = dev[i]->latency_max;
+  }
+  int64_t p50 = 0, p99 = 0, seen = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    seen += hist[b];
+    if (!p50 && seen * 2 >= n_ops)
+      p50 = 1LL << b;
+    if (!p99 && seen * 100 >= n_ops * 99)
+      p99 = 1LL << b;
+  }
+  printf("-----------------\n");
+  printf("latency (%s aio)\n", aio_mode_name);
+  printf("-----------------\n");
+  printf("%" PRId64 " ops %0.1f ops/sec\n", n_ops, n_ops / total_secs);
+  printf("%0.1f usec avg, p50 < %" PRId64 " usec, p99 < %" PRId64 " usec, %" PRId64 " usec max\n",
+         n_ops ? lat_total / n_ops / HRTIME_USECOND : 0.0, p50, p99, (int64_t)ink_hrtime_to_usec(lat_max));
   printf("----------------------------------------------------------\n");
 
   if (delete_disks)
@@ -245,8 +309,10 @@ AIO_Device::do_fd(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
 {
   if (!time_start) {
     time_start = Thread::get_hrtime();
+    io_start = 0;
     fprintf(stderr, "Starting the aio_testing \n");
   }
+  record_latency();
   if ((Thread::get_hrtime() - time_start) > (run_time * HRTIME_SECOND)) {
     time_end = Thread::get_hrtime();
     ink_atomic_increment(&n_accessors, -1);
@@ -271,6 +337,7 @@ AIO_Device::do_fd(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   io->aiocb.aio_buf = buf;
   io->action = this;
   io->thread = mutex->thread_holding;
+  io_start = Thread::get_hrtime_updated();
 
   switch (select_mode(drand48())) {
   case READ_MODE:
@@ -400,7 +467,7 @@ main(int /* argc ATS_UNUSED */, char *argv[])
   RecProcessInit(RECM_STAND_ALONE);
   ink_event_system_init(EVENT_SYSTEM_MODULE_VERSION);
   eventProcessor.start(ink_number_of_processors());
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -440,6 +507,7 @@ main(int /* argc ATS_UNUSED */, char *argv[])
         perror(disk_path[i]);
         exit(1);
       }
+      ink_aio_register_fd(dev[n_accessors]->fd);
       dev[n_accessors]->buf = (char *)valloc(max_size);
       eventProcessor.schedule_imm(dev[n_accessors]);
       n_accessors++;
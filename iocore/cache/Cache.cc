@@ -80,6 +80,8 @@ int cache_config_read_while_writer = 0;
 int cache_config_mutex_retry_delay = 2;
 int cache_read_while_writer_retry_delay = 50;
 int cache_config_read_while_writer_max_retries = 10;
+int cache_config_recovery_early_serve = 0;
+int cache_config_dir_segment_locks = 0;
 #ifdef HTTP_CACHE
 static int enable_cache_empty_http_doc = 0;
 /// Fix up a specific known problem with the 4.2.0 release.
@@ -109,6 +111,8 @@ int CacheProcessor::auto_clear_flag = 0;
 CacheProcessor cacheProcessor;
 Vol **gvol = NULL;
 volatile int gnvol = 0;
+// Serializes stripes coming online against each other and against cache initialization.
+static ink_mutex vol_init_mutex = INK_MUTEX_INIT;
 ClassAllocator<CacheVC> cacheVConnectionAllocator("cacheVConnection");
 ClassAllocator<EvacuationBlock> evacuationBlockAllocator("evacuationBlock");
 ClassAllocator<CacheRemoveCont> cacheRemoveContAllocator("cacheRemoveCont");
@@ -138,7 +142,7 @@ struct VolInitInfo {
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
 struct VolInit : public Continuation {
   Vol *vol;
   char *path;
@@ -607,7 +611,7 @@ CacheProcessor::start_internal(int flags)
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_FAILED == (int)CACHE_EVENT_SCAN_OPERATION_FAILED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_DONE == (int)CACHE_EVENT_SCAN_DONE);
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -711,7 +715,8 @@ CacheProcessor::start_internal(int flags)
 
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks = blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
+        ink_aio_register_fd(fd); // cache disks stay open for the life of the process
+#if AIO_MODE != AIO_MODE_THREAD
         eventProcessor.schedule_imm(new DiskInit(gdisks[gndisks], path, blocks, skip, sector_size, fd, clear));
 #else
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
@@ -868,6 +873,20 @@ CacheProcessor::diskInitialized()
   }
 }
 
+static RamCache *
+new_configured_RamCache()
+{
+  switch (cache_config_ram_cache_algorithm) {
+  default:
+  case RAM_CACHE_ALGORITHM_CLFUS:
+    return new_RamCacheCLFUS();
+  case RAM_CACHE_ALGORITHM_LRU:
+    return new_RamCacheLRU();
+  case RAM_CACHE_ALGORITHM_TINYLFU:
+    return new_RamCacheTinyLFU();
+  }
+}
+
 void
 CacheProcessor::cacheInitialized()
 {
@@ -942,15 +961,7 @@ CacheProcessor::cacheInitialized()
     if (gnvol) {
       // new ram_caches, with algorithm from the config
       for (i = 0; i < gnvol; i++) {
-        switch (cache_config_ram_cache_algorithm) {
-        default:
-        case RAM_CACHE_ALGORITHM_CLFUS:
-          gvol[i]->ram_cache = new_RamCacheCLFUS();
-          break;
-        case RAM_CACHE_ALGORITHM_LRU:
-          gvol[i]->ram_cache = new_RamCacheLRU();
-          break;
-        }
+        gvol[i]->ram_cache = new_configured_RamCache();
       }
       // let us calculate the Size
       if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
@@ -1083,6 +1094,47 @@ CacheProcessor::cacheInitialized()
   }
 }
 
+void
+CacheProcessor::volOnline(Vol *vol)
+{
+  int64_t ram_cache_bytes;
+  int64_t ram_cache_stat_bytes;
+
+  vol->ram_cache = new_configured_RamCache();
+  if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
+    ram_cache_bytes = vol_dirlen(vol) * DEFAULT_RAM_CACHE_MULTIPLIER;
+    ram_cache_stat_bytes = vol_dirlen(vol);
+  } else {
+    // Same split as cacheInitialized(), the cache sizes include the stripes that are not online yet.
+    int64_t total_size = (theCache ? theCache->cache_size : 0) + (theStreamCache ? theStreamCache->cache_size : 0);
+    int64_t http_ram_cache_size =
+      (theCache) ? (int64_t)(((double)theCache->cache_size / total_size) * cache_config_ram_cache_size) : 0;
+    int64_t cache_ram_cache_size =
+      (vol->cache == theCache) ? http_ram_cache_size : cache_config_ram_cache_size - http_ram_cache_size;
+    double factor = (double)(int64_t)(vol->len >> STORE_BLOCK_SHIFT) / (int64_t)vol->cache->cache_size;
+    ram_cache_bytes = ram_cache_stat_bytes = (int64_t)(cache_ram_cache_size * factor);
+  }
+  vol->ram_cache->init(ram_cache_bytes, vol);
+  Debug("cache_init", "CacheProcessor::volOnline - '%s' ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb", vol->hash_text.get(),
+        ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
+
+  int64_t vol_total_cache_bytes = vol->len - vol_dirlen(vol);
+  int64_t vol_total_direntries = vol->buckets * vol->segments * DIR_DEPTH;
+  int64_t vol_used_direntries = dir_entries_used(vol);
+  RecRawStatBlock *rsbs[] = {cache_rsb, vol->cache_vol->vol_rsb};
+  for (unsigned i = 0; i < countof(rsbs); ++i) {
+    RecIncrGlobalRawStat(rsbs[i], cache_ram_cache_bytes_total_stat, ram_cache_stat_bytes);
+    RecIncrGlobalRawStat(rsbs[i], cache_bytes_total_stat, vol_total_cache_bytes);
+    RecIncrGlobalRawStat(rsbs[i], cache_direntries_total_stat, vol_total_direntries);
+    RecIncrGlobalRawStat(rsbs[i], cache_direntries_used_stat, vol_used_direntries);
+  }
+
+  if (vol->header->version < min_stripe_version)
+    min_stripe_version = vol->header->version;
+  if (max_stripe_version < vol->header->version)
+    max_stripe_version = vol->header->version;
+}
+
 void
 CacheProcessor::stop()
 {
@@ -1358,6 +1410,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   ink_assert(len <= MAX_VOL_SIZE);
   skip = dir_skip;
   prev_recover_pos = 0;
+  init_start = Thread::get_hrtime_updated();
 
   // successive approximation, directory/meta data eats up some storage
   start = dir_skip;
@@ -1378,11 +1431,20 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     raw_dir = (char *)ats_alloc_hugepage(vol_dirlen(this));
   if (raw_dir == NULL)
     raw_dir = (char *)ats_memalign(ats_pagesize(), vol_dirlen(this));
+  // Keep the directory next to the AIO threads of the disk, see aio_init_fildes().
+  if (thread_numa_nodes && disk && disk->numa_node >= 0)
+    ink_numa_bind_memory(raw_dir, vol_dirlen(this), disk->numa_node);
 
   dir = (Dir *)(raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *)raw_dir;
   footer = (VolHeaderFooter *)(raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
 
+  if (cache_config_dir_segment_locks && !dir_seg_mutex) {
+    dir_seg_mutex = new Ptr<ProxyMutex>[segments];
+    for (int i = 0; i < segments; i++)
+      dir_seg_mutex[i] = new_ProxyMutex();
+  }
+
   if (clear) {
     Note("clearing cache directory '%s'", hash_text.get());
     return clear_dir();
@@ -1411,7 +1473,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     aio->thread = AIO_CALLBACK_THREAD_ANY;
     aio->then = (i < 3) ? &(init_info->vol_aio[i + 1]) : 0;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1545,11 +1607,15 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
     io.aiocb.aio_nbytes = RECOVERY_SIZE;
     if ((off_t)(recover_pos + io.aiocb.aio_nbytes) > (off_t)(skip + len))
       io.aiocb.aio_nbytes = (skip + len) - recover_pos;
+    RecIncrGlobalRawStat(cache_rsb, cache_recovery_count_stat, 1);
+    RecIncrGlobalRawStat(cache_vol->vol_rsb, cache_recovery_count_stat, 1);
   } else if (event == AIO_EVENT_DONE) {
     if ((size_t)io.aiocb.aio_nbytes != (size_t)io.aio_result) {
       Warning("disk read error on recover '%s', clearing", hash_text.get());
       goto Lclear;
     }
+    RecIncrGlobalRawStat(cache_rsb, cache_recovery_bytes_stat, io.aio_result);
+    RecIncrGlobalRawStat(cache_vol->vol_rsb, cache_recovery_bytes_stat, io.aio_result);
     if (io.aiocb.aio_offset == header->last_write_pos) {
       /* check that we haven't wrapped around without syncing
          the directory. Start from last_write_serial (write pos the documents
@@ -1754,7 +1820,7 @@ Ldone : {
   init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
   SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
   ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
   ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1844,14 +1910,12 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
-    int vol_no = ink_atomic_increment(&gnvol, 1);
-    ink_assert(!gvol[vol_no]);
-    gvol[vol_no] = this;
+    ink_hrtime elapsed = Thread::get_hrtime_updated() - init_start;
+    RecIncrGlobalRawStat(cache_rsb, cache_recovery_time_stat, elapsed);
+    RecIncrGlobalRawStat(cache_vol->vol_rsb, cache_recovery_time_stat, elapsed);
+    Debug("cache_init", "stripe '%s' initialized in %" PRId64 " ms", hash_text.get(), ink_hrtime_to_msec(elapsed));
     SET_HANDLER(&Vol::aggWrite);
-    if (fd == -1)
-      cache->vol_initialized(0);
-    else
-      cache->vol_initialized(1);
+    cache->vol_initialized(this, fd != -1);
     return EVENT_DONE;
   }
 }
@@ -1891,7 +1955,7 @@ build_vol_hash_table(CacheHostRecord *cp)
   uint64_t used = 0;
   // initialize number of elements per vol
   for (int i = 0; i < num_vols; i++) {
-    if (DISK_BAD(cp->vols[i]->disk)) {
+    if (DISK_BAD(cp->vols[i]->disk) || !cp->vols[i]->init_done) {
       bad_vols++;
       continue;
     }
@@ -1980,12 +2044,40 @@ build_vol_hash_table(CacheHostRecord *cp)
 }
 
 void
-Cache::vol_initialized(bool result)
+Cache::vol_initialized(Vol *vol, bool result)
 {
+  ink_mutex_acquire(&vol_init_mutex);
+
+  // Fill the slot before bumping the count so that walking gvol never sees an empty slot.
+  ink_assert(!gvol[gnvol]);
+  gvol[gnvol] = vol;
+  ink_atomic_increment(&gnvol, 1);
+  vol->init_done = true;
+
+  RecIncrGlobalRawStat(cache_rsb, cache_recovery_pending_stat, -1);
+  RecIncrGlobalRawStat(vol->cache_vol->vol_rsb, cache_recovery_pending_stat, -1);
+
   if (result)
     ink_atomic_increment(&total_good_nvol, 1);
-  if (total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1)
-    open_done();
+  int n_initialized = ink_atomic_increment(&total_initialized_vol, 1) + 1;
+
+  if (!cache_config_recovery_early_serve) {
+    if (total_nvol == n_initialized)
+      open_done();
+  } else if (ready == CACHE_INITIALIZING) {
+    // Start serving as soon as there is one good stripe, the host table only maps stripes that are done.
+    if (result || total_nvol == n_initialized)
+      open_done();
+  } else if (ready == CACHE_INITIALIZED && result && CacheProcessor::initialized != CACHE_INIT_FAILED) {
+    // Late stripe. If the processor is still initializing (waiting on the other cache) the RAM cache is set up
+    // along with all the other stripes in @c cacheInitialized.
+    if (CacheProcessor::initialized == CACHE_INITIALIZED)
+      cacheProcessor.volOnline(vol);
+    rebuild_host_table(this);
+    Note("cache stripe '%s' online, %d of %d stripes initialized", vol->hash_text.get(), n_initialized, total_nvol);
+  }
+
+  ink_mutex_release(&vol_init_mutex);
 }
 
 /** Set the state of a disk programmatically.
@@ -2156,7 +2248,7 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
             blocks = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_THREAD
             eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
 #else
             cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
@@ -2167,6 +2259,8 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
         }
       }
       total_nvol += vol_no;
+      RecIncrGlobalRawStat(cache_rsb, cache_recovery_pending_stat, vol_no);
+      RecIncrGlobalRawStat(cp->vol_rsb, cache_recovery_pending_stat, vol_no);
     }
   }
   if (total_nvol == 0)
@@ -3175,6 +3269,13 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("sync.count", cache_directory_sync_count_stat);
   REG_INT("sync.bytes", cache_directory_sync_bytes_stat);
   REG_INT("sync.time", cache_directory_sync_time_stat);
+  REG_INT("recovery.pending", cache_recovery_pending_stat);
+  REG_INT("recovery.count", cache_recovery_count_stat);
+  REG_INT("recovery.bytes", cache_recovery_bytes_stat);
+  REG_INT("recovery.time", cache_recovery_time_stat);
+  REG_INT("read.lock_miss", cache_read_lock_miss_stat);
+  REG_INT("read.segment_miss", cache_read_segment_miss_stat);
+  REG_INT("write.lock_miss", cache_write_lock_miss_stat);
 }
 
 void
@@ -3257,6 +3358,12 @@ ink_cache_init(ModuleVersion v)
   REC_RegisterConfigUpdateFunc("proxy.config.cache.enable_read_while_writer", update_cache_config, NULL);
   Debug("cache_init", "proxy.config.cache.enable_read_while_writer = %d", cache_config_read_while_writer);
 
+  REC_EstablishStaticConfigInt32(cache_config_recovery_early_serve, "proxy.config.cache.recovery.early_serve");
+  Debug("cache_init", "proxy.config.cache.recovery.early_serve = %d", cache_config_recovery_early_serve);
+
+  REC_EstablishStaticConfigInt32(cache_config_dir_segment_locks, "proxy.config.cache.dir.segment_locks");
+  Debug("cache_init", "proxy.config.cache.dir.segment_locks = %d", cache_config_dir_segment_locks);
+
   register_cache_stats(cache_rsb, "proxy.process.cache");
 
   REC_ReadConfigInteger(cacheProcessor.wait_for_cache, "proxy.config.http.wait_for_cache");
@@ -49,6 +49,22 @@
     CACHE_INCREMENT_DYN_STAT(cache_directory_collision_count_stat); \
   } while (0);
 
+// Holds the lock of directory segment @a s for the scope, a no-op unless segment locks are enabled.
+// Directory updates take it inside the stripe lock, dir_probe_miss takes it alone.
+struct DirSegmentLock {
+  DirSegmentLock(Vol *d, int s) : m(d->dir_seg_mutex ? d->dir_seg_mutex[s].m_ptr : NULL)
+  {
+    if (m)
+      MUTEX_TAKE_LOCK(m, this_ethread());
+  }
+  ~DirSegmentLock()
+  {
+    if (m)
+      MUTEX_UNTAKE_LOCK(m, m->thread_holding);
+  }
+  ProxyMutex *m;
+};
+
 // Globals
 
 ClassAllocator<OpenDirEntry> openDirEntryAllocator("openDirEntry");
@@ -360,6 +376,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
 void
 dir_clean_segment(int s, Vol *d)
 {
+  DirSegmentLock lock(d, s);
   Dir *seg = dir_segment(s, d);
   for (int64_t i = 0; i < d->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -378,14 +395,19 @@ dir_clean_vol(Vol *d)
 void
 dir_clear_range(off_t start, off_t end, Vol *vol)
 {
-  for (off_t i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
-    Dir *e = dir_index(vol, i);
-    if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
-      CACHE_DEC_DIR_USED(vol->mutex);
-      dir_set_offset(e, 0); // delete
+  off_t seg_len = vol->buckets * DIR_DEPTH;
+  for (int s = 0; s < vol->segments; s++) {
+    DirSegmentLock lock(vol, s);
+    for (off_t i = s * seg_len; i < (s + 1) * seg_len; i++) {
+      Dir *e = dir_index(vol, i);
+      if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+        CACHE_DEC_DIR_USED(vol->mutex);
+        dir_set_offset(e, 0); // delete
+      }
     }
+    dir_clean_segment(s, vol);
   }
-  dir_clean_vol(vol);
+  CHECK_DIR(vol);
 }
 
 void
@@ -403,6 +425,7 @@ check_bucket_not_contains(Dir *b, Dir *e, Dir *seg)
 void
 freelist_clean(int s, Vol *vol)
 {
+  DirSegmentLock lock(vol, s);
   dir_clean_segment(s, vol);
   if (vol->header->freelist[s])
     return;
@@ -505,6 +528,7 @@ dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->slice32(0) % d->segments;
   int b = key->slice32(1) % d->buckets;
+  DirSegmentLock lock(d, s);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL, *p = NULL, *collision = *last_collision;
   Vol *vol = d;
@@ -571,6 +595,7 @@ dir_insert(const CacheKey *key, Vol *d, Dir *to_part)
   int s = key->slice32(0) % d->segments, l;
   int bi = key->slice32(1) % d->buckets;
   ink_assert(dir_approx_size(to_part) <= MAX_FRAG_SIZE + sizeofDoc);
+  DirSegmentLock lock(d, s);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL;
   Dir *b = dir_bucket(bi, seg);
@@ -622,6 +647,7 @@ dir_overwrite(const CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_o
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->slice32(0) % d->segments, l;
   int bi = key->slice32(1) % d->buckets;
+  DirSegmentLock lock(d, s);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL;
   Dir *b = dir_bucket(bi, seg);
@@ -694,6 +720,7 @@ dir_delete(const CacheKey *key, Vol *d, Dir *del)
   ink_assert(d->mutex->thread_holding == this_ethread());
   int s = key->slice32(0) % d->segments;
   int b = key->slice32(1) % d->buckets;
+  DirSegmentLock lock(d, s);
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL, *p = NULL;
 #ifdef LOOP_CHECK_MODE
@@ -725,6 +752,44 @@ dir_delete(const CacheKey *key, Vol *d, Dir *del)
   return 0;
 }
 
+/** Check for a certain miss on @a key without the stripe lock.
+
+    Only the directory segment lock is taken and nothing is modified, so
+    this runs in parallel with directory updates on other segments. Open
+    writers and evacuated documents are tracked under the stripe lock,
+    their buckets are only tested for being empty.
+
+    @return 1 if the document is certainly not in the stripe, 0 if it may
+    be or segment locks are disabled or the segment lock is busy.
+*/
+int
+dir_probe_miss(const CacheKey *key, Vol *d)
+{
+  if (!d->dir_seg_mutex)
+    return 0;
+  // Check the writers before the directory, a writer inserts its entry before it closes.
+  if (*(OpenDirEntry *volatile *)&d->open_dir.bucket[key->slice32(0) % OPEN_DIR_BUCKETS].head)
+    return 0;
+  if (*(EvacuationBlock *volatile *)&d->lookaside[key->slice32(3) % LOOKASIDE_SIZE].head)
+    return 0;
+  int s = key->slice32(0) % d->segments;
+  MUTEX_TRY_LOCK(lock, d->dir_seg_mutex[s], this_ethread());
+  if (!lock.is_locked())
+    return 0;
+  Dir *seg = dir_segment(s, d);
+  Dir *e = dir_bucket(key->slice32(1) % d->buckets, seg);
+  unsigned int t = DIR_MASK_TAG(key->slice32(2));
+  if (!dir_offset(e))
+    return 1;
+  // Bound the walk, a looped chain is only repaired under the stripe lock.
+  for (int n = 0; e && n < d->buckets * DIR_DEPTH; n++) {
+    if (dir_tag(e) == t)
+      return 0;
+    e = next_dir(e, seg);
+  }
+  return !e;
+}
+
 // Lookaside Cache
 
 int
@@ -1526,3 +1591,141 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir)(RegressionTest *t, int /* atype ATS_UNUSED
   vol_dir_clear(d);
   *status = ret;
 }
+
+// Lock contention of cache read misses, as with many event threads on few stripes. Each ET_NET thread reads keys which
+// are not in the directory of a stripe for a second, first taking the stripe lock for each as Cache::open_read does,
+// then trying dir_probe_miss under the segment lock first. A read which misses the stripe lock would be rescheduled.
+struct CacheDirContentionTest : public Continuation {
+  RegressionTest *t;
+  int *status;
+  Vol *d;
+  CacheKey *keys;
+  int nkeys;
+  int mode; // 0 stripe lock only, 1 dir_probe_miss first
+  bool own_seg_mutex;
+  volatile int running;
+  volatile int64_t reads, lock_misses, segment_misses;
+
+  int start_readers(int event, void *data);
+  int done(int event, void *data);
+
+  CacheDirContentionTest(RegressionTest *at, int *astatus, Vol *ad)
+    : Continuation(new_ProxyMutex()), t(at), status(astatus), d(ad), keys(NULL), nkeys(0), mode(0), own_seg_mutex(false),
+      running(0), reads(0), lock_misses(0), segment_misses(0)
+  {
+    SET_HANDLER(&CacheDirContentionTest::start_readers);
+  }
+};
+
+struct CacheDirContentionReader : public Continuation {
+  CacheDirContentionTest *test;
+  int first;
+
+  CacheDirContentionReader(CacheDirContentionTest *atest, int afirst) : Continuation(new_ProxyMutex()), test(atest), first(afirst)
+  {
+    SET_HANDLER(&CacheDirContentionReader::run);
+  }
+
+  int
+  run(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+  {
+    Vol *d = test->d;
+    EThread *thread = this_ethread();
+    ink_hrtime until = Thread::get_hrtime_updated() + HRTIME_SECOND;
+    int64_t reads = 0, lock_misses = 0, segment_misses = 0;
+
+    for (int i = first; (reads & 255) || Thread::get_hrtime_updated() < until; i = (i + 1) % test->nkeys, reads++) {
+      if (test->mode && dir_probe_miss(&test->keys[i], d)) {
+        segment_misses++;
+        continue;
+      }
+      MUTEX_TRY_LOCK(lock, d->mutex, thread);
+      if (!lock.is_locked()) {
+        lock_misses++;
+        continue;
+      }
+      Dir dir, *last_collision = 0;
+      dir_probe(&test->keys[i], d, &dir, &last_collision);
+    }
+    ink_atomic_increment(&test->reads, reads);
+    ink_atomic_increment(&test->lock_misses, lock_misses);
+    ink_atomic_increment(&test->segment_misses, segment_misses);
+    if (ink_atomic_increment(&test->running, -1) == 1) {
+      eventProcessor.schedule_imm(test);
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
+int
+CacheDirContentionTest::start_readers(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  int n = eventProcessor.n_threads_for_type[ET_NET];
+
+  reads = lock_misses = segment_misses = 0;
+  running = n;
+  SET_HANDLER(&CacheDirContentionTest::done);
+  for (int i = 0; i < n; i++) {
+    eventProcessor.eventthread[ET_NET][i]->schedule_imm(new CacheDirContentionReader(this, i * (nkeys / n)));
+  }
+  return EVENT_DONE;
+}
+
+int
+CacheDirContentionTest::done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
+{
+  rprintf(t, "%d threads, %s: %" PRId64 " read misses / second, %" PRId64 "%% missed the stripe lock, %" PRId64
+             "%% resolved under the segment lock\n",
+          eventProcessor.n_threads_for_type[ET_NET], mode ? "segment locks" : "stripe lock", reads,
+          reads ? lock_misses * 100 / reads : 0, reads ? segment_misses * 100 / reads : 0);
+  if (mode == 0) {
+    mode = 1;
+    SET_HANDLER(&CacheDirContentionTest::start_readers);
+    eventProcessor.schedule_imm(this);
+    return EVENT_DONE;
+  }
+  if (own_seg_mutex) {
+    delete[] d->dir_seg_mutex;
+    d->dir_seg_mutex = NULL;
+  }
+  ats_free(keys);
+  *status = REGRESSION_TEST_PASSED;
+  delete this;
+  return EVENT_DONE;
+}
+
+EXCLUSIVE_REGRESSION_TEST(Cache_dir_contention)(RegressionTest *t, int /* atype ATS_UNUSED */, int *status)
+{
+  if ((CacheProcessor::IsCacheEnabled() != CACHE_INITIALIZED) || gnvol < 1) {
+    rprintf(t, "cache not ready/configured");
+    *status = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  CacheDirContentionTest *test = new CacheDirContentionTest(t, status, gvol[0]);
+  Vol *d = test->d;
+  EThread *thread = this_ethread();
+  int n = 65536;
+
+  MUTEX_TRY_LOCK(lock, d->mutex, thread);
+  ink_release_assert(lock.is_locked());
+  // Nothing else runs during an exclusive test, so the segment locks can be put in place for it.
+  if (!d->dir_seg_mutex) {
+    d->dir_seg_mutex = new Ptr<ProxyMutex>[d->segments];
+    for (int i = 0; i < d->segments; i++) {
+      d->dir_seg_mutex[i] = new_ProxyMutex();
+    }
+    test->own_seg_mutex = true;
+  }
+  test->keys = (CacheKey *)ats_malloc(n * sizeof(CacheKey));
+  while (test->nkeys < n) {
+    Dir dir, *last_collision = 0;
+    rand_CacheKey(&test->keys[test->nkeys], thread->mutex);
+    if (!dir_probe(&test->keys[test->nkeys], d, &dir, &last_collision)) {
+      test->nkeys++;
+    }
+  }
+  *status = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(test);
+}
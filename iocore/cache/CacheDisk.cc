@@ -29,6 +29,7 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
   path = ats_strdup(s);
   hw_sector_size = ahw_sector_size;
   fd = fildes;
+  numa_node = ink_numa_node_of_fd(fd);
   skip = askip;
   start = skip;
   /* we can't use fractions of store blocks. */
@@ -46,6 +46,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
   CacheVC *c = NULL;
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      CACHE_INCREMENT_DYN_STAT(cache_read_lock_miss_stat);
+      if (dir_probe_miss(key, vol)) {
+        CACHE_INCREMENT_DYN_STAT(cache_read_segment_miss_stat);
+        goto Lmiss;
+      }
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -110,6 +117,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
 
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      CACHE_INCREMENT_DYN_STAT(cache_read_lock_miss_stat);
+      if (dir_probe_miss(key, vol)) {
+        CACHE_INCREMENT_DYN_STAT(cache_read_segment_miss_stat);
+        goto Lmiss;
+      }
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
@@ -627,7 +627,144 @@ REGRESSION_TEST(ram_cache)(RegressionTest *t, int level, int *pstatus)
   for (int s = 20; s <= 28; s += 4) {
     int64_t cache_size = 1LL << s;
     *pstatus = REGRESSION_TEST_PASSED;
-    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size))
+    if (!test_RamCache(t, new_RamCacheLRU(), "LRU", cache_size) || !test_RamCache(t, new_RamCacheCLFUS(), "CLFUS", cache_size) ||
+        !test_RamCache(t, new_RamCacheTinyLFU(), "TinyLFU", cache_size))
+      *pstatus = REGRESSION_TEST_FAILED;
+  }
+}
+
+// Trace driven RAM cache simulator.
+//
+// Replays a request trace against each RAM cache implementation and reports
+// the hit ratio, byte hit ratio and cost per request. The trace is read from
+// the file named by TS_RAM_CACHE_TRACE, one "<key> <size>" request per line.
+// Without one, a zipf trace interrupted by a one time scan is synthesized.
+
+struct RamCacheTraceRequest {
+  INK_MD5 key;
+  int64_t size;
+};
+
+#define RAM_CACHE_TRACE_LENGTH (1 << 21)
+
+static bool
+load_RamCacheTrace(RegressionTest *t, const char *path, vector<RamCacheTraceRequest> &trace)
+{
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    rprintf(t, "unable to open RAM cache trace '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+  char line[1024];
+  char key[1024];
+  long long size;
+  while (fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "%1023s %lld", key, &size) != 2 || size <= 0)
+      continue;
+    RamCacheTraceRequest req;
+    MD5Context().hash_immediate(req.key, key, strlen(key));
+    req.size = MIN((int64_t)size, (int64_t)BUFFER_SIZE_FOR_INDEX(MAX_BUFFER_SIZE_INDEX));
+    trace.push_back(req);
+  }
+  fclose(fp);
+  return !trace.empty();
+}
+
+static void
+build_RamCacheTrace(vector<RamCacheTraceRequest> &trace)
+{
+  build_zipf();
+  srand48(13);
+  for (int i = 0; i < RAM_CACHE_TRACE_LENGTH; i++) {
+    // The third quarter of the trace is interleaved with a scan of objects that are never requested again.
+    int64_t k = (i >= RAM_CACHE_TRACE_LENGTH / 2 && i < RAM_CACHE_TRACE_LENGTH * 3 / 4 && (i & 1)) ? ZIPF_SIZE + i :
+                                                                                                      get_zipf(drand48());
+    RamCacheTraceRequest req;
+    req.key.u64[0] = ((uint64_t)k << 32) + k;
+    req.key.u64[1] = ((uint64_t)k << 32) + k;
+    req.size = BUFFER_SIZE_FOR_INDEX(BUFFER_SIZE_INDEX_8K + (k % 3));
+    trace.push_back(req);
+  }
+}
+
+static double
+replay_RamCacheTrace(RegressionTest *t, RamCache *cache, const char *name, int64_t cache_size, Vol *vol,
+                     const vector<RamCacheTraceRequest> &trace)
+{
+  Ptr<IOBufferData> data[DEFAULT_BUFFER_SIZES];
+  int64_t hits = 0, requests = 0, hit_bytes = 0, bytes = 0;
+
+  cache->init(cache_size, vol);
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (size_t i = 0; i < trace.size(); i++) {
+    const RamCacheTraceRequest &req = trace[i];
+    Ptr<IOBufferData> get_data;
+    bool hit = cache->get(const_cast<INK_MD5 *>(&req.key), &get_data) != 0;
+    if (!hit) {
+      // Objects of the same size class share one buffer, only the accounting matters here.
+      int64_t index = iobuffer_size_to_index(req.size, MAX_BUFFER_SIZE_INDEX);
+      if (!data[index]) {
+        IOBufferData *d = THREAD_ALLOC(ioDataAllocator, this_thread());
+        d->alloc(index);
+        data[index] = make_ptr(d);
+      }
+      cache->put(const_cast<INK_MD5 *>(&req.key), data[index], req.size);
+    }
+    if (i >= trace.size() / 2) { // Sample last half of the requests.
+      requests++;
+      bytes += req.size;
+      if (hit) {
+        hits++;
+        hit_bytes += req.size;
+      }
+    }
+  }
+  ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+
+  double hit_ratio = requests ? (double)hits / requests : 0.0;
+  double byte_hit_ratio = bytes ? (double)hit_bytes / bytes : 0.0;
+  rprintf(t, "RamCache %s Size %lld Hit Ratio %f Byte Hit Ratio %f ns/op %lld\n", name, cache_size, hit_ratio, byte_hit_ratio,
+          (long long)(elapsed / (ink_hrtime)trace.size()));
+  delete cache;
+  return hit_ratio;
+}
+
+REGRESSION_TEST(ram_cache_trace)(RegressionTest *t, int level, int *pstatus)
+{
+  if (REGRESSION_TEST_EXTENDED > level) {
+    *pstatus = REGRESSION_TEST_PASSED;
+    return;
+  }
+
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  vector<RamCacheTraceRequest> trace;
+  const char *path = getenv("TS_RAM_CACHE_TRACE");
+  if (path) {
+    if (!load_RamCacheTrace(t, path, trace)) {
+      *pstatus = REGRESSION_TEST_FAILED;
+      return;
+    }
+  } else {
+    build_RamCacheTrace(trace);
+  }
+  rprintf(t, "RamCache trace %s, %zu requests\n", path ? path : "zipf with scan", trace.size());
+
+  CacheKey key;
+  Vol *vol = theCache->key_to_vol(&key, "example.com", sizeof("example.com") - 1);
+
+  *pstatus = REGRESSION_TEST_PASSED;
+  for (int s = 20; s <= 28; s += 4) {
+    int64_t cache_size = 1LL << s;
+    double lru = replay_RamCacheTrace(t, new_RamCacheLRU(), "LRU", cache_size, vol, trace);
+    replay_RamCacheTrace(t, new_RamCacheCLFUS(), "CLFUS", cache_size, vol, trace);
+    double tinylfu = replay_RamCacheTrace(t, new_RamCacheTinyLFU(), "TinyLFU", cache_size, vol, trace);
+    // The synthetic trace is built so that a scan resistant policy must do at least as well as LRU.
+    if (!path && tinylfu < lru)
       *pstatus = REGRESSION_TEST_FAILED;
   }
 }
@@ -1619,6 +1619,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_ty
     return ACTION_RESULT_DONE;
   }
   if (res < 0) {
+    CACHE_INCREMENT_DYN_STAT(cache_write_lock_miss_stat);
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartBegin);
     c->trigger = CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
@@ -1744,6 +1745,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
       }
     }
     // missed lock
+    CACHE_INCREMENT_DYN_STAT(cache_write_lock_miss_stat);
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartDone);
     CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
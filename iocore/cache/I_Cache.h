@@ -43,6 +43,7 @@
 
 #define RAM_CACHE_ALGORITHM_CLFUS 0
 #define RAM_CACHE_ALGORITHM_LRU 1
+#define RAM_CACHE_ALGORITHM_TINYLFU 2
 
 #define CACHE_COMPRESSION_NONE 0
 #define CACHE_COMPRESSION_FASTLZ 1
@@ -53,6 +54,7 @@ enum { RAM_HIT_COMPRESS_NONE = 1, RAM_HIT_COMPRESS_FASTLZ, RAM_HIT_COMPRESS_LIBZ
 
 struct CacheVC;
 struct CacheDisk;
+struct Vol;
 #ifdef HTTP_CACHE
 class CacheLookupHttpConfig;
 class URL;
@@ -149,6 +151,9 @@ struct CacheProcessor : public Processor {
 
   void cacheInitialized();
 
+  /// Bring up a stripe that finished initializing after the cache was enabled.
+  void volOnline(Vol *vol);
+
   int
   waitForCache() const
   {
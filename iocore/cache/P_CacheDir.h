@@ -283,6 +283,7 @@ struct CacheSync : public Continuation {
 void vol_init_dir(Vol *d);
 int dir_token_probe(const CacheKey *, Vol *, Dir *);
 int dir_probe(const CacheKey *, Vol *, Dir *, Dir **);
+int dir_probe_miss(const CacheKey *key, Vol *d);
 int dir_insert(const CacheKey *key, Vol *d, Dir *to_part);
 int dir_overwrite(const CacheKey *key, Vol *d, Dir *to_part, Dir *overwrite, bool must_overwrite = true);
 int dir_delete(const CacheKey *key, Vol *d, Dir *del);
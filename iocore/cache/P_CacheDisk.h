@@ -90,6 +90,7 @@ struct CacheDisk : public Continuation {
   off_t num_usable_blocks;
   int hw_sector_size;
   int fd;
+  int numa_node; ///< Node nearest to the disk controller, -1 if unknown.
   off_t free_space;
   off_t wasted_space;
   DiskVol **disk_vols;
@@ -104,8 +105,8 @@ struct CacheDisk : public Continuation {
 
   CacheDisk()
     : Continuation(new_ProxyMutex()), header(NULL), path(NULL), header_len(0), len(0), start(0), skip(0), num_usable_blocks(0),
-      fd(-1), free_space(0), wasted_space(0), disk_vols(NULL), free_blocks(NULL), num_errors(0), cleared(0), read_only_p(false),
-      forced_volume_num(-1)
+      fd(-1), numa_node(-1), free_space(0), wasted_space(0), disk_vols(NULL), free_blocks(NULL), num_errors(0), cleared(0),
+      read_only_p(false), forced_volume_num(-1)
   {
   }
 
@@ -150,6 +150,13 @@ enum {
   cache_directory_sync_count_stat,
   cache_directory_sync_time_stat,
   cache_directory_sync_bytes_stat,
+  cache_recovery_pending_stat,
+  cache_recovery_count_stat,
+  cache_recovery_bytes_stat,
+  cache_recovery_time_stat,
+  cache_read_lock_miss_stat,
+  cache_read_segment_miss_stat,
+  cache_write_lock_miss_stat,
   cache_stat_count
 };
 
@@ -214,6 +221,8 @@ extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
 extern int cache_read_while_writer_retry_delay;
 extern int cache_config_read_while_writer_max_retries;
+extern int cache_config_recovery_early_serve;
+extern int cache_config_dir_segment_locks;
 
 // CacheVC
 struct CacheVC : public CacheVConnection {
@@ -985,7 +994,7 @@ struct Cache {
                int host_len);
   Action *deref(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len);
 
-  void vol_initialized(bool result);
+  void vol_initialized(Vol *vol, bool result);
 
   int open_done();
 
@@ -132,6 +132,7 @@ struct Vol : public Continuation {
   VolHeaderFooter *footer;
   int segments;
   off_t buckets;
+  Ptr<ProxyMutex> *dir_seg_mutex; ///< Per segment directory locks, @c NULL unless segment locking is enabled.
   off_t recover_pos;
   off_t prev_recover_pos;
   off_t scan_pos;
@@ -167,6 +168,7 @@ struct Vol : public Continuation {
   uint32_t last_write_serial;
   uint32_t sector_size;
   bool recover_wrapped;
+  bool init_done; ///< Directory has been read and recovered, the stripe can serve requests.
   bool dir_sync_waiting;
   bool dir_sync_in_progress;
   bool writing_end_marker;
@@ -175,6 +177,8 @@ struct Vol : public Continuation {
   int64_t first_fragment_offset;
   Ptr<IOBufferData> first_fragment_data;
 
+  ink_hrtime init_start; ///< When initialization of the stripe started, for the recovery stats.
+
   void cancel_trigger();
 
   int recover_data();
@@ -246,10 +250,10 @@ struct Vol : public Continuation {
   uint32_t round_to_approx_size(uint32_t l);
 
   Vol()
-    : Continuation(new_ProxyMutex()), path(NULL), fd(-1), dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0),
-      skip(0), start(0), len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
-      evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false), dir_sync_waiting(0),
-      dir_sync_in_progress(0), writing_end_marker(0)
+    : Continuation(new_ProxyMutex()), path(NULL), fd(-1), dir(0), buckets(0), dir_seg_mutex(NULL), recover_pos(0),
+      prev_recover_pos(0), scan_pos(0), skip(0), start(0), len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0),
+      agg_buf_pos(0), trigger(0), ram_cache(NULL), evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0),
+      recover_wrapped(false), init_done(false), dir_sync_waiting(0), dir_sync_in_progress(0), writing_end_marker(0), init_start(0)
   {
     open_dir.mutex = mutex;
     agg_buffer = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
@@ -257,7 +261,11 @@ struct Vol : public Continuation {
     SET_HANDLER(&Vol::aggWrite);
   }
 
-  ~Vol() { ats_memalign_free(agg_buffer); }
+  ~Vol()
+  {
+    ats_memalign_free(agg_buffer);
+    delete[] dir_seg_mutex;
+  }
 };
 
 struct AIO_Callback_handler : public Continuation {
@@ -0,0 +1,437 @@
+/** @file
+
+  W-TinyLFU RAM cache replacement policy.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// New objects enter a small window LRU. Objects leaving the window are only
+// admitted to the main cache, a segmented LRU (probation and protected), if
+// their estimated access frequency beats that of the object main would evict.
+// Frequencies are kept in a count-min sketch which is periodically halved, so
+// one pass over many cold objects (a crawler) can't flush the hot set.
+// See Einziger, Friedman and Manes, "TinyLFU: A Highly Efficient Cache
+// Admission Policy".
+
+#include "P_Cache.h"
+
+#define ENTRY_OVERHEAD 128      // per-entry overhead to consider when computing sizes
+#define WINDOW_PERCENT 1        // share of the cache given to the window LRU
+#define PROTECTED_PERCENT 80    // share of the main cache given to the protected segment
+#define SKETCH_DEPTH 4          // rows in the count-min sketch
+#define SKETCH_MAX_COUNT 15     // counters saturate here
+#define SKETCH_SAMPLE_FACTOR 10 // halve all counters after this many increments per counter
+
+enum { TINYLFU_WINDOW, TINYLFU_PROBATION, TINYLFU_PROTECTED };
+
+struct RamCacheTinyLFUEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t size;
+  uint32_t segment;
+  LINK(RamCacheTinyLFUEntry, lru_link);
+  LINK(RamCacheTinyLFUEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+// Count-min sketch of recent access frequencies.
+struct FrequencySketch {
+  uint8_t *table;
+  uint32_t width; // counters per row, a power of 2
+  int shift;
+  int64_t additions;
+  int64_t sample_size;
+
+  // Widen the rows to at least @a n counters. Growing by k bits turns old
+  // counter i into counters i << k .. (i << k) + 2^k - 1, which all start
+  // out with its value, so every estimate is unchanged by a resize.
+  void
+  resize(int64_t n)
+  {
+    int bits = 6;
+    while (bits < 30 && ((int64_t)1 << bits) < n)
+      bits++;
+    int grow = table ? shift - (32 - bits) : 0;
+    if (table && grow <= 0)
+      return;
+    uint32_t awidth = 1 << bits;
+    uint8_t *atable = (uint8_t *)ats_malloc(SKETCH_DEPTH * awidth);
+    if (table) {
+      for (int r = 0; r < SKETCH_DEPTH; r++)
+        for (uint32_t i = 0; i < awidth; i++)
+          atable[r * awidth + i] = table[r * width + (i >> grow)];
+      ats_free(table);
+    } else {
+      memset(atable, 0, SKETCH_DEPTH * awidth);
+    }
+    table = atable;
+    width = awidth;
+    shift = 32 - bits;
+    sample_size = (int64_t)SKETCH_SAMPLE_FACTOR * width;
+  }
+
+  uint8_t *
+  counter(const INK_MD5 *key, int row) const
+  {
+    static const uint32_t seed[SKETCH_DEPTH] = {0x9E3779B1, 0x85EBCA77, 0xC2B2AE3D, 0x27D4EB2F};
+    return &table[row * width + ((key->slice32(row) * seed[row]) >> shift)];
+  }
+
+  int
+  estimate(const INK_MD5 *key) const
+  {
+    int f = SKETCH_MAX_COUNT;
+    for (int r = 0; r < SKETCH_DEPTH; r++)
+      f = MIN(f, *counter(key, r));
+    return f;
+  }
+
+  void
+  increment(const INK_MD5 *key)
+  {
+    bool added = false;
+    for (int r = 0; r < SKETCH_DEPTH; r++) {
+      uint8_t *c = counter(key, r);
+      if (*c < SKETCH_MAX_COUNT) {
+        ++*c;
+        added = true;
+      }
+    }
+    if (added && ++additions >= sample_size) {
+      for (uint32_t i = 0; i < SKETCH_DEPTH * width; i++)
+        table[i] >>= 1;
+      additions /= 2;
+    }
+  }
+
+  FrequencySketch() : table(0), width(0), shift(0), additions(0), sample_size(0) {}
+  ~FrequencySketch() { ats_free(table); }
+};
+
+struct RamCacheTinyLFU : public RamCache {
+  int64_t max_bytes;
+  int64_t bytes;
+  int64_t objects;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(const INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+  int64_t size() const;
+
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  int64_t window_max;
+  int64_t protected_max;
+  int64_t segment_bytes[3];
+  Que(RamCacheTinyLFUEntry, lru_link) segment[3];
+  FrequencySketch sketch;
+  DList(RamCacheTinyLFUEntry, hash_link) * bucket;
+  int nbuckets;
+  int ibuckets;
+  Vol *vol;
+
+  void resize_hashtable();
+  void move(RamCacheTinyLFUEntry *e, int to);
+  void admit(RamCacheTinyLFUEntry *candidate);
+  RamCacheTinyLFUEntry *remove(RamCacheTinyLFUEntry *e);
+
+  int64_t
+  main_bytes() const
+  {
+    return segment_bytes[TINYLFU_PROBATION] + segment_bytes[TINYLFU_PROTECTED];
+  }
+
+  RamCacheTinyLFU()
+    : max_bytes(0), bytes(0), objects(0), window_max(0), protected_max(0), bucket(0), nbuckets(0), ibuckets(0), vol(NULL)
+  {
+    memset(segment_bytes, 0, sizeof(segment_bytes));
+  }
+};
+
+int64_t
+RamCacheTinyLFU::size() const
+{
+  int64_t s = 0;
+  for (int i = 0; i < 3; i++) {
+    forl_LL(RamCacheTinyLFUEntry, e, segment[i])
+    {
+      s += sizeof(*e);
+      s += sizeof(*e->data);
+      s += e->data->block_size();
+    }
+  }
+  return s;
+}
+
+ClassAllocator<RamCacheTinyLFUEntry> ramCacheTinyLFUEntryAllocator("RamCacheTinyLFUEntry");
+
+static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
+                                   32749,   65521,    131071,   262139,   524287,    1048573,   2097143,  4194301,
+                                   8388593, 16777213, 33554393, 67108859, 134217689, 268435399, 536870909};
+
+void
+RamCacheTinyLFU::resize_hashtable()
+{
+  int anbuckets = bucket_sizes[ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t s = anbuckets * sizeof(DList(RamCacheTinyLFUEntry, hash_link));
+  DList(RamCacheTinyLFUEntry, hash_link) *new_bucket = (DList(RamCacheTinyLFUEntry, hash_link) *)ats_malloc(s);
+  memset(new_bucket, 0, s);
+  if (bucket) {
+    for (int64_t i = 0; i < nbuckets; i++) {
+      RamCacheTinyLFUEntry *e = 0;
+      while ((e = bucket[i].pop()))
+        new_bucket[e->key.slice32(3) % anbuckets].push(e);
+    }
+    ats_free(bucket);
+  }
+  bucket = new_bucket;
+  nbuckets = anbuckets;
+  // Track roughly as many keys as the cache holds objects.
+  sketch.resize(anbuckets);
+}
+
+void
+RamCacheTinyLFU::init(int64_t abytes, Vol *avol)
+{
+  vol = avol;
+  max_bytes = abytes;
+  window_max = max_bytes * WINDOW_PERCENT / 100;
+  protected_max = (max_bytes - window_max) * PROTECTED_PERCENT / 100;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!max_bytes)
+    return;
+  resize_hashtable();
+}
+
+int
+RamCacheTinyLFU::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  sketch.increment(key);
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      move(e, e->segment == TINYLFU_WINDOW ? TINYLFU_WINDOW : TINYLFU_PROTECTED);
+      (*ret_data) = e->data;
+      DDebug("ram_cache", "get %X %d %d HIT", key->slice32(3), auxkey1, auxkey2);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+// Move @a e to the most recently used end of segment @a to, demoting from
+// protected to probation if protected grows over its share.
+void
+RamCacheTinyLFU::move(RamCacheTinyLFUEntry *e, int to)
+{
+  segment[e->segment].remove(e);
+  segment_bytes[e->segment] -= e->size;
+  e->segment = to;
+  segment[to].enqueue(e);
+  segment_bytes[to] += e->size;
+  while (segment_bytes[TINYLFU_PROTECTED] > protected_max) {
+    RamCacheTinyLFUEntry *d = segment[TINYLFU_PROTECTED].head;
+    if (d == e)
+      break;
+    segment[TINYLFU_PROTECTED].remove(d);
+    segment_bytes[TINYLFU_PROTECTED] -= d->size;
+    d->segment = TINYLFU_PROBATION;
+    segment[TINYLFU_PROBATION].enqueue(d);
+    segment_bytes[TINYLFU_PROBATION] += d->size;
+  }
+}
+
+RamCacheTinyLFUEntry *
+RamCacheTinyLFU::remove(RamCacheTinyLFUEntry *e)
+{
+  RamCacheTinyLFUEntry *ret = e->hash_link.next;
+  uint32_t b = e->key.slice32(3) % nbuckets;
+  bucket[b].remove(e);
+  segment[e->segment].remove(e);
+  segment_bytes[e->segment] -= e->size;
+  bytes -= e->size;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+  DDebug("ram_cache", "put %X %d %d FREED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheTinyLFUEntryAllocator, this_thread());
+  objects--;
+  return ret;
+}
+
+// @a candidate has left the window: keep it if it is used more often than
+// the object the main cache would give up for it.
+void
+RamCacheTinyLFU::admit(RamCacheTinyLFUEntry *candidate)
+{
+  int64_t main_max = max_bytes - window_max;
+  if (main_bytes() + candidate->size > main_max) {
+    RamCacheTinyLFUEntry *victim = segment[TINYLFU_PROBATION].head;
+    if (!victim)
+      victim = segment[TINYLFU_PROTECTED].head;
+    if (!victim || sketch.estimate(&candidate->key) <= sketch.estimate(&victim->key)) {
+      DDebug("ram_cache", "put %X %d %d REJECTED", candidate->key.slice32(3), candidate->auxkey1, candidate->auxkey2);
+      remove(candidate);
+      return;
+    }
+    while (main_bytes() + candidate->size > main_max) {
+      if (!(victim = segment[TINYLFU_PROBATION].head))
+        victim = segment[TINYLFU_PROTECTED].head;
+      remove(victim);
+    }
+  }
+  move(candidate, TINYLFU_PROBATION);
+}
+
+// ignore 'copy' since we don't touch the data
+int
+RamCacheTinyLFU::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        move(e, e->segment);
+        return 1;
+      } else { // discard when aux keys conflict
+        e = remove(e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  uint32_t size = ENTRY_OVERHEAD + data->block_size();
+  if (size > max_bytes - window_max) {
+    DDebug("ram_cache", "put %X %d %d len %d TOO LARGE", key->slice32(3), auxkey1, auxkey2, len);
+    return 0;
+  }
+  e = THREAD_ALLOC(ramCacheTinyLFUEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->size = size;
+  e->data = data;
+  e->segment = TINYLFU_WINDOW;
+  bucket[i].push(e);
+  segment[TINYLFU_WINDOW].enqueue(e);
+  segment_bytes[TINYLFU_WINDOW] += size;
+  bytes += size;
+  objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
+  DDebug("ram_cache", "put %X %d %d len %d INSERTED", key->slice32(3), auxkey1, auxkey2, len);
+  while (segment_bytes[TINYLFU_WINDOW] > window_max) {
+    RamCacheTinyLFUEntry *candidate = segment[TINYLFU_WINDOW].head;
+    admit(candidate);
+  }
+  if (objects > nbuckets) {
+    ++ibuckets;
+    resize_hashtable();
+  }
+  return 1;
+}
+
+int
+RamCacheTinyLFU::fixup(const INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1,
+                       uint32_t new_auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+RamCache *
+new_RamCacheTinyLFU()
+{
+  return new RamCacheTinyLFU;
+}
+
+#if TS_HAS_TESTS
+// Growing the hash table grows the sketch. Frequencies learned before must
+// survive that, or every resize would reset admission to a coin toss.
+REGRESSION_TEST(ram_cache_tinylfu_resize)(RegressionTest *t, int /* level ATS_UNUSED */, int *pstatus)
+{
+  const int nkeys = 1000;
+  INK_MD5 keys[nkeys];
+  int before[nkeys];
+
+  *pstatus = REGRESSION_TEST_PASSED;
+
+  FrequencySketch sketch;
+  sketch.resize(127);
+  for (int i = 0; i < nkeys; i++) {
+    keys[i].u64[0] = ((uint64_t)i << 32) + i;
+    keys[i].u64[1] = ((uint64_t)i << 32) + i;
+    for (int j = 0; j < i % 8; j++)
+      sketch.increment(&keys[i]);
+  }
+  for (int i = 0; i < nkeys; i++)
+    before[i] = sketch.estimate(&keys[i]);
+  sketch.resize(65521);
+  for (int i = 0; i < nkeys; i++) {
+    if (sketch.estimate(&keys[i]) != before[i]) {
+      rprintf(t, "key %d estimated %d after resize, %d before\n", i, sketch.estimate(&keys[i]), before[i]);
+      *pstatus = REGRESSION_TEST_FAILED;
+      return;
+    }
+  }
+
+  // The same through the cache: a key read often before the table grows still beats a cold one after.
+  RamCacheTinyLFU cache;
+  Ptr<IOBufferData> data = make_ptr(new_IOBufferData(BUFFER_SIZE_INDEX_4K));
+  cache.init(1 << 24, NULL);
+  INK_MD5 hot = keys[7], cold = keys[8];
+  Ptr<IOBufferData> got;
+  for (int j = 0; j < 10; j++)
+    cache.get(&hot, &got);
+  int hot_before = cache.sketch.estimate(&hot);
+  int nbuckets = cache.nbuckets;
+  for (int i = nkeys; cache.nbuckets == nbuckets; i++) {
+    INK_MD5 key;
+    key.u64[0] = key.u64[1] = ((uint64_t)i << 32) + i;
+    cache.put(&key, data, 4096);
+  }
+  rprintf(t, "hash table grew from %d to %d buckets, hot key estimated %d before and %d after\n", nbuckets, cache.nbuckets,
+          hot_before, cache.sketch.estimate(&hot));
+  if (cache.sketch.estimate(&hot) != hot_before || cache.sketch.estimate(&hot) <= cache.sketch.estimate(&cold))
+    *pstatus = REGRESSION_TEST_FAILED;
+}
+#endif
@@ -42,6 +42,9 @@ ink_event_system_init(ModuleVersion v)
 
   REC_EstablishStaticConfigInt32(thread_freelist_low_watermark, "proxy.config.allocator.thread_freelist_low_watermark");
 
+  REC_EstablishStaticConfigInt32(thread_work_stealing, "proxy.config.exec_thread.work_stealing");
+  REC_EstablishStaticConfigInt32(thread_stall_threshold, "proxy.config.exec_thread.stall_threshold");
+
   REC_ReadConfigInteger(config_max_iobuffer_size, "proxy.config.io.max_buffer_size");
 
   max_iobuffer_size = buffer_size_to_index(config_max_iobuffer_size, DEFAULT_BUFFER_SIZES - 1);
@@ -105,9 +105,8 @@ public:
   */
   ContinuationHandler handler;
 
-#ifdef DEBUG
+  /// Name of the current handler, as passed to SET_HANDLER.
   const char *handler_name;
-#endif
 
   /**
     The Continuation's lock.
@@ -170,11 +169,7 @@ public:
   @param _h Pointer to the function used to callback with events.
 
 */
-#ifdef DEBUG
 #define SET_HANDLER(_h) (handler = ((ContinuationHandler)_h), handler_name = #_h)
-#else
-#define SET_HANDLER(_h) (handler = ((ContinuationHandler)_h))
-#endif
 
 /**
   Sets a Continuation's handler.
@@ -185,18 +180,10 @@ public:
   @param _h Pointer to the function used to callback with events.
 
 */
-#ifdef DEBUG
 #define SET_CONTINUATION_HANDLER(_c, _h) (_c->handler = ((ContinuationHandler)_h), _c->handler_name = #_h)
-#else
-#define SET_CONTINUATION_HANDLER(_c, _h) (_c->handler = ((ContinuationHandler)_h))
-#endif
 
 inline Continuation::Continuation(ProxyMutex *amutex)
-  : handler(NULL),
-#ifdef DEBUG
-    handler_name(NULL),
-#endif
-    mutex(amutex)
+  : handler(NULL), handler_name(NULL), mutex(amutex)
 {
   // Pick up the control flags from the creating thread
   this->control_flags.set_flags(get_cont_flags().get_flags());
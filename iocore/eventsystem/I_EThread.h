@@ -27,6 +27,7 @@
 
 #include "ts/ink_platform.h"
 #include "ts/ink_rand.h"
+#include "ts/Histogram.h"
 #include "ts/I_Version.h"
 #include "I_Thread.h"
 #include "I_PriorityEventQueue.h"
@@ -300,6 +301,8 @@ public:
 
   int id;
   unsigned int event_types;
+  /// NUMA node this thread and its memory are bound to, -1 if none.
+  int numa_node;
   bool is_event_type(EventType et);
   void set_event_type(EventType et);
 
@@ -307,6 +310,9 @@ public:
 
   void execute();
   void process_event(Event *e, int calling_code);
+  void report_stall(const char *handler_name, Continuation *c, int calling_code, ink_hrtime run, ink_hrtime now);
+  void process_stealable_events();
+  int steal_events();
   void free_event(Event *e);
   void (*signal_hook)(EThread *);
 
@@ -321,6 +327,32 @@ public:
   Event *oneevent; // For dedicated event thread
 
   ServerSessionPool *server_session_pool;
+
+  /// Number of events this thread took from the queue of a busy peer.
+  volatile int64_t steal_count;
+
+  /** Event loop timing, in nanoseconds. Only written by this thread.
+      @c lag_histogram is how late events ran relative to @c timeout_at, 0 for immediate ones,
+      @c run_histogram is how long handlers ran and @c poll_histogram is time
+      spent waiting for I/O in the net poll.
+  */
+  Histogram lag_histogram;
+  Histogram run_histogram;
+  Histogram poll_histogram;
+
+  /// Number of handlers which ran longer than proxy.config.exec_thread.stall_threshold.
+  volatile int64_t stall_count;
+  ink_hrtime last_stall_warning;
+
+  /// Total time spent in the net poll, so it is not counted as handler run time.
+  ink_hrtime poll_wait;
+
+  void
+  record_poll_wait(ink_hrtime t)
+  {
+    poll_histogram.record(t);
+    poll_wait += t;
+  }
 };
 
 /**
@@ -312,4 +312,11 @@ public:
 
 extern inkcoreapi class EventProcessor eventProcessor;
 
+/// Allow idle event threads to run immediate events queued for a busy peer.
+extern int thread_work_stealing;
+/// Handler run time, in milliseconds, above which an event thread is reported as stalled (0 disables).
+extern int thread_stall_threshold;
+/// Number of NUMA nodes the event threads are spread over, 0 when NUMA mode is off.
+extern int thread_numa_nodes;
+
 #endif /*_EventProcessor_h_*/
@@ -39,6 +39,9 @@
 #include "I_Event.h"
 struct ProtectedQueue {
   void enqueue(Event *e, bool fast_signal = false);
+  void enqueue_stealable(Event *e, bool fast_signal = false); // May be run by an idle peer, see steal()
+  Event *dequeue_stealable();                                 // Safe when called from any thread
+  void requeue_stealable(Event *e);                           // Undo dequeue_stealable()
   void signal();
   int try_signal();             // Use non blocking lock and if acquired, signal
   void enqueue_local(Event *e); // Safe when called from the same thread
@@ -51,7 +54,16 @@ struct ProtectedQueue {
   ink_cond might_have_data;
   Que(Event, link) localQueue;
 
+  // Immediate events which are not bound to this thread. Unlike al they
+  // are taken one at a time, so a peer can share the backlog.
+  ink_mutex steal_lock;
+  Que(Event, link) stealQueue;
+  volatile int steal_depth;
+
   ProtectedQueue();
+
+private:
+  void signal_enqueued(EThread *e_ethread, bool fast_signal);
 };
 
 void flush_signals(EThread *t);
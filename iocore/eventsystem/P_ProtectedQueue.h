@@ -33,12 +33,13 @@
 #include "I_EventSystem.h"
 
 TS_INLINE
-ProtectedQueue::ProtectedQueue()
+ProtectedQueue::ProtectedQueue() : steal_depth(0)
 {
   Event e;
   ink_mutex_init(&lock, "ProtectedQueue");
   ink_atomiclist_init(&al, "ProtectedQueue", (char *)&e.link.next - (char *)&e);
   ink_cond_init(&might_have_data);
+  ink_mutex_init(&steal_lock, "ProtectedQueue.steal");
 }
 
 TS_INLINE void
@@ -81,6 +82,23 @@ ProtectedQueue::remove(Event *e)
   e->in_the_prot_queue = 0;
 }
 
+TS_INLINE Event *
+ProtectedQueue::dequeue_stealable()
+{
+  Event *e = NULL;
+  if (steal_depth) {
+    ink_mutex_acquire(&steal_lock);
+    if ((e = stealQueue.dequeue()))
+      steal_depth--;
+    ink_mutex_release(&steal_lock);
+  }
+  if (e) {
+    ink_assert(e->in_the_prot_queue);
+    e->in_the_prot_queue = 0;
+  }
+  return e;
+}
+
 TS_INLINE Event *
 ProtectedQueue::dequeue_local()
 {
@@ -77,7 +77,13 @@ EventProcessor::schedule(Event *e, EventType etype, bool fast_signal)
     e->mutex = e->continuation->mutex;
   else
     e->mutex = e->continuation->mutex = e->ethread->mutex;
-  e->ethread->EventQueueExternal.enqueue(e, fast_signal);
+  // Immediate events for a continuation with its own (non thread) mutex
+  // can run on any thread of the group, so let an idle peer steal them.
+  if (thread_work_stealing && !e->timeout_at && n_threads_for_type[etype] > 1 &&
+      e->mutex->nthread_holding >= 0)
+    e->ethread->EventQueueExternal.enqueue_stealable(e, fast_signal);
+  else
+    e->ethread->EventQueueExternal.enqueue(e, fast_signal);
   return e;
 }
 
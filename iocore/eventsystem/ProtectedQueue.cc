@@ -51,55 +51,96 @@ ProtectedQueue::enqueue(Event *e, bool fast_signal)
   e->in_the_prot_queue = 1;
   bool was_empty = (ink_atomiclist_push(&al, e) == NULL);
 
-  if (was_empty) {
-    EThread *inserting_thread = this_ethread();
-    // queue e->ethread in the list of threads to be signalled
-    // inserting_thread == 0 means it is not a regular EThread
-    if (inserting_thread != e_ethread) {
-      if (!inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
-        signal();
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
-      } else {
+  if (was_empty)
+    signal_enqueued(e_ethread, fast_signal);
+}
+
+// Put back an event taken with dequeue_stealable() which could not be run.
+// It goes ahead of the others so the events of one continuation stay in
+// the order they were scheduled in.
+void
+ProtectedQueue::requeue_stealable(Event *e)
+{
+  ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
+  EThread *e_ethread = e->ethread;
+  e->in_the_prot_queue = 1;
+  ink_mutex_acquire(&steal_lock);
+  bool was_empty = !steal_depth++;
+  stealQueue.push(e);
+  ink_mutex_release(&steal_lock);
+
+  // the owner may have seen the queue empty and gone to sleep meanwhile
+  if (was_empty)
+    signal_enqueued(e_ethread, false);
+}
+
+// Same as enqueue(), but the event is kept on stealQueue, from which an
+// idle thread of the same event type may take it, see EThread::steal_events().
+void
+ProtectedQueue::enqueue_stealable(Event *e, bool fast_signal)
+{
+  ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
+  EThread *e_ethread = e->ethread;
+  e->in_the_prot_queue = 1;
+  ink_mutex_acquire(&steal_lock);
+  bool was_empty = !steal_depth++;
+  stealQueue.enqueue(e);
+  ink_mutex_release(&steal_lock);
+
+  if (was_empty)
+    signal_enqueued(e_ethread, fast_signal);
+}
+
+void
+ProtectedQueue::signal_enqueued(EThread *e_ethread, bool fast_signal)
+{
+  EThread *inserting_thread = this_ethread();
+  // queue e->ethread in the list of threads to be signalled
+  // inserting_thread == 0 means it is not a regular EThread
+  if (inserting_thread != e_ethread) {
+    if (!inserting_thread || !inserting_thread->ethreads_to_be_signalled) {
+      signal();
+      if (fast_signal) {
+        if (e_ethread->signal_hook)
+          e_ethread->signal_hook(e_ethread);
+      }
+    } else {
 #ifdef EAGER_SIGNALLING
-        // Try to signal now and avoid deferred posting.
-        if (e_ethread->EventQueueExternal.try_signal())
-          return;
+      // Try to signal now and avoid deferred posting.
+      if (e_ethread->EventQueueExternal.try_signal())
+        return;
 #endif
-        if (fast_signal) {
-          if (e_ethread->signal_hook)
-            e_ethread->signal_hook(e_ethread);
-        }
-        int &t = inserting_thread->n_ethreads_to_be_signalled;
-        EThread **sig_e = inserting_thread->ethreads_to_be_signalled;
-        if ((t + 1) >= eventProcessor.n_ethreads) {
-          // we have run out of room
-          if ((t + 1) == eventProcessor.n_ethreads) {
-            // convert to direct map, put each ethread (sig_e[i]) into
-            // the direct map loation: sig_e[sig_e[i]->id]
-            for (int i = 0; i < t; i++) {
-              EThread *cur = sig_e[i]; // put this ethread
-              while (cur) {
-                EThread *next = sig_e[cur->id]; // into this location
-                if (next == cur)
-                  break;
-                sig_e[cur->id] = cur;
-                cur = next;
-              }
-              // if not overwritten
-              if (sig_e[i] && sig_e[i]->id != i)
-                sig_e[i] = 0;
+      if (fast_signal) {
+        if (e_ethread->signal_hook)
+          e_ethread->signal_hook(e_ethread);
+      }
+      int &t = inserting_thread->n_ethreads_to_be_signalled;
+      EThread **sig_e = inserting_thread->ethreads_to_be_signalled;
+      if ((t + 1) >= eventProcessor.n_ethreads) {
+        // we have run out of room
+        if ((t + 1) == eventProcessor.n_ethreads) {
+          // convert to direct map, put each ethread (sig_e[i]) into
+          // the direct map loation: sig_e[sig_e[i]->id]
+          for (int i = 0; i < t; i++) {
+            EThread *cur = sig_e[i]; // put this ethread
+            while (cur) {
+              EThread *next = sig_e[cur->id]; // into this location
+              if (next == cur)
+                break;
+              sig_e[cur->id] = cur;
+              cur = next;
             }
-            t++;
+            // if not overwritten
+            if (sig_e[i] && sig_e[i]->id != i)
+              sig_e[i] = 0;
           }
-          // we have a direct map, insert this EThread
-          sig_e[e_ethread->id] = e_ethread;
-        } else
-          // insert into vector
-          sig_e[t++] = e_ethread;
-      }
+          t++;
+        }
+        // we have a direct map, insert this EThread
+        sig_e[e_ethread->id] = e_ethread;
+      } else
+        // insert into vector
+        sig_e[t++] = e_ethread;
     }
   }
 }
@@ -143,7 +184,7 @@ ProtectedQueue::dequeue_timed(ink_hrtime cur_time, ink_hrtime timeout, bool slee
   Event *e;
   if (sleep) {
     ink_mutex_acquire(&lock);
-    if (INK_ATOMICLIST_EMPTY(al)) {
+    if (INK_ATOMICLIST_EMPTY(al) && !steal_depth) {
       timespec ts = ink_hrtime_to_timespec(timeout);
       ink_cond_timedwait(&might_have_data, &lock, &ts);
     }
@@ -38,20 +38,22 @@ struct AIOCallback;
 #define NO_HEARTBEAT -1
 #define THREAD_MAX_HEARTBEAT_MSECONDS 60
 #define NO_ETHREAD_ID -1
+#define THREAD_MAX_STEAL_BATCH 16
 
 bool shutdown_event_system = false;
 
 EThread::EThread()
   : generator((uint64_t)Thread::get_hrtime_updated() ^ (uint64_t)(uintptr_t)this), ethreads_to_be_signalled(NULL),
-    n_ethreads_to_be_signalled(0), main_accept_index(-1), id(NO_ETHREAD_ID), event_types(0), signal_hook(0), tt(REGULAR)
+    n_ethreads_to_be_signalled(0), main_accept_index(-1), id(NO_ETHREAD_ID), event_types(0), numa_node(-1), signal_hook(0),
+    tt(REGULAR), steal_count(0), stall_count(0), last_stall_warning(0), poll_wait(0)
 {
   memset(thread_private, 0, PER_THREAD_DATA);
 }
 
 EThread::EThread(ThreadType att, int anid)
   : generator((uint64_t)Thread::get_hrtime_updated() ^ (uint64_t)(uintptr_t)this), ethreads_to_be_signalled(NULL),
-    n_ethreads_to_be_signalled(0), main_accept_index(-1), id(anid), event_types(0), signal_hook(0), tt(att),
-    server_session_pool(NULL)
+    n_ethreads_to_be_signalled(0), main_accept_index(-1), id(anid), event_types(0), numa_node(-1), signal_hook(0), tt(att),
+    server_session_pool(NULL), steal_count(0), stall_count(0), last_stall_warning(0), poll_wait(0)
 {
   ethreads_to_be_signalled = (EThread **)ats_malloc(MAX_EVENT_THREADS * sizeof(EThread *));
   memset((char *)ethreads_to_be_signalled, 0, MAX_EVENT_THREADS * sizeof(EThread *));
@@ -83,7 +85,8 @@ EThread::EThread(ThreadType att, int anid)
 
 EThread::EThread(ThreadType att, Event *e)
   : generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t)this)), ethreads_to_be_signalled(NULL), n_ethreads_to_be_signalled(0),
-    main_accept_index(-1), id(NO_ETHREAD_ID), event_types(0), signal_hook(0), tt(att), oneevent(e)
+    main_accept_index(-1), id(NO_ETHREAD_ID), event_types(0), numa_node(-1), signal_hook(0), tt(att), oneevent(e),
+    steal_count(0), stall_count(0), last_stall_warning(0), poll_wait(0)
 {
   ink_assert(att == DEDICATED);
   memset(thread_private, 0, PER_THREAD_DATA);
@@ -126,10 +129,20 @@ EThread::process_event(Event *e, int calling_code)
       return;
     }
     Continuation *c_temp = e->continuation;
+    // the continuation may be gone once the handler returns
+    const char *handler_name = c_temp->handler_name;
+    ink_hrtime start = Thread::get_hrtime_updated();
+    ink_hrtime waited = poll_wait;
+    lag_histogram.record(e->timeout_at > 0 && start > e->timeout_at ? start - e->timeout_at : 0);
     e->continuation->handleEvent(calling_code, e);
     ink_assert(!e->in_the_priority_queue);
     ink_assert(c_temp == e->continuation);
     MUTEX_RELEASE(lock);
+    ink_hrtime end = Thread::get_hrtime_updated();
+    ink_hrtime run = end - start - (poll_wait - waited);
+    run_histogram.record(run > 0 ? run : 0);
+    if (thread_stall_threshold && run > HRTIME_MSECONDS(thread_stall_threshold))
+      report_stall(handler_name, c_temp, calling_code, run, end);
     if (e->period) {
       if (!e->in_the_prot_queue && !e->in_the_priority_queue) {
         if (e->period < 0)
@@ -147,6 +160,82 @@ EThread::process_event(Event *e, int calling_code)
   }
 }
 
+// A handler ran longer than proxy.config.exec_thread.stall_threshold, which
+// usually means it blocked the thread. Warnings are limited to one a second per
+// thread, stall_count has the full number.
+void
+EThread::report_stall(const char *handler_name, Continuation *c, int calling_code, ink_hrtime run, ink_hrtime now)
+{
+  ink_atomic_increment(&stall_count, 1);
+  if (now - last_stall_warning < HRTIME_SECOND)
+    return;
+  last_stall_warning = now;
+  Warning("event thread %d stalled for %" PRId64 " ms in handler %s (continuation %p, event %d)", id, ink_hrtime_to_msec(run),
+          handler_name ? handler_name : "<unknown>", c, calling_code);
+}
+
+// Run the stealable events queued so far. They are taken one at a time so
+// an idle peer can share the work while this thread is busy; later arrivals
+// wait for the next pass.
+void
+EThread::process_stealable_events()
+{
+  Event *e;
+  for (int n = EventQueueExternal.steal_depth; n > 0 && (e = EventQueueExternal.dequeue_stealable()); n--) {
+    if (e->cancelled)
+      free_event(e);
+    else
+      process_event(e, e->callback_event);
+  }
+}
+
+// Take immediate events from the busiest peer sharing an event type with
+// this thread. Only called when this thread has nothing of its own to do.
+// An event whose mutex is held elsewhere is handed back to its owner, at
+// the head of its queue so it still runs before the events queued after
+// it. Returns the number of events run.
+int
+EThread::steal_events()
+{
+  EThread *victim = NULL;
+  int depth = 0;
+
+  for (int et = 0; et < eventProcessor.n_thread_groups; et++) {
+    if (!is_event_type((EventType)et))
+      continue;
+    for (int i = 0; i < eventProcessor.n_threads_for_type[et]; i++) {
+      EThread *t = eventProcessor.eventthread[et][i];
+      // never pull work, and the memory it touches, across NUMA nodes
+      if (t != this && (!thread_numa_nodes || t->numa_node == numa_node) && t->EventQueueExternal.steal_depth > depth) {
+        victim = t;
+        depth = t->EventQueueExternal.steal_depth;
+      }
+    }
+  }
+  if (!victim)
+    return 0;
+
+  // leave the owner at least half of its backlog
+  int n = 0, todo = MIN((depth + 1) / 2, THREAD_MAX_STEAL_BATCH);
+  Event *e;
+  while (n < todo && (e = victim->EventQueueExternal.dequeue_stealable())) {
+    if (e->cancelled) {
+      free_event(e);
+      continue;
+    }
+    MUTEX_TRY_LOCK_FOR(lock, e->mutex.m_ptr, this, e->continuation);
+    if (!lock.is_locked()) {
+      victim->EventQueueExternal.requeue_stealable(e);
+      break;
+    }
+    e->ethread = this;
+    ink_atomic_increment(&steal_count, 1);
+    process_event(e, e->callback_event);
+    n++;
+  }
+  return n;
+}
+
 //
 // void  EThread::execute()
 //
@@ -161,6 +250,12 @@ EThread::process_event(Event *e, int calling_code)
 void
 EThread::execute()
 {
+  // EventProcessor::start() binds our CPUs inside the node, per proxy.config.exec_thread.affinity.
+  if (numa_node >= 0) {
+    ink_numa_bind_thread_memory(numa_node);
+    ink_freelist_set_thread_node(numa_node);
+  }
+
   switch (tt) {
   case REGULAR: {
     Event *e;
@@ -196,6 +291,7 @@ EThread::execute()
             NegativeQueue.insert(e, p);
         }
       }
+      process_stealable_events();
       bool done_one;
       do {
         done_one = false;
@@ -221,6 +317,8 @@ EThread::execute()
         // do a cond_timedwait.
         if (!INK_ATOMICLIST_EMPTY(EventQueueExternal.al))
           EventQueueExternal.dequeue_timed(cur_time, next_time, false);
+        else if (thread_work_stealing && !EventQueueExternal.steal_depth)
+          steal_events();
         while ((e = EventQueueExternal.dequeue_local())) {
           if (!e->timeout_at)
             process_event(e, e->callback_event);
@@ -251,6 +349,7 @@ EThread::execute()
             }
           }
         }
+        process_stealable_events();
         // execute poll events
         while ((e = NegativeQueue.dequeue()))
           process_event(e, EVENT_POLL);
@@ -268,7 +367,10 @@ EThread::execute()
         // cond_timedwait.
         if (n_ethreads_to_be_signalled)
           flush_signals(this);
-        EventQueueExternal.dequeue_timed(cur_time, next_time, true);
+        // an idle thread helps a busy peer before going to sleep
+        bool sleep = !thread_work_stealing || !INK_ATOMICLIST_EMPTY(EventQueueExternal.al) ||
+                     EventQueueExternal.steal_depth || !steal_events();
+        EventQueueExternal.dequeue_timed(cur_time, next_time, sleep);
       }
     }
   }
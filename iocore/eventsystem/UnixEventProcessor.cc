@@ -31,6 +31,19 @@
 #endif
 #include "ts/ink_defs.h"
 
+#if TS_USE_HWLOC
+// The @a n th object of @a type inside NUMA node @a node, or the node itself if it has none.
+static hwloc_obj_t
+numa_local_obj(hwloc_obj_type_t type, int node, int n)
+{
+  hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, node);
+  if (!obj || type == HWLOC_OBJ_NODE)
+    return obj;
+  int count = hwloc_get_nbobjs_inside_cpuset_by_type(ink_get_topology(), obj->cpuset, type);
+  return count > 0 ? hwloc_get_obj_inside_cpuset_by_type(ink_get_topology(), obj->cpuset, type, n % count) : obj;
+}
+#endif
+
 EventType
 EventProcessor::spawn_event_threads(int n_threads, const char *et_name, size_t stacksize)
 {
@@ -49,12 +62,23 @@ EventProcessor::spawn_event_threads(int n_threads, const char *et_name, size_t s
     all_ethreads[n_ethreads + i] = t;
     eventthread[new_thread_group_id][i] = t;
     t->set_event_type(new_thread_group_id);
+    if (thread_numa_nodes)
+      t->numa_node = i % thread_numa_nodes;
   }
 
   n_threads_for_type[new_thread_group_id] = n_threads;
   for (i = 0; i < n_threads; i++) {
     snprintf(thr_name, MAX_THREAD_NAME_LENGTH, "[%s %d]", et_name, i);
-    eventthread[new_thread_group_id][i]->start(thr_name, stacksize);
+    ink_thread tid = eventthread[new_thread_group_id][i]->start(thr_name, stacksize);
+#if TS_USE_HWLOC
+    if (thread_numa_nodes) {
+      hwloc_obj_t obj = numa_local_obj(HWLOC_OBJ_NODE, eventthread[new_thread_group_id][i]->numa_node, 0);
+      if (obj)
+        hwloc_set_thread_cpubind(ink_get_topology(), tid, obj->cpuset, HWLOC_CPUBIND_STRICT);
+    }
+#else
+    (void)tid;
+#endif
   }
 
   n_thread_groups++;
@@ -65,6 +89,9 @@ EventProcessor::spawn_event_threads(int n_threads, const char *et_name, size_t s
 }
 
 class EventProcessor eventProcessor;
+int thread_work_stealing = 0;
+int thread_stall_threshold = 0;
+int thread_numa_nodes = 0;
 
 int
 EventProcessor::start(int n_event_threads, size_t stacksize)
@@ -95,9 +122,31 @@ EventProcessor::start(int n_event_threads, size_t stacksize)
   }
   n_threads_for_type[ET_CALL] = n_event_threads;
 
+  // In NUMA mode each event thread is bound to a node, and takes its memory and freelists from there.
+  int numa = 0;
+  REC_ReadConfigInteger(numa, "proxy.config.exec_thread.numa");
+  if (numa) {
+    int n_nodes = ink_number_of_numa_nodes();
+    if (n_nodes > 1) {
+      thread_numa_nodes = n_nodes;
+      ink_freelists_numa_init(n_nodes);
+      for (i = 0; i < n_event_threads; i++)
+        all_ethreads[i]->numa_node = i % n_nodes;
+      Note("NUMA mode enabled, %d event threads over %d nodes", n_event_threads, n_nodes);
+    } else {
+      Warning("proxy.config.exec_thread.numa is set but %d NUMA node(s) were found, NUMA mode disabled", n_nodes);
+    }
+  }
+
 #if TS_USE_HWLOC
   int affinity = 1;
   REC_ReadConfigInteger(affinity, "proxy.config.exec_thread.affinity");
+  // In NUMA mode a thread has to stay on its node. Cores and processing units are picked inside it,
+  // anything wider than a node is narrowed to the node.
+  if (thread_numa_nodes && affinity != 1 && affinity != 3 && affinity != 4) {
+    Warning("proxy.config.exec_thread.affinity %d is wider than a NUMA node, binding threads to NUMA nodes instead", affinity);
+    affinity = 1;
+  }
   hwloc_obj_t obj;
   hwloc_obj_type_t obj_type;
   int obj_count = 0;
@@ -144,7 +193,10 @@ EventProcessor::start(int n_event_threads, size_t stacksize)
     }
 #if TS_USE_HWLOC
     if (obj_count > 0) {
-      obj = hwloc_get_obj_by_type(ink_get_topology(), obj_type, i % obj_count);
+      if (thread_numa_nodes)
+        obj = numa_local_obj(obj_type, all_ethreads[i]->numa_node, i / thread_numa_nodes);
+      else
+        obj = hwloc_get_obj_by_type(ink_get_topology(), obj_type, i % obj_count);
 #if HWLOC_API_VERSION >= 0x00010100
       int cpu_mask_len = hwloc_bitmap_snprintf(NULL, 0, obj->cpuset) + 1;
       char *cpu_mask = (char *)alloca(cpu_mask_len);
@@ -234,6 +234,12 @@ Server::setup_fd_for_listen(bool non_blocking, int recv_bufsize, int send_bufsiz
     goto Lerror;
   }
 
+#ifdef SO_REUSEPORT
+  if (f_reuseport && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0) {
+    goto Lerror;
+  }
+#endif
+
   if ((sockopt_flag_in & NetVCOptions::SOCK_OPT_NO_DELAY) &&
       (res = safe_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, SOCKOPT_ON, sizeof(int))) < 0) {
     goto Lerror;
@@ -292,6 +298,18 @@ Lerror:
   return res;
 }
 
+bool
+Server::reuseport() const
+{
+#ifdef SO_REUSEPORT
+  int on = 0;
+  int len = sizeof(on);
+  if (fd != NO_FD && safe_getsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char *)&on, &len) == 0)
+    return on != 0;
+#endif
+  return false;
+}
+
 int
 Server::listen(bool non_blocking, int recv_bufsize, int send_bufsize, bool transparent)
 {
@@ -134,6 +134,8 @@ struct NetVCOptions {
   bool f_blocking;
   /// Make socket block on connect (default: @c false)
   bool f_blocking_connect;
+  /// Offer HTTP/2 with ALPN on an outbound TLS connection (default: @c false)
+  bool f_offer_http2;
 
   /// Control use of SOCKS.
   /// Set to @c NO_SOCKS to disable use of SOCKS. Otherwise SOCKS is
@@ -468,6 +470,23 @@ public:
    */
   virtual void trapWriteBufferEmpty(int event = VC_EVENT_WRITE_READY);
 
+  /** Pair this connection with @a peer so that data read from either one is
+      moved to the other's socket inside the kernel, without passing through
+      the read VIO buffer. The VIOs still account for the bytes and signal as
+      usual, data already in a write buffer is sent first.
+
+      Only useful when nothing needs to look at the payload.
+
+      @return @c true if the connections were paired, @c false if either one
+      does not support it (the buffered path is used).
+   */
+  virtual bool
+  splice_with(NetVConnection *peer)
+  {
+    (void)peer;
+    return false;
+  }
+
   /** Returns local sockaddr storage. */
   sockaddr const *get_local_addr();
 
@@ -135,6 +135,121 @@ register_net_stats()
   NET_CLEAR_DYN_STAT(default_inactivity_timeout_stat);
 }
 
+// Event loop statistics are kept by the event threads, they are registered
+// here because the records raw stats are not available to every user of
+// the event system.
+
+enum EventLoopHistogram { EVENTLOOP_LAG, EVENTLOOP_RUN, EVENTLOOP_POLL, EVENTLOOP_N_HISTOGRAMS };
+enum EventLoopHistogramValue { EVENTLOOP_COUNT, EVENTLOOP_P50, EVENTLOOP_P90, EVENTLOOP_P99, EVENTLOOP_MAX, EVENTLOOP_N_VALUES };
+
+static const char *const eventloop_histogram_name[EVENTLOOP_N_HISTOGRAMS] = {"lag", "run", "poll"};
+static const char *const eventloop_value_name[EVENTLOOP_N_VALUES] = {"count", "p50", "p90", "p99", "max"};
+
+// Stat ids: the two totals, then the histogram values, then a
+// (queue depth, steal count) pair per ET_NET thread if work stealing is on.
+enum {
+  EVENTLOOP_STAT_STEAL_COUNT,
+  EVENTLOOP_STAT_STALL_COUNT,
+  EVENTLOOP_STAT_HISTOGRAM,
+  EVENTLOOP_STAT_THREAD = EVENTLOOP_STAT_HISTOGRAM + EVENTLOOP_N_HISTOGRAMS * EVENTLOOP_N_VALUES
+};
+
+static Histogram *
+eventloop_histogram(EThread *t, int h)
+{
+  switch (h) {
+  case EVENTLOOP_LAG:
+    return &t->lag_histogram;
+  case EVENTLOOP_RUN:
+    return &t->run_histogram;
+  default:
+    return &t->poll_histogram;
+  }
+}
+
+static int
+eventloop_stats_cb(const char * /* name ATS_UNUSED */, RecDataT /* data_type ATS_UNUSED */, RecData *data,
+                   RecRawStatBlock * /* rsb ATS_UNUSED */, int id)
+{
+  // The thread histograms are merged when the count is synced, the other
+  // values of that histogram are registered after it and reuse the result.
+  // The threads never reset their histograms, so the totals of the previous
+  // sync are taken out again to report on the last interval only.
+  static Histogram merged[EVENTLOOP_N_HISTOGRAMS];
+  static Histogram previous[EVENTLOOP_N_HISTOGRAMS];
+  static Histogram total;
+  int64_t sum = 0;
+
+  if (id == EVENTLOOP_STAT_STEAL_COUNT) {
+    for (int i = 0; i < eventProcessor.n_threads_for_type[ET_NET]; i++)
+      sum += eventProcessor.eventthread[ET_NET][i]->steal_count;
+    data->rec_int = sum;
+  } else if (id == EVENTLOOP_STAT_STALL_COUNT) {
+    for (int i = 0; i < eventProcessor.n_ethreads; i++)
+      sum += eventProcessor.all_ethreads[i]->stall_count;
+    data->rec_int = sum;
+  } else if (id < EVENTLOOP_STAT_THREAD) {
+    int h = (id - EVENTLOOP_STAT_HISTOGRAM) / EVENTLOOP_N_VALUES;
+    Histogram &m = merged[h];
+    switch ((id - EVENTLOOP_STAT_HISTOGRAM) % EVENTLOOP_N_VALUES) {
+    case EVENTLOOP_COUNT:
+      total.reset();
+      for (int i = 0; i < eventProcessor.n_ethreads; i++)
+        total.merge(*eventloop_histogram(eventProcessor.all_ethreads[i], h));
+      m = total;
+      m.subtract(previous[h]);
+      previous[h] = total;
+      data->rec_int = m.count();
+      break;
+    case EVENTLOOP_P50:
+      data->rec_int = m.percentile(50) / HRTIME_USECOND;
+      break;
+    case EVENTLOOP_P90:
+      data->rec_int = m.percentile(90) / HRTIME_USECOND;
+      break;
+    case EVENTLOOP_P99:
+      data->rec_int = m.percentile(99) / HRTIME_USECOND;
+      break;
+    default:
+      data->rec_int = m.max() / HRTIME_USECOND;
+      break;
+    }
+  } else {
+    EThread *t = eventProcessor.eventthread[ET_NET][(id - EVENTLOOP_STAT_THREAD) / 2];
+    data->rec_int = (id - EVENTLOOP_STAT_THREAD) % 2 ? t->steal_count : t->EventQueueExternal.steal_depth;
+  }
+  return 0;
+}
+
+void
+register_eventloop_stats(int n_threads)
+{
+  char name[64];
+  int n_stats = EVENTLOOP_STAT_THREAD + (thread_work_stealing ? 2 * n_threads : 0);
+  RecRawStatBlock *rsb = RecAllocateRawStatBlock(n_stats);
+
+  RecRegisterRawStat(rsb, RECT_PROCESS, "proxy.process.eventloop.steal_count", RECD_INT, RECP_NON_PERSISTENT,
+                     EVENTLOOP_STAT_STEAL_COUNT, eventloop_stats_cb);
+  RecRegisterRawStat(rsb, RECT_PROCESS, "proxy.process.eventloop.stall_count", RECD_INT, RECP_NON_PERSISTENT,
+                     EVENTLOOP_STAT_STALL_COUNT, eventloop_stats_cb);
+  for (int h = 0; h < EVENTLOOP_N_HISTOGRAMS; h++) {
+    for (int v = 0; v < EVENTLOOP_N_VALUES; v++) {
+      snprintf(name, sizeof(name), "proxy.process.eventloop.%s.%s", eventloop_histogram_name[h], eventloop_value_name[v]);
+      RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT,
+                         EVENTLOOP_STAT_HISTOGRAM + h * EVENTLOOP_N_VALUES + v, eventloop_stats_cb);
+    }
+  }
+  if (!thread_work_stealing)
+    return;
+  for (int i = 0; i < n_threads; i++) {
+    snprintf(name, sizeof(name), "proxy.process.eventloop.thread.%d.queue_depth", i);
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, EVENTLOOP_STAT_THREAD + 2 * i, eventloop_stats_cb);
+    snprintf(name, sizeof(name), "proxy.process.eventloop.thread.%d.steal_count", i);
+    RecRegisterRawStat(rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, EVENTLOOP_STAT_THREAD + 2 * i + 1,
+                       eventloop_stats_cb);
+  }
+}
+
 void
 ink_net_init(ModuleVersion version)
 {
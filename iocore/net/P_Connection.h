@@ -167,6 +167,9 @@ struct Server : public Connection {
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// If set, the listen socket is opened with @c SO_REUSEPORT so other sockets can bind the same address.
+  bool f_reuseport;
+
   //
   // Use this call for the main proxy accept
   //
@@ -185,7 +188,10 @@ struct Server : public Connection {
                           bool transparent = false ///< Inbound transparent.
                           );
 
-  Server() : Connection(), f_inbound_transparent(false) { ink_zero(accept_addr); }
+  /// Whether the listen socket has @c SO_REUSEPORT set, e.g. on a socket inherited from traffic_manager.
+  bool reuseport() const;
+
+  Server() : Connection(), f_inbound_transparent(false), f_reuseport(false) { ink_zero(accept_addr); }
 };
 
 #endif /*_Connection_h*/
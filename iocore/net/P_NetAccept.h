@@ -95,6 +95,8 @@ struct NetAccept : public Continuation {
   EventType etype;
   UnixNetVConnection *epoll_vc; // only storage for epoll events
   EventIO ep;
+  int reuseport;   ///< proxy.config.net.listen_reuseport for per thread accepts.
+  bool private_fd; ///< server.fd is a per thread @c SO_REUSEPORT socket owned by this clone.
 
   virtual EventType getEtype() const;
   virtual NetProcessor *getNetProcessor() const;
@@ -105,6 +107,9 @@ struct NetAccept : public Continuation {
   virtual NetAccept *clone() const;
   // 0 == success
   int do_listen(bool non_blocking, bool transparent = false);
+  bool listen_per_thread(NetAccept *a, bool transparent);
+  void attach_reuseport_steering(EThread **threads, int n);
+  void set_accept_sockopts(int fd);
 
   int do_blocking_accept(EThread *t);
   virtual int acceptEvent(int event, void *e);
@@ -40,4 +40,7 @@ SSL_CTX *SSLInitClientContext(const struct SSLConfigParams *param);
 // Returns the index used to store our data on the SSL
 int get_ssl_client_data_index();
 
+// Offer HTTP/2 and HTTP/1.1 to the origin server with ALPN.
+void SSLClientOfferHttp2(SSL *ssl);
+
 #endif /* IOCORE_NET_P_SSLCLIENTUTILS_H_ */
@@ -147,6 +147,9 @@ public:
     return npnEndpoint;
   }
 
+  // The protocol the origin server selected with ALPN, TS_NPN_PROTOCOL_HTTP_2_0 or TS_NPN_PROTOCOL_HTTP_1_1, or NULL.
+  const char *getSelectedProtocol() const;
+
   bool
   getSSLClientRenegotiationAbort() const
   {
@@ -75,6 +75,7 @@ extern UnixNetProcessor unix_netProcessor;
 // accept such events by the EventProcesor.
 //
 extern void initialize_thread_for_net(EThread *thread);
+extern void register_eventloop_stats(int n_threads);
 
 //#include "UnixNet.h"
 #endif
@@ -51,6 +51,7 @@ NetVCOptions::reset()
   addr_binding = ANY_ADDR;
   f_blocking = false;
   f_blocking_connect = false;
+  f_offer_http2 = false;
   socks_support = NORMAL_SOCKS;
   socks_version = SOCKS_DEFAULT_VERSION;
   socket_recv_bufsize =
@@ -105,6 +106,9 @@ public:
 
   virtual bool get_data(int id, void *data);
 
+  virtual bool splice_with(NetVConnection *peer);
+  void splice_close();
+
   virtual Action *send_OOB(Continuation *cont, char *buf, int len);
   virtual void cancel_OOB();
 
@@ -274,6 +278,16 @@ public:
   const sockaddr *origin_trace_addr;
   int origin_trace_port;
 
+  /// Connection paired by splice_with(). Bytes read here go into its
+  /// splice_pipe, bytes in our splice_pipe are written to our socket.
+  UnixNetVConnection *splice_peer;
+  int splice_pipe[2];
+  int64_t splice_pipe_size;
+  int64_t splice_pending; ///< Bytes in splice_pipe not yet written to our socket.
+  int64_t splice_done;    ///< Bytes we read that the peer has written out but read.vio does not count yet.
+  bool splice_eof;        ///< Our socket hit EOS or an error, held back until the peer has written our bytes.
+  int splice_errno;       ///< The error for splice_eof, 0 for EOS.
+
   int startEvent(int event, Event *e);
   int acceptEvent(int event, Event *e);
   int mainEvent(int event, Event *e);
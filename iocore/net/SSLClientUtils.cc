@@ -43,6 +43,21 @@ get_ssl_client_data_index()
   return ssl_client_data_index;
 }
 
+void
+SSLClientOfferHttp2(SSL *ssl)
+{
+#if TS_USE_TLS_ALPN
+  // [RFC 7301] 3.1. The protocol names are length prefixed, in order of preference.
+  static const unsigned char protocols[] = "\x02h2\x08http/1.1";
+
+  if (SSL_set_alpn_protos(ssl, protocols, sizeof(protocols) - 1) != 0) {
+    Debug("ssl.error", "failed to offer HTTP/2 with ALPN");
+  }
+#else
+  (void)ssl;
+#endif
+}
+
 int
 verify_callback(int preverify_ok, X509_STORE_CTX *ctx)
 {
@@ -43,6 +43,7 @@ void
 SSLNetAccept::init_accept_per_thread(bool isTransparent)
 {
   int i, n;
+  int n_private = 0;
   NetAccept *a;
 
   if (do_listen(NON_BLOCKING, isTransparent))
@@ -54,18 +55,22 @@ SSLNetAccept::init_accept_per_thread(bool isTransparent)
   period = -HRTIME_MSECONDS(net_accept_period);
   n = eventProcessor.n_threads_for_type[SSLNetProcessor::ET_SSL];
   for (i = 0; i < n; i++) {
-    if (i < n - 1)
+    if (i < n - 1) {
       a = clone();
-    else
+      if (reuseport && listen_per_thread(a, isTransparent))
+        n_private++;
+    } else
       a = this;
     EThread *t = eventProcessor.eventthread[SSLNetProcessor::ET_SSL][i];
 
     PollDescriptor *pd = get_PollDescriptor(t);
-    if (ep.start(pd, this, EVENTIO_READ) < 0)
+    if (a->ep.start(pd, a, EVENTIO_READ) < 0)
       Debug("iocore_net", "error starting EventIO");
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, etype);
   }
+  if (reuseport > 1 && n > 1 && n_private == n - 1)
+    attach_reuseport_steering(eventProcessor.eventthread[SSLNetProcessor::ET_SSL], n);
 }
 
 NetAccept *
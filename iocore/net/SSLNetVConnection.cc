@@ -26,6 +26,7 @@
 #include "P_Net.h"
 #include "P_SSLNextProtocolSet.h"
 #include "P_SSLUtils.h"
+#include "P_SSLClientUtils.h"
 #include "InkAPIInternal.h" // Added to include the ssl_hook definitions
 #include "P_SSLConfig.h"
 #include "Log.h"
@@ -996,6 +997,9 @@ SSLNetVConnection::sslStartHandShake(int event, int &err)
   case SSL_EVENT_CLIENT:
     if (this->ssl == NULL) {
       this->ssl = make_ssl_connection(ssl_NetProcessor.client_ctx, this);
+      if (this->ssl != NULL && options.f_offer_http2) {
+        SSLClientOfferHttp2(this->ssl);
+      }
     }
 
     if (this->ssl == NULL) {
@@ -1338,6 +1342,26 @@ SSLNetVConnection::registerNextProtocolSet(const SSLNextProtocolSet *s)
   this->npnSet = s;
 }
 
+const char *
+SSLNetVConnection::getSelectedProtocol() const
+{
+#if TS_USE_TLS_ALPN
+  const unsigned char *proto = NULL;
+  unsigned len = 0;
+
+  if (this->ssl) {
+    SSL_get0_alpn_selected(this->ssl, &proto, &len);
+  }
+  if (len == strlen(TS_NPN_PROTOCOL_HTTP_2_0) && memcmp(proto, TS_NPN_PROTOCOL_HTTP_2_0, len) == 0) {
+    return TS_NPN_PROTOCOL_HTTP_2_0;
+  }
+  if (len == strlen(TS_NPN_PROTOCOL_HTTP_1_1) && memcmp(proto, TS_NPN_PROTOCOL_HTTP_1_1, len) == 0) {
+    return TS_NPN_PROTOCOL_HTTP_1_1;
+  }
+#endif /* TS_USE_TLS_ALPN */
+  return NULL;
+}
+
 // NextProtocolNegotiation TLS extension callback. The NPN extension
 // allows the client to select a preferred protocol, so all we have
 // to do here is tell them what out protocol set is.
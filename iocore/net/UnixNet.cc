@@ -417,6 +417,7 @@ NetHandler::mainNetEvent(int event, Event *e)
 
   PollDescriptor *pd = get_PollDescriptor(trigger_event->ethread);
   UnixNetVConnection *vc = NULL;
+  ink_hrtime poll_start = Thread::get_hrtime_updated();
 #if TS_USE_EPOLL
   pd->result = epoll_wait(pd->epoll_fd, pd->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
   NetDebug("iocore_net_main_poll", "[NetHandler::mainNetEvent] epoll_wait(%d,%d), result=%d", pd->epoll_fd, poll_timeout,
@@ -457,6 +458,7 @@ NetHandler::mainNetEvent(int event, Event *e)
 #else
 #error port me
 #endif
+  trigger_event->ethread->record_poll_wait(Thread::get_hrtime_updated() - poll_start);
 
   vc = NULL;
   for (int x = 0; x < pd->result; x++) {
@@ -22,6 +22,9 @@
  */
 
 #include "P_Net.h"
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+#include <linux/filter.h>
+#endif
 
 #ifdef ROUNDUP
 #undef ROUNDUP
@@ -185,11 +188,14 @@ NetAccept::init_accept_per_thread(bool isTransparent)
   period = -HRTIME_MSECONDS(net_accept_period);
 
   NetAccept *a;
+  int n_private = 0;
   n = eventProcessor.n_threads_for_type[ET_NET];
   for (i = 0; i < n; i++) {
-    if (i < n - 1)
+    if (i < n - 1) {
       a = clone();
-    else
+      if (reuseport && listen_per_thread(a, isTransparent))
+        n_private++;
+    } else
       a = this;
     EThread *t = eventProcessor.eventthread[ET_NET][i];
     PollDescriptor *pd = get_PollDescriptor(t);
@@ -198,6 +204,107 @@ NetAccept::init_accept_per_thread(bool isTransparent)
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, etype);
   }
+  if (reuseport > 1 && n > 1 && n_private == n - 1)
+    attach_reuseport_steering(eventProcessor.eventthread[ET_NET], n);
+}
+
+//
+// Give the per thread clone @a a its own listen socket on our address. Both
+// sockets are opened with SO_REUSEPORT, so the kernel spreads new connections
+// across the threads and a connection is only ever accepted by the thread
+// that owns its socket. If the socket can't be opened (for instance the main
+// socket came from traffic_manager under a different user) the clone shares
+// our socket as usual.
+//
+bool
+NetAccept::listen_per_thread(NetAccept *a, bool transparent)
+{
+  a->server.fd = NO_FD;
+  ats_ip_copy(&a->server.accept_addr, &server.addr);
+  if (a->server.listen(NON_BLOCKING, recv_bufsize, send_bufsize, transparent) == 0) {
+    a->private_fd = true;
+    set_accept_sockopts(a->server.fd);
+    return true;
+  }
+  Warning("unable to open a per thread listen socket on port %d, sharing the main socket", ats_ip_port_host_order(&server.addr));
+  a->server.fd = server.fd;
+  ats_ip_copy(&a->server.accept_addr, &server.accept_addr);
+  return false;
+}
+
+//
+// Select the listen socket by the CPU the connection arrived on, so with one
+// thread pinned per CPU the accept runs where the packets are. Sockets join
+// the SO_REUSEPORT group in listen order: ours first, then the clones for
+// threads 0 .. n-2. Ours is served by thread n-1, hence the +1. That only
+// holds if @a threads are bound one to a CPU, thread i to CPU i, and there
+// are no more CPUs than threads, otherwise the kernel keeps hashing.
+//
+void
+NetAccept::attach_reuseport_steering(EThread **threads, int n)
+{
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  bool pinned = ink_number_of_processors() == n;
+  for (int i = 0; pinned && i < n; i++) {
+    cpu_set_t cpus;
+    pinned = pthread_getaffinity_np(threads[i]->tid, sizeof(cpus), &cpus) == 0 && CPU_COUNT(&cpus) == 1 && CPU_ISSET(i, &cpus);
+  }
+  if (!pinned) {
+    Warning("proxy.config.net.listen_reuseport 2 needs each of the %d threads bound to its own CPU in order, "
+            "not steering port %d by CPU",
+            n, ats_ip_port_host_order(&server.addr));
+    return;
+  }
+
+  struct sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+    {BPF_ALU | BPF_ADD | BPF_K, 0, 0, 1},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)n},
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+  prog.len = countof(code);
+  prog.filter = code;
+  if (safe_setsockopt(server.fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *)&prog, sizeof(prog)) < 0)
+    Warning("unable to attach CPU steering to port %d: %d, %s", ats_ip_port_host_order(&server.addr), errno, strerror(errno));
+  else
+    Debug("iocore_net_accept", "CPU steering over %d listen sockets on port %d", n, ats_ip_port_host_order(&server.addr));
+#else
+  (void)threads;
+  (void)n;
+  Warning("proxy.config.net.listen_reuseport CPU steering is not supported on this platform");
+#endif
+}
+
+//
+// Options for the proxy's accept sockets that Server::setup_fd_for_listen
+// does not set. Applied to the main socket by accept_internal and to every
+// per thread socket as it is opened.
+//
+void
+NetAccept::set_accept_sockopts(int fd)
+{
+  if (fd == NO_FD)
+    return;
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  int should_filter_int = 0;
+  REC_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
+  if (should_filter_int > 0) {
+    setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
+  }
+#endif
+#ifdef TCP_INIT_CWND
+  int tcp_init_cwnd = 0;
+  REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+  if (tcp_init_cwnd > 0) {
+    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+    if (setsockopt(fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+    }
+  }
+#endif
 }
 
 int
@@ -311,6 +418,8 @@ NetAccept::acceptEvent(int event, void *ep)
   MUTEX_TRY_LOCK(lock, m, e->ethread);
   if (lock.is_locked()) {
     if (action_->cancelled) {
+      if (private_fd)
+        server.close();
       e->cancel();
       NET_DECREMENT_DYN_STAT(net_accepts_currently_open_stat);
       delete this;
@@ -350,6 +459,14 @@ NetAccept::acceptFastEvent(int event, void *ep)
   UnixNetVConnection *vc = NULL;
   int loop = accept_till_done;
 
+  // Cancelling the action only closes the main socket, close our own.
+  if (private_fd && action_->cancelled) {
+    server.close();
+    e->cancel();
+    delete this;
+    return EVENT_DONE;
+  }
+
   do {
     if (!backdoor && check_net_throttle(ACCEPT, Thread::get_hrtime())) {
       ifd = NO_FD;
@@ -499,7 +616,7 @@ NetAccept::acceptLoopEvent(int event, Event *e)
 
 NetAccept::NetAccept()
   : Continuation(NULL), period(0), ifd(NO_FD), callback_on_open(false), backdoor(false), recv_bufsize(0), send_bufsize(0),
-    sockopt_flags(0), packet_mark(0), packet_tos(0), etype(0)
+    sockopt_flags(0), packet_mark(0), packet_tos(0), etype(0), reuseport(0), private_fd(false)
 {
 }
 
@@ -537,3 +654,45 @@ NetAccept::getNetProcessor() const
 {
   return &netProcessor;
 }
+
+#if TS_HAS_TESTS
+#include "ts/TestBox.h"
+
+#ifdef SO_REUSEPORT
+// Per thread sockets can only join a port whose first socket was bound with SO_REUSEPORT.
+REGRESSION_TEST(NetAccept_reuseport)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // As traffic_manager binds the port with proxy.config.net.listen_reuseport set.
+  Server main, clone;
+  ats_ip4_set(&main.accept_addr, htonl(INADDR_LOOPBACK), 0);
+  main.f_reuseport = true;
+  box.check(main.listen(true) == 0, "main listen failed, %s", strerror(errno));
+  box.check(main.reuseport(), "main socket does not report SO_REUSEPORT");
+  ats_ip_copy(&clone.accept_addr, &main.addr);
+  clone.f_reuseport = true;
+  box.check(clone.listen(true) == 0, "per thread socket could not join port %d, %s", ats_ip_port_host_order(&main.addr),
+            strerror(errno));
+
+  // As traffic_manager binds the port without it: the inherited socket is detected and a clone can't bind.
+  Server inherited, refused;
+  IpEndpoint ip;
+  int len = sizeof(ip);
+  ats_ip4_set(&ip, htonl(INADDR_LOOPBACK), 0);
+  inherited.fd = socket(AF_INET, SOCK_STREAM, 0);
+  box.check(bind(inherited.fd, &ip.sa, ats_ip_size(&ip)) == 0 && safe_getsockname(inherited.fd, &ip.sa, &len) == 0,
+            "bind failed, %s", strerror(errno));
+  box.check(!inherited.reuseport(), "socket bound without SO_REUSEPORT reports it");
+  box.check(safe_listen(inherited.fd, 16) == 0, "inherited listen failed, %s", strerror(errno));
+  ats_ip_copy(&refused.accept_addr, &ip);
+  refused.f_reuseport = true;
+  box.check(refused.listen(true) != 0, "per thread socket joined a port bound without SO_REUSEPORT");
+
+  main.close();
+  clone.close();
+  inherited.close();
+}
+#endif
+#endif // TS_HAS_TESTS
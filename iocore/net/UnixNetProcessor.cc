@@ -129,6 +129,15 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
   if (should_filter_int > 0 && opt.etype == ET_NET)
     na->server.http_accept_filter = true;
 
+  int listen_reuseport = 0;
+  REC_ReadConfigInteger(listen_reuseport, "proxy.config.net.listen_reuseport");
+#ifndef SO_REUSEPORT
+  if (listen_reuseport) {
+    Warning("proxy.config.net.listen_reuseport is not supported on this platform, ignored");
+    listen_reuseport = 0;
+  }
+#endif
+
   na->action_ = new NetAcceptAction();
   *na->action_ = cont;
   na->action_->server = &na->server;
@@ -168,29 +177,22 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
 #endif // TS_USE_POSIX_CAP
       }
     } else {
+      // A socket bound by traffic_manager without SO_REUSEPORT can't share its port with the per thread sockets.
+      if (listen_reuseport && na->server.fd != NO_FD && !na->server.reuseport()) {
+        Error("proxy.config.net.listen_reuseport: port %d was bound by traffic_manager without SO_REUSEPORT,"
+              " per thread listen sockets are disabled until traffic_manager is restarted",
+              opt.local_port);
+        listen_reuseport = 0;
+      }
+      na->reuseport = listen_reuseport;
+      na->server.f_reuseport = listen_reuseport > 0;
       na->init_accept_per_thread(opt.f_inbound_transparent);
     }
   } else {
     na->init_accept(NULL, opt.f_inbound_transparent);
   }
 
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-#ifdef TCP_INIT_CWND
-  int tcp_init_cwnd = 0;
-  REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
-  if (tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if (setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
-  }
-#endif
+  na->set_accept_sockopts(na->server.fd);
   return na->action_;
 }
 
@@ -409,6 +411,8 @@ UnixNetProcessor::start(int, size_t)
     extern void initialize_thread_for_http_sessions(EThread * thread, int thread_index);
     initialize_thread_for_http_sessions(netthreads[i], i);
   }
+  if (etype == ET_NET)
+    register_eventloop_stats(n_netthreads);
 
   RecData d;
   d.rec_int = 0;
@@ -99,6 +99,7 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
 {
   NetHandler *nh = vc->nh;
   vc->cancel_OOB();
+  vc->splice_close();
   vc->ep.stop();
   vc->con.close();
 
@@ -242,6 +243,145 @@ write_signal_error(NetHandler *nh, UnixNetVConnection *vc, int lerrno)
   return write_signal_done(VC_EVENT_ERROR, nh, vc);
 }
 
+#ifdef SPLICE_F_NONBLOCK
+//
+// Signal the EOS or error that splice_from_net held back for @a vc.
+//
+static void
+splice_signal_eof(NetHandler *nh, UnixNetVConnection *vc)
+{
+  vc->read.triggered = 0;
+  nh->read_ready_list.remove(vc);
+  if (vc->splice_errno)
+    read_signal_error(nh, vc, vc->splice_errno);
+  else
+    read_signal_done(VC_EVENT_EOS, nh, vc);
+}
+
+//
+// Move data from the socket of @a vc into the splice pipe of the paired
+// connection. The read VIO only counts bytes once the peer has written them
+// to its socket, and EOS or an error is held back until then, so a producer
+// never completes with its data still in the pipe. Returns false if the
+// buffered read must be used this time, which is the case while the peer
+// still has buffered data to send ahead of the pipe.
+//
+static bool
+splice_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread, const ProxyMutex *locked)
+{
+  NetState *s = &vc->read;
+  ProxyMutex *mutex = thread->mutex;
+
+  // Count what the peer has written out since the last time.
+  if (vc->splice_done > 0) {
+    s->vio.ndone += vc->splice_done;
+    vc->splice_done = 0;
+    if (s->vio.ntodo() <= 0) {
+      read_signal_done(VC_EVENT_READ_COMPLETE, nh, vc);
+      return true;
+    }
+    if (read_signal_and_update(VC_EVENT_READ_READY, vc) != EVENT_CONT)
+      return true;
+    // change of lock... don't look at shared variables!
+    if (locked != s->vio.mutex.m_ptr) {
+      read_reschedule(nh, vc);
+      return true;
+    }
+    if (!s->enabled) {
+      read_disable(nh, vc);
+      return true;
+    }
+  }
+
+  UnixNetVConnection *peer = vc->splice_peer;
+  if (vc->splice_eof) {
+    // The peer reschedules us once it has written out the rest of the pipe.
+    if (peer && peer->splice_pending > 0)
+      nh->read_ready_list.remove(vc);
+    else
+      splice_signal_eof(nh, vc);
+    return true;
+  }
+  if (!peer || peer->closed || peer->write.vio.op != VIO::WRITE)
+    return false;
+  {
+    MUTEX_TRY_LOCK_FOR(peer_lock, peer->write.vio.mutex, thread, peer->write.vio._cont);
+    if (!peer_lock.is_locked())
+      return false;
+    IOBufferReader *reader = peer->write.vio.get_reader();
+    if (reader && reader->is_read_avail_more_than(0))
+      return false;
+  }
+
+  // Everything in the peer's pipe came from us and is not counted yet.
+  int64_t toread = peer->splice_pipe_size - peer->splice_pending;
+  toread = MIN(toread, s->vio.ntodo() - peer->splice_pending);
+  toread = MIN(toread, peer->write.vio.ntodo() - peer->splice_pending);
+  if (toread <= 0) {
+    // The pipe is full, the peer reschedules us once it has written some.
+    nh->read_ready_list.remove(vc);
+    return true;
+  }
+
+  int64_t r = splice(vc->con.fd, NULL, peer->splice_pipe[1], NULL, toread, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  NET_INCREMENT_DYN_STAT(net_calls_to_read_stat);
+  if (r < 0)
+    r = -errno;
+
+  if (r == -EAGAIN || r == -ENOTCONN) {
+    // With data still in the pipe this can mean the pipe ran out of room
+    // rather than the socket being drained, so stay triggered.
+    if (!peer->splice_pending) {
+      NET_INCREMENT_DYN_STAT(net_calls_to_read_nodata_stat);
+      vc->read.triggered = 0;
+    }
+    nh->read_ready_list.remove(vc);
+    return true;
+  }
+  if (r <= 0) {
+    vc->splice_eof = true;
+    vc->splice_errno = (!r || r == -ECONNRESET) ? 0 : (int)-r;
+    if (peer->splice_pending > 0)
+      nh->read_ready_list.remove(vc);
+    else
+      splice_signal_eof(nh, vc);
+    return true;
+  }
+  NET_SUM_DYN_STAT(net_read_bytes_stat, r);
+
+  peer->splice_pending += r;
+  net_activity(vc, thread);
+  write_reschedule(nh, peer);
+  read_reschedule(nh, vc);
+  return true;
+}
+
+//
+// Write out the bytes the paired connection spliced into the pipe of @a vc,
+// at most @a ntodo. Returns the number of bytes written or -errno if none
+// were.
+//
+static int64_t
+splice_to_net(UnixNetVConnection *vc, EThread *thread, int64_t ntodo)
+{
+  ProxyMutex *mutex = thread->mutex;
+  int64_t towrite = MIN(vc->splice_pending, ntodo);
+  int64_t total = 0, r = 0;
+
+  while (total < towrite) {
+    r = splice(vc->splice_pipe[0], NULL, vc->con.fd, NULL, towrite - total, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    NET_INCREMENT_DYN_STAT(net_calls_to_write_stat);
+    if (r <= 0) {
+      r = -errno;
+      break;
+    }
+    total += r;
+  }
+  vc->splice_pending -= total;
+  return total ? total : r;
+}
+#endif
+
 // Read the data for a UnixNetVConnection.
 // Rescheduling the UnixNetVConnection by moving the VC
 // onto or off of the ready_list.
@@ -282,6 +422,10 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     read_disable(nh, vc);
     return;
   }
+#ifdef SPLICE_F_NONBLOCK
+  if ((vc->splice_peer || vc->splice_done || vc->splice_eof) && splice_from_net(nh, vc, thread, lock.get_mutex()))
+    return;
+#endif
   int64_t toread = buf.writer()->write_avail();
   if (toread > ntodo)
     toread = ntodo;
@@ -474,6 +618,38 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     return;
   }
 
+#ifdef SPLICE_F_NONBLOCK
+  // Spliced bytes are older than anything in the write buffer, send them first.
+  if (vc->splice_pending > 0) {
+    int64_t r = splice_to_net(vc, thread, ntodo);
+    if (r > 0) {
+      NET_SUM_DYN_STAT(net_write_bytes_stat, r);
+      s->vio.ndone += r;
+      net_activity(vc, thread);
+      // The producer counts the bytes now that they are out, and there is room in the pipe again.
+      if (vc->splice_peer) {
+        vc->splice_peer->splice_done += r;
+        read_reschedule(nh, vc->splice_peer);
+      }
+    } else if (r != -EAGAIN && r != -ENOTCONN) {
+      vc->write.triggered = 0;
+      write_signal_error(nh, vc, (int)-r);
+      return;
+    }
+    ntodo = s->vio.ntodo();
+    if (ntodo <= 0) {
+      write_signal_done(VC_EVENT_WRITE_COMPLETE, nh, vc);
+      return;
+    }
+    if (vc->splice_pending > 0) {
+      // The socket is full.
+      vc->write.triggered = 0;
+      nh->write_ready_list.remove(vc);
+      return;
+    }
+  }
+#endif
+
   MIOBufferAccessor &buf = s->vio.buffer;
   ink_assert(buf.writer());
 
@@ -592,6 +768,79 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
   }
 }
 
+#ifdef SPLICE_F_NONBLOCK
+static bool
+open_splice_pipe(UnixNetVConnection *vc)
+{
+  if (pipe2(vc->splice_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+    Debug("iocore_net", "unable to create splice pipe: %s", strerror(errno));
+    vc->splice_pipe[0] = vc->splice_pipe[1] = NO_FD;
+    return false;
+  }
+  vc->splice_pipe_size = 65536;
+#ifdef F_GETPIPE_SZ
+  int size = fcntl(vc->splice_pipe[0], F_GETPIPE_SZ);
+  if (size > 0)
+    vc->splice_pipe_size = size;
+#endif
+  vc->splice_pending = 0;
+  return true;
+}
+#endif
+
+bool
+UnixNetVConnection::splice_with(NetVConnection *apeer)
+{
+#ifdef SPLICE_F_NONBLOCK
+  UnixNetVConnection *peer = dynamic_cast<UnixNetVConnection *>(apeer);
+
+  // Both ends must be plain sockets serviced by the same thread.
+  if (!peer || peer == this || closed || peer->closed || splice_peer || peer->splice_peer || !thread || peer->thread != thread)
+    return false;
+  if (dynamic_cast<SSLNetVConnection *>(this) || dynamic_cast<SSLNetVConnection *>(peer))
+    return false;
+  if (!open_splice_pipe(this))
+    return false;
+  if (!open_splice_pipe(peer)) {
+    splice_close();
+    return false;
+  }
+  splice_peer = peer;
+  peer->splice_peer = this;
+  Debug("iocore_net", "splicing vc %p with vc %p", this, peer);
+  return true;
+#else
+  (void)apeer;
+  return false;
+#endif
+}
+
+//
+// Each connection owns the pipe holding the bytes to be written to its own
+// socket, so when the producer side closes first the consumer still writes
+// out what was already spliced.
+//
+void
+UnixNetVConnection::splice_close()
+{
+  if (splice_peer && splice_peer->splice_peer == this) {
+    UnixNetVConnection *peer = splice_peer;
+    peer->splice_peer = NULL;
+    // The peer may be holding back EOS for bytes in our pipe, which can't be written now.
+    if (peer->splice_eof)
+      read_reschedule(peer->nh, peer);
+  }
+  splice_peer = NULL;
+  if (splice_pipe[0] != NO_FD) {
+    ::close(splice_pipe[0]);
+    ::close(splice_pipe[1]);
+    splice_pipe[0] = splice_pipe[1] = NO_FD;
+  }
+  splice_pending = 0;
+  splice_done = 0;
+  splice_eof = false;
+}
+
 bool
 UnixNetVConnection::get_data(int id, void *data)
 {
@@ -889,8 +1138,10 @@ UnixNetVConnection::UnixNetVConnection()
     next_inactivity_timeout_at(0), next_activity_timeout_at(0),
 #endif
     nh(NULL), id(0), flags(0), recursion(0), submit_time(0), oob_ptr(0), from_accept_thread(false), origin_trace(false),
-    origin_trace_addr(NULL), origin_trace_port(0)
+    origin_trace_addr(NULL), origin_trace_port(0), splice_peer(NULL), splice_pipe_size(0), splice_pending(0),
+    splice_done(0), splice_eof(false), splice_errno(0)
 {
+  splice_pipe[0] = splice_pipe[1] = NO_FD;
   memset(&local_addr, 0, sizeof local_addr);
   memset(&server_addr, 0, sizeof server_addr);
   SET_HANDLER((NetVConnHandler)&UnixNetVConnection::startEvent);
@@ -1409,3 +1660,187 @@ UnixNetVConnection::migrateToCurrentThread(Continuation *cont, EThread *t)
     return netvc;
   }
 }
+
+#if TS_HAS_TESTS && defined(SPLICE_F_NONBLOCK)
+//
+// A spliced blind tunnel whose producer is closed while the consumer's
+// socket is full. The bytes already in the consumer's pipe must still be
+// written out, in order, after the producer is gone.
+//
+struct SpliceProducerCloseTest : public Continuation {
+  RegressionTest *test;
+  int *pstatus;
+  int client_fd; ///< Far end of the producer, sends the payload.
+  int origin_fd; ///< Far end of the consumer, reads it back.
+  UnixNetVConnection *producer;
+  UnixNetVConnection *consumer;
+  MIOBuffer *read_buf;
+  MIOBuffer *write_buf;
+  int64_t expected;
+  int64_t received;
+  ink_hrtime deadline;
+  Event *timer;
+
+  static int
+  connect_to(const IpEndpoint &addr, int rcvbuf)
+  {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvbuf)
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (connect(fd, &addr.sa, ats_ip_size(&addr.sa)) < 0) {
+      ::close(fd);
+      return NO_FD;
+    }
+    return fd;
+  }
+
+  UnixNetVConnection *
+  wrap(EThread *t, int fd)
+  {
+    UnixNetVConnection *vc = static_cast<UnixNetVConnection *>(netProcessor.allocate_vc(t));
+    vc->action_ = this;
+    vc->mutex = new_ProxyMutex();
+    if (vc->connectUp(t, fd) != CONNECT_SUCCESS)
+      return NULL;
+    return vc;
+  }
+
+  int
+  done(int status)
+  {
+    if (timer)
+      timer->cancel();
+    if (producer)
+      producer->do_io_close();
+    if (consumer)
+      consumer->do_io_close();
+    if (read_buf)
+      free_MIOBuffer(read_buf);
+    if (write_buf)
+      free_MIOBuffer(write_buf);
+    if (client_fd != NO_FD)
+      ::close(client_fd);
+    if (origin_fd != NO_FD)
+      ::close(origin_fd);
+    *pstatus = status;
+    delete this;
+    return EVENT_DONE;
+  }
+
+  int
+  startEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    EThread *t = this_ethread();
+    IpEndpoint addr;
+    int len = sizeof(addr);
+    int small = 4096;
+
+    ats_ip4_set(&addr, htonl(INADDR_LOOPBACK), 0);
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (bind(lfd, &addr.sa, ats_ip_size(&addr.sa)) < 0 || ::listen(lfd, 4) < 0 || safe_getsockname(lfd, &addr.sa, &len) < 0) {
+      rprintf(test, "unable to listen on loopback: %s\n", strerror(errno));
+      ::close(lfd);
+      return done(REGRESSION_TEST_FAILED);
+    }
+    client_fd = connect_to(addr, 0);
+    int client_near = ::accept(lfd, NULL, NULL);
+    // Small socket buffers on the consumer side, so its socket fills and the rest waits in the pipe.
+    origin_fd = connect_to(addr, small);
+    int origin_near = ::accept(lfd, NULL, NULL);
+    ::close(lfd);
+    if (client_fd == NO_FD || client_near < 0 || origin_fd == NO_FD || origin_near < 0) {
+      rprintf(test, "unable to connect on loopback: %s\n", strerror(errno));
+      return done(REGRESSION_TEST_FAILED);
+    }
+    setsockopt(origin_near, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    safe_nonblocking(client_fd);
+    safe_nonblocking(origin_fd);
+
+    producer = wrap(t, client_near);
+    consumer = wrap(t, origin_near);
+    if (!producer || !consumer) {
+      rprintf(test, "unable to set up the connections\n");
+      return done(REGRESSION_TEST_FAILED);
+    }
+    SET_HANDLER(&SpliceProducerCloseTest::mainEvent);
+    read_buf = new_MIOBuffer();
+    write_buf = new_MIOBuffer();
+    producer->do_io_read(this, INT64_MAX, read_buf);
+    consumer->do_io_write(this, INT64_MAX, write_buf->alloc_reader());
+    if (!producer->splice_with(consumer)) {
+      rprintf(test, "connections were not spliced\n");
+      return done(REGRESSION_TEST_FAILED);
+    }
+
+    char chunk[4096];
+    int64_t sent = 0;
+    for (;;) {
+      for (unsigned i = 0; i < sizeof(chunk); ++i)
+        chunk[i] = (sent + i) % 251;
+      int r = ::write(client_fd, chunk, sizeof(chunk));
+      if (r <= 0 || (sent += r) >= 1024 * 1024)
+        break;
+    }
+    rprintf(test, "sent %" PRId64 " bytes into the tunnel\n", sent);
+
+    deadline = Thread::get_hrtime() + HRTIME_SECONDS(5);
+    timer = t->schedule_every(this, HRTIME_MSECONDS(10));
+    return EVENT_DONE;
+  }
+
+  int
+  mainEvent(int event, Event * /* e ATS_UNUSED */)
+  {
+    if (event != EVENT_INTERVAL)
+      return EVENT_CONT;
+    if (Thread::get_hrtime() > deadline) {
+      rprintf(test, "timed out, %" PRId64 " of %" PRId64 " bytes received\n", received, expected);
+      return done(REGRESSION_TEST_FAILED);
+    }
+
+    if (producer) {
+      if (consumer->splice_pending <= 0)
+        return EVENT_CONT;
+      // Nothing is read from the consumer's socket yet, so it is full and the pipe is not empty.
+      expected = consumer->write.vio.ndone + consumer->splice_pending;
+      rprintf(test, "closing the producer with %" PRId64 " bytes in the pipe, %" PRId64 " bytes counted by the producer\n",
+              consumer->splice_pending, producer->read.vio.ndone);
+      if (producer->read.vio.ndone > consumer->write.vio.ndone) {
+        rprintf(test, "the producer counted bytes that were not written out\n");
+        return done(REGRESSION_TEST_FAILED);
+      }
+      producer->do_io_close();
+      producer = NULL;
+    }
+
+    char buf[4096];
+    int r;
+    while ((r = ::read(origin_fd, buf, sizeof(buf))) > 0) {
+      for (int i = 0; i < r; ++i) {
+        if (buf[i] != (char)((received + i) % 251)) {
+          rprintf(test, "byte %" PRId64 " is wrong\n", received + i);
+          return done(REGRESSION_TEST_FAILED);
+        }
+      }
+      received += r;
+    }
+    if (received < expected)
+      return EVENT_CONT;
+    rprintf(test, "received %" PRId64 " of %" PRId64 " bytes after the producer closed\n", received, expected);
+    return done(received == expected ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED);
+  }
+
+  SpliceProducerCloseTest(RegressionTest *t, int *status)
+    : Continuation(new_ProxyMutex()), test(t), pstatus(status), client_fd(NO_FD), origin_fd(NO_FD), producer(NULL),
+      consumer(NULL), read_buf(NULL), write_buf(NULL), expected(0), received(0), deadline(0), timer(NULL)
+  {
+    SET_HANDLER(&SpliceProducerCloseTest::startEvent);
+  }
+};
+
+REGRESSION_TEST(UnixNetVConnection_splice_producer_close)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(new SpliceProducerCloseTest(t, pstatus), ET_NET);
+}
+#endif
@@ -0,0 +1,434 @@
+/** @file
+
+    Immutable string indexes, built once and then only read, laid out in a few contiguous arrays.
+
+    CompactStringMap finds the value of a key, through an array of the keys sorted on their hashes and a directory
+    of where each value of the leading bits of the hash starts in it, so a search reads a couple of cache lines
+    rather than doing a binary search.
+    CompactPrefixMap finds the value with the lowest rank among the keys which are prefixes of a string, like Trie,
+    through a radix tree. Neither owns its values, and neither can be changed once built, so any number of threads can
+    read them without locking. What they save is memory: about half that of an InkHashTable of the same keys, and a
+    small part of that of a Trie, for lookups about as fast (see test_CompactIndex).
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#ifndef _COMPACT_INDEX_H
+#define _COMPACT_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "ts/ink_memory.h"
+
+/** A key and its value, to build an index from. Keys are copied by the build, and need not be NUL terminated. */
+template <typename T> struct CompactIndexEntry {
+  const char *key;
+  int key_len;
+  int rank; // Only used by CompactPrefixMap
+  T *value;
+
+  static bool
+  key_less(const CompactIndexEntry &lhs, const CompactIndexEntry &rhs)
+  {
+    int c = memcmp(lhs.key, rhs.key, std::min(lhs.key_len, rhs.key_len));
+    return c < 0 || (c == 0 && lhs.key_len < rhs.key_len);
+  }
+};
+
+template <typename T> class CompactStringMap
+{
+public:
+  typedef CompactIndexEntry<T> Entry;
+
+  CompactStringMap() : _count(0), _bits(0), _buckets(NULL), _slots(NULL), _keys(NULL) {}
+  ~CompactStringMap() { Clear(); }
+
+  // Build from @a entries. Returns false if two of them have the same key.
+  bool Build(Entry *entries, int count);
+  T *Find(const char *key, int key_len) const;
+  void Clear();
+
+  int
+  Size() const
+  {
+    return _count;
+  }
+
+  // Visit every value, in hash order.
+  template <typename F>
+  void
+  ForEach(F f) const
+  {
+    for (int i = 0; i < _count; i++) {
+      f(_slots[i].value);
+    }
+  }
+
+  // Eight bytes at a time, mixed well enough that the leading bits can pick the bucket.
+  static uint64_t
+  Hash(const char *key, int key_len)
+  {
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ key_len;
+    uint64_t w;
+
+    for (; key_len >= 8; key += 8, key_len -= 8) {
+      memcpy(&w, key, 8);
+      h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+      h ^= h >> 31;
+    }
+    if (key_len > 0) {
+      w = 0;
+      memcpy(&w, key, key_len);
+      h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+      h ^= h >> 31;
+    }
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 29);
+  }
+
+private:
+  // Keys which fit are kept in the slot, so a search usually reads one cache line past the bucket.
+  static const int INLINE_KEY_LEN = 40;
+
+  struct Slot {
+    uint64_t hash;
+    T *value;
+    uint32_t key_len;
+    uint32_t key; // Offset in _keys, if the key does not fit in inline_key
+    char inline_key[INLINE_KEY_LEN];
+
+    const char *
+    key_ptr(const char *keys) const
+    {
+      return key_len <= static_cast<uint32_t>(INLINE_KEY_LEN) ? inline_key : keys + key;
+    }
+  };
+
+  struct HashedEntry {
+    uint64_t hash;
+    Entry *entry;
+
+    bool
+    operator<(const HashedEntry &rhs) const
+    {
+      return hash < rhs.hash || (hash == rhs.hash && Entry::key_less(*entry, *rhs.entry));
+    }
+  };
+
+  CompactStringMap(const CompactStringMap &);            // noncopyable
+  CompactStringMap &operator=(const CompactStringMap &); // noncopyable
+
+  int _count;
+  int _bits;          // Leading bits of the hash which pick a bucket
+  uint32_t *_buckets; // The slots of bucket b are _slots[_buckets[b]] up to _slots[_buckets[b + 1]]
+  Slot *_slots;       // Sorted on the hash
+  char *_keys;
+};
+
+template <typename T>
+bool
+CompactStringMap<T>::Build(Entry *entries, int count)
+{
+  HashedEntry *hashed = static_cast<HashedEntry *>(ats_malloc(count * sizeof(HashedEntry)));
+  size_t keys_size = 0;
+
+  Clear();
+  for (int i = 0; i < count; i++) {
+    hashed[i].hash = Hash(entries[i].key, entries[i].key_len);
+    hashed[i].entry = &entries[i];
+    if (entries[i].key_len > INLINE_KEY_LEN) {
+      keys_size += entries[i].key_len;
+    }
+  }
+  std::sort(hashed, hashed + count);
+
+  for (int i = 1; i < count; i++) {
+    if (hashed[i].hash == hashed[i - 1].hash && !Entry::key_less(*hashed[i - 1].entry, *hashed[i].entry)) {
+      ats_free(hashed);
+      return false;
+    }
+  }
+
+  // About one slot per bucket.
+  for (_bits = 1; (1 << _bits) < count; _bits++) {
+  }
+  _buckets = static_cast<uint32_t *>(ats_malloc(((1 << _bits) + 1) * sizeof(uint32_t)));
+  for (int b = 0, i = 0; b <= (1 << _bits); b++) {
+    while (i < count && (hashed[i].hash >> (64 - _bits)) < static_cast<uint64_t>(b)) {
+      ++i;
+    }
+    _buckets[b] = i;
+  }
+
+  _slots = static_cast<Slot *>(ats_memalign(64, (count > 0 ? count : 1) * sizeof(Slot)));
+  _keys = static_cast<char *>(ats_malloc(keys_size + 1));
+  keys_size = 0;
+  for (int i = 0; i < count; i++) {
+    const Entry *e = hashed[i].entry;
+    Slot &slot = _slots[i];
+
+    slot.hash = hashed[i].hash;
+    slot.value = e->value;
+    slot.key_len = e->key_len;
+    slot.key = 0;
+    if (e->key_len <= INLINE_KEY_LEN) {
+      memcpy(slot.inline_key, e->key, e->key_len);
+    } else {
+      slot.key = keys_size;
+      memcpy(_keys + keys_size, e->key, e->key_len);
+      keys_size += e->key_len;
+    }
+  }
+  _count = count;
+  ats_free(hashed);
+  return true;
+}
+
+template <typename T>
+T *
+CompactStringMap<T>::Find(const char *key, int key_len) const
+{
+  if (_count == 0) {
+    return NULL;
+  }
+
+  uint64_t hash = Hash(key, key_len);
+  uint64_t bucket = hash >> (64 - _bits);
+  const Slot *end = _slots + _buckets[bucket + 1];
+
+  for (const Slot *slot = _slots + _buckets[bucket]; slot < end && slot->hash <= hash; slot++) {
+    if (slot->hash == hash && slot->key_len == static_cast<uint32_t>(key_len) &&
+        memcmp(slot->key_ptr(_keys), key, key_len) == 0) {
+      return slot->value;
+    }
+  }
+  return NULL;
+}
+
+template <typename T>
+void
+CompactStringMap<T>::Clear()
+{
+  ats_free(_buckets);
+  ats_memalign_free(_slots);
+  ats_free(_keys);
+  _buckets = NULL;
+  _slots = NULL;
+  _keys = NULL;
+  _bits = 0;
+  _count = 0;
+}
+
+template <typename T> class CompactPrefixMap
+{
+public:
+  typedef CompactIndexEntry<T> Entry;
+
+  CompactPrefixMap() : _count(0), _nnodes(0), _nodes(NULL), _labels(NULL) {}
+  ~CompactPrefixMap() { Clear(); }
+
+  // Build from @a entries, which are sorted in place. Values must not be NULL. Returns false if two of them have the
+  // same key.
+  bool Build(Entry *entries, int count);
+  // Of the keys which are prefixes of @a key, the value of the one with the lowest rank, the longer key on a tie.
+  T *Search(const char *key, int key_len) const;
+  void Clear();
+
+  int
+  Size() const
+  {
+    return _count;
+  }
+
+  // Visit every value, in key order.
+  template <typename F>
+  void
+  ForEach(F f) const
+  {
+    for (int i = 0; i < _nnodes; i++) {
+      if (_nodes[i].value) {
+        f(_nodes[i].value);
+      }
+    }
+  }
+
+private:
+  // The children of a node are next to each other, sorted on the first byte of their labels.
+  struct Node {
+    uint32_t label; // Offset in _labels of the bytes from the parent to this node
+    uint32_t label_len;
+    uint32_t children;
+    uint32_t nchildren;
+    int rank;
+    T *value; // NULL if no key ends here
+  };
+
+  CompactPrefixMap(const CompactPrefixMap &);            // noncopyable
+  CompactPrefixMap &operator=(const CompactPrefixMap &); // noncopyable
+
+  int _count;
+  int _nnodes;
+  Node *_nodes; // The root is the first
+  char *_labels;
+};
+
+template <typename T>
+bool
+CompactPrefixMap<T>::Build(Entry *entries, int count)
+{
+  struct Range {
+    int node;
+    int lo, hi; // Entries under the node
+    int depth;  // Length of the keys up to and including the node
+
+    void
+    set(int n, int l, int h, int d)
+    {
+      node = n;
+      lo = l;
+      hi = h;
+      depth = d;
+    }
+  };
+
+  size_t labels_size = 0;
+
+  Clear();
+  std::sort(entries, entries + count, Entry::key_less);
+  for (int i = 0; i < count; i++) {
+    labels_size += entries[i].key_len;
+  }
+
+  // Every node but the root ends a key or has two or more children, so there are fewer than twice as many.
+  Range *queue = static_cast<Range *>(ats_malloc((2 * count + 1) * sizeof(Range)));
+  int head = 0, tail = 0;
+
+  _nodes = static_cast<Node *>(ats_malloc((2 * count + 1) * sizeof(Node)));
+  _labels = static_cast<char *>(ats_malloc(labels_size + 1));
+  labels_size = 0;
+  memset(&_nodes[0], 0, sizeof(Node));
+  _nnodes = 1;
+  queue[tail++].set(0, 0, count, 0);
+
+  // Breadth first, so the children of a node can be put next to each other.
+  while (head < tail) {
+    Range r = queue[head++];
+    Node *node = &_nodes[r.node];
+
+    if (r.lo < r.hi && entries[r.lo].key_len == r.depth) {
+      if (r.lo + 1 < r.hi && entries[r.lo + 1].key_len == r.depth) {
+        ats_free(queue);
+        Clear();
+        return false;
+      }
+      node->value = entries[r.lo].value;
+      node->rank = entries[r.lo].rank;
+      ++r.lo;
+    }
+
+    node->children = _nnodes;
+    for (int lo = r.lo; lo < r.hi;) {
+      char c = entries[lo].key[r.depth];
+      int hi = lo + 1;
+      while (hi < r.hi && entries[hi].key[r.depth] == c) {
+        ++hi;
+      }
+
+      // The keys are sorted, so what the first and last of the group have in common all of them have.
+      const Entry &first = entries[lo];
+      const Entry &last = entries[hi - 1];
+      int depth = r.depth + 1;
+      while (depth < first.key_len && depth < last.key_len && first.key[depth] == last.key[depth]) {
+        ++depth;
+      }
+
+      Node *child = &_nodes[_nnodes];
+      memset(child, 0, sizeof(Node));
+      child->label = labels_size;
+      child->label_len = depth - r.depth;
+      memcpy(_labels + labels_size, first.key + r.depth, child->label_len);
+      labels_size += child->label_len;
+      queue[tail++].set(_nnodes++, lo, hi, depth);
+      ++node->nchildren;
+      lo = hi;
+    }
+  }
+
+  ats_free(queue);
+  _count = count;
+  return true;
+}
+
+template <typename T>
+T *
+CompactPrefixMap<T>::Search(const char *key, int key_len) const
+{
+  const Node *found = NULL;
+  const Node *node = _nodes;
+  int i = 0;
+
+  if (node == NULL) {
+    return NULL;
+  }
+
+  while (true) {
+    if (node->value && (!found || node->rank <= found->rank)) {
+      found = node;
+    }
+    if (i == key_len || node->nchildren == 0) {
+      break;
+    }
+
+    // Binary search of the children on their first byte.
+    const Node *lo = _nodes + node->children;
+    const Node *hi = lo + node->nchildren;
+    unsigned char c = key[i];
+    while (lo < hi) {
+      const Node *mid = lo + (hi - lo) / 2;
+      if (static_cast<unsigned char>(_labels[mid->label]) < c) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    if (lo == _nodes + node->children + node->nchildren || static_cast<unsigned char>(_labels[lo->label]) != c ||
+        lo->label_len > static_cast<uint32_t>(key_len - i) || memcmp(_labels + lo->label, key + i, lo->label_len) != 0) {
+      break;
+    }
+    i += lo->label_len;
+    node = lo;
+  }
+
+  return found ? found->value : NULL;
+}
+
+template <typename T>
+void
+CompactPrefixMap<T>::Clear()
+{
+  ats_free(_nodes);
+  ats_free(_labels);
+  _nodes = NULL;
+  _labels = NULL;
+  _nnodes = 0;
+  _count = 0;
+}
+
+#endif // _COMPACT_INDEX_H
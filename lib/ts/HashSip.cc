@@ -143,3 +143,79 @@ ATSHash64Sip24::clear(void)
   total_len = 0;
   block_buffer_len = 0;
 }
+
+SipHashContext::SipHashContext(uint64_t key0, uint64_t key1)
+{
+  v0 = key0 ^ 0x736f6d6570736575ull;
+  v1 = key1 ^ 0x646f72616e646f6dull ^ 0xee;
+  v2 = key0 ^ 0x6c7967656e657261ull;
+  v3 = key1 ^ 0x7465646279746573ull;
+  block_buffer_len = 0;
+  total_len = 0;
+}
+
+inline void
+SipHashContext::compress(uint64_t m)
+{
+  v3 ^= m;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  v0 ^= m;
+}
+
+bool
+SipHashContext::update(void const *data, int length)
+{
+  const unsigned char *m = static_cast<const unsigned char *>(data);
+  const unsigned char *e = m + length;
+  uint64_t mi;
+
+  total_len += length;
+
+  // Top up a partial block from the last update first
+  if (block_buffer_len > 0) {
+    while (block_buffer_len < SIP_BLOCK_SIZE && m < e) {
+      block_buffer[block_buffer_len++] = *m++;
+    }
+    if (block_buffer_len < SIP_BLOCK_SIZE) {
+      return true;
+    }
+    memcpy(&mi, block_buffer, SIP_BLOCK_SIZE);
+    compress(mi);
+    block_buffer_len = 0;
+  }
+
+  for (; e - m >= SIP_BLOCK_SIZE; m += SIP_BLOCK_SIZE) {
+    memcpy(&mi, m, SIP_BLOCK_SIZE);
+    compress(mi);
+  }
+
+  block_buffer_len = e - m;
+  memcpy(block_buffer, m, block_buffer_len);
+  return true;
+}
+
+bool
+SipHashContext::finalize(CryptoHash &hash)
+{
+  uint64_t last7 = (uint64_t)(total_len & 0xff) << 56;
+
+  for (int i = block_buffer_len - 1; i >= 0; i--) {
+    last7 |= (uint64_t)block_buffer[i] << (i * 8);
+  }
+
+  compress(last7);
+  v2 ^= 0xee;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  hash.u64[0] = v0 ^ v1 ^ v2 ^ v3;
+  v1 ^= 0xdd;
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  SIPCOMPRESS(v0, v1, v2, v3);
+  hash.u64[1] = v0 ^ v1 ^ v2 ^ v3;
+  return true;
+}
@@ -23,6 +23,7 @@
 #define __HASH_SIP_H__
 
 #include "ts/Hash.h"
+#include "ts/CryptoHash.h"
 #include <stdint.h>
 
 /*
@@ -49,4 +50,29 @@ private:
   bool finalized;
 };
 
+/*
+  SipHash-2-4 with the 128 bit output, as a CryptoContext so it can be
+  used for cache keys in place of MD5. It is not a cryptographic hash,
+  but with a 128 bit output collisions are no more likely than with MD5,
+  and it is several times faster.
+ */
+
+class SipHashContext : public CryptoContext
+{
+public:
+  SipHashContext(uint64_t key0 = 0, uint64_t key1 = 0);
+  /// Update the hash with @a data of @a length bytes.
+  virtual bool update(void const *data, int length);
+  /// Finalize and extract the @a hash.
+  virtual bool finalize(CryptoHash &hash);
+
+private:
+  void compress(uint64_t m);
+
+  uint64_t v0, v1, v2, v3;
+  unsigned char block_buffer[8];
+  uint8_t block_buffer_len;
+  size_t total_len;
+};
+
 #endif
@@ -0,0 +1,163 @@
+/** @file
+
+  Log-linear histogram for latency style values.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <string.h>
+#include "ts/ink_defs.h"
+
+/** A fixed size, log-linear (HDR style) histogram of unsigned 64 bit values.
+
+    Values are grouped by their most significant bit and each power of two
+    range is split into @c SUB_BUCKETS linear buckets, so a value reported
+    back from a bucket is within 1/SUB_BUCKETS of any value recorded in it.
+    Values below @c SUB_BUCKETS are kept exactly.
+
+    Recording is a handful of instructions and never allocates. There must be
+    a single writer; other threads may read or merge a histogram while it is
+    being written and see a slightly stale view.
+ */
+class Histogram
+{
+public:
+  static const int SUB_BITS = 3;
+  static const int SUB_BUCKETS = 1 << SUB_BITS;
+  static const int N_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  Histogram() { reset(); }
+
+  void
+  reset()
+  {
+    memset(_bucket, 0, sizeof(_bucket));
+    _count = 0;
+    _max = 0;
+  }
+
+  void
+  record(uint64_t v)
+  {
+    ++_bucket[bucket_index(v)];
+    ++_count;
+    if (v > _max)
+      _max = v;
+  }
+
+  /// Add the contents of @a h to this histogram.
+  void
+  merge(const Histogram &h)
+  {
+    for (int i = 0; i < N_BUCKETS; i++)
+      _bucket[i] += h._bucket[i];
+    _count += h._count;
+    if (h._max > _max)
+      _max = h._max;
+  }
+
+  /** Take the contents of @a h, an earlier copy of this histogram, out again, leaving what was recorded since.
+      The maximum becomes the upper bound of the highest bucket left, capped at the previous maximum.
+  */
+  void
+  subtract(const Histogram &h)
+  {
+    uint64_t max = 0;
+    for (int i = 0; i < N_BUCKETS; i++) {
+      _bucket[i] -= MIN(h._bucket[i], _bucket[i]);
+      if (_bucket[i])
+        max = bucket_upper(i);
+    }
+    _count -= MIN(h._count, _count);
+    _max = MIN(max, _max);
+  }
+
+  uint64_t
+  count() const
+  {
+    return _count;
+  }
+
+  uint64_t
+  max() const
+  {
+    return _max;
+  }
+
+  /** Value at percentile @a pct (0 - 100).
+      @return The upper bound of the bucket holding that rank, capped at the largest value recorded, or 0 if empty.
+  */
+  uint64_t
+  percentile(double pct) const
+  {
+    uint64_t total = 0;
+    for (int i = 0; i < N_BUCKETS; i++)
+      total += _bucket[i];
+    if (total == 0)
+      return 0;
+
+    uint64_t rank = (uint64_t)(pct * total / 100.0 + 0.5);
+    if (rank < 1)
+      rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < N_BUCKETS; i++) {
+      seen += _bucket[i];
+      if (seen >= rank)
+        return MIN(bucket_upper(i), _max);
+    }
+    return _max;
+  }
+
+  static int
+  bucket_index(uint64_t v)
+  {
+    if (v < (uint64_t)SUB_BUCKETS)
+      return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int sub = (int)(v >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+  }
+
+  static uint64_t
+  bucket_lower(int i)
+  {
+    if (i < SUB_BUCKETS)
+      return i;
+    int group = i / SUB_BUCKETS;
+    return (uint64_t)(SUB_BUCKETS + i % SUB_BUCKETS) << (group - 1);
+  }
+
+  static uint64_t
+  bucket_upper(int i)
+  {
+    if (i < SUB_BUCKETS)
+      return i;
+    return bucket_lower(i) + (((uint64_t)1 << (i / SUB_BUCKETS - 1)) - 1);
+  }
+
+private:
+  uint64_t _bucket[N_BUCKETS];
+  uint64_t _count;
+  uint64_t _max;
+};
+
+#endif /* __HISTOGRAM_H__ */
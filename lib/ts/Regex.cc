@@ -24,6 +24,7 @@
 #include "ts/ink_platform.h"
 #include "ts/ink_thread.h"
 #include "ts/ink_memory.h"
+#include "ts/ParseRules.h"
 #include "ts/Regex.h"
 
 #ifdef PCRE_CONFIG_JIT
@@ -240,3 +241,334 @@ DFA::match(const char *str, int length) const
 
   return -1;
 }
+
+// Longest literal taken out of a pattern, longer ones are cut short, which still leaves a substring of every match.
+#define REGEX_PREFILTER_MAX_LITERAL 64
+
+static const char *
+regex_skip_class(const char *p)
+{
+  // p is just past the '['
+  if (*p == '^') {
+    ++p;
+  }
+  if (*p == ']') {
+    ++p;
+  }
+  while (*p && *p != ']') {
+    if (*p == '\\' && p[1]) {
+      p += 2;
+    } else if (*p == '[' && p[1] == ':') {
+      const char *e = strstr(p + 2, ":]");
+      p = e ? e + 2 : p + 1;
+    } else {
+      ++p;
+    }
+  }
+  return *p ? p + 1 : p;
+}
+
+static const char *
+regex_skip_group(const char *p)
+{
+  // p is just past the '('
+  int depth = 1;
+
+  while (*p && depth > 0) {
+    if (*p == '\\' && p[1]) {
+      p += 2;
+    } else if (*p == '[') {
+      p = regex_skip_class(p + 1);
+    } else {
+      if (*p == '(') {
+        ++depth;
+      } else if (*p == ')') {
+        --depth;
+      }
+      ++p;
+    }
+  }
+  return p;
+}
+
+static const char *
+regex_skip_quantifier(const char *p)
+{
+  if (*p == '*' || *p == '+' || *p == '?') {
+    ++p;
+  } else if (*p == '{') {
+    while (*p && *p != '}') {
+      ++p;
+    }
+    if (*p) {
+      ++p;
+    }
+  } else {
+    return p;
+  }
+  // Lazy or possessive
+  if (*p == '?' || *p == '+') {
+    ++p;
+  }
+  return p;
+}
+
+int
+RegexPrefilter::required_literal(const char *pattern, char *buf, int bufsize)
+{
+  char run[REGEX_PREFILTER_MAX_LITERAL];
+  char best[REGEX_PREFILTER_MAX_LITERAL];
+  int run_len = 0;
+  int best_len = 0;
+  int max_len = bufsize - 1 < REGEX_PREFILTER_MAX_LITERAL ? bufsize - 1 : REGEX_PREFILTER_MAX_LITERAL;
+
+  if (bufsize > 0) {
+    buf[0] = '\0';
+  }
+  const char *p = pattern;
+
+  while (*p) {
+    bool literal = false;
+    char c = 0;
+
+    switch (*p) {
+    case '\\':
+      if (p[1] == '\0') {
+        return 0;
+      } else if (!isalnum(static_cast<unsigned char>(p[1]))) {
+        c = p[1];
+        literal = true;
+      } else if (!strchr("dDwWsShHvVRNbBAzZG", p[1])) {
+        // Back references, character codes, \Q..\E and anything else which is more than one character or
+        // is not the character itself.
+        return 0;
+      }
+      p += 2;
+      break;
+    case '[':
+      p = regex_skip_class(p + 1);
+      break;
+    case '(':
+      if (p[1] == '?') {
+        // Options and assertions could change what the rest of the pattern matches.
+        return 0;
+      }
+      p = regex_skip_group(p + 1);
+      break;
+    case ')':
+    case '|':
+      // A top level alternative means no literal is required.
+      return 0;
+    default:
+      if (strchr(".^$*+?{", *p)) {
+        ++p;
+      } else {
+        c = *p++;
+        literal = true;
+      }
+      break;
+    }
+
+    if (literal) {
+      if (*p == '*' || *p == '?' || *p == '{') {
+        // The character is optional, or could be repeated, which ends the run.
+        literal = false;
+      } else if (*p == '+') {
+        // At least one of them, but the run can not go past it.
+        if (run_len < max_len) {
+          run[run_len++] = ParseRules::ink_tolower(c);
+        }
+        literal = false;
+      } else if (run_len < max_len) {
+        run[run_len++] = ParseRules::ink_tolower(c);
+      }
+    }
+
+    if (!literal) {
+      if (run_len > best_len) {
+        memcpy(best, run, run_len);
+        best_len = run_len;
+      }
+      run_len = 0;
+    }
+    p = regex_skip_quantifier(p);
+  }
+
+  if (run_len > best_len) {
+    memcpy(best, run, run_len);
+    best_len = run_len;
+  }
+  if (bufsize > 0) {
+    memcpy(buf, best, best_len);
+    buf[best_len] = '\0';
+  }
+  return best_len;
+}
+
+RegexPrefilter::RegexPrefilter()
+  : _count(0), _literals(NULL), _always(NULL), _nstates(0), _nclasses(0), _delta(NULL), _out_link(NULL), _out_start(NULL),
+    _out(NULL)
+{
+  memset(_class, 0, sizeof(_class));
+}
+
+RegexPrefilter::~RegexPrefilter()
+{
+  clear();
+  for (int i = 0; i < _count; i++) {
+    ats_free(_literals[i]);
+  }
+  ats_free(_literals);
+}
+
+void
+RegexPrefilter::clear()
+{
+  ats_free(_always);
+  ats_free(_delta);
+  ats_free(_out_link);
+  ats_free(_out_start);
+  ats_free(_out);
+  _always = NULL;
+  _delta = _out_link = _out_start = _out = NULL;
+  _nstates = 0;
+}
+
+int
+RegexPrefilter::add(const char *pattern)
+{
+  char literal[REGEX_PREFILTER_MAX_LITERAL + 1];
+
+  if ((_count & 63) == 0) {
+    _literals = static_cast<char **>(ats_realloc(_literals, (_count + 64) * sizeof(char *)));
+  }
+  _literals[_count] = required_literal(pattern, literal, sizeof(literal)) > 0 ? ats_strdup(literal) : NULL;
+  return _count++;
+}
+
+void
+RegexPrefilter::compile()
+{
+  int words = (_count + 63) / 64;
+  int max_states = 1;
+
+  clear();
+
+  // Give each byte used in a literal its own class, with upper case in the class of its lower case.
+  memset(_class, 0, sizeof(_class));
+  _nclasses = 1;
+  for (int i = 0; i < _count; i++) {
+    if (_literals[i]) {
+      for (const char *s = _literals[i]; *s; s++) {
+        uint8_t b = static_cast<uint8_t>(*s);
+        if (_class[b] == 0) {
+          _class[b] = _nclasses++;
+        }
+      }
+      max_states += strlen(_literals[i]);
+    }
+  }
+  for (int b = 'A'; b <= 'Z'; b++) {
+    _class[b] = _class[b - 'A' + 'a'];
+  }
+
+  _always = static_cast<uint64_t *>(ats_malloc(words * sizeof(uint64_t)));
+  memset(_always, 0, words * sizeof(uint64_t));
+
+  // The trie of the literals, -1 where there is no edge.
+  int32_t *go = static_cast<int32_t *>(ats_malloc(max_states * _nclasses * sizeof(int32_t)));
+  int32_t *terminal = static_cast<int32_t *>(ats_malloc(max_states * sizeof(int32_t)));
+  int32_t *next_terminal = static_cast<int32_t *>(ats_malloc(_count * sizeof(int32_t)));
+
+  memset(go, 0xff, max_states * _nclasses * sizeof(int32_t));
+  memset(terminal, 0xff, max_states * sizeof(int32_t));
+  _nstates = 1;
+  for (int i = 0; i < _count; i++) {
+    if (_literals[i] == NULL) {
+      _always[i >> 6] |= static_cast<uint64_t>(1) << (i & 63);
+      continue;
+    }
+    int32_t s = 0;
+    for (const char *l = _literals[i]; *l; l++) {
+      int32_t *edge = &go[s * _nclasses + _class[static_cast<uint8_t>(*l)]];
+      if (*edge < 0) {
+        *edge = _nstates++;
+      }
+      s = *edge;
+    }
+    next_terminal[i] = terminal[s];
+    terminal[s] = i;
+  }
+
+  // Fill in the missing edges from the failure links, breadth first, which makes the trie a DFA.
+  int32_t *fail = static_cast<int32_t *>(ats_malloc(_nstates * sizeof(int32_t)));
+  int32_t *queue = static_cast<int32_t *>(ats_malloc(_nstates * sizeof(int32_t)));
+  int head = 0, tail = 0;
+
+  _delta = go;
+  _out_link = static_cast<int32_t *>(ats_malloc(_nstates * sizeof(int32_t)));
+  fail[0] = 0;
+  _out_link[0] = -1;
+  queue[tail++] = 0;
+  while (head < tail) {
+    int32_t s = queue[head++];
+    for (int c = 0; c < _nclasses; c++) {
+      int32_t t = _delta[s * _nclasses + c];
+      if (t < 0) {
+        _delta[s * _nclasses + c] = s == 0 ? 0 : _delta[fail[s] * _nclasses + c];
+      } else {
+        int32_t f = s == 0 ? 0 : _delta[fail[s] * _nclasses + c];
+        fail[t] = f;
+        _out_link[t] = terminal[f] >= 0 ? f : _out_link[f];
+        queue[tail++] = t;
+      }
+    }
+  }
+
+  // Flatten the patterns ending at each state.
+  _out_start = static_cast<int32_t *>(ats_malloc((_nstates + 1) * sizeof(int32_t)));
+  _out = static_cast<int32_t *>(ats_malloc((_count > 0 ? _count : 1) * sizeof(int32_t)));
+  int n = 0;
+  for (int s = 0; s < _nstates; s++) {
+    _out_start[s] = n;
+    for (int32_t i = terminal[s]; i >= 0; i = next_terminal[i]) {
+      _out[n++] = i;
+    }
+  }
+  _out_start[_nstates] = n;
+
+  ats_free(queue);
+  ats_free(fail);
+  ats_free(next_terminal);
+  ats_free(terminal);
+}
+
+void
+RegexPrefilter::scan(const char *str, int length, RegexCandidates &candidates) const
+{
+  if (_nstates == 0) {
+    // Not compiled, so every pattern is a candidate.
+    candidates._words = 0;
+    return;
+  }
+
+  int words = (_count + 63) / 64;
+  if (words > static_cast<int>(countof(candidates._local))) {
+    if (candidates._bits != candidates._local) {
+      ats_free(candidates._bits);
+    }
+    candidates._bits = static_cast<uint64_t *>(ats_malloc(words * sizeof(uint64_t)));
+  }
+  candidates._words = words;
+  memcpy(candidates._bits, _always, words * sizeof(uint64_t));
+
+  int32_t state = 0;
+  for (int i = 0; i < length; i++) {
+    state = _delta[state * _nclasses + _class[static_cast<uint8_t>(str[i])]];
+    for (int32_t s = _out_start[state] < _out_start[state + 1] ? state : _out_link[state]; s >= 0; s = _out_link[s]) {
+      for (int32_t o = _out_start[s]; o < _out_start[s + 1]; o++) {
+        candidates._bits[_out[o] >> 6] |= static_cast<uint64_t>(1) << (_out[o] & 63);
+      }
+    }
+  }
+}
@@ -25,6 +25,7 @@
 #define __TS_REGEX_H__
 
 #include "ts/ink_config.h"
+#include "ts/ink_memory.h"
 
 #ifdef HAVE_PCRE_PCRE_H
 #include <pcre/pcre.h>
@@ -80,4 +81,85 @@ private:
   dfa_pattern *_my_patterns;
 };
 
+/** The patterns of a @c RegexPrefilter which might match a string, as a bit per pattern.
+
+    Patterns past the ones scanned, or all of them if the prefilter was never compiled, are always candidates.
+*/
+class RegexCandidates
+{
+public:
+  RegexCandidates() : _bits(_local), _words(0) {}
+  ~RegexCandidates()
+  {
+    if (_bits != _local) {
+      ats_free(_bits);
+    }
+  }
+
+  bool
+  test(int idx) const
+  {
+    return idx >= _words * 64 || (_bits[idx >> 6] >> (idx & 63)) & 1;
+  }
+
+private:
+  friend class RegexPrefilter;
+
+  RegexCandidates(const RegexCandidates &);            // noncopyable
+  RegexCandidates &operator=(const RegexCandidates &); // noncopyable
+
+  uint64_t _local[32];
+  uint64_t *_bits;
+  int _words;
+};
+
+/** Find which of a set of regular expressions can match a string, in one pass over it.
+
+    A literal is taken out of each pattern which every string the pattern matches must contain, and the literals are
+    compiled to an Aho-Corasick DFA. Scanning a string gives the patterns whose literal is in it, plus the patterns
+    with no literal, and only those need to be run. Literals are case folded, so case insensitive patterns are fine.
+    The prefilter never drops a pattern which matches, it only saves running the ones which can not.
+*/
+class RegexPrefilter
+{
+public:
+  RegexPrefilter();
+  ~RegexPrefilter();
+
+  // Add the next pattern, returns its index.
+  int add(const char *pattern);
+  // Build the DFA, after the last add().
+  void compile();
+  void scan(const char *str, int length, RegexCandidates &candidates) const;
+
+  int
+  count() const
+  {
+    return _count;
+  }
+
+  /** Copy the longest literal which any match of @a pattern must contain into @a buf, lower cased.
+
+      Returns the length of the literal, or 0 if the pattern has none or uses anything not understood here.
+  */
+  static int required_literal(const char *pattern, char *buf, int bufsize);
+
+private:
+  RegexPrefilter(const RegexPrefilter &);            // noncopyable
+  RegexPrefilter &operator=(const RegexPrefilter &); // noncopyable
+
+  void clear();
+
+  int _count;
+  char **_literals;  // Literal of each pattern, NULL if it has none
+  uint64_t *_always; // Patterns without a literal, which are always candidates
+  int _nstates;      // 0 until compiled
+  int _nclasses;     // Case folded bytes used by the literals, plus one class for all others
+  uint8_t _class[256];
+  int32_t *_delta;     // _nstates x _nclasses transitions
+  int32_t *_out_link;  // Next state down the failure links with patterns ending at it, -1 if none
+  int32_t *_out_start; // Patterns ending at each state are _out[_out_start[s]] to _out[_out_start[s + 1]]
+  int32_t *_out;
+};
+
 #endif /* __TS_REGEX_H__ */
@@ -143,3 +143,105 @@ ink_login_name_max()
   long value = sysconf(_SC_LOGIN_NAME_MAX);
   return value <= 0 ? _POSIX_LOGIN_NAME_MAX : value;
 }
+
+int
+ink_number_of_numa_nodes()
+{
+#if TS_USE_HWLOC
+  int n = hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE);
+  return n > 0 ? n : 0;
+#else
+  return 0;
+#endif
+}
+
+// Find the node of the device backing @a fd from sysfs. Partitions don't
+// carry a numa_node of their own, so fall back to the parent disk.
+int
+ink_numa_node_of_fd(int fd)
+{
+#if TS_USE_HWLOC && defined(linux)
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+    return -1;
+  dev_t dev = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+
+  static const char *const paths[] = {"/sys/dev/block/%u:%u/device/numa_node", "/sys/dev/block/%u:%u/../device/numa_node"};
+  int os_index = -1;
+  for (unsigned i = 0; i < sizeof(paths) / sizeof(paths[0]) && os_index < 0; i++) {
+    char path[PATH_NAME_MAX];
+    snprintf(path, sizeof(path), paths[i], major(dev), minor(dev));
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+      if (fscanf(fp, "%d", &os_index) != 1)
+        os_index = -1;
+      fclose(fp);
+    }
+  }
+  if (os_index < 0)
+    return -1;
+
+  // sysfs uses the kernel's numbering, hand back the logical index
+  int n = ink_number_of_numa_nodes();
+  for (int i = 0; i < n; i++) {
+    hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, i);
+    if (obj && obj->os_index == (unsigned)os_index)
+      return i;
+  }
+  return -1;
+#else
+  (void)fd;
+  return -1;
+#endif
+}
+
+// Take the calling thread's memory from @a node, wherever it runs, 0 on success.
+int
+ink_numa_bind_thread_memory(int node)
+{
+#if TS_USE_HWLOC
+  hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, node);
+  if (!obj)
+    return -1;
+  // Without HWLOC_MEMBIND_STRICT this is a preference, a full node does not fail allocations.
+  hwloc_set_membind(ink_get_topology(), obj->cpuset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_THREAD);
+  return 0;
+#else
+  (void)node;
+  return -1;
+#endif
+}
+
+// Run the calling thread on the CPUs of @a node and take its memory from there, 0 on success.
+int
+ink_numa_bind_thread(int node)
+{
+#if TS_USE_HWLOC
+  hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, node);
+  if (!obj)
+    return -1;
+  if (hwloc_set_cpubind(ink_get_topology(), obj->cpuset, HWLOC_CPUBIND_THREAD) < 0)
+    return -1;
+  return ink_numa_bind_thread_memory(node);
+#else
+  (void)node;
+  return -1;
+#endif
+}
+
+// Move the pages of [addr, addr + len) to @a node and keep them there, 0 on success.
+int
+ink_numa_bind_memory(void *addr, size_t len, int node)
+{
+#if TS_USE_HWLOC
+  hwloc_obj_t obj = hwloc_get_obj_by_type(ink_get_topology(), HWLOC_OBJ_NODE, node);
+  if (!obj)
+    return -1;
+  return hwloc_set_area_membind(ink_get_topology(), addr, len, obj->cpuset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_MIGRATE);
+#else
+  (void)addr;
+  (void)len;
+  (void)node;
+  return -1;
+#endif
+}
@@ -159,6 +159,15 @@ int ink_sys_name_release(char *name, int namelen, char *release, int releaselen)
 int ink_number_of_processors();
 int ink_login_name_max();
 
+/* NUMA helpers. Nodes are numbered 0 .. ink_number_of_numa_nodes() - 1, all
+   of them fail gracefully (0 or -1) when the topology is unknown.
+*/
+int ink_number_of_numa_nodes();
+int ink_numa_node_of_fd(int fd);
+int ink_numa_bind_thread(int node);
+int ink_numa_bind_thread_memory(int node);
+int ink_numa_bind_memory(void *addr, size_t len, int node);
+
 #if TS_USE_HWLOC
 // Get the hardware topology
 hwloc_topology_t ink_get_topology();
@@ -49,6 +49,7 @@
 #include "ts/ink_error.h"
 #include "ts/ink_assert.h"
 #include "ts/ink_align.h"
+#include "ts/ink_thread.h"
 #include "ts/hugepages.h"
 #include "ts/Diags.h"
 
@@ -91,6 +92,33 @@ static const ink_freelist_ops *default_ops = &freelist_ops;
 static ink_freelist_list *freelists = NULL;
 static const ink_freelist_ops *freelist_freelist_ops = default_ops;
 
+// Each node's head sits on its own cache line.
+#define FREELIST_NODE_STRIDE (64 / sizeof(head_p))
+
+static int freelist_numa_nodes = 0;
+static ink_thread_key freelist_node_key;
+
+static void
+freelist_node_init(InkFreeList *f)
+{
+  f->node_head = (volatile head_p *)ats_memalign(64, freelist_numa_nodes * FREELIST_NODE_STRIDE * sizeof(head_p));
+  for (int i = 0; i < freelist_numa_nodes; i++) {
+    SET_FREELIST_POINTER_VERSION(f->node_head[i * FREELIST_NODE_STRIDE], FROM_PTR(0), 0);
+  }
+}
+
+// The head the calling thread allocates from and frees to.
+static inline volatile head_p *
+freelist_head(InkFreeList *f)
+{
+  if (f->node_head) {
+    intptr_t node = (intptr_t)ink_thread_getspecific(freelist_node_key);
+    if (node)
+      return &f->node_head[(node - 1) * FREELIST_NODE_STRIDE];
+  }
+  return &f->head;
+}
+
 const InkFreeListOps *
 ink_freelist_malloc_ops()
 {
@@ -148,6 +176,8 @@ ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32
   }
   Debug(DEBUG_TAG "_init", "<%s> Chunk Size request/actual (%" PRIu32 "/%" PRIu32 ")", name, chunk_size, f->chunk_size);
   SET_FREELIST_POINTER_VERSION(f->head, FROM_PTR(0), 0);
+  if (freelist_numa_nodes)
+    freelist_node_init(f);
 
   *fl = f;
 }
@@ -188,67 +218,97 @@ ink_freelist_new(InkFreeList *f)
 }
 
 static void *
-freelist_new(InkFreeList *f)
+freelist_pop(volatile head_p *head)
 {
   head_p item;
   head_p next;
   int result = 0;
 
   do {
-    INK_QUEUE_LD(item, f->head);
-    if (TO_PTR(FREELIST_POINTER(item)) == NULL) {
-      uint32_t i;
-      void *newp = NULL;
-      size_t alloc_size = f->chunk_size * f->type_size;
-      size_t alignment = 0;
-
-      if (ats_hugepage_enabled()) {
-        alignment = ats_hugepage_size();
-        newp = ats_alloc_hugepage(alloc_size);
-      }
-
-      if (newp == NULL) {
-        alignment = ats_pagesize();
-        newp = ats_memalign(alignment, INK_ALIGN(alloc_size, alignment));
-      }
-
-      ats_madvise((caddr_t)newp, INK_ALIGN(alloc_size, alignment), f->advice);
-      SET_FREELIST_POINTER_VERSION(item, newp, 0);
-
-      ink_atomic_increment((int *)&f->allocated, f->chunk_size);
-
-      /* free each of the new elements */
-      for (i = 0; i < f->chunk_size; i++) {
-        char *a = ((char *)FREELIST_POINTER(item)) + i * f->type_size;
-#ifdef DEADBEEF
-        const char str[4] = {(char)0xde, (char)0xad, (char)0xbe, (char)0xef};
-        for (int j = 0; j < (int)f->type_size; j++)
-          a[j] = str[j % 4];
-#endif
-        freelist_free(f, a);
-      }
-
-    } else {
-      SET_FREELIST_POINTER_VERSION(next, *ADDRESS_OF_NEXT(TO_PTR(FREELIST_POINTER(item)), 0), FREELIST_VERSION(item) + 1);
-      result = ink_atomic_cas(&f->head.data, item.data, next.data);
+    INK_QUEUE_LD(item, *head);
+    if (TO_PTR(FREELIST_POINTER(item)) == NULL)
+      return NULL;
+    SET_FREELIST_POINTER_VERSION(next, *ADDRESS_OF_NEXT(TO_PTR(FREELIST_POINTER(item)), 0), FREELIST_VERSION(item) + 1);
+    result = ink_atomic_cas(&head->data, item.data, next.data);
 
 #ifdef SANITY
-      if (result) {
-        if (FREELIST_POINTER(item) == TO_PTR(FREELIST_POINTER(next)))
-          ink_fatal("ink_freelist_new: loop detected");
-        if (((uintptr_t)(TO_PTR(FREELIST_POINTER(next)))) & 3)
-          ink_fatal("ink_freelist_new: bad list");
-        if (TO_PTR(FREELIST_POINTER(next)))
-          fake_global_for_ink_queue = *(int *)TO_PTR(FREELIST_POINTER(next));
-      }
-#endif /* SANITY */
+    if (result) {
+      if (FREELIST_POINTER(item) == TO_PTR(FREELIST_POINTER(next)))
+        ink_fatal("ink_freelist_new: loop detected");
+      if (((uintptr_t)(TO_PTR(FREELIST_POINTER(next)))) & 3)
+        ink_fatal("ink_freelist_new: bad list");
+      if (TO_PTR(FREELIST_POINTER(next)))
+        fake_global_for_ink_queue = *(int *)TO_PTR(FREELIST_POINTER(next));
     }
+#endif /* SANITY */
   } while (result == 0);
-  ink_assert(!((uintptr_t)TO_PTR(FREELIST_POINTER(item)) & (((uintptr_t)f->alignment) - 1)));
 
   return TO_PTR(FREELIST_POINTER(item));
 }
 
+static void
+freelist_grow(InkFreeList *f)
+{
+  uint32_t i;
+  void *newp = NULL;
+  size_t alloc_size = f->chunk_size * f->type_size;
+  size_t alignment = 0;
+
+  if (ats_hugepage_enabled()) {
+    alignment = ats_hugepage_size();
+    newp = ats_alloc_hugepage(alloc_size);
+  }
+
+  if (newp == NULL) {
+    alignment = ats_pagesize();
+    newp = ats_memalign(alignment, INK_ALIGN(alloc_size, alignment));
+  }
+
+  ats_madvise((caddr_t)newp, INK_ALIGN(alloc_size, alignment), f->advice);
+
+  ink_atomic_increment((int *)&f->allocated, f->chunk_size);
+
+  /* free each of the new elements */
+  for (i = 0; i < f->chunk_size; i++) {
+    char *a = ((char *)newp) + i * f->type_size;
+#ifdef DEADBEEF
+    const char str[4] = {(char)0xde, (char)0xad, (char)0xbe, (char)0xef};
+    for (int j = 0; j < (int)f->type_size; j++)
+      a[j] = str[j % 4];
+#endif
+    freelist_free(f, a);
+  }
+}
+
+// Take an item from any head but @a head: the shared one first, then the other nodes'. Items freed on another node than
+// the one they came from pile up there, this is where they are reused instead of growing the list.
+static void *
+freelist_pop_other(InkFreeList *f, volatile head_p *head)
+{
+  void *item = NULL;
+
+  if (head != &f->head)
+    item = freelist_pop(&f->head);
+  for (int i = 0; !item && f->node_head && i < freelist_numa_nodes; i++) {
+    if (&f->node_head[i * FREELIST_NODE_STRIDE] != head)
+      item = freelist_pop(&f->node_head[i * FREELIST_NODE_STRIDE]);
+  }
+  return item;
+}
+
+static void *
+freelist_new(InkFreeList *f)
+{
+  volatile head_p *head = freelist_head(f);
+  void *item;
+
+  while (!(item = freelist_pop(head)) && !(item = freelist_pop_other(f, head)))
+    freelist_grow(f);
+  ink_assert(!((uintptr_t)item & (((uintptr_t)f->alignment) - 1)));
+
+  return item;
+}
+
 static void *
 malloc_new(InkFreeList *f)
 {
@@ -275,6 +335,7 @@ ink_freelist_free(InkFreeList *f, void *item)
 static void
 freelist_free(InkFreeList *f, void *item)
 {
+  volatile head_p *head = freelist_head(f);
   volatile void **adr_of_next = (volatile void **)ADDRESS_OF_NEXT(item, 0);
   head_p h;
   head_p item_pair;
@@ -293,7 +354,7 @@ freelist_free(InkFreeList *f, void *item)
 #endif /* DEADBEEF */
 
   while (!result) {
-    INK_QUEUE_LD(h, f->head);
+    INK_QUEUE_LD(h, *head);
 #ifdef SANITY
     if (TO_PTR(FREELIST_POINTER(h)) == item)
       ink_fatal("ink_freelist_free: trying to free item twice");
@@ -305,7 +366,7 @@ freelist_free(InkFreeList *f, void *item)
     *adr_of_next = FREELIST_POINTER(h);
     SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(item), FREELIST_VERSION(h));
     INK_MEMORY_BARRIER;
-    result = ink_atomic_cas(&f->head.data, h.data, item_pair.data);
+    result = ink_atomic_cas(&head->data, h.data, item_pair.data);
   }
 }
 
@@ -330,6 +391,7 @@ ink_freelist_free_bulk(InkFreeList *f, void *head, void *tail, size_t num_item)
 static void
 freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
 {
+  volatile head_p *list = freelist_head(f);
   volatile void **adr_of_next = (volatile void **)ADDRESS_OF_NEXT(tail, 0);
   head_p h;
   head_p item_pair;
@@ -353,7 +415,7 @@ freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
 #endif /* DEADBEEF */
 
   while (!result) {
-    INK_QUEUE_LD(h, f->head);
+    INK_QUEUE_LD(h, *list);
 #ifdef SANITY
     if (TO_PTR(FREELIST_POINTER(h)) == head)
       ink_fatal("ink_freelist_free: trying to free item twice");
@@ -365,7 +427,7 @@ freelist_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
     *adr_of_next = FREELIST_POINTER(h);
     SET_FREELIST_POINTER_VERSION(item_pair, FROM_PTR(head), FREELIST_VERSION(h));
     INK_MEMORY_BARRIER;
-    result = ink_atomic_cas(&f->head.data, h.data, item_pair.data);
+    result = ink_atomic_cas(&list->data, h.data, item_pair.data);
   }
 }
 
@@ -453,6 +515,25 @@ ink_freelists_dump(FILE *f)
   fprintf(f, "-----------------------------------------------------------------------------------------\n");
 }
 
+void
+ink_freelists_numa_init(int n_nodes)
+{
+  ink_release_assert(freelist_numa_nodes == 0 && n_nodes > 0);
+  ink_thread_key_create(&freelist_node_key, NULL);
+  freelist_numa_nodes = n_nodes;
+  for (ink_freelist_list *fll = freelists; fll; fll = fll->next)
+    freelist_node_init(fll->fl);
+}
+
+void
+ink_freelist_set_thread_node(int node)
+{
+  if (freelist_numa_nodes) {
+    ink_assert(node >= 0 && node < freelist_numa_nodes);
+    ink_thread_setspecific(freelist_node_key, (void *)(intptr_t)(node + 1));
+  }
+}
+
 void
 ink_atomiclist_init(InkAtomicList *l, const char *name, uint32_t offset_to_next)
 {
@@ -148,6 +148,7 @@ struct _InkFreeList {
   uint32_t type_size, chunk_size, used, allocated, alignment;
   uint32_t allocated_base, used_base;
   int advice;
+  volatile head_p *node_head; /* per NUMA node free items, see ink_freelists_numa_init() */
 };
 
 typedef struct ink_freelist_ops InkFreeListOps;
@@ -172,6 +173,15 @@ void ink_freelists_dump(FILE *f);
 void ink_freelists_dump_baselinerel(FILE *f);
 void ink_freelists_snap_baseline();
 
+/*
+ * Give every freelist a separate head for each of @a n_nodes NUMA nodes.
+ * Threads which called ink_freelist_set_thread_node() allocate from and free
+ * to the head of their node, everybody else uses the shared head.  Must be
+ * called before any thread sets its node.
+ */
+void ink_freelists_numa_init(int n_nodes);
+void ink_freelist_set_thread_node(int node);
+
 typedef struct {
   volatile head_p head;
   const char *name;
@@ -0,0 +1,343 @@
+/** @file
+
+    Tests and timings of the compact string indexes.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "ts/ink_assert.h"
+#include "ts/ink_defs.h"
+#include "ts/ink_hrtime.h"
+#include "ts/ink_hash_table.h"
+#include "ts/Diags.h"
+#include "ts/Trie.h"
+#include "ts/CompactIndex.h"
+
+struct Value {
+  int id;
+};
+
+// Trie deletes its values, and keeps them in a list.
+struct TrieValue {
+  int id;
+  LINK(TrieValue, link);
+};
+
+static int visited;
+
+static void
+visit(Value *)
+{
+  ++visited;
+}
+
+static void
+test_string_map()
+{
+  static const char *keys[] = {"", "a", "ab", "www.example.com", "example.com", "www.example.co", "WWW.example.com"};
+  CompactStringMap<Value>::Entry entries[countof(keys)];
+  Value values[countof(keys)];
+  CompactStringMap<Value> map;
+
+  for (unsigned int i = 0; i < countof(keys); i++) {
+    values[i].id = i;
+    entries[i].key = keys[i];
+    entries[i].key_len = strlen(keys[i]);
+    entries[i].rank = 0;
+    entries[i].value = &values[i];
+  }
+  ink_release_assert(map.Build(entries, countof(keys)));
+  ink_release_assert(map.Size() == static_cast<int>(countof(keys)));
+
+  visited = 0;
+  map.ForEach(visit);
+  ink_release_assert(visited == static_cast<int>(countof(keys)));
+
+  for (unsigned int i = 0; i < countof(keys); i++) {
+    ink_release_assert(map.Find(keys[i], strlen(keys[i])) == &values[i]);
+  }
+  ink_release_assert(map.Find("b", 1) == NULL);
+  ink_release_assert(map.Find("www.example.comx", 16) == NULL);
+  ink_release_assert(map.Find("www.example.comx", 15) == &values[3]);
+
+  // Duplicates are refused.
+  entries[1].key = "ab";
+  entries[1].key_len = 2;
+  ink_release_assert(!map.Build(entries, countof(keys)));
+
+  CompactStringMap<Value> empty;
+  ink_release_assert(empty.Find("a", 1) == NULL);
+  printf("test_string_map PASSED\n");
+}
+
+// The value Trie::Search would give, by looking at every key.
+static Value *
+brute_force_search(CompactPrefixMap<Value>::Entry *entries, int count, const char *key, int key_len)
+{
+  CompactPrefixMap<Value>::Entry *found = NULL;
+
+  for (int i = 0; i < count; i++) {
+    if (entries[i].key_len <= key_len && memcmp(entries[i].key, key, entries[i].key_len) == 0) {
+      if (!found || entries[i].rank < found->rank || (entries[i].rank == found->rank && entries[i].key_len > found->key_len)) {
+        found = &entries[i];
+      }
+    }
+  }
+  return found ? found->value : NULL;
+}
+
+static void
+test_prefix_map()
+{
+  static const char letters[] = "ab/\xff";
+  unsigned int seed = 1;
+
+  for (int n = 0; n < 500; n++) {
+    char keys[40][8];
+    Value values[40];
+    CompactPrefixMap<Value>::Entry entries[40], sorted[40];
+    CompactPrefixMap<Value> map;
+    int count = 0;
+
+    for (int i = 0; i < 40; i++) {
+      int len = rand_r(&seed) % 6;
+      for (int k = 0; k < len; k++) {
+        keys[count][k] = letters[rand_r(&seed) % (sizeof(letters) - 1)];
+      }
+      // Skip duplicates, they are tried below.
+      bool dup = false;
+      for (int j = 0; j < count; j++) {
+        dup = dup || (entries[j].key_len == len && memcmp(entries[j].key, keys[count], len) == 0);
+      }
+      if (dup) {
+        continue;
+      }
+      values[count].id = count;
+      entries[count].key = keys[count];
+      entries[count].key_len = len;
+      entries[count].rank = rand_r(&seed) % 10;
+      entries[count].value = &values[count];
+      ++count;
+    }
+
+    memcpy(sorted, entries, sizeof(entries));
+    ink_release_assert(map.Build(sorted, count));
+
+    visited = 0;
+    map.ForEach(visit);
+    ink_release_assert(visited == count);
+
+    for (int j = 0; j < 100; j++) {
+      char key[10];
+      int len = rand_r(&seed) % sizeof(key);
+      for (int k = 0; k < len; k++) {
+        key[k] = letters[rand_r(&seed) % (sizeof(letters) - 1)];
+      }
+      ink_release_assert(map.Search(key, len) == brute_force_search(entries, count, key, len));
+    }
+
+    if (count > 1) {
+      memcpy(sorted, entries, sizeof(entries));
+      sorted[count - 1].key = sorted[0].key;
+      sorted[count - 1].key_len = sorted[0].key_len;
+      ink_release_assert(!map.Build(sorted, count));
+    }
+  }
+
+  CompactPrefixMap<Value> empty;
+  ink_release_assert(empty.Search("a", 1) == NULL);
+  printf("test_prefix_map PASSED\n");
+}
+
+// Resident memory of the process, 0 where /proc/self/statm is not available.
+static int64_t
+resident_size()
+{
+  long pages = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+
+  if (fp) {
+    if (fscanf(fp, "%*ld %ld", &pages) != 1) {
+      pages = 0;
+    }
+    fclose(fp);
+  }
+  return (int64_t)pages * sysconf(_SC_PAGESIZE);
+}
+
+// Time building and searching indexes the size of a remap.config with 500,000 rules, and the memory they take, against
+// the hash table the hosts used to be in and the Trie the paths would otherwise be in. Lookups are about as fast in
+// either, within the noise of a run; the compact indexes take less memory, and CompactStringMap takes a little longer to
+// build than InkHashTable since it sorts the keys on their hashes.
+static void
+test_bench()
+{
+  const int count = 500000;
+  // Trie takes 2KB a node, about 5GB for all the paths, so it is compared with CompactPrefixMap on fewer of them. Its
+  // lookups are a little faster, one node a byte without a search of the children, as long as it fits.
+  const int trie_count = 10000;
+  const int lookups = 1000000;
+  const int key_size = 48;
+  char *keys = static_cast<char *>(ats_malloc(count * key_size));
+  char *queries = static_cast<char *>(ats_malloc(lookups * key_size));
+  int *query_lens = static_cast<int *>(ats_malloc(lookups * sizeof(int)));
+  int *query_ids = static_cast<int *>(ats_malloc(lookups * sizeof(int)));
+  Value *values = static_cast<Value *>(ats_malloc(count * sizeof(Value)));
+  CompactStringMap<Value>::Entry *entries = static_cast<CompactStringMap<Value>::Entry *>(ats_malloc(count * sizeof(entries[0])));
+  CompactStringMap<Value> hosts;
+  CompactPrefixMap<Value> paths;
+  InkHashTable *table = ink_hash_table_create(InkHashTableKeyType_String);
+  unsigned int seed = 1;
+  ink_hrtime start, build_time, find_time;
+  int64_t size;
+  int found = 0;
+
+  for (int i = 0; i < count; i++) {
+    values[i].id = i;
+    entries[i].key = keys + i * key_size;
+    entries[i].key_len = snprintf(keys + i * key_size, key_size, "www%d.example.com", i);
+    entries[i].rank = i;
+    entries[i].value = &values[i];
+  }
+  for (int i = 0; i < lookups; i++) {
+    query_ids[i] = rand_r(&seed) % count;
+    query_lens[i] = snprintf(queries + i * key_size, key_size, "www%d.example.com", query_ids[i]);
+  }
+
+  size = resident_size();
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < count; i++) {
+    ink_hash_table_insert(table, entries[i].key, entries[i].value);
+  }
+  build_time = ink_get_hrtime_internal() - start;
+  size = resident_size() - size;
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < lookups; i++) {
+    void *value;
+    found += ink_hash_table_lookup(table, queries + i * key_size, &value) && value == &values[query_ids[i]];
+  }
+  find_time = ink_get_hrtime_internal() - start;
+  ink_release_assert(found == lookups);
+  printf("%d hosts in InkHashTable: build %" PRId64 " ms, lookup %" PRId64 " ns, %" PRId64 " MB\n", count,
+         build_time / HRTIME_MSECOND, find_time / lookups, size >> 20);
+
+  // The hash table is kept until the map is built, so the map does not reuse its memory.
+  found = 0;
+  size = resident_size();
+  start = ink_get_hrtime_internal();
+  ink_release_assert(hosts.Build(entries, count));
+  build_time = ink_get_hrtime_internal() - start;
+  size = resident_size() - size;
+  ink_hash_table_destroy(table);
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < lookups; i++) {
+    found += hosts.Find(queries + i * key_size, query_lens[i]) == &values[query_ids[i]];
+  }
+  find_time = ink_get_hrtime_internal() - start;
+  ink_release_assert(found == lookups);
+  printf("%d hosts in CompactStringMap: build %" PRId64 " ms, lookup %" PRId64 " ns, %" PRId64 " MB\n", count,
+         build_time / HRTIME_MSECOND, find_time / lookups, size >> 20);
+
+  for (int i = 0; i < count; i++) {
+    entries[i].key_len = snprintf(keys + i * key_size, key_size, "images/%d/%d/", i % 1000, i);
+  }
+  for (int i = 0; i < lookups; i++) {
+    int n = query_ids[i];
+    query_lens[i] = snprintf(queries + i * key_size, key_size, "images/%d/%d/thumb.jpg", n % 1000, n);
+  }
+
+  found = 0;
+  size = resident_size();
+  start = ink_get_hrtime_internal();
+  ink_release_assert(paths.Build(entries, count));
+  build_time = ink_get_hrtime_internal() - start;
+  size = resident_size() - size;
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < lookups; i++) {
+    found += paths.Search(queries + i * key_size, query_lens[i]) == &values[query_ids[i]];
+  }
+  find_time = ink_get_hrtime_internal() - start;
+  ink_release_assert(found == lookups);
+  printf("%d paths in CompactPrefixMap: build %" PRId64 " ms, lookup %" PRId64 " ns, %" PRId64 " MB\n", count,
+         build_time / HRTIME_MSECOND, find_time / lookups, size >> 20);
+
+  // The entries were sorted by the build, so take the first of them, and only look up those.
+  Trie<TrieValue> trie;
+  CompactPrefixMap<Value> trie_paths;
+
+  for (int i = 0; i < lookups; i++) {
+    int n = entries[query_ids[i] % trie_count].value->id;
+    query_ids[i] = n;
+    query_lens[i] = snprintf(queries + i * key_size, key_size, "images/%d/%d/thumb.jpg", n % 1000, n);
+  }
+
+  size = resident_size();
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < trie_count; i++) {
+    TrieValue *value = new TrieValue;
+
+    value->id = entries[i].value->id;
+    ink_release_assert(trie.Insert(entries[i].key, value, entries[i].rank, entries[i].key_len));
+  }
+  build_time = ink_get_hrtime_internal() - start;
+  size = resident_size() - size;
+  found = 0;
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < lookups; i++) {
+    TrieValue *value = trie.Search(queries + i * key_size, query_lens[i]);
+    found += value && value->id == query_ids[i];
+  }
+  find_time = ink_get_hrtime_internal() - start;
+  ink_release_assert(found == lookups);
+  printf("%d paths in Trie: build %" PRId64 " ms, lookup %" PRId64 " ns, %" PRId64 " MB\n", trie_count,
+         build_time / HRTIME_MSECOND, find_time / lookups, size >> 20);
+
+  found = 0;
+  size = resident_size();
+  start = ink_get_hrtime_internal();
+  ink_release_assert(trie_paths.Build(entries, trie_count));
+  build_time = ink_get_hrtime_internal() - start;
+  size = resident_size() - size;
+  trie.Clear();
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < lookups; i++) {
+    found += trie_paths.Search(queries + i * key_size, query_lens[i]) == &values[query_ids[i]];
+  }
+  find_time = ink_get_hrtime_internal() - start;
+  ink_release_assert(found == lookups);
+  printf("%d paths in CompactPrefixMap: build %" PRId64 " ms, lookup %" PRId64 " ns, %" PRId64 " KB\n", trie_count,
+         build_time / HRTIME_MSECOND, find_time / lookups, size >> 10);
+
+  ats_free(entries);
+  ats_free(values);
+  ats_free(query_ids);
+  ats_free(query_lens);
+  ats_free(queries);
+  ats_free(keys);
+}
+
+int
+main(int /* argc ATS_UNUSED */, char ** /* argv ATS_UNUSED */)
+{
+  test_string_map();
+  test_prefix_map();
+  test_bench();
+  printf("test_CompactIndex PASSED\n");
+}
@@ -0,0 +1,100 @@
+/** @file
+
+    Unit tests for Histogram
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <ts/TestBox.h>
+
+#include "Histogram.h"
+
+// Every value falls in a bucket whose bounds contain it, and buckets are contiguous.
+REGRESSION_TEST(Histogram_Buckets)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  for (int i = 1; i < Histogram::N_BUCKETS; i++) {
+    if (Histogram::bucket_lower(i) != Histogram::bucket_upper(i - 1) + 1) {
+      box.check(false, "bucket %d does not start after bucket %d", i, i - 1);
+      break;
+    }
+  }
+  box.check(Histogram::bucket_upper(Histogram::N_BUCKETS - 1) == UINT64_MAX, "last bucket should end at UINT64_MAX");
+
+  uint64_t values[] = {0, 1, 7, 8, 9, 15, 16, 17, 1000, 123456789, 1ULL << 40, UINT64_MAX};
+  for (unsigned i = 0; i < countof(values); i++) {
+    int b = Histogram::bucket_index(values[i]);
+    box.check(b >= 0 && b < Histogram::N_BUCKETS, "value %" PRIu64 " out of range bucket %d", values[i], b);
+    box.check(Histogram::bucket_lower(b) <= values[i] && values[i] <= Histogram::bucket_upper(b),
+              "value %" PRIu64 " not within bucket %d", values[i], b);
+  }
+}
+
+// Percentiles are within the bucket precision.
+REGRESSION_TEST(Histogram_Percentile)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Histogram h;
+  box.check(h.percentile(50) == 0, "empty histogram should report 0");
+
+  for (uint64_t v = 1; v <= 10000; v++)
+    h.record(v);
+  box.check(h.count() == 10000, "count should be 10000");
+  box.check(h.max() == 10000, "max should be 10000");
+
+  uint64_t p50 = h.percentile(50);
+  uint64_t p99 = h.percentile(99);
+  box.check(p50 >= 5000 && p50 <= 5000 + 5000 / Histogram::SUB_BUCKETS, "p50 %" PRIu64 " out of range", p50);
+  box.check(p99 >= 9900 && p99 <= 10000, "p99 %" PRIu64 " out of range", p99);
+  box.check(h.percentile(100) == 10000, "p100 should be the max");
+
+  Histogram m;
+  m.record(1000000);
+  m.merge(h);
+  box.check(m.count() == 10001, "merged count should be 10001");
+  box.check(m.max() == 1000000, "merged max should be 1000000");
+  box.check(m.percentile(50) == p50, "merge should not move the median");
+
+  Histogram d = m;
+  d.record(3);
+  d.record(20000);
+  d.subtract(m);
+  box.check(d.count() == 2, "difference count should be 2");
+  box.check(d.percentile(50) == 3, "difference median should be 3");
+  box.check(d.max() >= 20000 && d.max() <= 20000 + 20000 / Histogram::SUB_BUCKETS, "difference max %" PRIu64 " out of range",
+            d.max());
+  d.subtract(d);
+  box.check(d.count() == 0 && d.max() == 0, "subtracting itself should empty the histogram");
+
+  m.reset();
+  box.check(m.count() == 0 && m.max() == 0 && m.percentile(99) == 0, "reset should empty the histogram");
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char ** /* argv ATS_UNUSED */)
+{
+  const char *name = "Histogram";
+  RegressionTest::run(name);
+
+  return RegressionTest::final_status == REGRESSION_TEST_PASSED ? 0 : 1;
+}
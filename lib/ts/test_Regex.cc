@@ -19,8 +19,11 @@
   limitations under the License.
 */
 
+#include <stdlib.h>
+#include <string.h>
 #include "ts/ink_assert.h"
 #include "ts/ink_defs.h"
+#include "ts/ink_hrtime.h"
 #include "ts/Regex.h"
 
 typedef struct {
@@ -53,9 +56,190 @@ test_basic()
   }
 }
 
+struct literal_test_t {
+  const char *regex;
+  const char *literal;
+};
+
+static const literal_test_t literal_test_data[] = {
+  {"^foo", "foo"},
+  {"^(.*)\\.example\\.com$", ".example.com"},
+  {"^www[0-9]+\\.Example\\.org", ".example.org"},
+  {"ab+c", "ab"},
+  {"abc*de", "ab"},
+  {"abc?defg", "defg"},
+  {"x{2}yz", "yz"},
+  {"a\\dbcd", "bcd"},
+  {"[abc]]de", "]de"},
+  {"[[:alpha:]]xy", "xy"},
+  {"(foo|bar)baz", "baz"},
+  {"(a(b)c)?de", "de"},
+  {"foo|bar", ""},
+  {"(?i)foo", ""},
+  {"foo\\1bar", ""},
+  {"\\x41bc", ""},
+  {".*", ""},
+};
+
+static void
+test_required_literal()
+{
+  for (unsigned int i = 0; i < countof(literal_test_data); i++) {
+    char buf[128];
+    int len = RegexPrefilter::required_literal(literal_test_data[i].regex, buf, sizeof(buf));
+
+    printf("Regex: %s Literal: %s\n", literal_test_data[i].regex, buf);
+    ink_assert(len == static_cast<int>(strlen(literal_test_data[i].literal)));
+    ink_assert(strcmp(buf, literal_test_data[i].literal) == 0);
+  }
+}
+
+static const char *prefilter_patterns[] = {
+  "^(.*)\\.example\\.com$", "^cdn[0-9]+\\.example\\.net$", "^([a-z]+)\\.img\\.example\\.org$", "^www\\.foo\\.(com|net)$",
+  "bar", "^[^.]+$", "(a|b)+\\.test$", "Static\\.", "\\.mp4$", "^api-v[12]\\.service\\.local$",
+};
+
+static const char *prefilter_subjects[] = {
+  "www.example.com", "cdn12.example.net", "cdn.example.net", "thumbs.img.example.org", "www.foo.com", "www.foo.org",
+  "bar.com", "localhost", "abab.test", "STATIC.example.com", "static.other.com", "video.mp4", "api-v1.service.local",
+  "api-v3.service.local", "",
+};
+
+static void
+test_prefilter()
+{
+  RegexPrefilter prefilter;
+  Regex regexes[countof(prefilter_patterns)];
+
+  for (unsigned int i = 0; i < countof(prefilter_patterns); i++) {
+    ink_assert(regexes[i].compile(prefilter_patterns[i]));
+    ink_assert(prefilter.add(prefilter_patterns[i]) == static_cast<int>(i));
+  }
+
+  // Before it is compiled everything is a candidate.
+  {
+    RegexCandidates candidates;
+    prefilter.scan("nothing", 7, candidates);
+    for (unsigned int i = 0; i < countof(prefilter_patterns); i++) {
+      ink_assert(candidates.test(i));
+    }
+  }
+
+  prefilter.compile();
+  for (unsigned int j = 0; j < countof(prefilter_subjects); j++) {
+    const char *subject = prefilter_subjects[j];
+    RegexCandidates candidates;
+    int skipped = 0;
+
+    prefilter.scan(subject, strlen(subject), candidates);
+    for (unsigned int i = 0; i < countof(prefilter_patterns); i++) {
+      // Every pattern which matches must be a candidate.
+      ink_assert(!regexes[i].exec(subject) || candidates.test(i));
+      skipped += !candidates.test(i);
+    }
+    printf("Subject: %s Skipped: %d of %d\n", subject, skipped, static_cast<int>(countof(prefilter_patterns)));
+  }
+}
+
+// Patterns and subjects put together at random from small pieces, to try the literals on more shapes of pattern.
+static void
+test_prefilter_random()
+{
+  static const char *pieces[] = {"a", "b", "ab", "c", "x", "\\.", "[ab]", "(a|bc)",
+                                 "a*", "b+", "c?", "x{2}", ".", ".*", "\\d", "(ab)?"};
+  static const char letters[] = "abcx.1";
+  unsigned int seed = 1;
+
+  for (int n = 0; n < 200; n++) {
+    RegexPrefilter prefilter;
+    Regex regexes[8];
+
+    for (unsigned int i = 0; i < countof(regexes); i++) {
+      char pattern[128] = "";
+      int npieces = 1 + rand_r(&seed) % 6;
+      for (int k = 0; k < npieces; k++) {
+        strcat(pattern, pieces[rand_r(&seed) % countof(pieces)]);
+      }
+      ink_assert(regexes[i].compile(pattern));
+      prefilter.add(pattern);
+    }
+    prefilter.compile();
+
+    for (int j = 0; j < 50; j++) {
+      char subject[16];
+      int len = rand_r(&seed) % (sizeof(subject) - 1);
+      for (int k = 0; k < len; k++) {
+        subject[k] = letters[rand_r(&seed) % (sizeof(letters) - 1)];
+      }
+      subject[len] = '\0';
+
+      RegexCandidates candidates;
+      prefilter.scan(subject, len, candidates);
+      for (unsigned int i = 0; i < countof(regexes); i++) {
+        ink_assert(!regexes[i].exec(subject, len) || candidates.test(i));
+      }
+    }
+  }
+}
+
+// Time finding the first match among many host patterns, one after the other and through the prefilter.
+static void
+test_prefilter_bench()
+{
+  const int npatterns = 2000;
+  const int nsubjects = 200;
+  RegexPrefilter prefilter;
+  Regex *regexes = new Regex[npatterns];
+  char buf[128];
+  ink_hrtime start, sequential, filtered;
+  int found = 0;
+
+  for (int i = 0; i < npatterns; i++) {
+    snprintf(buf, sizeof(buf), "^(.*)\\.site%d\\.example\\.com$", i);
+    ink_assert(regexes[i].compile(buf));
+    prefilter.add(buf);
+  }
+  prefilter.compile();
+
+  start = ink_get_hrtime_internal();
+  for (int j = 0; j < nsubjects; j++) {
+    int len = snprintf(buf, sizeof(buf), "www.site%d.example.com", j * 13);
+    for (int i = 0; i < npatterns; i++) {
+      if (regexes[i].exec(buf, len)) {
+        found += i;
+        break;
+      }
+    }
+  }
+  sequential = ink_get_hrtime_internal() - start;
+
+  start = ink_get_hrtime_internal();
+  for (int j = 0; j < nsubjects; j++) {
+    int len = snprintf(buf, sizeof(buf), "www.site%d.example.com", j * 13);
+    RegexCandidates candidates;
+    prefilter.scan(buf, len, candidates);
+    for (int i = 0; i < npatterns; i++) {
+      if (candidates.test(i) && regexes[i].exec(buf, len)) {
+        found -= i;
+        break;
+      }
+    }
+  }
+  filtered = ink_get_hrtime_internal() - start;
+
+  ink_assert(found == 0);
+  printf("%d patterns, %d lookups: sequential %" PRId64 " us, prefiltered %" PRId64 " us\n", npatterns, nsubjects,
+         sequential / HRTIME_USECOND, filtered / HRTIME_USECOND);
+  delete[] regexes;
+}
+
 int
 main(int /* argc ATS_UNUSED */, char ** /* argv ATS_UNUSED */)
 {
   test_basic();
+  test_required_literal();
+  test_prefilter();
+  test_prefilter_random();
+  test_prefilter_bench();
   printf("test_Regex PASSED\n");
 }
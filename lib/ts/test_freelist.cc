@@ -36,6 +36,9 @@ test(void *d)
   void *m1, *m2, *m3;
 
   id = (intptr_t)d;
+  // Spread the threads over two NUMA node heads and the shared one.
+  if (id % 3)
+    ink_freelist_set_thread_node(id % 2);
 
   time_t start = time(NULL);
   int count = 0;
@@ -65,12 +68,36 @@ test(void *d)
   }
 }
 
+// Items allocated on one node and freed on the other must be reused, not leave the first node to grow the list.
+static void
+cross_node_test()
+{
+  const int N = 1000;
+  void *items[N];
+  InkFreeList *f = ink_freelist_create("cross", 64, 256, 8);
+
+  for (int round = 0; round < 100; round++) {
+    ink_freelist_set_thread_node(0);
+    for (int i = 0; i < N; i++)
+      items[i] = ink_freelist_new(f);
+    ink_freelist_set_thread_node(1);
+    for (int i = 0; i < N; i++)
+      ink_freelist_free(f, items[i]);
+  }
+  if (f->allocated > N + f->chunk_size) {
+    fprintf(stderr, "cross node frees grew the freelist to %" PRIu32 " items for %d in use\n", f->allocated, N);
+    exit(1);
+  }
+}
+
 int
 main(int /* argc ATS_UNUSED */, char * /*argv ATS_UNUSED */ [])
 {
   int i;
 
   flist = ink_freelist_create("woof", 64, 256, 8);
+  ink_freelists_numa_init(2);
+  cross_node_test();
 
   for (i = 0; i < NTHREADS; i++) {
     fprintf(stderr, "Create thread %d\n", i);
@@ -1035,6 +1035,18 @@ LocalManager::bindProxyPort(HttpProxyPort &port)
     _exit(1);
   }
 
+#ifdef SO_REUSEPORT
+  {
+    // traffic_server opens a socket per net thread on this port, which the kernel only allows if every one
+    // of them, this one included, has SO_REUSEPORT set before it is bound.
+    bool found;
+    RecInt reuseport = REC_readInteger("proxy.config.net.listen_reuseport", &found);
+    if (found && reuseport > 0 && setsockopt(port.m_fd, SOL_SOCKET, SO_REUSEPORT, (char *)&one, sizeof(int)) < 0) {
+      mgmt_elog(stderr, 0, "[bindProxyPort] Unable to set SO_REUSEPORT: %d : %s\n", port.m_port, strerror(errno));
+    }
+  }
+#endif
+
   if (port.m_inbound_transparent_p) {
 #if TS_USE_TPROXY
     Debug("http_tproxy", "Listen port %d inbound transparency enabled.\n", port.m_port);
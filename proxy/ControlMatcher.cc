@@ -480,12 +480,26 @@ RegexMatcher<Data, Result>::NewEntry(matcher_line *line_info)
     pcre_free(re_array[num_el]);
     re_array[num_el] = NULL;
   } else {
+    prefilter.add(pattern);
     num_el++;
   }
 
   return error;
 }
 
+//
+// void RegexMatcher<Data,Result>::Compile()
+//
+//   Builds the prefilter once all the entries are in, so Match()
+//     only runs the regexs which could match
+//
+template <class Data, class Result>
+void
+RegexMatcher<Data, Result>::Compile()
+{
+  prefilter.compile();
+}
+
 //
 // void RegexMatcher<Data,Result>::Match(RequestData* rdata, Result* result)
 //
@@ -517,8 +531,15 @@ RegexMatcher<Data, Result>::Match(RequestData *rdata, Result *result)
   // HttpRequestData::get_string(); therefore, no need to call again here.
   // unescapifyStr(url_str);
 
+  RegexCandidates candidates;
+  int url_len = strlen(url_str);
+
+  prefilter.scan(url_str, url_len, candidates);
   for (int i = 0; i < num_el; i++) {
-    r = pcre_exec(re_array[i], NULL, url_str, strlen(url_str), 0, 0, NULL, 0);
+    if (!candidates.test(i)) {
+      continue;
+    }
+    r = pcre_exec(re_array[i], NULL, url_str, url_len, 0, 0, NULL, 0);
     if (r > -1) {
       Debug("matcher", "%s Matched %s with regex at line %d", matcher_name, url_str, data_array[i].line_num);
       data_array[i].UpdateMatch(result, rdata);
@@ -565,16 +586,24 @@ HostRegexMatcher<Data, Result>::Match(RequestData *rdata, Result *result)
   if (url_str == NULL) {
     url_str = "";
   }
+
+  RegexCandidates candidates;
+  int url_len = strlen(url_str);
+
+  this->prefilter.scan(url_str, url_len, candidates);
   for (int i = 0; i < this->num_el; i++) {
-    r = pcre_exec(this->re_array[i], NULL, url_str, strlen(url_str), 0, 0, NULL, 0);
-    if (r != -1) {
+    if (!candidates.test(i)) {
+      continue;
+    }
+    r = pcre_exec(this->re_array[i], NULL, url_str, url_len, 0, 0, NULL, 0);
+    if (r > -1) {
       Debug("matcher", "%s Matched %s with regex at line %d", const_cast<char *>(this->matcher_name), url_str,
             this->data_array[i].line_num);
       this->data_array[i].UpdateMatch(result, rdata);
-    } else {
+    } else if (r < -1) {
       // An error has occured
-      Warning("error matching regex at line %d", this->data_array[i].line_num);
-    }
+      Warning("Error [%d] matching regex at line %d.", r, this->data_array[i].line_num);
+    } // else it's -1 which means no match was found.
   }
 }
 
@@ -946,6 +975,13 @@ ControlMatcher<Data, Result>::BuildTableFromString(char *file_buf)
 
   ink_assert(second_pass == numEntries);
 
+  if (reMatch != NULL) {
+    reMatch->Compile();
+  }
+  if (hrMatch != NULL) {
+    hrMatch->Compile();
+  }
+
   if (is_debug_tag_set("matcher")) {
     Print();
   }
@@ -193,6 +193,7 @@ public:
   void Match(RequestData *rdata, Result *result);
   void AllocateSpace(int num_entries);
   config_parse_error NewEntry(matcher_line *line_info);
+  void Compile();
   void Print();
 
   int
@@ -209,6 +210,7 @@ public:
 protected:
   pcre **re_array;          // array of compiled regexs
   char **re_str;            // array of uncompiled regex strings
+  RegexPrefilter prefilter; // the regexs which could match a string, after Compile()
   Data *data_array;         // data array.  Corresponds to re_array
   int array_len;            // length of the arrays (all three are the same length)
   int num_el;               // number of elements in the table
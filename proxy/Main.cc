@@ -1794,6 +1794,11 @@ main(int /* argc ATS_UNUSED */, const char **argv)
 
     pmgmt->registerPluginCallbacks(global_config_cbs);
 
+    // The URL hash for cache keys, before anything is looked up. Pre 4.0 stripes override this.
+    if (REC_ConfigReadInteger("proxy.config.cache.url_hash") == 1) {
+      URLHashContext::Setting = URLHashContext::SIP;
+    }
+
     cacheProcessor.afterInitCallbackSet(&CB_After_Cache_Init);
     cacheProcessor.start();
 
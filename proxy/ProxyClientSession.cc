@@ -66,10 +66,45 @@ is_valid_hook(TSHttpHookID hookid)
   return (hookid >= 0) && (hookid < TS_HTTP_LAST_HOOK);
 }
 
+HdrHeapCache::~HdrHeapCache()
+{
+  while (count > 0) {
+    heaps[--count]->destroy();
+  }
+}
+
+HdrHeap *
+HdrHeapCache::take()
+{
+  return count > 0 ? heaps[--count] : NULL;
+}
+
+void
+HdrHeapCache::put(HdrHeap *heap)
+{
+  // Only heaps of the default size are kept, a header starts in one and only grows into bigger ones.
+  if (count < HDR_HEAP_CACHE_SIZE && heap->m_size == HDR_HEAP_DEFAULT_SIZE && heap->m_writeable) {
+    heap->reset();
+    heaps[count++] = heap;
+  } else {
+    heap->destroy();
+  }
+}
+
+HdrHeapCache *
+ProxyClientSession::get_hdr_heap_cache()
+{
+  if (!this->hdr_heap_cache) {
+    this->hdr_heap_cache = new HdrHeapCache(this->mutex);
+  }
+  return this->hdr_heap_cache;
+}
+
 void
 ProxyClientSession::destroy()
 {
   this->api_hooks.clear();
+  this->hdr_heap_cache.clear();
   this->mutex.clear();
 }
 
@@ -38,6 +38,32 @@
 class ProxyClientTransaction;
 struct AclRecord;
 
+// Header heaps kept between the transactions of a session, one for each header a transaction builds.
+#define HDR_HEAP_CACHE_SIZE 4
+
+/** Header heaps left by the finished transactions of a session, emptied for the next ones to use.
+
+    It is shared by the session and its state machines so that it outlives whichever of them goes first. Hold
+    @a mutex, the mutex of the session, to take or put a heap.
+*/
+class HdrHeapCache : public RefCountObj
+{
+public:
+  HdrHeapCache(ProxyMutex *m) : mutex(m), count(0) {}
+  ~HdrHeapCache();
+
+  // Take a heap for a header, NULL if there are none.
+  HdrHeap *take();
+  // Empty @a heap and keep it, or destroy it if it can't be kept.
+  void put(HdrHeap *heap);
+
+  Ptr<ProxyMutex> mutex;
+
+private:
+  HdrHeap *heaps[HDR_HEAP_CACHE_SIZE];
+  int count;
+};
+
 class ProxyClientSession : public VConnection
 {
 public:
@@ -149,6 +175,9 @@ public:
     return NULL;
   }
 
+  // The header heaps of the session, for its state machines to reuse.
+  HdrHeapCache *get_hdr_heap_cache();
+
   /// DNS resolution preferences.
   HostResStyle host_res_style;
 
@@ -192,6 +221,7 @@ private:
   APIHook *api_current;
   HttpAPIHooks api_hooks;
   void *user_args[HTTP_SSN_TXN_MAX_USER_ARG];
+  Ptr<HdrHeapCache> hdr_heap_cache;
 
   ProxyClientSession(ProxyClientSession &);                  // noncopyable
   ProxyClientSession &operator=(const ProxyClientSession &); // noncopyable
@@ -207,6 +207,14 @@ public:
 
   virtual bool allow_half_open() const = 0;
 
+  // Whether the transaction has its session's connection to itself, so a
+  // blind tunnel may move data directly between sockets.
+  virtual bool
+  allow_splice() const
+  {
+    return false;
+  }
+
   virtual const char *get_protocol_string() const = 0;
 
   void
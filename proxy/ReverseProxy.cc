@@ -62,6 +62,72 @@ remap_plugin_info *remap_pi_list; // We never reload the remap plugins, just app
 
 int url_remap_mode;
 
+/** Resident set size of the process in bytes, 0 where it can not be read. */
+int64_t
+process_resident_size()
+{
+  int64_t pages = 0;
+  int64_t resident = 0;
+  FILE *fp = fopen("/proc/self/statm", "r");
+
+  if (fp != NULL) {
+    if (fscanf(fp, "%" SCNd64 " %" SCNd64, &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(fp);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+  Builds a remap table from remap.config, reusing the plugin instances of @a previous for the rules which did not
+  change, for plugins which opted in or all of them if proxy.config.url_remap.reuse_plugin_instances is set. Every
+  rule is parsed and built again either way. Reports how long it took, the memory in use with both tables loaded, and
+  what changed.
+
+*/
+static UrlRewrite *
+load_url_rewrite(UrlRewrite *previous)
+{
+  int reuse = 0;
+  int added, removed, changed;
+
+  REC_ReadConfigInteger(reuse, "proxy.config.url_remap.reuse_plugin_instances");
+
+  int64_t start_size = process_resident_size();
+  ink_hrtime start = Thread::get_hrtime_updated();
+  UrlRewrite *table = new UrlRewrite(previous, reuse != 0);
+  ink_hrtime elapsed = Thread::get_hrtime_updated() - start;
+  int64_t end_size = process_resident_size();
+
+  if (!table->is_valid()) {
+    return table;
+  }
+
+  if (previous) {
+    table->DiffMappings(previous, added, removed, changed);
+  } else {
+    added = table->num_rules_forward + table->num_rules_reverse + table->num_rules_redirect_permanent +
+            table->num_rules_redirect_temporary + table->num_rules_forward_with_recv_port;
+    removed = changed = 0;
+  }
+  Note("remap.config loaded in %" PRId64 " ms, %d rules added, %d removed, %d changed, %d plugin instances reused",
+       ink_hrtime_to_msec(elapsed), added, removed, changed, table->num_plugin_instances_reused);
+
+  if (http_rsb == NULL) { // Not running, only checking the configuration
+    return table;
+  }
+  RecSetGlobalRawStatSum(http_rsb, http_remap_reload_time_stat, ink_hrtime_to_msec(elapsed));
+  RecSetGlobalRawStatSum(http_rsb, http_remap_reload_resident_memory_stat, end_size);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_reload_memory_growth_stat, end_size > start_size ? end_size - start_size : 0);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_rules_added_stat, added);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_rules_removed_stat, removed);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_rules_changed_stat, changed);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_plugin_instances_created_stat, table->num_plugin_instances_created);
+  RecSetGlobalRawStatSum(http_rsb, http_remap_plugin_instances_reused_stat, table->num_plugin_instances_reused);
+  return table;
+}
+
 //
 // Begin API Functions
 //
@@ -71,7 +137,7 @@ init_reverse_proxy()
 {
   ink_assert(rewrite_table == NULL);
   reconfig_mutex = new_ProxyMutex();
-  rewrite_table = new UrlRewrite();
+  rewrite_table = load_url_rewrite(NULL);
 
   if (!rewrite_table->is_valid()) {
     Warning("Can not load the remap table, exiting out!");
@@ -150,7 +216,7 @@ reloadUrlRewrite()
   UrlRewrite *newTable;
 
   Debug("url_rewrite", "remap.config updated, reloading...");
-  newTable = new UrlRewrite();
+  newTable = load_url_rewrite(rewrite_table);
   if (newTable->is_valid()) {
     new_Deleter(rewrite_table, URL_REWRITE_TIMEOUT);
     Debug("url_rewrite", "remap.config done reloading!");
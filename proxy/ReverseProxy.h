@@ -69,4 +69,6 @@ bool reloadUrlRewrite();
 
 int url_rewrite_CB(const char *name, RecDataT data_type, RecData data, void *cookie);
 
+int64_t process_resident_size();
+
 #endif
@@ -119,6 +119,14 @@ tsapi void TSRemapDeleteInstance(void *);
 */
 tsapi void TSRemapOSResponse(void *ih, TSHttpTxn rh, int os_response_type);
 
+/* Instance reuse across remap.config reloads, called once when the plugin is loaded.
+   Optional function. A plugin whose instances depend on nothing but their arguments
+   and the files those arguments name can return non-zero, to keep its instances for
+   the rules a reload does not change instead of creating them anew.
+   Return: non-zero to have instances reused
+*/
+tsapi int TSRemapReuseInstances(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -1666,6 +1666,9 @@ tsapi TS_DEPRECATED TSReturnCode TSHttpIsInternalSession(TSHttpSsn ssnp);
 tsapi TSReturnCode TSHttpTxnIsInternal(TSHttpTxn txnp);
 tsapi TSReturnCode TSHttpSsnIsInternal(TSHttpSsn ssnp);
 
+/* Push url to the client of an HTTP/2 transaction */
+tsapi TSReturnCode TSHttpTxnServerPush(TSHttpTxn txnp, const char *url, int url_len);
+
 /* --------------------------------------------------------------------------
    HTTP alternate selection */
 tsapi TSReturnCode TSHttpAltInfoClientReqGet(TSHttpAltInfo infop, TSMBuffer *bufp, TSMLoc *offset);
@@ -0,0 +1,79 @@
+/** @file
+
+  Generate the parameters of the perfect hash of the commonly tokenized strings.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include "HdrTokenHash.h"
+
+// Seeds to try for each table size before going to a bigger table.
+#define MAX_SEED_TRIES (1 << 20)
+
+static bool
+is_perfect(uint64_t seed, int bits)
+{
+  std::vector<bool> used(1 << bits);
+
+  for (unsigned i = 0; i < SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+    const char *str = _hdrtoken_commonly_tokenized_strs[i];
+    uint32_t slot = hdrtoken_hash(str, strlen(str), seed, bits);
+
+    if (used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  return true;
+}
+
+int
+main()
+{
+  int bits = 1;
+
+  // Start from the smallest table which is no more than half full.
+  while ((1U << bits) < 2 * SIZEOF(_hdrtoken_commonly_tokenized_strs)) {
+    ++bits;
+  }
+
+  for (; bits <= 16; bits++) {
+    for (uint64_t i = 1; i <= MAX_SEED_TRIES; i++) {
+      uint64_t seed = i * 0x9e3779b97f4a7c15ULL;
+
+      if (is_perfect(seed, bits)) {
+        FILE *fp = fopen("HdrTokenHashSeed", "w");
+        if (fp == NULL) {
+          perror("HdrTokenHashSeed");
+          return 1;
+        }
+        fprintf(fp, "// Generated by CompileHdrTokenHash, do not edit.\n");
+        fprintf(fp, "#define HDRTOKEN_HASH_BITS %d\n", bits);
+        fprintf(fp, "#define HDRTOKEN_HASH_SEED 0x%016llxULL\n", static_cast<unsigned long long>(seed));
+        fclose(fp);
+        return 0;
+      }
+    }
+  }
+
+  fprintf(stderr, "CompileHdrTokenHash: no perfect hash for the commonly tokenized strings, are there duplicates?\n");
+  return 1;
+}
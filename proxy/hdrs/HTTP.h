@@ -826,7 +826,9 @@ HTTPHdr::copy(const HTTPHdr *hdr)
   if (valid()) {
     http_hdr_copy_onto(hdr->m_http, hdr->m_heap, m_http, m_heap, (m_heap != hdr->m_heap) ? true : false);
   } else {
-    m_heap = new_HdrHeap();
+    if (!m_heap) {
+      m_heap = new_HdrHeap();
+    }
     m_http = http_hdr_clone(hdr->m_http, hdr->m_heap, m_heap);
     m_mime = m_http->m_fields_impl;
   }
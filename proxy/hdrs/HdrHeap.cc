@@ -186,6 +186,41 @@ HdrHeap::destroy()
   }
 }
 
+// void HdrHeap::reset()
+//
+//    Empties the heap for reuse by another header.  The first
+//     block is kept, and so is the read-write string heap if
+//     no other header has inherited it, reset to empty.
+//
+void
+HdrHeap::reset()
+{
+  ink_assert(m_writeable);
+
+  if (m_next) {
+    m_next->destroy();
+  }
+
+  HdrStrHeap *str_heap = NULL;
+  if (m_read_write_heap && m_read_write_heap->refcount() == 1) {
+    str_heap = m_read_write_heap;
+    str_heap->refcount_inc();
+  }
+
+  m_read_write_heap = NULL;
+  for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++)
+    m_ronly_heap[i].m_ref_count_ptr = NULL;
+
+  init();
+
+  if (str_heap) {
+    str_heap->m_free_start = ((char *)str_heap) + STR_HEAP_HDR_SIZE;
+    str_heap->m_free_size = str_heap->m_heap_size - STR_HEAP_HDR_SIZE;
+    m_read_write_heap = str_heap;
+    str_heap->refcount_dec();
+  }
+}
+
 HdrHeapObjImpl *
 HdrHeap::allocate_obj(int nbytes, int type)
 {
@@ -180,6 +180,7 @@ class HdrHeap
 public:
   void init();
   inkcoreapi void destroy();
+  void reset();
 
   // PtrHeap allocation
   HdrHeapObjImpl *allocate_obj(int nbytes, int type);
@@ -77,6 +77,7 @@ HdrTest::go(RegressionTest *t, int /* atype ATS_UNUSED */)
   status = status & test_regex();
   status = status & test_http_parser_eos_boundary_cases();
   status = status & test_http_mutation();
+  status = status & test_http_hdr_copy_sharing();
   status = status & test_mime();
   status = status & test_http();
 
@@ -1630,6 +1631,118 @@ HdrTest::test_http_mutation()
   return (failures_to_status("test_http_mutation", (status == 0)));
 }
 
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+int
+HdrTest::test_http_hdr_copy_sharing()
+{
+  int failures = 0;
+
+  bri_box("test_http_hdr_copy_sharing");
+
+  HTTPHdr src, dst;
+  HTTPParser parser;
+  char buf[8192];
+  char field_name[32];
+  char field_value[32];
+  int len, i, err;
+  const char *start, *end;
+
+  /*** (1) parse a request with enough fields to chain field blocks ***/
+
+  len = snprintf(buf, sizeof(buf), "GET http://foo.com/bar.txt HTTP/1.1\r\n");
+  for (i = 1; i <= 50; i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, "X-Test%d: value %d\r\n", i, i);
+  }
+  len += snprintf(buf + len, sizeof(buf) - len, "\r\n");
+
+  start = buf;
+  end = start + len;
+  http_parser_init(&parser);
+  src.create(HTTP_TYPE_REQUEST);
+  while (1) {
+    err = src.parse_req(&parser, &start, end, true);
+    if (err != PARSE_CONT)
+      break;
+  }
+  http_parser_clear(&parser);
+
+  if (err != PARSE_DONE || src.fields_count() != 50) {
+    printf("FAILED: parse of %d byte request\n", len);
+    src.destroy();
+    return (failures_to_status("test_http_hdr_copy_sharing", 1));
+  }
+
+  /*** (2) copy it, the chained blocks are copied up to their free top and the strings are shared ***/
+
+  int blocks = 0;
+
+  dst.copy(&src);
+  for (MIMEFieldBlockImpl *fblock = &src.m_mime->m_first_fblock; fblock; fblock = fblock->m_next) {
+    ++blocks;
+  }
+  if (blocks < 3) {
+    printf("FAILED: %d field blocks, the fields are not chained\n", blocks);
+    ++failures;
+  }
+  if (dst.m_heap == src.m_heap || dst.fields_count() != 50) {
+    printf("FAILED: copy is not in its own heap with all fields\n");
+    ++failures;
+  }
+
+  for (i = 1; i <= 50; i++) {
+    int n_len = snprintf(field_name, sizeof(field_name), "X-Test%d", i);
+    MIMEField *s_field = src.field_find(field_name, n_len);
+    MIMEField *d_field = dst.field_find(field_name, n_len);
+
+    if (!s_field || !d_field || s_field == d_field || s_field->m_ptr_value != d_field->m_ptr_value) {
+      printf("FAILED: field %s is not a separate field sharing its value string\n", field_name);
+      ++failures;
+    }
+  }
+
+  /*** (3) changes to the copy, in the first and chained blocks, leave the original alone ***/
+
+  dst.value_set("X-Test1", 7, "changed", 7);
+  dst.value_set("X-Test40", 8, "changed", 7);
+  dst.field_delete("X-Test45", 8);
+  dst.value_set("X-Added", 7, "added", 5);
+
+  for (i = 1; i <= 50; i++) {
+    int n_len = snprintf(field_name, sizeof(field_name), "X-Test%d", i);
+    int v_len = snprintf(field_value, sizeof(field_value), "value %d", i);
+    int value_len;
+    const char *value = src.value_get(field_name, n_len, &value_len);
+
+    if (!value || value_len != v_len || memcmp(value, field_value, v_len) != 0) {
+      printf("FAILED: original field %s changed with the copy\n", field_name);
+      ++failures;
+    }
+  }
+  if (src.field_find("X-Added", 7) || src.fields_count() != 50 || dst.fields_count() != 50) {
+    printf("FAILED: fields added to or deleted from the copy were in the original\n");
+    ++failures;
+  }
+
+  /*** (4) and changes to the original leave the copy alone ***/
+
+  src.value_set("X-Test41", 8, "changed", 7);
+  src.field_delete("X-Test2", 7);
+
+  int value_len;
+  const char *value = dst.value_get("X-Test41", 8, &value_len);
+  if (!value || value_len != 8 || memcmp(value, "value 41", 8) != 0 || !dst.field_find("X-Test2", 7)) {
+    printf("FAILED: copy changed with the original\n");
+    ++failures;
+  }
+
+  dst.destroy();
+  src.destroy();
+
+  return (failures_to_status("test_http_hdr_copy_sharing", failures));
+}
+
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
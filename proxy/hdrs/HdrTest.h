@@ -67,6 +67,7 @@ private:
   int test_mime();
   int test_http();
   int test_http_mutation();
+  int test_http_hdr_copy_sharing();
 
   int test_http_hdr_print_and_copy_aux(int testnum, const char *req, const char *req_tgt, const char *rsp, const char *rsp_tgt);
   int test_http_hdr_null_char(int testnum, const char *req, const char *req_tgt);
@@ -22,13 +22,14 @@
  */
 
 #include "ts/ink_platform.h"
-#include "ts/HashFNV.h"
 #include "ts/Diags.h"
 #include "ts/ink_memory.h"
 #include <stdio.h>
 #include "ts/Allocator.h"
 #include "HTTP.h"
 #include "HdrToken.h"
+#include "HdrTokenHash.h"
+#include "HdrTokenHashSeed" // generated by CompileHdrTokenHash
 #include "MIME.h"
 #include "ts/Regex.h"
 #include "URL.h"
@@ -255,100 +256,50 @@ DFA *hdrtoken_strs_dfa = NULL;
  *                                                                     *
  ***********************************************************************/
 
-#define HDRTOKEN_HASH_TABLE_SIZE 65536
-#define HDRTOKEN_HASH_TABLE_MASK HDRTOKEN_HASH_TABLE_SIZE - 1
+#define HDRTOKEN_HASH_TABLE_SIZE (1 << HDRTOKEN_HASH_BITS)
+#define HDRTOKEN_HASH_MAX_LENGTH 32 // longest commonly tokenized string, rounded up to words
 
-struct HdrTokenHashBucket {
+/**
+  A commonly tokenized string, with its case folded copy for the compare: @a key has the letters lower cased, and
+  @a fold has 0x20 where @a key has a letter and 0 elsewhere, so a string matches where (string | fold) == key.
+*/
+struct HdrTokenHashEntry {
   const char *wks;
-  uint32_t hash;
+  int length;
+  char key[HDRTOKEN_HASH_MAX_LENGTH];
+  char fold[HDRTOKEN_HASH_MAX_LENGTH];
 };
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
+static HdrTokenHashEntry hdrtoken_hash_entries[SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+static HdrTokenHashEntry *hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
 
 /**
-  basic FNV hash
-**/
-#define TINY_MASK(x) (((uint32_t)1 << (x)) - 1)
-
-inline uint32_t
-hash_to_slot(uint32_t hash)
-{
-  return ((hash >> 15) ^ hash) & TINY_MASK(15);
-}
-
-inline uint32_t
-hdrtoken_hash(const unsigned char *string, unsigned int length)
+  Case insensitive compare of @a string with @a entry a word at a time. Strings of eight bytes or more are compared
+  in whole words, the last one overlapping the one before it, shorter strings in the single word of
+  hdrtoken_hash_load().
+*/
+static inline bool
+hdrtoken_hash_match(const HdrTokenHashEntry *entry, const char *string, int length)
 {
-  ATSHash32FNV1a fnv;
-  fnv.update(string, length, ATSHash::nocase());
-  fnv.final();
-  return fnv.get();
-}
-
-/*-------------------------------------------------------------------------
-  -------------------------------------------------------------------------*/
-
-static const char *_hdrtoken_commonly_tokenized_strs[] = {
-  // MIME Field names
-  "Accept-Charset", "Accept-Encoding", "Accept-Language", "Accept-Ranges", "Accept", "Age", "Allow",
-  "Approved", // NNTP
-  "Authorization",
-  "Bytes", // NNTP
-  "Cache-Control", "Client-ip", "Connection", "Content-Base", "Content-Encoding", "Content-Language", "Content-Length",
-  "Content-Location", "Content-MD5", "Content-Range", "Content-Type",
-  "Control", // NNTP
-  "Cookie", "Date",
-  "Distribution", // NNTP
-  "Etag", "Expect", "Expires",
-  "Followup-To", // NNTP
-  "From", "Host", "If-Match", "If-Modified-Since", "If-None-Match", "If-Range", "If-Unmodified-Since", "Keep-Alive",
-  "Keywords", // NNTP
-  "Last-Modified",
-  "Lines", // NNTP
-  "Location", "Max-Forwards",
-  "Message-ID", // NNTP
-  "MIME-Version",
-  "Newsgroups",   // NNTP
-  "Organization", // NNTP
-  "Path",         // NNTP
-  "Pragma", "Proxy-Authenticate", "Proxy-Authorization", "Proxy-Connection", "Public", "Range",
-  "References", // NNTP
-  "Referer",
-  "Reply-To", // NNTP
-  "Retry-After",
-  "Sender", // NNTP
-  "Server", "Set-Cookie",
-  "Subject", // NNTP
-  "Summary", // NNTP
-  "Transfer-Encoding", "Upgrade", "User-Agent", "Vary", "Via", "Warning", "Www-Authenticate",
-  "Xref",          // NNTP
-  "@Ats-Internal", // Internal Hack
-
-  // Accept-Encoding
-  "compress", "deflate", "gzip", "identity",
-
-  // Cache-Control flags
-  "max-age", "max-stale", "min-fresh", "must-revalidate", "no-cache", "no-store", "no-transform", "only-if-cached", "private",
-  "proxy-revalidate", "s-maxage", "need-revalidate-once",
-
-  // HTTP miscellaneous
-  "none", "chunked", "close",
-
-  // WS
-  "websocket", "Sec-WebSocket-Key", "Sec-WebSocket-Version",
-
-  // HTTP/2 cleartext
-  MIME_UPGRADE_H2C_TOKEN, "HTTP2-Settings",
+  if (entry->length != length) {
+    return false;
+  }
+  if (length < 8) {
+    return (hdrtoken_hash_load(string, length) | hdrtoken_hash_load(entry->fold, length)) ==
+           hdrtoken_hash_load(entry->key, length);
+  }
 
-  // URL schemes
-  "file", "ftp", "gopher", "https", "http", "mailto", "news", "nntp", "prospero", "telnet", "tunnel", "wais", "pnm", "rtspu",
-  "rtsp", "mmsu", "mmst", "mms", "wss", "ws",
+  uint64_t diff = 0;
+  int i;
 
-  // HTTP methods
-  "CONNECT", "DELETE", "GET", "POST", "HEAD", "ICP_QUERY", "OPTIONS", "PURGE", "PUT", "TRACE", "PUSH",
+  for (i = 0; i < length - 8; i += 8) {
+    diff |= (hdrtoken_hash_load(string + i, 8) | hdrtoken_hash_load(entry->fold + i, 8)) ^ hdrtoken_hash_load(entry->key + i, 8);
+  }
+  i = length - 8;
+  diff |= (hdrtoken_hash_load(string + i, 8) | hdrtoken_hash_load(entry->fold + i, 8)) ^ hdrtoken_hash_load(entry->key + i, 8);
 
-  // Header extensions
-  "X-ID", "X-Forwarded-For", "TE", "Strict-Transport-Security", "100-continue"};
+  return diff == 0;
+}
 
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
@@ -362,23 +313,31 @@ hdrtoken_hash_init()
   memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
   num_collisions = 0;
 
-  for (i = 0; i < (int)SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+  for (i = 0; i < SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
     // convert the common string to the well-known token
-    unsigned const char *wks;
+    const char *wks;
     int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i], (int)strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **)&wks);
+                                        &wks);
     ink_release_assert(wks_idx >= 0);
 
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
+    HdrTokenHashEntry *entry = &hdrtoken_hash_entries[i];
+    int length = hdrtoken_str_lengths[wks_idx];
 
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n", slot, (const char *)wks,
-             hdrtoken_hash_table[slot].wks);
+    ink_release_assert(length <= HDRTOKEN_HASH_MAX_LENGTH);
+    entry->wks = wks;
+    entry->length = length;
+    for (int j = 0; j < length; j++) {
+      entry->key[j] = ParseRules::ink_tolower(wks[j]);
+      entry->fold[j] = ParseRules::is_alpha(wks[j]) ? 0x20 : 0;
+    }
+
+    uint32_t slot = hdrtoken_hash(wks, length, HDRTOKEN_HASH_SEED, HDRTOKEN_HASH_BITS);
+
+    if (hdrtoken_hash_table[slot]) {
+      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n", slot, wks, hdrtoken_hash_table[slot]->wks);
       ++num_collisions;
     }
-    hdrtoken_hash_table[slot].wks = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
+    hdrtoken_hash_table[slot] = entry;
   }
 
   if (num_collisions > 0)
@@ -532,7 +491,7 @@ int
 hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out)
 {
   int wks_idx;
-  HdrTokenHashBucket *bucket;
+  HdrTokenHashEntry *entry;
 
   ink_assert(string != NULL);
 
@@ -543,14 +502,11 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
     return wks_idx;
   }
 
-  uint32_t hash = hdrtoken_hash((const unsigned char *)string, (unsigned int)string_len);
-  uint32_t slot = hash_to_slot(hash);
-
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != NULL) && (bucket->hash == hash) && (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
+  entry = hdrtoken_hash_table[hdrtoken_hash(string, string_len, HDRTOKEN_HASH_SEED, HDRTOKEN_HASH_BITS)];
+  if ((entry != NULL) && hdrtoken_hash_match(entry, string, string_len)) {
+    wks_idx = hdrtoken_wks_to_index(entry->wks);
     if (wks_string_out)
-      *wks_string_out = bucket->wks;
+      *wks_string_out = entry->wks;
     return wks_idx;
   }
 
@@ -0,0 +1,145 @@
+/** @file
+
+  Perfect hash of the commonly tokenized strings.
+
+  The strings are hashed from their length and their first and last eight bytes, case folded, mixed with a seed.
+  CompileHdrTokenHash searches at build time for the smallest table and the seed which give every string its own
+  slot, and writes them to HdrTokenHashSeed as HDRTOKEN_HASH_BITS and HDRTOKEN_HASH_SEED.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HDRTOKEN_HASH_H__
+#define __HDRTOKEN_HASH_H__
+
+#include <stdint.h>
+#include <string.h>
+#include "HdrToken.h"
+
+/*
+ The strings hdrtoken_tokenize() finds by hash, each of which must also be in _hdrtoken_strs. Changing this list
+ changes the hash, which is regenerated by the build.
+*/
+
+static const char *_hdrtoken_commonly_tokenized_strs[] = {
+  // MIME Field names
+  "Accept-Charset", "Accept-Encoding", "Accept-Language", "Accept-Ranges", "Accept", "Age", "Allow",
+  "Approved", // NNTP
+  "Authorization",
+  "Bytes", // NNTP
+  "Cache-Control", "Client-ip", "Connection", "Content-Base", "Content-Encoding", "Content-Language", "Content-Length",
+  "Content-Location", "Content-MD5", "Content-Range", "Content-Type",
+  "Control", // NNTP
+  "Cookie", "Date",
+  "Distribution", // NNTP
+  "Etag", "Expect", "Expires",
+  "Followup-To", // NNTP
+  "From", "Host", "If-Match", "If-Modified-Since", "If-None-Match", "If-Range", "If-Unmodified-Since", "Keep-Alive",
+  "Keywords", // NNTP
+  "Last-Modified",
+  "Lines", // NNTP
+  "Location", "Max-Forwards",
+  "Message-ID", // NNTP
+  "MIME-Version",
+  "Newsgroups",   // NNTP
+  "Organization", // NNTP
+  "Path",         // NNTP
+  "Pragma", "Proxy-Authenticate", "Proxy-Authorization", "Proxy-Connection", "Public", "Range",
+  "References", // NNTP
+  "Referer",
+  "Reply-To", // NNTP
+  "Retry-After",
+  "Sender", // NNTP
+  "Server", "Set-Cookie",
+  "Subject", // NNTP
+  "Summary", // NNTP
+  "Transfer-Encoding", "Upgrade", "User-Agent", "Vary", "Via", "Warning", "Www-Authenticate",
+  "Xref",          // NNTP
+  "@Ats-Internal", // Internal Hack
+
+  // Accept-Encoding
+  "compress", "deflate", "gzip", "identity",
+
+  // Cache-Control flags
+  "max-age", "max-stale", "min-fresh", "must-revalidate", "no-cache", "no-store", "no-transform", "only-if-cached", "private",
+  "proxy-revalidate", "s-maxage", "need-revalidate-once",
+
+  // HTTP miscellaneous
+  "none", "chunked", "close",
+
+  // WS
+  "websocket", "Sec-WebSocket-Key", "Sec-WebSocket-Version",
+
+  // HTTP/2 cleartext
+  MIME_UPGRADE_H2C_TOKEN, "HTTP2-Settings",
+
+  // URL schemes
+  "file", "ftp", "gopher", "https", "http", "mailto", "news", "nntp", "prospero", "telnet", "tunnel", "wais", "pnm", "rtspu",
+  "rtsp", "mmsu", "mmst", "mms", "wss", "ws",
+
+  // HTTP methods
+  "CONNECT", "DELETE", "GET", "POST", "HEAD", "ICP_QUERY", "OPTIONS", "PURGE", "PUT", "TRACE", "PUSH",
+
+  // Header extensions
+  "X-ID", "X-Forwarded-For", "TE", "Strict-Transport-Security", "100-continue"};
+
+// Case folding of a word, lower cases letters and leaves digits and '-' alone.
+#define HDRTOKEN_HASH_FOLD 0x2020202020202020ULL
+
+/**
+  Load up to eight bytes of @a string as a word, without reading past @a length. Strings shorter than eight bytes
+  are loaded as overlapping halves, or single bytes, so every byte is in the word.
+*/
+static inline uint64_t
+hdrtoken_hash_load(const char *string, int length)
+{
+  uint64_t word;
+
+  if (length >= 8) {
+    memcpy(&word, string, 8);
+  } else if (length >= 4) {
+    uint32_t head, tail;
+    memcpy(&head, string, 4);
+    memcpy(&tail, string + length - 4, 4);
+    word = head | (static_cast<uint64_t>(tail) << 32);
+  } else if (length > 0) {
+    word = static_cast<uint8_t>(string[0]) | (static_cast<uint64_t>(static_cast<uint8_t>(string[length >> 1])) << 8) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(string[length - 1])) << 16);
+  } else {
+    word = 0;
+  }
+  return word;
+}
+
+/**
+  Hash @a string into a table of 2^@a bits slots. Only the length and first and last eight bytes are hashed, which
+  is enough to tell the commonly tokenized strings apart, anything else is sorted out by the compare after it.
+*/
+static inline uint32_t
+hdrtoken_hash(const char *string, int length, uint64_t seed, int bits)
+{
+  uint64_t head = hdrtoken_hash_load(string, length) | HDRTOKEN_HASH_FOLD;
+  uint64_t tail = (length > 8 ? hdrtoken_hash_load(string + length - 8, 8) | HDRTOKEN_HASH_FOLD : 0) + length;
+  uint64_t x = (head ^ seed) * 0x9e3779b97f4a7c15ULL;
+
+  x = (x ^ tail ^ (x >> 29)) * 0xbf58476d1ce4e5b9ULL;
+  return static_cast<uint32_t>(x >> (64 - bits));
+}
+
+#endif /* __HDRTOKEN_HASH_H__ */
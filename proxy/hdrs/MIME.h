@@ -689,6 +689,11 @@ void mime_field_name_value_set(HdrHeap *heap, MIMEHdrImpl *mh, MIMEField *field,
 void mime_field_value_append(HdrHeap *heap, MIMEHdrImpl *mh, MIMEField *field, const char *value, int length, bool prepend_comma,
                              const char separator);
 
+/// Find the first LF or NUL in [@a s, @a e), or @a e if there is neither.
+const char *mime_scan_line_end(const char *s, const char *e);
+/// The byte at a time version, which the vector versions must agree with.
+const char *mime_scan_line_end_scalar(const char *s, const char *e);
+
 void mime_scanner_init(MIMEScanner *scanner);
 void mime_scanner_clear(MIMEScanner *scanner);
 void mime_scanner_append(MIMEScanner *scanner, const char *data, int data_size);
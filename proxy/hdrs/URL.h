@@ -29,6 +29,7 @@
 #include "HdrHeap.h"
 #include "ts/INK_MD5.h"
 #include "ts/MMH.h"
+#include "ts/HashSip.h"
 #include "MIME.h"
 #include "ts/TsBuffer.h"
 
@@ -105,6 +106,7 @@ public:
     UNSPECIFIED,
     MD5,
     MMH,
+    SIP, ///< SipHash-2-4-128, selected by proxy.config.cache.url_hash
   }; ///< What type of hash we really are.
   static HashType Setting;
 
@@ -24,6 +24,7 @@
 #include <ts/TestBox.h>
 #include "I_EventSystem.h"
 #include "MIME.h"
+#include "HTTP.h"
 
 REGRESSION_TEST(MIME)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
 {
@@ -52,6 +53,234 @@ REGRESSION_TEST(MIME)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatu
   hdr.destroy();
 }
 
+// A small deterministic generator, so a failure can be reproduced.
+static uint32_t
+test_rand(uint32_t *state)
+{
+  *state = *state * 1103515245 + 12345;
+  return *state >> 8;
+}
+
+REGRESSION_TEST(MIME_ScanLineEnd)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  static const char alphabet[] = {'a', 'b', ':', ' ', '\t', '\r', '\n', '\0', '\x80', '\xff', '=', ';'};
+  char buf[320];
+  uint32_t seed = 1;
+
+  // Against the byte at a time scan, for every alignment and for lengths
+  // around the vector widths, with few and with many line ends.
+  for (int round = 0; round < 2000; ++round) {
+    int sparse = round % 2;
+    for (unsigned i = 0; i < sizeof(buf); ++i) {
+      uint32_t r = test_rand(&seed);
+      buf[i] = sparse && r % 64 ? 'x' : alphabet[r % sizeof(alphabet)];
+    }
+
+    int offset = round % 33;
+    int length = test_rand(&seed) % (sizeof(buf) - 33);
+    const char *s = buf + offset;
+    const char *e = s + length;
+
+    const char *expected = mime_scan_line_end_scalar(s, e);
+    const char *result = mime_scan_line_end(s, e);
+    box.check(result == expected, "Scan of %d bytes at offset %d found %d, expected %d", length, offset, (int)(result - s),
+              (int)(expected - s));
+  }
+
+  // The end of the range is respected even when a line end follows it.
+  memset(buf, 'x', sizeof(buf));
+  buf[40] = '\n';
+  box.check(mime_scan_line_end(buf, buf + 40) == buf + 40, "Scan went past the end of the range");
+  box.check(mime_scan_line_end(buf, buf + 41) == buf + 40, "Scan missed the LF at the end of the range");
+}
+
+REGRESSION_TEST(MIME_ParseLongFields)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // A big cookie, a folded field and some short ones, as clients send them.
+  char cookie[6000];
+  for (unsigned i = 0; i < sizeof(cookie) - 1; ++i) {
+    cookie[i] = "abcdefghij=;"[i % 12];
+  }
+  cookie[sizeof(cookie) - 1] = '\0';
+
+  char text[8192];
+  int text_len = snprintf(text, sizeof(text), "Host: example.com\r\n"
+                                               "Cookie: %s\r\n"
+                                               "X-Folded: one\r\n"
+                                               "\ttwo\r\n"
+                                               "Accept: */*\r\n"
+                                               "\r\n",
+                          cookie);
+
+  uint32_t seed = 7;
+  for (int round = 0; round < 50; ++round) {
+    MIMEParser parser;
+    MIMEHdr hdr;
+    MIMEParseResult result = PARSE_CONT;
+
+    mime_parser_init(&parser);
+    hdr.create(NULL);
+
+    // Feed it whole the first time, then in pieces which split lines anywhere.
+    const char *start = text;
+    const char *end = text + text_len;
+    while (result == PARSE_CONT && start < end) {
+      const char *piece_end = round == 0 ? end : std::min(end, start + 1 + test_rand(&seed) % 200);
+      result = (MIMEParseResult)hdr.parse(&parser, &start, piece_end, true, piece_end == end);
+    }
+
+    box.check(result == PARSE_DONE, "Parse result %d, expected %d", result, PARSE_DONE);
+    box.check(hdr.fields_count() == 4, "Parsed %d fields, expected 4", hdr.fields_count());
+
+    int len = 0;
+    MIMEField *field = hdr.field_find("Cookie", 6);
+    const char *value = field ? field->value_get(&len) : NULL;
+    box.check(value && len == (int)strlen(cookie) && memcmp(value, cookie, len) == 0, "The Cookie value is wrong");
+
+    field = hdr.field_find("Accept", 6);
+    value = field ? field->value_get(&len) : NULL;
+    box.check(value && len == 3 && memcmp(value, "*/*", 3) == 0, "The Accept value is wrong");
+
+    hdr.destroy();
+    mime_parser_clear(&parser);
+  }
+
+  // A NUL anywhere in a field fails the header, as it did before.
+  for (int pos = 0; pos < 6100; pos += 97) {
+    MIMEParser parser;
+    MIMEHdr hdr;
+    const char *start = text;
+    char saved = text[pos];
+
+    text[pos] = '\0';
+    mime_parser_init(&parser);
+    hdr.create(NULL);
+    MIMEParseResult result = (MIMEParseResult)hdr.parse(&parser, &start, text + text_len, true, true);
+    box.check(result == PARSE_ERROR, "NUL at %d gave parse result %d, expected %d", pos, result, PARSE_ERROR);
+    hdr.destroy();
+    mime_parser_clear(&parser);
+    text[pos] = saved;
+  }
+}
+
+REGRESSION_TEST(MIME_Tokenize)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // Every well-known string, as given and in both cases, out of the token heap.
+  for (int i = 0; i < hdrtoken_num_wks; ++i) {
+    char name[64];
+    int len = hdrtoken_index_to_length(i);
+    const char *wks = NULL;
+
+    for (int c = 0; c < 3; ++c) {
+      for (int j = 0; j < len; ++j) {
+        char ch = hdrtoken_index_to_wks(i)[j];
+        name[j] = c == 0 ? ch : c == 1 ? ParseRules::ink_tolower(ch) : ParseRules::ink_toupper(ch);
+      }
+      int idx = hdrtoken_tokenize(name, len, &wks);
+      int dfa_idx = hdrtoken_tokenize_dfa(name, len);
+      box.check(idx == dfa_idx, "'%.*s' tokenized to %d, the DFA gives %d", len, name, idx, dfa_idx);
+      box.check(idx < 0 || wks == hdrtoken_index_to_wks(idx), "'%.*s' gave the wrong well-known string", len, name);
+    }
+  }
+
+  // Near misses, including non-letters which differ from the token only in the case bit.
+  static const struct {
+    const char *name;
+    int len;
+  } misses[] = {{"Hos", 3},           {"Hostx", 5},          {"Content-Typf", 12},  {"Content\rType", 12},
+                {"`Ats-Internal", 13}, {"\x11" "00-continue", 12}, {"Accept-Charse", 13}, {"X-Unknown", 9},
+                {"Strict-Transport-Securitz", 25}, {"", 0}, {"te\0", 3}};
+  for (unsigned i = 0; i < sizeof(misses) / sizeof(misses[0]); ++i) {
+    int idx = hdrtoken_tokenize(misses[i].name, misses[i].len);
+    box.check(idx == -1, "'%.*s' tokenized to %d, expected -1", misses[i].len, misses[i].name, idx);
+  }
+
+  // Time it over the header names of a typical request and response, some of them not well-known.
+  static const char *names[] = {"Host", "User-Agent", "Accept", "Accept-Language", "Accept-Encoding", "Cookie", "Referer",
+                                "Connection", "Cache-Control", "If-Modified-Since", "If-None-Match", "X-Forwarded-For",
+                                "Upgrade-Insecure-Requests", "DNT", "Date", "Server", "Content-Type", "Content-Length",
+                                "Last-Modified", "ETag", "Expires", "Vary", "Set-Cookie", "Age", "Via", "Accept-Ranges",
+                                "X-Cache", "X-Request-Id", "Transfer-Encoding", "Content-Encoding"};
+  const int n_names = sizeof(names) / sizeof(names[0]);
+  const int rounds = 20000;
+  int name_lens[n_names];
+  int found = 0;
+
+  for (int i = 0; i < n_names; ++i) {
+    name_lens[i] = strlen(names[i]);
+  }
+
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < n_names; ++i) {
+      found += hdrtoken_tokenize(names[i], name_lens[i]) >= 0;
+    }
+  }
+  ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+
+  // All but Upgrade-Insecure-Requests, DNT, X-Cache and X-Request-Id are well-known.
+  box.check(found == rounds * (n_names - 4), "Found %d names, expected %d", found, rounds * (n_names - 4));
+  rprintf(t, "tokenize: %.1f ns/name\n", (double)elapsed / (rounds * n_names));
+}
+
+REGRESSION_TEST(HdrHeap_Reset)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  HdrHeap *heap = new_HdrHeap();
+  HTTPHdr hdr;
+  char big[4000];
+
+  memset(big, 'x', sizeof(big));
+  hdr.create(HTTP_TYPE_REQUEST, heap);
+  hdr.value_set("X-Small", 7, "small", 5);
+  hdr.value_set("X-Big", 5, big, sizeof(big)); // Into a bigger string heap
+  for (int i = 0; i < 100; ++i) {                // And enough fields for overflow blocks
+    char name[16];
+    hdr.value_set(name, snprintf(name, sizeof(name), "X-Field-%d", i), "value", 5);
+  }
+  box.check(heap->m_next != NULL, "Expected an overflow block");
+
+  // A copy inherits the string heap, which must then not be reused.
+  HTTPHdr copy;
+  copy.create(HTTP_TYPE_REQUEST);
+  copy.copy(&hdr);
+  hdr.clear();
+  heap->reset();
+  box.check(heap->m_next == NULL && heap->m_read_write_heap == NULL, "The reset heap still has blocks or a shared string heap");
+  box.check(heap->m_free_size == heap->m_size - HDR_HEAP_HDR_SIZE, "The reset heap is not empty");
+
+  int len = 0;
+  const char *value = copy.value_get("X-Small", 7, &len);
+  box.check(value && len == 5 && memcmp(value, "small", 5) == 0, "The copy lost its strings");
+  copy.destroy();
+
+  // A string heap which is not shared is kept, empty.
+  hdr.create(HTTP_TYPE_REQUEST, heap);
+  hdr.value_set("X-Small", 7, "small", 5);
+  HdrStrHeap *str_heap = heap->m_read_write_heap;
+  hdr.clear();
+  heap->reset();
+  box.check(heap->m_read_write_heap == str_heap && str_heap->refcount() == 1, "The string heap was not kept");
+  box.check(str_heap->m_free_size == str_heap->m_heap_size - STR_HEAP_HDR_SIZE, "The kept string heap is not empty");
+
+  hdr.create(HTTP_TYPE_REQUEST, heap);
+  hdr.value_set("X-Again", 7, "again", 5);
+  value = hdr.value_get("X-Again", 7, &len);
+  box.check(value && len == 5 && memcmp(value, "again", 5) == 0, "The reused heap lost a string");
+  hdr.destroy();
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -94,6 +94,11 @@ public:
   {
     return true;
   }
+  virtual bool
+  allow_splice() const
+  {
+    return true;
+  }
   virtual const char *
   get_protocol_string() const
   {
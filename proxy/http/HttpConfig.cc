@@ -811,6 +811,26 @@ register_stat_callbacks()
                      (int)https_total_client_connections_stat, RecRawStatSyncCount);
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.post_body_too_large", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_post_body_too_large, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.hdr_heaps_reused", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_hdr_heaps_reused_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.hdr_heaps_allocated", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)http_hdr_heaps_allocated_stat, RecRawStatSyncCount);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.reload_time", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_reload_time_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.reload_resident_memory", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_reload_resident_memory_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.reload_memory_growth", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_reload_memory_growth_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.rules_added", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_rules_added_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.rules_removed", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_rules_removed_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.rules_changed", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_rules_changed_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.plugin_instances_created", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_plugin_instances_created_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.remap.plugin_instances_reused", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)http_remap_plugin_instances_reused_stat, RecRawStatSyncSum);
   // milestones
   RecRegisterRawStat(http_rsb, RECT_PROCESS, "proxy.process.http.milestone.ua_begin", RECD_COUNTER, RECP_PERSISTENT,
                      (int)http_ua_begin_time_stat, RecRawStatSyncSum);
@@ -899,6 +919,7 @@ HttpConfig::startup()
   HttpEstablishStaticConfigByte(c.no_origin_server_dns, "proxy.config.http.no_origin_server_dns");
   HttpEstablishStaticConfigByte(c.use_client_target_addr, "proxy.config.http.use_client_target_addr");
   HttpEstablishStaticConfigByte(c.use_client_source_port, "proxy.config.http.use_client_source_port");
+  HttpEstablishStaticConfigByte(c.tunnel_splice, "proxy.config.http.tunnel_splice");
   HttpEstablishStaticConfigByte(c.oride.maintain_pristine_host_hdr, "proxy.config.url_remap.pristine_host_hdr");
 
   HttpEstablishStaticConfigByte(c.enable_url_expandomatic, "proxy.config.http.enable_url_expandomatic");
@@ -1147,6 +1168,7 @@ HttpConfig::reconfigure()
   params->no_origin_server_dns = INT_TO_BOOL(m_master.no_origin_server_dns);
   params->use_client_target_addr = m_master.use_client_target_addr;
   params->use_client_source_port = INT_TO_BOOL(m_master.use_client_source_port);
+  params->tunnel_splice = INT_TO_BOOL(m_master.tunnel_splice);
   params->oride.maintain_pristine_host_hdr = INT_TO_BOOL(m_master.oride.maintain_pristine_host_hdr);
 
   params->disable_ssl_parenting = INT_TO_BOOL(m_master.disable_ssl_parenting);
@@ -290,6 +290,20 @@ enum {
   https_incoming_requests_stat,
   https_total_client_connections_stat,
 
+  // Header heaps, reused from the client session or newly allocated
+  http_hdr_heaps_reused_stat,
+  http_hdr_heaps_allocated_stat,
+
+  // Remap table, as of the last time it was loaded
+  http_remap_reload_time_stat,
+  http_remap_reload_resident_memory_stat,
+  http_remap_reload_memory_growth_stat,
+  http_remap_rules_added_stat,
+  http_remap_rules_removed_stat,
+  http_remap_rules_changed_stat,
+  http_remap_plugin_instances_created_stat,
+  http_remap_plugin_instances_reused_stat,
+
   // milestone timing statistics in milliseconds
   http_ua_begin_time_stat,
   http_ua_first_read_time_stat,
@@ -645,6 +659,7 @@ public:
   MgmtByte no_origin_server_dns;
   MgmtByte use_client_target_addr;
   MgmtByte use_client_source_port;
+  MgmtByte tunnel_splice;
 
   char *proxy_request_via_string;
   int proxy_request_via_string_len;
@@ -852,15 +867,15 @@ inline HttpConfigParams::HttpConfigParams()
   : proxy_hostname(NULL), proxy_hostname_len(0), server_max_connections(0), origin_min_keep_alive_connections(0),
     max_websocket_connections(-1), parent_proxy_routing_enable(0), disable_ssl_parenting(0), enable_url_expandomatic(0),
     no_dns_forward_to_parent(0), uncacheable_requests_bypass_parent(1), no_origin_server_dns(0), use_client_target_addr(0),
-    use_client_source_port(0), proxy_request_via_string(NULL), proxy_request_via_string_len(0), proxy_response_via_string(NULL),
-    proxy_response_via_string_len(0), url_expansions_string(NULL), url_expansions(NULL), num_url_expansions(0),
-    session_auth_cache_keep_alive_enabled(1), transaction_active_timeout_in(900), accept_no_activity_timeout(120),
-    parent_connect_attempts(4), per_parent_connect_attempts(2), parent_connect_timeout(30), anonymize_other_header_list(NULL),
-    enable_http_stats(1), icp_enabled(0), stale_icp_enabled(0), cache_vary_default_text(NULL), cache_vary_default_images(NULL),
-    cache_vary_default_other(NULL), cache_enable_default_vary_headers(0), cache_post_method(0), connect_ports_string(NULL),
-    connect_ports(NULL), push_method_enabled(0), referer_filter_enabled(0), referer_format_redirect(0), strict_uri_parsing(0),
-    reverse_proxy_enabled(0), url_remap_required(1), record_cop_page(0), errors_log_error_pages(1), enable_http_info(0),
-    cluster_time_delta(0), redirection_host_no_port(1), post_copy_size(2048), ignore_accept_mismatch(0),
+    use_client_source_port(0), tunnel_splice(0), proxy_request_via_string(NULL), proxy_request_via_string_len(0),
+    proxy_response_via_string(NULL), proxy_response_via_string_len(0), url_expansions_string(NULL), url_expansions(NULL),
+    num_url_expansions(0), session_auth_cache_keep_alive_enabled(1), transaction_active_timeout_in(900),
+    accept_no_activity_timeout(120), parent_connect_attempts(4), per_parent_connect_attempts(2), parent_connect_timeout(30),
+    anonymize_other_header_list(NULL), enable_http_stats(1), icp_enabled(0), stale_icp_enabled(0), cache_vary_default_text(NULL),
+    cache_vary_default_images(NULL), cache_vary_default_other(NULL), cache_enable_default_vary_headers(0), cache_post_method(0),
+    connect_ports_string(NULL), connect_ports(NULL), push_method_enabled(0), referer_filter_enabled(0), referer_format_redirect(0),
+    strict_uri_parsing(0), reverse_proxy_enabled(0), url_remap_required(1), record_cop_page(0), errors_log_error_pages(1),
+    enable_http_info(0), cluster_time_delta(0), redirection_host_no_port(1), post_copy_size(2048), ignore_accept_mismatch(0),
     ignore_accept_language_mismatch(0), ignore_accept_encoding_mismatch(0), ignore_accept_charset_mismatch(0),
     send_100_continue_response(0), disallow_post_100_continue(0), parser_allow_non_http(1), max_post_size(0),
     server_session_sharing_pool(TS_SERVER_SESSION_SHARING_POOL_THREAD), synthetic_port(0)
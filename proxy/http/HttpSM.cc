@@ -39,6 +39,7 @@
 #include "RemapProcessor.h"
 #include "Transform.h"
 #include "P_SSLConfig.h"
+#include "http2/HTTP2.h"
 
 #include "HttpPages.h"
 
@@ -264,8 +265,10 @@ HttpSM::HttpSM()
     enable_redirection(false), redirect_url(NULL), redirect_url_len(0), redirection_tries(0), transfered_bytes(0),
     post_failed(false), debug_on(false), plugin_tunnel_type(HTTP_NO_PLUGIN_TUNNEL), plugin_tunnel(NULL), reentrancy_count(0),
     history_pos(0), tunnel(), ua_entry(NULL), ua_session(NULL), background_fill(BACKGROUND_FILL_NONE), ua_raw_buffer_reader(NULL),
-    server_entry(NULL), server_session(NULL), will_be_private_ss(false), shared_session_retries(0), server_buffer_reader(NULL),
-    transform_info(), post_transform_info(), has_active_plugin_agents(false), second_cache_sm(NULL), default_handler(NULL),
+    hdr_heaps_reused(0), server_entry(NULL), server_session(NULL), will_be_private_ss(false), shared_session_retries(0),
+    server_buffer_reader(NULL), server_handshake_vc(NULL), server_handshake_buffer(NULL), server_http2_handshake(false),
+    server_http2_wait_until(0), server_http2_waited(false), transform_info(), post_transform_info(),
+    has_active_plugin_agents(false), second_cache_sm(NULL), default_handler(NULL),
     pending_action(NULL), historical_action(NULL), last_action(HttpTransact::SM_ACTION_UNDEFINED),
     // TODO:  Now that bodies can be empty, should the body counters be set to -1 ? TS-2213
     client_request_hdr_bytes(0), client_request_body_bytes(0), server_request_hdr_bytes(0), server_request_body_bytes(0),
@@ -284,6 +287,7 @@ HttpSM::HttpSM()
 void
 HttpSM::cleanup()
 {
+  recycle_hdr_heaps();
   t_state.destroy();
   api_hooks.clear();
   http_parser_clear(&http_parser);
@@ -311,6 +315,61 @@ HttpSM::destroy()
   httpSMAllocator.free(this);
 }
 
+// Take a header heap left by an earlier transaction of the client session, or NULL to allocate one.
+HdrHeap *
+HttpSM::take_hdr_heap()
+{
+  HdrHeap *heap = NULL;
+
+  if (hdr_heap_cache) {
+    MUTEX_TRY_LOCK(lock, hdr_heap_cache->mutex, this_ethread());
+    if (lock.is_locked()) {
+      heap = hdr_heap_cache->take();
+    }
+  }
+  if (heap) {
+    ++hdr_heaps_reused;
+  }
+  return heap;
+}
+
+// Hand the heaps of the request and response headers to the client session for its next transaction, rather than
+// free them. Whatever else the transaction has is freed with it.
+void
+HttpSM::recycle_hdr_heaps()
+{
+  HTTPHdr *hdrs[] = {&t_state.hdr_info.client_request, &t_state.hdr_info.server_request, &t_state.hdr_info.server_response,
+                     &t_state.hdr_info.client_response};
+  int heaps = 0;
+
+  for (unsigned i = 0; i < countof(hdrs); i++) {
+    if (hdrs[i]->m_heap) {
+      ++heaps;
+    }
+  }
+  if (heaps > hdr_heaps_reused) {
+    HTTP_SUM_DYN_STAT(http_hdr_heaps_allocated_stat, heaps - hdr_heaps_reused);
+  }
+  if (hdr_heaps_reused > 0) {
+    HTTP_SUM_DYN_STAT(http_hdr_heaps_reused_stat, hdr_heaps_reused);
+  }
+  hdr_heaps_reused = 0;
+
+  if (hdr_heap_cache) {
+    MUTEX_TRY_LOCK(lock, hdr_heap_cache->mutex, this_ethread());
+    if (lock.is_locked()) {
+      for (unsigned i = 0; i < countof(hdrs); i++) {
+        HdrHeap *heap = hdrs[i]->m_heap;
+        if (heap) {
+          hdrs[i]->clear();
+          hdr_heap_cache->put(heap);
+        }
+      }
+    }
+    hdr_heap_cache = NULL;
+  }
+}
+
 void
 HttpSM::init()
 {
@@ -512,8 +571,19 @@ HttpSM::attach_client_session(ProxyClientTransaction *client_vc, IOBufferReader
   // Setup for parsing the header
   ua_buffer_reader = buffer_reader;
   ua_entry->vc_handler = &HttpSM::state_read_client_request_header;
+  if (client_vc->get_parent()) {
+    hdr_heap_cache = client_vc->get_parent()->get_hdr_heap_cache();
+  }
   t_state.hdr_info.client_request.destroy();
-  t_state.hdr_info.client_request.create(HTTP_TYPE_REQUEST);
+  t_state.hdr_info.client_request.create(HTTP_TYPE_REQUEST, take_hdr_heap());
+  // The request to the origin server and the response to the client are copies of other headers, which allocate a
+  // heap only when the header has none, so they get theirs here.
+  if (!t_state.hdr_info.server_request.m_heap) {
+    t_state.hdr_info.server_request.m_heap = take_hdr_heap();
+  }
+  if (!t_state.hdr_info.client_response.m_heap) {
+    t_state.hdr_info.client_response.m_heap = take_hdr_heap();
+  }
   http_parser_init(&http_parser);
 
   // Prepare raw reader which will live until we are sure this is HTTP indeed
@@ -932,7 +1002,7 @@ HttpSM::setup_push_read_response_header()
   // Note: we must use destroy() here since clear()
   //  does not free the memory from the header
   t_state.hdr_info.server_response.destroy();
-  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE, take_hdr_heap());
   http_parser_clear(&http_parser);
 
   // We already done the READ when we read the client
@@ -1647,11 +1717,19 @@ HttpSM::state_http_server_open(int event, void *data)
   // TODO decide whether to uncomment after finish testing redirect
   // ink_assert(server_entry == NULL);
   pending_action = NULL;
-  milestones[TS_MILESTONE_SERVER_CONNECT_END] = Thread::get_hrtime();
+  // EVENT_INTERVAL is a retry, the connection is yet to be opened
+  if (event != EVENT_INTERVAL) {
+    milestones[TS_MILESTONE_SERVER_CONNECT_END] = Thread::get_hrtime();
+  }
   HttpServerSession *session;
 
   switch (event) {
   case NET_EVENT_OPEN:
+    // Settle whether the origin server took HTTP/2 before deciding what kind of session this is
+    if (static_cast<NetVConnection *>(data)->options.f_offer_http2) {
+      start_http_server_handshake(static_cast<NetVConnection *>(data));
+      return 0;
+    }
     session = (TS_SERVER_SESSION_SHARING_POOL_THREAD == t_state.http_config_param->server_session_sharing_pool) ?
                 THREAD_ALLOC_INIT(httpServerSessionAllocator, mutex->thread_holding) :
                 httpServerSessionAllocator.alloc();
@@ -1693,6 +1771,7 @@ HttpSM::state_http_server_open(int event, void *data)
     break;
   case VC_EVENT_ERROR:
   case NET_EVENT_OPEN_FAILED:
+    end_http2_handshake();
     t_state.current.state = HttpTransact::CONNECTION_ERROR;
     // save the errno from the connect fail for future use (passed as negative value, flip back)
     t_state.current.server->set_connect_fail(event == NET_EVENT_OPEN_FAILED ? -reinterpret_cast<intptr_t>(data) : ECONNABORTED);
@@ -1735,6 +1814,97 @@ HttpSM::state_http_server_open(int event, void *data)
   return 0;
 }
 
+void
+HttpSM::start_http_server_handshake(NetVConnection *netvc)
+{
+  DebugSM("http_ss", "[%" PRId64 "] waiting for the TLS handshake to see if the origin server takes HTTP/2", sm_id);
+
+  server_handshake_vc = netvc;
+  server_handshake_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_128);
+  HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_http_server_handshake);
+
+  // A zero length read signals READ_COMPLETE once the handshake is done, and
+  // the write side is what starts a client handshake.
+  netvc->set_inactivity_timeout(HRTIME_SECONDS(t_state.txn_conf->connect_attempts_timeout));
+  netvc->do_io_read(this, 0, server_handshake_buffer);
+  netvc->do_io_write(this, 0, server_handshake_buffer->alloc_reader())->reenable();
+}
+
+void
+HttpSM::clear_http_server_handshake()
+{
+  server_handshake_vc->do_io_read(NULL, 0, NULL);
+  server_handshake_vc->do_io_write(NULL, 0, NULL);
+  free_MIOBuffer(server_handshake_buffer);
+  server_handshake_buffer = NULL;
+  server_handshake_vc = NULL;
+}
+
+// The new connection is settled one way or the other, let the requests waiting for it go
+void
+HttpSM::end_http2_handshake()
+{
+  if (server_http2_handshake) {
+    server_http2_handshake = false;
+    httpSessionManager.end_http2_handshake(&t_state.current.server->dst_addr.sa, t_state.current.server->name);
+  }
+}
+
+int
+HttpSM::state_http_server_handshake(int event, void *data)
+{
+  STATE_ENTER(&HttpSM::state_http_server_handshake, event);
+  NetVConnection *netvc = server_handshake_vc;
+
+  switch (event) {
+  case VC_EVENT_READ_COMPLETE:
+  case VC_EVENT_READ_READY: {
+    SSLNetVConnection *ssl_vc = dynamic_cast<SSLNetVConnection *>(netvc);
+    bool http2 = ssl_vc && ssl_vc->getSelectedProtocol() == TS_NPN_PROTOCOL_HTTP_2_0;
+
+    clear_http_server_handshake();
+    HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_http_server_open);
+
+    if (!http2) {
+      // The offer is settled, carry on with HTTP/1.1 on the connection
+      end_http2_handshake();
+      netvc->options.f_offer_http2 = false;
+      return state_http_server_open(NET_EVENT_OPEN, netvc);
+    }
+
+    DebugSM("http_ss", "[%" PRId64 "] origin server took HTTP/2", sm_id);
+    httpSessionManager.start_http2_session(netvc, &t_state.current.server->dst_addr.sa, t_state.current.server->name, this);
+    // The connection is in the pool now, for the requests waiting on it
+    end_http2_handshake();
+    hsm_release_assert(server_session != NULL);
+    handle_http_server_open();
+    return 0;
+  }
+
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    return 0;
+
+  case VC_EVENT_EOS:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_ACTIVE_TIMEOUT:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+    clear_http_server_handshake();
+    end_http2_handshake();
+    netvc->do_io_close();
+    HTTP_SM_SET_DEFAULT_HANDLER(&HttpSM::state_http_server_open);
+    t_state.current.state = HttpTransact::CONNECTION_ERROR;
+    t_state.current.server->set_connect_fail(ECONNABORTED);
+    call_transact_and_set_next_state(HttpTransact::HandleResponse);
+    return 0;
+
+  default:
+    Error("[HttpSM::state_http_server_handshake] Unknown event: %d", event);
+    ink_release_assert(0);
+    return 0;
+  }
+}
+
 int
 HttpSM::state_read_server_response_header(int event, void *data)
 {
@@ -2779,7 +2949,7 @@ HttpSM::tunnel_handler_100_continue(int event, void *data)
       // Since 100 isn't a final (loggable) response header
       //   kill the 100 continue header and create an empty one
       t_state.hdr_info.server_response.destroy();
-      t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+      t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE, take_hdr_heap());
       handle_server_setup_error(VC_EVENT_EOS, server_entry->read_vio);
     } else {
       setup_server_read_response_header();
@@ -3046,7 +3216,8 @@ HttpSM::tunnel_handler_server(int event, HttpTunnelProducer *p)
     // server session to so the next ka request can use it.  Server sessions will
     // be placed into the shared pool if the next incoming request is for a different
     // origin server
-    if (t_state.txn_conf->attach_server_session_to_client == 1 && ua_session && t_state.client_info.keep_alive == HTTP_KEEPALIVE) {
+    if (t_state.txn_conf->attach_server_session_to_client == 1 && ua_session && t_state.client_info.keep_alive == HTTP_KEEPALIVE &&
+        !server_session->multiplexed) {
       Debug("http", "attaching server session to the client");
       ua_session->attach_server_session(server_session);
     } else {
@@ -4643,7 +4814,11 @@ HttpSM::do_http_server_open(bool raw)
 
   DebugSM("http_seq", "[HttpSM::do_http_server_open] Sending request to server");
 
-  milestones[TS_MILESTONE_SERVER_CONNECT] = Thread::get_hrtime();
+  // A request waiting for a stream on a shared HTTP/2 connection keeps the
+  // time of its first try
+  if (server_http2_wait_until == 0 || server_http2_waited) {
+    milestones[TS_MILESTONE_SERVER_CONNECT] = Thread::get_hrtime();
+  }
   if (milestones[TS_MILESTONE_SERVER_FIRST_CONNECT] == 0) {
     milestones[TS_MILESTONE_SERVER_FIRST_CONNECT] = milestones[TS_MILESTONE_SERVER_CONNECT];
   }
@@ -4766,6 +4941,42 @@ HttpSM::do_http_server_open(bool raw)
       ua_session->attach_server_session(NULL);
     }
   }
+  // Streams on a shared HTTP/2 connection to the origin server don't count
+  // towards the connection limits below.
+  bool offer_http2 = !raw && is_http2_origin_candidate();
+  if (offer_http2 && server_session == NULL) {
+    switch (httpSessionManager.acquire_http2_stream(&t_state.current.server->dst_addr.sa, t_state.current.server->name, this,
+                                                    !server_http2_waited)) {
+    case HSM_DONE:
+      hsm_release_assert(server_session != NULL);
+      milestones[TS_MILESTONE_SERVER_CONNECT_END] = Thread::get_hrtime();
+      server_http2_wait_until = 0;
+      handle_http_server_open();
+      return;
+    case HSM_RETRY:
+      // A lock was missed, or another request is opening a connection to the
+      // origin server which this one can share. Wait for it, for no longer
+      // than it takes to connect; the pool calls back when the handshake ends.
+      if (server_http2_wait_until == 0) {
+        server_http2_wait_until = Thread::get_hrtime() + HRTIME_SECONDS(t_state.txn_conf->connect_attempts_timeout);
+      }
+      if (Thread::get_hrtime() < server_http2_wait_until) {
+        ink_assert(pending_action == NULL);
+        pending_action = httpSessionManager.wait_for_http2_stream(&t_state.current.server->dst_addr.sa,
+                                                                  t_state.current.server->name, this, server_http2_wait_until);
+        return;
+      }
+      server_http2_waited = true;
+      break;
+    default:
+      // Having waited once, open a connection of our own
+      if (server_http2_wait_until != 0) {
+        server_http2_waited = true;
+      }
+      break;
+    }
+  }
+
   // Check to see if we have reached the max number of connections.
   // Atomically read the current number of connections and check to see
   // if we have gone above the max allowed.
@@ -4885,6 +5096,13 @@ HttpSM::do_http_server_open(bool raw)
     const char *host = t_state.hdr_info.server_request.host_get(&len);
     if (host && len > 0)
       opt.set_sni_servername(host, len);
+    opt.f_offer_http2 = offer_http2;
+    if (offer_http2) {
+      // The connect and then the handshake each have the connect timeout
+      server_http2_handshake = true;
+      httpSessionManager.begin_http2_handshake(&t_state.current.server->dst_addr.sa, t_state.current.server->name,
+                                               HRTIME_SECONDS(t_state.txn_conf->connect_attempts_timeout) * 2);
+    }
     connect_action_handle = sslNetProcessor.connect_re(this,                                 // state machine
                                                        &t_state.current.server->dst_addr.sa, // addr + port
                                                        &opt);
@@ -5147,7 +5365,8 @@ HttpSM::release_server_session(bool serve_from_cache)
     return;
   }
 
-  if (TS_SERVER_SESSION_SHARING_MATCH_NONE != t_state.txn_conf->server_session_sharing_match && t_state.current.server != NULL &&
+  if (TS_SERVER_SESSION_SHARING_MATCH_NONE != t_state.txn_conf->server_session_sharing_match && !server_session->multiplexed &&
+      t_state.current.server != NULL &&
       t_state.current.server->keep_alive == HTTP_KEEPALIVE && t_state.hdr_info.server_response.valid() &&
       t_state.hdr_info.server_request.valid() && (t_state.hdr_info.server_response.status_get() == HTTP_STATUS_NOT_MODIFIED ||
                                                   (t_state.hdr_info.server_request.method_get_wksidx() == HTTP_WKSIDX_HEAD &&
@@ -5905,7 +6124,7 @@ HttpSM::setup_server_read_response_header()
   // Note: we must use destroy() here since clear()
   //  does not free the memory from the header
   t_state.hdr_info.server_response.destroy();
-  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE);
+  t_state.hdr_info.server_response.create(HTTP_TYPE_RESPONSE, take_hdr_heap());
   http_parser_clear(&http_parser);
   server_response_hdr_bytes = 0;
   milestones[TS_MILESTONE_SERVER_READ_HEADER_DONE] = 0;
@@ -6578,6 +6797,17 @@ HttpSM::setup_blind_tunnel(bool send_response_hdr)
 
   tunnel.tunnel_run();
 
+  // Nothing looks at the payload of a blind tunnel, so if both ends are plain
+  // sockets let the kernel move it between them.
+  if (t_state.http_config_param->tunnel_splice && ua_entry->vc == ua_session && server_entry->vc == server_session &&
+      ua_session->allow_splice()) {
+    NetVConnection *ua_netvc = ua_session->get_netvc();
+    NetVConnection *server_netvc = server_session->get_netvc();
+    if (ua_netvc && server_netvc && ua_netvc->splice_with(server_netvc)) {
+      DebugSM("http", "[%" PRId64 "] blind tunnel spliced", sm_id);
+    }
+  }
+
   // If we're half closed, we got a FIN from the client. Forward it on to the origin server
   // now that we have the tunnel operational.
   if (ua_session->get_half_close_flag()) {
@@ -6665,6 +6895,14 @@ HttpSM::kill_this()
     transform_cache_sm.end_both();
     vc_table.cleanup_all();
 
+    // The client went away while the origin server was still in the TLS handshake
+    if (server_handshake_vc) {
+      NetVConnection *netvc = server_handshake_vc;
+      clear_http_server_handshake();
+      netvc->do_io_close();
+    }
+    end_http2_handshake();
+
     // tunnel.deallocate_buffers();
     // Why don't we just kill the tunnel?  Might still be
     // active if the state machine is going down hard,
@@ -7811,6 +8049,30 @@ HttpSM::is_private()
   return res;
 }
 
+// HTTP/2 to the origin server is only negotiated with ALPN, and only for
+// requests which could have shared a connection anyway. Parent proxies are
+// left alone.
+bool
+HttpSM::is_http2_origin_candidate()
+{
+  if (!Http2::origin_enabled || ua_session == NULL || t_state.is_websocket || t_state.method == HTTP_WKSIDX_CONNECT) {
+    return false;
+  }
+  if (TS_SERVER_SESSION_SHARING_MATCH_NONE == t_state.txn_conf->server_session_sharing_match || is_private() ||
+      will_be_private_ss || t_state.current.request_to == HttpTransact::PARENT_PROXY) {
+    return false;
+  }
+
+  int scheme = t_state.hdr_info.server_request.url_get()->scheme_get_wksidx();
+  if (scheme < 0) {
+    scheme = t_state.hdr_info.client_request.url_get()->scheme_get_wksidx();
+  }
+  if (scheme < 0) {
+    scheme = t_state.scheme;
+  }
+  return scheme == URL_WKSIDX_HTTPS;
+}
+
 // check to see if redirection is enabled and less than max redirections tries or if a plugin enabled redirection
 inline bool
 HttpSM::is_redirect_required()
@@ -310,6 +310,12 @@ protected:
   IOBufferReader *ua_buffer_reader;
   IOBufferReader *ua_raw_buffer_reader;
 
+  // Header heaps passed between the transactions of the client session
+  Ptr<HdrHeapCache> hdr_heap_cache;
+  int hdr_heaps_reused;
+  HdrHeap *take_hdr_heap();
+  void recycle_hdr_heaps();
+
   HttpVCTableEntry *server_entry;
   HttpServerSession *server_session;
 
@@ -321,6 +327,21 @@ protected:
   bool will_be_private_ss;
   int shared_session_retries;
   IOBufferReader *server_buffer_reader;
+
+  // A new TLS connection to the origin server which offered HTTP/2, held
+  // while the handshake settles which protocol it speaks
+  NetVConnection *server_handshake_vc;
+  MIOBuffer *server_handshake_buffer;
+  // Set while the HTTP/2 pool knows of the handshake, so other requests to
+  // the origin server wait for the connection instead of opening their own
+  bool server_http2_handshake;
+  // Until when this request waits for a stream, and whether it is done waiting
+  ink_hrtime server_http2_wait_until;
+  bool server_http2_waited;
+  bool is_http2_origin_candidate();
+  void start_http_server_handshake(NetVConnection *netvc);
+  void clear_http_server_handshake();
+  void end_http2_handshake();
   void remove_server_entry();
 
   HttpTransformInfo transform_info;
@@ -381,6 +402,7 @@ protected:
   // Http Server Handlers
   int state_http_server_open(int event, void *data);
   int state_raw_http_server_open(int event, void *data);
+  int state_http_server_handshake(int event, void *data);
   int state_send_server_request_header(int event, void *data);
   int state_acquire_server_read(int event, void *data);
   int state_read_server_response_header(int event, void *data);
@@ -69,8 +69,13 @@ HttpServerSession::new_connection(NetVConnection *new_vc)
   con_id = ink_atomic_increment((int64_t *)(&next_ss_id), 1);
 
   magic = HTTP_SS_MAGIC_ALIVE;
-  HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, 1); // Update the true global stat
-  HTTP_INCREMENT_DYN_STAT(http_total_server_connections_stat);
+  if (multiplexed) {
+    // The HTTP/2 connection underneath is not ours to count or tune
+    enable_origin_connection_limiting = false;
+  } else {
+    HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, 1); // Update the true global stat
+    HTTP_INCREMENT_DYN_STAT(http_total_server_connections_stat);
+  }
   // Check to see if we are limiting the number of connections
   // per host
   if (enable_origin_connection_limiting == true) {
@@ -91,7 +96,8 @@ HttpServerSession::new_connection(NetVConnection *new_vc)
   Debug("http_ss", "[%" PRId64 "] session born, netvc %p", con_id, new_vc);
   state = HSS_INIT;
   RecString congestion_control_out;
-  if (REC_ReadConfigStringAlloc(congestion_control_out, "proxy.config.net.tcp_congestion_control_out") == REC_ERR_OKAY) {
+  if (!multiplexed &&
+      REC_ReadConfigStringAlloc(congestion_control_out, "proxy.config.net.tcp_congestion_control_out") == REC_ERR_OKAY) {
     int len = strlen(congestion_control_out);
     if (len > 0) {
       new_vc->set_tcp_congestion_control(congestion_control_out, len);
@@ -133,8 +139,10 @@ HttpServerSession::do_io_close(int alerrno)
   }
   server_vc = NULL;
 
-  HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, -1); // Make sure to work on the global stat
-  HTTP_SUM_DYN_STAT(http_transactions_per_server_con, transact_count);
+  if (!multiplexed) {
+    HTTP_SUM_GLOBAL_DYN_STAT(http_current_server_connections_stat, -1); // Make sure to work on the global stat
+    HTTP_SUM_DYN_STAT(http_transactions_per_server_con, transact_count);
+  }
 
   // Check to see if we are limiting the number of connections
   // per host
@@ -174,8 +182,9 @@ HttpServerSession::release()
   // Set our state to KA for stat issues
   state = HSS_KA_SHARED;
 
-  // Private sessions are never released back to the shared pool
-  if (private_session || TS_SERVER_SESSION_SHARING_MATCH_NONE == sharing_match) {
+  // Private sessions are never released back to the shared pool, and a
+  // multiplexed session is done with its one transaction
+  if (private_session || multiplexed || TS_SERVER_SESSION_SHARING_MATCH_NONE == sharing_match) {
     this->do_io_close();
     return;
   }
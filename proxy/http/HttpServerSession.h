@@ -72,7 +72,7 @@ public:
     : VConnection(NULL), hostname_hash(), con_id(0), transact_count(0), state(HSS_INIT), to_parent_proxy(false),
       server_trans_stat(0), private_session(false), sharing_match(TS_SERVER_SESSION_SHARING_MATCH_BOTH),
       sharing_pool(TS_SERVER_SESSION_SHARING_POOL_GLOBAL), enable_origin_connection_limiting(false), connection_count(NULL),
-      read_buffer(NULL), server_vc(NULL), magic(HTTP_SS_MAGIC_DEAD), buf_reader(NULL)
+      multiplexed(false), read_buffer(NULL), server_vc(NULL), magic(HTTP_SS_MAGIC_DEAD), buf_reader(NULL)
   {
     ink_zero(server_ip);
   }
@@ -154,6 +154,11 @@ public:
   bool enable_origin_connection_limiting;
   ConnectionCount *connection_count;
 
+  // The session is a stream on an HTTP/2 connection to the origin server
+  // rather than a connection of its own. It is not counted as a server
+  // connection and is never kept alive, the HTTP/2 connection is.
+  bool multiplexed;
+
   // The ServerSession owns the following buffer which use
   //   for parsing the headers.  The server session needs to
   //   own the buffer so we can go from a keep-alive state
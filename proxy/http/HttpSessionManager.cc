@@ -35,6 +35,7 @@
 #include "HttpServerSession.h"
 #include "HttpSM.h"
 #include "HttpDebugNames.h"
+#include "http2/Http2ServerSession.h"
 
 // Initialize a thread to handle HTTP session management
 void
@@ -221,6 +222,7 @@ void
 HttpSessionManager::init()
 {
   m_g_pool = new ServerSessionPool;
+  m_h2_pool = new Http2ServerSessionPool;
 }
 
 // TODO: Should this really purge all keep-alive sessions?
@@ -330,6 +332,85 @@ HttpSessionManager::acquire_session(Continuation * /* cont ATS_UNUSED */, sockad
   return retval;
 }
 
+HSMresult_t
+HttpSessionManager::acquire_http2_stream(sockaddr const *ip, const char *hostname, HttpSM *sm, bool wait_for_handshake)
+{
+  INK_MD5 hostname_hash;
+  bool retry;
+
+  ink_code_md5((unsigned char *)hostname, strlen(hostname), (unsigned char *)&hostname_hash);
+
+  Http2ServerStream *stream = m_h2_pool->acquire_stream(ip, hostname_hash, sm->mutex, wait_for_handshake, retry);
+  Debug("http_ss", "[acquire session] HTTP/2 pool search %s", stream ? "successful" : retry ? "busy" : "failed");
+  if (stream == NULL) {
+    return retry ? HSM_RETRY : HSM_NOT_FOUND;
+  }
+
+  attach_http2_stream(stream, ip, hostname_hash, sm);
+  return HSM_DONE;
+}
+
+Action *
+HttpSessionManager::wait_for_http2_stream(sockaddr const *ip, const char *hostname, HttpSM *sm, ink_hrtime wait_until)
+{
+  INK_MD5 hostname_hash;
+
+  ink_code_md5((unsigned char *)hostname, strlen(hostname), (unsigned char *)&hostname_hash);
+  return m_h2_pool->wait_for_stream(ip, hostname_hash, sm, wait_until);
+}
+
+void
+HttpSessionManager::start_http2_session(NetVConnection *netvc, sockaddr const *ip, const char *hostname, HttpSM *sm)
+{
+  INK_MD5 hostname_hash;
+
+  ink_code_md5((unsigned char *)hostname, strlen(hostname), (unsigned char *)&hostname_hash);
+
+  Http2ServerSession *h2_session = THREAD_ALLOC_INIT(http2ServerSessionAllocator, this_ethread());
+  h2_session->new_connection(netvc, ip, hostname_hash);
+  Http2ServerStream *stream = h2_session->start(m_h2_pool, sm->mutex);
+
+  attach_http2_stream(stream, ip, hostname_hash, sm);
+}
+
+void
+HttpSessionManager::begin_http2_handshake(sockaddr const *ip, const char *hostname, ink_hrtime timeout)
+{
+  INK_MD5 hostname_hash;
+
+  ink_code_md5((unsigned char *)hostname, strlen(hostname), (unsigned char *)&hostname_hash);
+  m_h2_pool->begin_handshake(ip, hostname_hash, timeout);
+}
+
+void
+HttpSessionManager::end_http2_handshake(sockaddr const *ip, const char *hostname)
+{
+  INK_MD5 hostname_hash;
+
+  ink_code_md5((unsigned char *)hostname, strlen(hostname), (unsigned char *)&hostname_hash);
+  m_h2_pool->end_handshake(ip, hostname_hash);
+}
+
+// Wrap an HTTP/2 stream in a server session of its own, so the state machine can treat it as a connection.
+void
+HttpSessionManager::attach_http2_stream(NetVConnection *stream, sockaddr const *ip, INK_MD5 const &hostname_hash, HttpSM *sm)
+{
+  HttpServerSession *session =
+    (TS_SERVER_SESSION_SHARING_POOL_THREAD == sm->t_state.http_config_param->server_session_sharing_pool) ?
+      THREAD_ALLOC_INIT(httpServerSessionAllocator, this_ethread()) :
+      httpServerSessionAllocator.alloc();
+
+  session->sharing_pool = static_cast<TSServerSessionSharingPoolType>(sm->t_state.http_config_param->server_session_sharing_pool);
+  session->sharing_match = static_cast<TSServerSessionSharingMatchType>(sm->t_state.txn_conf->server_session_sharing_match);
+  session->multiplexed = true;
+  session->hostname_hash = hostname_hash;
+  ats_ip_copy(&session->server_ip, ip);
+  session->new_connection(stream);
+  session->state = HSS_ACTIVE;
+
+  sm->attach_server_session(session);
+}
+
 HSMresult_t
 HttpSessionManager::release_session(HttpServerSession *to_release)
 {
@@ -39,6 +39,7 @@
 
 class ProxyClientTransaction;
 class HttpSM;
+class Http2ServerSessionPool;
 
 void initialize_thread_for_http_sessions(EThread *thread, int thread_index);
 
@@ -153,11 +154,30 @@ public:
 class HttpSessionManager
 {
 public:
-  HttpSessionManager() : m_g_pool(NULL) {}
+  HttpSessionManager() : m_g_pool(NULL), m_h2_pool(NULL) {}
   ~HttpSessionManager() {}
   HSMresult_t acquire_session(Continuation *cont, sockaddr const *addr, const char *hostname, ProxyClientTransaction *ua_session,
                               HttpSM *sm);
   HSMresult_t release_session(HttpServerSession *to_release);
+
+  /** Get a stream on a shared HTTP/2 connection to the origin server.
+
+      On success the stream is attached to @a sm as a multiplexed server session. @c HSM_RETRY means a stream may be
+      available shortly, because a lock was missed or, with @a wait_for_handshake, a connection to the origin server is
+      still in its handshake.
+  */
+  HSMresult_t acquire_http2_stream(sockaddr const *addr, const char *hostname, HttpSM *sm, bool wait_for_handshake);
+  /** Call @a sm back with @c EVENT_INTERVAL when a stream may be available after @c HSM_RETRY, or at @a wait_until.
+   */
+  Action *wait_for_http2_stream(sockaddr const *addr, const char *hostname, HttpSM *sm, ink_hrtime wait_until);
+  /** Start sharing @a netvc, which negotiated HTTP/2, and attach its first stream to @a sm.
+   */
+  void start_http2_session(NetVConnection *netvc, sockaddr const *addr, const char *hostname, HttpSM *sm);
+  /** Note a connection to the origin server which offers HTTP/2 and has yet to finish its handshake.
+   */
+  void begin_http2_handshake(sockaddr const *addr, const char *hostname, ink_hrtime timeout);
+  void end_http2_handshake(sockaddr const *addr, const char *hostname);
+
   void purge_keepalives();
   void init();
   int main_handler(int event, void *data);
@@ -166,6 +186,10 @@ private:
   /// Global pool, used if not per thread pools.
   /// @internal We delay creating this because the session manager is created during global statics init.
   ServerSessionPool *m_g_pool;
+  /// HTTP/2 connections to origin servers, always global since streams are taken from any thread.
+  Http2ServerSessionPool *m_h2_pool;
+
+  void attach_http2_stream(NetVConnection *stream, sockaddr const *addr, INK_MD5 const &hostname_hash, HttpSM *sm);
 };
 
 extern HttpSessionManager httpSessionManager;
@@ -31,6 +31,8 @@
 #include "ts/ink_cap.h"
 #include "ts/ink_file.h"
 #include "ts/Tokenizer.h"
+#include "ts/HashFNV.h"
+#include <string>
 
 #define modulePrefix "[ReverseProxy]"
 
@@ -683,9 +685,48 @@ remap_check_option(const char **argv, int argc, unsigned long findmode, int *_re
   return ret_flags;
 }
 
+/**
+  Makes the key a plugin instance is shared by between remap tables: the plugin path, where it is in the plugin chain of
+  the rule, the instance arguments, and the identity, size and modification time of each argument which names a file,
+  as is or after its last '=', absolute or relative to the config directory. This way an instance whose configuration
+  file was changed is not reused, nor is one given to another plugin of the same chain with the same arguments.
+
+*/
+static void
+remap_plugin_instance_key(const remap_plugin_info *pi, int jump_to_argc, int parc, char *parv[], std::string &key)
+{
+  char buf[64];
+
+  snprintf(buf, sizeof(buf), "\n%d", jump_to_argc);
+  key = pi->path;
+  key += buf;
+  for (int i = 0; i < parc; i++) {
+    key += '\n';
+    key += parv[i];
+  }
+
+  for (int i = 2; i < parc; i++) {
+    const char *eq = strrchr(parv[i], '=');
+    const char *names[2] = {parv[i], eq && eq[1] ? eq + 1 : NULL};
+    struct stat st;
+
+    for (unsigned j = 0; j < countof(names); j++) {
+      if (names[j] == NULL) {
+        continue;
+      }
+      ats_scoped_str path(RecConfigReadConfigPath(NULL, names[j]));
+      if (path && stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+        snprintf(buf, sizeof(buf), "\n%" PRIu64 ":%" PRId64 ":%" PRId64, (uint64_t)st.st_ino, (int64_t)st.st_size,
+                 (int64_t)st.st_mtime);
+        key += buf;
+      }
+    }
+  }
+}
+
 int
-remap_load_plugin(const char **argv, int argc, url_mapping *mp, char *errbuf, int errbufsize, int jump_to_argc,
-                  int *plugin_found_at)
+remap_load_plugin(UrlRewrite *rewrite, const char **argv, int argc, url_mapping *mp, char *errbuf, int errbufsize,
+                  int jump_to_argc, int *plugin_found_at)
 {
   TSRemapInterface ri;
   struct stat stat_buf;
@@ -780,6 +821,8 @@ remap_load_plugin(const char **argv, int argc, url_mapping *mp, char *errbuf, in
         (remap_plugin_info::_tsremap_delete_instance *)dlsym(pi->dlh, TSREMAP_FUNCNAME_DELETE_INSTANCE);
       pi->fp_tsremap_do_remap = (remap_plugin_info::_tsremap_do_remap *)dlsym(pi->dlh, TSREMAP_FUNCNAME_DO_REMAP);
       pi->fp_tsremap_os_response = (remap_plugin_info::_tsremap_os_response *)dlsym(pi->dlh, TSREMAP_FUNCNAME_OS_RESPONSE);
+      remap_plugin_info::_tsremap_reuse_instances *fp_tsremap_reuse_instances =
+        (remap_plugin_info::_tsremap_reuse_instances *)dlsym(pi->dlh, TSREMAP_FUNCNAME_REUSE_INSTANCES);
 
       if (!pi->fp_tsremap_init) {
         snprintf(errbuf, errbufsize, "Can't find \"%s\" function in remap plugin \"%s\"", TSREMAP_FUNCNAME_INIT, c);
@@ -803,6 +846,7 @@ remap_load_plugin(const char **argv, int argc, url_mapping *mp, char *errbuf, in
         Warning("Failed to initialize plugin %s (non-zero retval) ... bailing out", pi->path);
         return -5;
       }
+      pi->reuse_instances = fp_tsremap_reuse_instances && fp_tsremap_reuse_instances();
     } // done elevating access
     Debug("remap_plugin", "Remap plugin \"%s\" - initialization completed", c);
   }
@@ -853,6 +897,18 @@ remap_load_plugin(const char **argv, int argc, url_mapping *mp, char *errbuf, in
     Debug("url_rewrite", "Argument %d: %s", k, parv[k]);
   }
 
+  std::string key;
+  remap_plugin_instance *instance;
+
+  remap_plugin_instance_key(pi, jump_to_argc, parc, parv, key);
+  if ((instance = rewrite->ReusePluginInstance(pi, key.c_str())) != NULL) {
+    Debug("remap_plugin", "reusing the plugin instance of the previous remap table");
+    ats_free(parv[0]); // fromURL
+    ats_free(parv[1]); // toURL
+    mp->add_plugin(instance);
+    return 0;
+  }
+
   Debug("remap_plugin", "creating new plugin instance");
 
   void *ih = NULL;
@@ -873,7 +929,9 @@ remap_load_plugin(const char **argv, int argc, url_mapping *mp, char *errbuf, in
     return -8;
   }
 
-  mp->add_plugin(pi, ih);
+  instance = new remap_plugin_instance(pi, ih, key.c_str());
+  rewrite->AddPluginInstance(instance);
+  mp->add_plugin(instance);
 
   return 0;
 }
@@ -953,6 +1011,38 @@ lFail:
   return false;
 }
 
+/**
+  Records the rule just parsed, by its type and from URL and by all of its tokens and the filters active for it, so that
+  a reload can tell which rules it added, removed or changed.
+
+*/
+static void
+remap_add_signature(BUILD_TABLE_INFO *bti)
+{
+  ATSHash64FNV1a from, rule;
+
+  from.update(bti->paramv[0], strlen(bti->paramv[0]) + 1);
+  from.update(bti->paramv[1], strlen(bti->paramv[1]) + 1);
+  from.final();
+
+  for (int i = 0; i < bti->paramc; i++) {
+    rule.update(bti->paramv[i], strlen(bti->paramv[i]) + 1);
+  }
+  for (int i = 0; i < bti->argc; i++) {
+    rule.update(bti->argv[i], strlen(bti->argv[i]) + 1);
+  }
+  for (acl_filter_rule *rp = bti->rules_list; rp; rp = rp->next) {
+    if (rp->active_queue_flag) {
+      for (int i = 0; i < rp->argc; i++) {
+        rule.update(rp->argv[i], strlen(rp->argv[i]) + 1);
+      }
+    }
+  }
+  rule.final();
+
+  bti->rewrite->AddMappingSignature(from.get(), rule.get());
+}
+
 static bool
 remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
 {
@@ -1313,7 +1403,7 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
         int jump_to_argc = 0;
 
         // this loads the first plugin
-        if (remap_load_plugin((const char **)bti->argv, bti->argc, new_mapping, errStrBuf, sizeof(errStrBuf), 0,
+        if (remap_load_plugin(bti->rewrite, (const char **)bti->argv, bti->argc, new_mapping, errStrBuf, sizeof(errStrBuf), 0,
                               &plugin_found_at)) {
           Debug("remap_plugin", "Remap plugin load error - %s", errStrBuf[0] ? errStrBuf : "Unknown error");
           errStr = errStrBuf;
@@ -1322,8 +1412,8 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
         // this loads any subsequent plugins (if present)
         while (plugin_found_at) {
           jump_to_argc += plugin_found_at;
-          if (remap_load_plugin((const char **)bti->argv, bti->argc, new_mapping, errStrBuf, sizeof(errStrBuf), jump_to_argc,
-                                &plugin_found_at)) {
+          if (remap_load_plugin(bti->rewrite, (const char **)bti->argv, bti->argc, new_mapping, errStrBuf, sizeof(errStrBuf),
+                                jump_to_argc, &plugin_found_at)) {
             Debug("remap_plugin", "Remap plugin load error - %s", errStrBuf[0] ? errStrBuf : "Unknown error");
             errStr = errStrBuf;
             goto MAP_ERROR;
@@ -1337,6 +1427,7 @@ remap_parse_config_bti(const char *path, BUILD_TABLE_INFO *bti)
       errStr = "Unable to add mapping rule to lookup table";
       goto MAP_ERROR;
     }
+    remap_add_signature(bti);
 
     fromHost_lower_ptr = (char *)ats_free_null(fromHost_lower_ptr);
 
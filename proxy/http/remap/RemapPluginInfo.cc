@@ -27,7 +27,8 @@
 
 remap_plugin_info::remap_plugin_info(char *_path)
   : next(0), path(NULL), path_size(0), dlh(NULL), fp_tsremap_init(NULL), fp_tsremap_done(NULL), fp_tsremap_new_instance(NULL),
-    fp_tsremap_delete_instance(NULL), fp_tsremap_do_remap(NULL), fp_tsremap_os_response(NULL)
+    fp_tsremap_delete_instance(NULL), fp_tsremap_do_remap(NULL), fp_tsremap_os_response(NULL),
+    reuse_instances(false)
 {
   // coverity did not see ats_free
   // coverity[ctor_dtor_leak]
@@ -95,3 +96,15 @@ remap_plugin_info::delete_my_list()
 
   delete this;
 }
+
+remap_plugin_instance::remap_plugin_instance(remap_plugin_info *_plugin, void *_ih, const char *_key)
+  : plugin(_plugin), ih(_ih), key(ats_strdup(_key))
+{
+}
+
+remap_plugin_instance::~remap_plugin_instance()
+{
+  if (ih && plugin->fp_tsremap_delete_instance)
+    plugin->fp_tsremap_delete_instance(ih);
+  ats_free(key);
+}
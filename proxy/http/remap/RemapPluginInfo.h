@@ -24,6 +24,7 @@
 #if !defined(_REMAPPLUGININFO_h_)
 #define _REMAPPLUGININFO_h_
 #include "ts/ink_platform.h"
+#include "ts/Ptr.h"
 #include "api/ts/ts.h"
 #include "api/ts/remap.h"
 
@@ -33,6 +34,7 @@
 #define TSREMAP_FUNCNAME_DELETE_INSTANCE "TSRemapDeleteInstance"
 #define TSREMAP_FUNCNAME_DO_REMAP "TSRemapDoRemap"
 #define TSREMAP_FUNCNAME_OS_RESPONSE "TSRemapOSResponse"
+#define TSREMAP_FUNCNAME_REUSE_INSTANCES "TSRemapReuseInstances"
 
 class url_mapping;
 
@@ -48,6 +50,7 @@ public:
   typedef void _tsremap_delete_instance(void *);
   typedef TSRemapStatus _tsremap_do_remap(void *ih, TSHttpTxn rh, TSRemapRequestInfo *rri);
   typedef void _tsremap_os_response(void *ih, TSHttpTxn rh, int os_response_type);
+  typedef int _tsremap_reuse_instances(void);
 
   remap_plugin_info *next;
   char *path;
@@ -59,6 +62,7 @@ public:
   _tsremap_delete_instance *fp_tsremap_delete_instance;
   _tsremap_do_remap *fp_tsremap_do_remap;
   _tsremap_os_response *fp_tsremap_os_response;
+  bool reuse_instances; /* the plugin's TSRemapReuseInstances returned non-zero */
 
   remap_plugin_info(char *_path);
   ~remap_plugin_info();
@@ -68,6 +72,26 @@ public:
   void delete_my_list();
 };
 
+/**
+ * An instance of a remap plugin, as created by TSRemapNewInstance. It is refcounted by the mappings which use it, so
+ * that a reloaded remap table can keep the instances of the table it replaces for the rules which did not change. The
+ * instance is deleted along with the last mapping holding it.
+**/
+class remap_plugin_instance : public RefCountObj
+{
+public:
+  remap_plugin_instance(remap_plugin_info *_plugin, void *_ih, const char *_key);
+  ~remap_plugin_instance();
+
+  remap_plugin_info *plugin;
+  void *ih;  /* instance handle passed to the plugin */
+  char *key; /* plugin path and arguments the instance was created with */
+
+private:
+  remap_plugin_instance(const remap_plugin_instance &);            // disabled
+  remap_plugin_instance &operator=(const remap_plugin_instance &); // disabled
+};
+
 /**
  * struct host_hdr_info;
  * Used to store info about host header
@@ -33,21 +33,20 @@ url_mapping::url_mapping(int rank /* = 0 */)
     optional_referer(false), negative_referer(false), wildcard_from_scheme(false), tag(NULL), filter_redirect_url(NULL),
     referer_list(0), redir_chunk_list(0), filter(NULL), _plugin_count(0), _rank(rank)
 {
-  memset(_plugin_list, 0, sizeof(_plugin_list));
-  memset(_instance_data, 0, sizeof(_instance_data));
+  memset(_instance_list, 0, sizeof(_instance_list));
 }
 
 /**
  *
 **/
 bool
-url_mapping::add_plugin(remap_plugin_info *i, void *ih)
+url_mapping::add_plugin(remap_plugin_instance *i)
 {
   if (_plugin_count >= MAX_REMAP_PLUGIN_CHAIN)
     return false;
 
-  _plugin_list[_plugin_count] = i;
-  _instance_data[_plugin_count] = ih;
+  i->refcount_inc();
+  _instance_list[_plugin_count] = i;
   ++_plugin_count;
 
   return true;
@@ -60,23 +59,23 @@ remap_plugin_info *
 url_mapping::get_plugin(unsigned int index) const
 {
   Debug("url_rewrite", "get_plugin says we have %d plugins and asking for plugin %d", _plugin_count, index);
-  if ((_plugin_count == 0) || unlikely(index > _plugin_count))
+  if ((_plugin_count == 0) || unlikely(index >= _plugin_count))
     return NULL;
 
-  return _plugin_list[index];
+  return _instance_list[index]->plugin;
 }
 
 /**
- *
+ * Releases the nth plugin instance, which is deleted if no other mapping shares it.
 **/
 void
 url_mapping::delete_instance(unsigned int index)
 {
-  void *ih = get_instance(index);
-  remap_plugin_info *p = get_plugin(index);
+  remap_plugin_instance *i = _instance_list[index];
 
-  if (ih && p && p->fp_tsremap_delete_instance) {
-    p->fp_tsremap_delete_instance(ih);
+  _instance_list[index] = NULL;
+  if (i && i->refcount_dec() == 0) {
+    delete i;
   }
 }
 
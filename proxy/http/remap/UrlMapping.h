@@ -83,13 +83,18 @@ public:
   url_mapping(int rank = 0);
   ~url_mapping();
 
-  bool add_plugin(remap_plugin_info *i, void *ih);
+  bool add_plugin(remap_plugin_instance *i);
   remap_plugin_info *get_plugin(unsigned int) const;
 
   void *
   get_instance(unsigned int index) const
   {
-    return _instance_data[index];
+    return _instance_list[index]->ih;
+  };
+  remap_plugin_instance *
+  get_plugin_instance(unsigned int index) const
+  {
+    return _instance_list[index];
   };
   void delete_instance(unsigned int index);
   void Print();
@@ -124,8 +129,7 @@ public:
   };
 
 private:
-  remap_plugin_info *_plugin_list[MAX_REMAP_PLUGIN_CHAIN];
-  void *_instance_data[MAX_REMAP_PLUGIN_CHAIN];
+  remap_plugin_instance *_instance_list[MAX_REMAP_PLUGIN_CHAIN];
   int _rank;
 };
 
@@ -24,67 +24,114 @@
 
 UrlMappingPathIndex::~UrlMappingPathIndex()
 {
-  for (UrlMappingGroup::iterator group_iter = m_tries.begin(); group_iter != m_tries.end(); ++group_iter)
-    delete group_iter->second; // Delete the Trie
-  m_tries.clear();
+  delete[] m_groups;
+  for (std::vector<url_mapping *>::iterator iter = m_mappings.begin(); iter != m_mappings.end(); ++iter) {
+    delete *iter;
+  }
 }
 
 bool
 UrlMappingPathIndex::Insert(url_mapping *mapping)
 {
-  int scheme_idx;
-  int port = (mapping->fromURL).port_get();
-  UrlMappingTrie *trie;
-  int from_path_len;
-  const char *from_path;
-
-  trie = _GetTrie(&(mapping->fromURL), scheme_idx, port);
-
-  if (!trie) {
-    trie = new UrlMappingTrie();
-    m_tries.insert(UrlMappingGroup::value_type(UrlMappingTrieKey(scheme_idx, port), trie));
-    Debug("UrlMappingPathIndex::Insert", "Created new trie for scheme index, port combo <%d, %d>", scheme_idx, port);
+  ink_assert(m_groups == NULL);
+  m_mappings.push_back(mapping);
+  Debug("UrlMappingPathIndex::Insert", "Inserted new element!");
+  return true;
+}
+
+bool
+UrlMappingPathIndex::_GroupLess(url_mapping *lhs, url_mapping *rhs)
+{
+  int lhs_port = lhs->fromURL.port_get();
+  int rhs_port = rhs->fromURL.port_get();
+  int lhs_idx = _GetSchemeIndex(&lhs->fromURL, lhs_port);
+  int rhs_idx = _GetSchemeIndex(&rhs->fromURL, rhs_port);
+
+  if (lhs_idx == rhs_idx) {
+    return lhs_port < rhs_port;
   }
+  return lhs_idx < rhs_idx;
+}
 
-  from_path = mapping->fromURL.path_get(&from_path_len);
-  if (!trie->Insert(from_path, mapping, mapping->getRank(), from_path_len)) {
-    Error("Couldn't insert into trie!");
-    return false;
+bool
+UrlMappingPathIndex::Freeze()
+{
+  std::vector<url_mapping *> sorted(m_mappings);
+  std::vector<UrlMappingPathMap::Entry> entries(sorted.size());
+  int n = sorted.size();
+
+  ink_assert(m_groups == NULL);
+  std::stable_sort(sorted.begin(), sorted.end(), _GroupLess);
+
+  m_ngroups = 0;
+  for (int i = 0; i < n; i++) {
+    if (i == 0 || _GroupLess(sorted[i - 1], sorted[i])) {
+      ++m_ngroups;
+    }
+  }
+  m_groups = new UrlMappingGroup[m_ngroups > 0 ? m_ngroups : 1];
+
+  for (int lo = 0, group = 0; lo < n; group++) {
+    int hi = lo + 1;
+    while (hi < n && !_GroupLess(sorted[lo], sorted[hi])) {
+      ++hi;
+    }
+
+    for (int i = lo; i < hi; i++) {
+      entries[i - lo].key = sorted[i]->fromURL.path_get(&entries[i - lo].key_len);
+      entries[i - lo].rank = sorted[i]->getRank();
+      entries[i - lo].value = sorted[i];
+    }
+    m_groups[group].port = sorted[lo]->fromURL.port_get();
+    m_groups[group].scheme_wks_idx = _GetSchemeIndex(&sorted[lo]->fromURL, m_groups[group].port);
+    if (!m_groups[group].paths.Build(&entries[0], hi - lo)) {
+      Error("Duplicate mapping for scheme index, port combo <%d, %d>", m_groups[group].scheme_wks_idx, m_groups[group].port);
+      return false;
+    }
+    Debug("UrlMappingPathIndex::Freeze", "Indexed %d paths for scheme index, port combo <%d, %d>", hi - lo,
+          m_groups[group].scheme_wks_idx, m_groups[group].port);
+    lo = hi;
   }
-  Debug("UrlMappingPathIndex::Insert", "Inserted new element!");
   return true;
 }
 
 url_mapping *
 UrlMappingPathIndex::Search(URL *request_url, int request_port, bool normal_search /* = true */) const
 {
-  url_mapping *retval = 0;
-  int scheme_idx;
-  UrlMappingTrie *trie;
+  const UrlMappingGroup *group = NULL;
+  int scheme_idx = _GetSchemeIndex(request_url, request_port);
   int path_len;
   const char *path;
+  url_mapping *retval;
+
+  if (normal_search) {
+    for (int i = 0; i < m_ngroups; i++) {
+      if (m_groups[i].scheme_wks_idx == scheme_idx && m_groups[i].port == request_port) {
+        group = &m_groups[i];
+        break;
+      }
+    }
+  } else if (m_ngroups > 0) { // return the first group arbitrarily
+    Debug("UrlMappingPathIndex::Search", "Not performing search; will use first available group");
+    group = &m_groups[0];
+  }
 
-  trie = _GetTrie(request_url, scheme_idx, request_port, normal_search);
-
-  if (!trie) {
+  if (!group) {
     Debug("UrlMappingPathIndex::Search", "No mappings exist for scheme index, port combo <%d, %d>", scheme_idx, request_port);
-    goto lFail;
+    return NULL;
   }
 
   path = request_url->path_get(&path_len);
-  if (!(retval = trie->Search(path, path_len))) {
+  if (!(retval = group->paths.Search(path, path_len))) {
     Debug("UrlMappingPathIndex::Search", "Couldn't find entry for url with path [%.*s]", path_len, path);
-    goto lFail;
   }
   return retval;
-
-lFail:
-  return 0;
 }
 
 void
 UrlMappingPathIndex::Print()
 {
-  for (UrlMappingGroup::iterator group_iter = m_tries.begin(); group_iter != m_tries.end(); ++group_iter)
-    group_iter->second->Print();
+  for (std::vector<url_mapping *>::iterator iter = m_mappings.begin(); iter != m_mappings.end(); ++iter) {
+    (*iter)->Print();
+  }
 }
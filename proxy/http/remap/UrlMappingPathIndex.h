@@ -25,41 +25,40 @@
 
 #include "ts/ink_platform.h"
 #undef std // FIXME: remove dependancy on the STL
-#include <map>
+#include <vector>
 
 #include "URL.h"
 #include "UrlMapping.h"
-#include "ts/Trie.h"
+#include "ts/CompactIndex.h"
 
+/** The mappings of one host, by scheme, port and path.
+
+    Mappings are inserted while remap.config is loaded, then Freeze() puts each scheme and port into a compact radix
+    tree of the paths, after which the index is only searched.
+*/
 class UrlMappingPathIndex
 {
 public:
-  UrlMappingPathIndex() {}
+  UrlMappingPathIndex() : m_groups(NULL), m_ngroups(0) {}
   virtual ~UrlMappingPathIndex();
   bool Insert(url_mapping *mapping);
+  // Returns false if two mappings have the same scheme, port and path.
+  bool Freeze();
   url_mapping *Search(URL *request_url, int request_port, bool normal_search = true) const;
   void Print();
 
 private:
-  typedef Trie<url_mapping> UrlMappingTrie;
+  typedef CompactPrefixMap<url_mapping> UrlMappingPathMap;
 
-  struct UrlMappingTrieKey {
+  struct UrlMappingGroup {
     int scheme_wks_idx;
     int port;
-
-    UrlMappingTrieKey(int idx, int p) : scheme_wks_idx(idx), port(p) {}
-    bool
-    operator<(const UrlMappingTrieKey &rhs) const
-    {
-      if (scheme_wks_idx == rhs.scheme_wks_idx) {
-        return (port < rhs.port);
-      }
-      return (scheme_wks_idx < rhs.scheme_wks_idx);
-    }
+    UrlMappingPathMap paths;
   };
 
-  typedef std::map<UrlMappingTrieKey, UrlMappingTrie *> UrlMappingGroup;
-  UrlMappingGroup m_tries;
+  std::vector<url_mapping *> m_mappings; // Owned, in the order they were inserted
+  UrlMappingGroup *m_groups;             // Sorted on scheme, then port
+  int m_ngroups;
 
   // make copy-constructor and assignment operator private
   // till we properly implement them
@@ -70,10 +69,10 @@ private:
     return *this;
   }
 
-  inline UrlMappingTrie *
-  _GetTrie(URL *url, int &idx, int port, bool search = true) const
+  static int
+  _GetSchemeIndex(URL *url, int port)
   {
-    idx = url->scheme_get_wksidx();
+    int idx = url->scheme_get_wksidx();
     // If the scheme is empty (e.g. because of a CONNECT method), guess it
     // based on port
     if (idx == -1) {
@@ -83,18 +82,10 @@ private:
         idx = URL_WKSIDX_HTTPS;
       }
     }
-    UrlMappingGroup::const_iterator group_iter;
-    if (search) { // normal search
-      group_iter = m_tries.find(UrlMappingTrieKey(idx, port));
-    } else { // return the first trie arbitrarily
-      Debug("UrlMappingPathIndex::_GetTrie", "Not performing search; will return first available trie");
-      group_iter = m_tries.begin();
-    }
-    if (group_iter != m_tries.end()) {
-      return group_iter->second;
-    }
-    return 0;
+    return idx;
   }
+
+  static bool _GroupLess(url_mapping *lhs, url_mapping *rhs);
 };
 
 #endif // _URL_MAPPING_PATH_INDEX_H
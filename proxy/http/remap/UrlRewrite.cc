@@ -21,6 +21,7 @@
   limitations under the License.
  */
 
+#include <algorithm>
 #include "UrlRewrite.h"
 #include "ProxyConfig.h"
 #include "ReverseProxy.h"
@@ -53,10 +54,13 @@ SetHomePageRedirectFlag(url_mapping *new_mapping, URL &new_to_url)
 //
 // CTOR / DTOR for the UrlRewrite class.
 //
-UrlRewrite::UrlRewrite()
+// If @a previous is given, the plugin instances of its rules are reused for the rules of this table which did not change,
+// for the plugins which export TSRemapReuseInstances, or for all of them with @a reuse_all.
+UrlRewrite::UrlRewrite(UrlRewrite *previous, bool reuse_all)
   : nohost_rules(0), reverse_proxy(0), mgmt_synthetic_port(0), ts_name(NULL), http_default_redirect_url(NULL), num_rules_forward(0),
     num_rules_reverse(0), num_rules_redirect_permanent(0), num_rules_redirect_temporary(0), num_rules_forward_with_recv_port(0),
-    _valid(false)
+    num_plugin_instances_created(0), num_plugin_instances_reused(0), _valid(false), _previous(previous), _reuse_all(reuse_all),
+    _plugin_instances(ink_hash_table_create(InkHashTableKeyType_String))
 {
   ats_scoped_str config_file_path;
 
@@ -97,6 +101,7 @@ UrlRewrite::UrlRewrite()
   } else {
     Warning("something failed during BuildTable() -- check your remap plugins!");
   }
+  _previous = NULL;
 }
 
 UrlRewrite::~UrlRewrite()
@@ -109,9 +114,94 @@ UrlRewrite::~UrlRewrite()
   DestroyStore(permanent_redirects);
   DestroyStore(temporary_redirects);
   DestroyStore(forward_mappings_with_recv_port);
+
+  InkHashTableEntry *ht_entry;
+  InkHashTableIteratorState ht_iter;
+
+  for (ht_entry = ink_hash_table_iterator_first(_plugin_instances, &ht_iter); ht_entry != NULL;
+       ht_entry = ink_hash_table_iterator_next(_plugin_instances, &ht_iter)) {
+    remap_plugin_instance *instance = (remap_plugin_instance *)ink_hash_table_entry_value(_plugin_instances, ht_entry);
+    if (instance->refcount_dec() == 0) {
+      delete instance;
+    }
+  }
+  ink_hash_table_destroy(_plugin_instances);
   _valid = false;
 }
 
+/**
+  Returns the instance the table being replaced has for @a key, and adds it to this table, or NULL if there is none or
+  @a plugin does not have its instances reused.
+
+*/
+remap_plugin_instance *
+UrlRewrite::ReusePluginInstance(const remap_plugin_info *plugin, const char *key)
+{
+  void *value;
+
+  if (_previous == NULL || !(_reuse_all || plugin->reuse_instances) ||
+      !ink_hash_table_lookup(_previous->_plugin_instances, key, &value)) {
+    return NULL;
+  }
+  remap_plugin_instance *instance = (remap_plugin_instance *)value;
+  if (!ink_hash_table_isbound(_plugin_instances, key)) {
+    instance->refcount_inc();
+    ink_hash_table_insert(_plugin_instances, key, instance);
+  }
+  ++num_plugin_instances_reused;
+  return instance;
+}
+
+void
+UrlRewrite::AddPluginInstance(remap_plugin_instance *instance)
+{
+  // Rules with the same key can only be duplicates, the first instance is the one to reuse.
+  if (!ink_hash_table_isbound(_plugin_instances, instance->key)) {
+    instance->refcount_inc();
+    ink_hash_table_insert(_plugin_instances, instance->key, instance);
+  }
+  ++num_plugin_instances_created;
+}
+
+void
+UrlRewrite::AddMappingSignature(uint64_t from, uint64_t rule)
+{
+  MappingSignature sig;
+
+  sig.from = from;
+  sig.rule = rule;
+  _mapping_signatures.push_back(sig);
+}
+
+/**
+  Counts the rules of this table which are not in @a previous, the rules of @a previous which are not in this table,
+  and the rules whose type and from URL are in both but which differ otherwise.
+
+*/
+void
+UrlRewrite::DiffMappings(const UrlRewrite *previous, int &added, int &removed, int &changed) const
+{
+  std::vector<MappingSignature>::const_iterator cur = _mapping_signatures.begin();
+  std::vector<MappingSignature>::const_iterator prev = previous->_mapping_signatures.begin();
+
+  added = removed = changed = 0;
+  while (cur != _mapping_signatures.end() && prev != previous->_mapping_signatures.end()) {
+    if (cur->from < prev->from) {
+      ++added;
+      ++cur;
+    } else if (prev->from < cur->from) {
+      ++removed;
+      ++prev;
+    } else {
+      changed += cur->rule != prev->rule;
+      ++cur;
+      ++prev;
+    }
+  }
+  added += _mapping_signatures.end() - cur;
+  removed += previous->_mapping_signatures.end() - prev;
+}
+
 /** Sets the reverse proxy flag. */
 void
 UrlRewrite::SetReverseFlag(int flag)
@@ -166,6 +256,19 @@ UrlRewrite::_destroyTable(InkHashTable *h_table)
   }
 }
 
+static void
+delete_path_index(UrlMappingPathIndex *index)
+{
+  delete index;
+}
+
+void
+UrlRewrite::_destroyIndex(UrlMappingHostIndex &host_index)
+{
+  host_index.ForEach(delete_path_index);
+  host_index.Clear();
+}
+
 /** Debugging Method. */
 void
 UrlRewrite::Print()
@@ -195,20 +298,16 @@ UrlRewrite::Print()
 }
 
 /** Debugging method. */
+static void
+print_path_index(UrlMappingPathIndex *index)
+{
+  index->Print();
+}
+
 void
 UrlRewrite::PrintStore(MappingsStore &store)
 {
-  if (store.hash_lookup != NULL) {
-    InkHashTableEntry *ht_entry;
-    InkHashTableIteratorState ht_iter;
-    UrlMappingPathIndex *value;
-
-    for (ht_entry = ink_hash_table_iterator_first(store.hash_lookup, &ht_iter); ht_entry != NULL;) {
-      value = (UrlMappingPathIndex *)ink_hash_table_entry_value(store.hash_lookup, ht_entry);
-      value->Print();
-      ht_entry = ink_hash_table_iterator_next(store.hash_lookup, &ht_iter);
-    }
-  }
+  store.host_index.ForEach(print_path_index);
 
   if (!store.regex_list.empty()) {
     printf("    Regex mappings:\n");
@@ -222,15 +321,13 @@ UrlRewrite::PrintStore(MappingsStore &store)
 
 */
 url_mapping *
-UrlRewrite::_tableLookup(InkHashTable *h_table, URL *request_url, int request_port, char *request_host, int request_host_len)
+UrlRewrite::_tableLookup(const UrlMappingHostIndex &host_index, URL *request_url, int request_port, char *request_host,
+                         int request_host_len)
 {
-  UrlMappingPathIndex *ht_entry;
+  UrlMappingPathIndex *ht_entry = host_index.Find(request_host, request_host_len);
   url_mapping *um = NULL;
-  int ht_result;
 
-  ht_result = ink_hash_table_lookup(h_table, request_host, (void **)&ht_entry);
-
-  if (likely(ht_result && ht_entry)) {
+  if (likely(ht_entry != NULL)) {
     // for empty host don't do a normal search, get a mapping arbitrarily
     um = ht_entry->Search(request_url, request_port, request_host_len ? true : false);
   }
@@ -578,6 +675,7 @@ UrlRewrite::_addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMap
   new_mapping->setRank(count); // Use the mapping rules number count for rank
   if (is_cur_mapping_regex) {
     store.regex_list.enqueue(reg_map);
+    store.regex_prefilter.add(src_host);
     retval = true;
   } else {
     retval = TableInsert(store.hash_lookup, new_mapping, src_host);
@@ -713,9 +811,60 @@ UrlRewrite::BuildTable(const char *path)
     forward_mappings_with_recv_port.hash_lookup = ink_hash_table_destroy(forward_mappings_with_recv_port.hash_lookup);
   }
 
+  if (!_freezeStore(forward_mappings) || !_freezeStore(reverse_mappings) || !_freezeStore(permanent_redirects) ||
+      !_freezeStore(temporary_redirects) || !_freezeStore(forward_mappings_with_recv_port)) {
+    return 4;
+  }
+  std::sort(_mapping_signatures.begin(), _mapping_signatures.end());
+
   return 0;
 }
 
+/**
+  Moves the hosts of @a store out of the hash table they were loaded into and into its compact host index, and builds
+  the path index of each host and the regex prefilter. Lookups only read what this builds, which is not changed again,
+  so the table needs no locking once it is published.
+
+  @return false if two mappings of a host have the same scheme, port and path.
+
+*/
+bool
+UrlRewrite::_freezeStore(MappingsStore &store)
+{
+  InkHashTableEntry *ht_entry;
+  InkHashTableIteratorState ht_iter;
+  std::vector<UrlMappingHostIndex::Entry> entries;
+  bool retval = true;
+
+  store.regex_prefilter.compile();
+  if (store.hash_lookup == NULL) {
+    return true;
+  }
+
+  for (ht_entry = ink_hash_table_iterator_first(store.hash_lookup, &ht_iter); ht_entry != NULL;
+       ht_entry = ink_hash_table_iterator_next(store.hash_lookup, &ht_iter)) {
+    UrlMappingHostIndex::Entry entry;
+
+    entry.key = (const char *)ink_hash_table_entry_key(store.hash_lookup, ht_entry);
+    entry.key_len = strlen(entry.key);
+    entry.rank = 0;
+    entry.value = (UrlMappingPathIndex *)ink_hash_table_entry_value(store.hash_lookup, ht_entry);
+    if (!entry.value->Freeze()) {
+      Warning("%s Duplicate mappings for host [%s]", modulePrefix, entry.key);
+      retval = false;
+    }
+    entries.push_back(entry);
+  }
+
+  // Until the index is built the hash table still owns the path indexes.
+  if (retval && store.host_index.Build(entries.empty() ? NULL : &entries[0], entries.size())) {
+    ink_hash_table_destroy(store.hash_lookup);
+    store.hash_lookup = NULL;
+    return true;
+  }
+  return false;
+}
+
 /**
   Inserts arg mapping in h_table with key src_host chaining the mapping
   of existing entries bound to src_host if necessary.
@@ -775,15 +924,15 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url, int reques
 
   bool retval = false;
   int rank_ceiling = -1;
-  url_mapping *mapping = _tableLookup(mappings.hash_lookup, request_url, request_port, request_host_lower, request_host_len);
+  url_mapping *mapping = _tableLookup(mappings.host_index, request_url, request_port, request_host_lower, request_host_len);
   if (mapping != NULL) {
     rank_ceiling = mapping->getRank();
     Debug("url_rewrite", "Found 'simple' mapping with rank %d", rank_ceiling);
     mapping_container.set(mapping);
     retval = true;
   }
-  if (_regexMappingLookup(mappings.regex_list, request_url, request_port, request_host_lower, request_host_len, rank_ceiling,
-                          mapping_container)) {
+  if (_regexMappingLookup(mappings.regex_list, mappings.regex_prefilter, request_url, request_port, request_host_lower,
+                          request_host_len, rank_ceiling, mapping_container)) {
     Debug("url_rewrite", "Using regex mapping with rank %d", (mapping_container.getMapping())->getRank());
     retval = true;
   }
@@ -839,8 +988,9 @@ lOverFlow:
 }
 
 bool
-UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
-                                int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container)
+UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, const RegexPrefilter &prefilter, URL *request_url,
+                                int request_port, const char *request_host, int request_host_len, int rank_ceiling,
+                                UrlMappingContainer &mapping_container)
 {
   bool retval = false;
 
@@ -864,15 +1014,26 @@ UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_u
     request_scheme_len = hdrtoken_wks_to_length(request_scheme);
   }
 
+  // Find the mappings whose regex could match the host in one pass over it, only those are run.
+  RegexCandidates candidates;
+  int reg_map_idx = -1;
+
+  prefilter.scan(request_host, request_host_len, candidates);
+
   // Loop over the entire linked list, or until we're satisfied
   forl_LL(RegexMapping, list_iter, regex_mappings)
   {
     int reg_map_rank = list_iter->url_map->getRank();
 
+    ++reg_map_idx;
     if (reg_map_rank > rank_ceiling) {
       break;
     }
 
+    if (!candidates.test(reg_map_idx)) {
+      continue;
+    }
+
     reg_map_scheme = list_iter->url_map->fromURL.scheme_get(&reg_map_scheme_len);
     if ((request_scheme_len != reg_map_scheme_len) || strncmp(request_scheme, reg_map_scheme, request_scheme_len)) {
       Debug("url_rewrite_regex", "Skipping regex with rank %d as scheme does not match request scheme", reg_map_rank);
@@ -937,3 +1098,115 @@ UrlRewrite::_destroyList(RegexMappingList &mappings)
   }
   mappings.clear();
 }
+
+#if TS_HAS_TESTS
+#include "ts/Regression.h"
+#include "ts/TestBox.h"
+
+// Load a remap.config of 500,000 rules, a rule for each of 250,000 hosts and one for a path below it, reload it over
+// itself as reloadUrlRewrite() does, and look rules up by host and path. It takes a few seconds and some hundred MB.
+EXCLUSIVE_REGRESSION_TEST(UrlRewrite_500k)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  const int hosts = 250000;
+  const int n_urls = 10000;
+  const int rounds = 100;
+  TestBox box(t, pstatus);
+  char config_path[] = "/tmp/remap_500k.XXXXXX";
+  char *saved_path = NULL;
+  int fd = mkstemp(config_path);
+  FILE *fp = fd >= 0 ? fdopen(fd, "w") : NULL;
+
+  box = REGRESSION_TEST_PASSED;
+  if (fp == NULL) {
+    box.check(false, "can't create %s", config_path);
+    return;
+  }
+  for (int i = 0; i < hosts; i++) {
+    fprintf(fp, "map http://www%d.example.com/ http://origin%d.example.com/\n", i, i);
+    fprintf(fp, "map http://www%d.example.com/images/%d/ http://images%d.example.com/\n", i, i % 100, i);
+  }
+  fclose(fp);
+
+  REC_ReadConfigStringAlloc(saved_path, "proxy.config.url_remap.filename");
+  RecSetRecordString("proxy.config.url_remap.filename", config_path, REC_SOURCE_EXPLICIT);
+
+  int64_t size = process_resident_size();
+  ink_hrtime start = ink_get_hrtime_internal();
+  UrlRewrite *table = new UrlRewrite;
+  ink_hrtime load_time = ink_get_hrtime_internal() - start;
+  size = process_resident_size() - size;
+  box.check(table->is_valid() && table->num_rules_forward == 2 * hosts, "loaded %d rules of %d", table->num_rules_forward,
+            2 * hosts);
+
+  int added, removed, changed;
+  start = ink_get_hrtime_internal();
+  UrlRewrite *reloaded = new UrlRewrite(table);
+  ink_hrtime reload_time = ink_get_hrtime_internal() - start;
+  reloaded->DiffMappings(table, added, removed, changed);
+  box.check(reloaded->is_valid() && added == 0 && removed == 0 && changed == 0, "reload changed %d, %d, %d rules", added,
+            removed, changed);
+  delete table;
+  table = reloaded;
+
+  // Parse the request URLs up front, so the lookups are timed alone.
+  URL *urls = new URL[n_urls];
+  int *ids = static_cast<int *>(ats_malloc(n_urls * sizeof(int)));
+  unsigned int seed = 1;
+  for (int i = 0; i < n_urls; i++) {
+    char buf[128];
+    int len;
+
+    ids[i] = rand_r(&seed) % hosts;
+    if (i % 2) {
+      len = snprintf(buf, sizeof(buf), "http://www%d.example.com/images/%d/thumb.jpg", ids[i], ids[i] % 100);
+    } else {
+      len = snprintf(buf, sizeof(buf), "http://www%d.example.com/index.html", ids[i]);
+    }
+    urls[i].create(NULL);
+    urls[i].parse(buf, len);
+  }
+
+  int found = 0;
+  start = ink_get_hrtime_internal();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < n_urls; i++) {
+      UrlMappingContainer container;
+      int host_len;
+      const char *host = urls[i].host_get(&host_len);
+
+      found += table->forwardMappingLookup(&urls[i], 80, host, host_len, container);
+    }
+  }
+  ink_hrtime lookup_time = ink_get_hrtime_internal() - start;
+  box.check(found == rounds * n_urls, "found %d of %d mappings", found, rounds * n_urls);
+
+  // And that they found the right rule.
+  for (int i = 0; i < n_urls; i++) {
+    UrlMappingContainer container;
+    char expected[64];
+    int host_len, expected_len;
+    const char *host = urls[i].host_get(&host_len);
+
+    if (i % 2) {
+      expected_len = snprintf(expected, sizeof(expected), "images%d.example.com", ids[i]);
+    } else {
+      expected_len = snprintf(expected, sizeof(expected), "origin%d.example.com", ids[i]);
+    }
+    if (table->forwardMappingLookup(&urls[i], 80, host, host_len, container)) {
+      host = container.getToURL()->host_get(&host_len);
+      box.check(host_len == expected_len && memcmp(host, expected, host_len) == 0, "www%d.example.com mapped to %.*s", ids[i],
+                host_len, host);
+    }
+    urls[i].destroy();
+  }
+  rprintf(t, "%d rules: load %" PRId64 " ms, %" PRId64 " MB, reload %" PRId64 " ms, lookup %" PRId64 " ns\n", 2 * hosts,
+          load_time / HRTIME_MSECOND, size >> 20, reload_time / HRTIME_MSECOND, lookup_time / (rounds * n_urls));
+
+  ats_free(ids);
+  delete[] urls;
+  delete table;
+  RecSetRecordString("proxy.config.url_remap.filename", saved_path, REC_SOURCE_EXPLICIT);
+  ats_free(saved_path);
+  unlink(config_path);
+}
+#endif // TS_HAS_TESTS
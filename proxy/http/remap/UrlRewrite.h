@@ -28,12 +28,15 @@
 #include "UrlMapping.h"
 #include "HttpTransact.h"
 #include "ts/Regex.h"
+#include "ts/CompactIndex.h"
+#include <vector>
 
 #define URL_REMAP_FILTER_NONE 0x00000000
 #define URL_REMAP_FILTER_REFERER 0x00000001      /* enable "referer" header validation */
 #define URL_REMAP_FILTER_REDIRECT_FMT 0x00010000 /* enable redirect URL formatting */
 
 struct BUILD_TABLE_INFO;
+class UrlMappingPathIndex;
 
 /**
  * used for redirection, mapping, and reverse mapping
@@ -54,7 +57,7 @@ enum mapping_type {
 class UrlRewrite
 {
 public:
-  UrlRewrite();
+  explicit UrlRewrite(UrlRewrite *previous = NULL, bool reuse_all = false);
   ~UrlRewrite();
 
   int BuildTable(const char *path);
@@ -94,14 +97,17 @@ public:
   };
 
   typedef Queue<RegexMapping> RegexMappingList;
+  typedef CompactStringMap<UrlMappingPathIndex> UrlMappingHostIndex;
 
   struct MappingsStore {
-    InkHashTable *hash_lookup;
+    InkHashTable *hash_lookup;      // The hosts while remap.config is loaded
+    UrlMappingHostIndex host_index; // The hosts once it is, see _freezeStore()
     RegexMappingList regex_list;
+    RegexPrefilter regex_prefilter; // The host patterns of regex_list, in the same order
     bool
     empty()
     {
-      return ((hash_lookup == NULL) && regex_list.empty());
+      return ((hash_lookup == NULL) && (host_index.Size() == 0) && regex_list.empty());
     }
   };
 
@@ -113,6 +119,7 @@ public:
   DestroyStore(MappingsStore &store)
   {
     _destroyTable(store.hash_lookup);
+    _destroyIndex(store.host_index);
     _destroyList(store.regex_list);
   }
 
@@ -122,6 +129,16 @@ public:
 
   bool TableInsert(InkHashTable *h_table, url_mapping *mapping, const char *src_host);
 
+  // Plugin instances are kept by the key remap_load_plugin() makes of their plugin and arguments, and taken over by
+  // the table which replaces this one for the rules which have the same key, if the plugin opted in or reuse_all is set.
+  remap_plugin_instance *ReusePluginInstance(const remap_plugin_info *plugin, const char *key);
+  void AddPluginInstance(remap_plugin_instance *instance);
+
+  // Each rule is recorded as a hash of its type and from URL, and a hash of the whole rule, so that a reload can count
+  // the rules it added, removed and changed.
+  void AddMappingSignature(uint64_t from, uint64_t rule);
+  void DiffMappings(const UrlRewrite *previous, int &added, int &removed, int &changed) const;
+
   MappingsStore forward_mappings;
   MappingsStore reverse_mappings;
   MappingsStore permanent_redirects;
@@ -174,18 +191,39 @@ public:
   int num_rules_redirect_permanent;
   int num_rules_redirect_temporary;
   int num_rules_forward_with_recv_port;
+  int num_plugin_instances_created;
+  int num_plugin_instances_reused;
 
 private:
+  struct MappingSignature {
+    uint64_t from;
+    uint64_t rule;
+
+    bool
+    operator<(const MappingSignature &that) const
+    {
+      return from < that.from || (from == that.from && rule < that.rule);
+    }
+  };
+
   bool _valid;
+  UrlRewrite *_previous;           // The table this one replaces, while it is being built
+  bool _reuse_all;                 // Reuse the instances of every plugin, not just of those which opted in
+  InkHashTable *_plugin_instances; // Each holds a reference
+  std::vector<MappingSignature> _mapping_signatures;
 
   bool _mappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host, int request_host_len,
                       UrlMappingContainer &mapping_container);
-  url_mapping *_tableLookup(InkHashTable *h_table, URL *request_url, int request_port, char *request_host, int request_host_len);
-  bool _regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
-                           int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container);
+  url_mapping *_tableLookup(const UrlMappingHostIndex &host_index, URL *request_url, int request_port, char *request_host,
+                            int request_host_len);
+  bool _regexMappingLookup(RegexMappingList &regex_mappings, const RegexPrefilter &prefilter, URL *request_url, int request_port,
+                           const char *request_host, int request_host_len, int rank_ceiling,
+                           UrlMappingContainer &mapping_container);
   int _expandSubstitutions(int *matches_info, const RegexMapping *reg_map, const char *matched_string, char *dest_buf,
                            int dest_buf_size);
   void _destroyTable(InkHashTable *h_table);
+  void _destroyIndex(UrlMappingHostIndex &host_index);
+  bool _freezeStore(MappingsStore &store);
   void _destroyList(RegexMappingList &regexes);
   inline bool _addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMapping *reg_map, const char *src_host,
                           bool is_cur_mapping_regex, int &count);
@@ -23,6 +23,7 @@
 
 #include "HPACK.h"
 #include "HuffmanCodec.h"
+#include "ts/HashFNV.h"
 
 // [RFC 7541] 4.1. Calculating Table Size
 // The size of an entry is the sum of its name's length in octets (as defined in Section 5.2),
@@ -97,69 +98,354 @@ typedef enum {
 
 const static struct {
   const char *name;
+  int name_len;
   const char *value;
-} STATIC_TABLE[] = {{"", ""},
-                    {":authority", ""},
-                    {":method", "GET"},
-                    {":method", "POST"},
-                    {":path", "/"},
-                    {":path", "/index.html"},
-                    {":scheme", "http"},
-                    {":scheme", "https"},
-                    {":status", "200"},
-                    {":status", "204"},
-                    {":status", "206"},
-                    {":status", "304"},
-                    {":status", "400"},
-                    {":status", "404"},
-                    {":status", "500"},
-                    {"accept-charset", ""},
-                    {"accept-encoding", "gzip, deflate"},
-                    {"accept-language", ""},
-                    {"accept-ranges", ""},
-                    {"accept", ""},
-                    {"access-control-allow-origin", ""},
-                    {"age", ""},
-                    {"allow", ""},
-                    {"authorization", ""},
-                    {"cache-control", ""},
-                    {"content-disposition", ""},
-                    {"content-encoding", ""},
-                    {"content-language", ""},
-                    {"content-length", ""},
-                    {"content-location", ""},
-                    {"content-range", ""},
-                    {"content-type", ""},
-                    {"cookie", ""},
-                    {"date", ""},
-                    {"etag", ""},
-                    {"expect", ""},
-                    {"expires", ""},
-                    {"from", ""},
-                    {"host", ""},
-                    {"if-match", ""},
-                    {"if-modified-since", ""},
-                    {"if-none-match", ""},
-                    {"if-range", ""},
-                    {"if-unmodified-since", ""},
-                    {"last-modified", ""},
-                    {"link", ""},
-                    {"location", ""},
-                    {"max-forwards", ""},
-                    {"proxy-authenticate", ""},
-                    {"proxy-authorization", ""},
-                    {"range", ""},
-                    {"referer", ""},
-                    {"refresh", ""},
-                    {"retry-after", ""},
-                    {"server", ""},
-                    {"set-cookie", ""},
-                    {"strict-transport-security", ""},
-                    {"transfer-encoding", ""},
-                    {"user-agent", ""},
-                    {"vary", ""},
-                    {"via", ""},
-                    {"www-authenticate", ""}};
+  int value_len;
+} STATIC_TABLE[] = {{"", 0, "", 0},
+                    {":authority", 10, "", 0},
+                    {":method", 7, "GET", 3},
+                    {":method", 7, "POST", 4},
+                    {":path", 5, "/", 1},
+                    {":path", 5, "/index.html", 11},
+                    {":scheme", 7, "http", 4},
+                    {":scheme", 7, "https", 5},
+                    {":status", 7, "200", 3},
+                    {":status", 7, "204", 3},
+                    {":status", 7, "206", 3},
+                    {":status", 7, "304", 3},
+                    {":status", 7, "400", 3},
+                    {":status", 7, "404", 3},
+                    {":status", 7, "500", 3},
+                    {"accept-charset", 14, "", 0},
+                    {"accept-encoding", 15, "gzip, deflate", 13},
+                    {"accept-language", 15, "", 0},
+                    {"accept-ranges", 13, "", 0},
+                    {"accept", 6, "", 0},
+                    {"access-control-allow-origin", 27, "", 0},
+                    {"age", 3, "", 0},
+                    {"allow", 5, "", 0},
+                    {"authorization", 13, "", 0},
+                    {"cache-control", 13, "", 0},
+                    {"content-disposition", 19, "", 0},
+                    {"content-encoding", 16, "", 0},
+                    {"content-language", 16, "", 0},
+                    {"content-length", 14, "", 0},
+                    {"content-location", 16, "", 0},
+                    {"content-range", 13, "", 0},
+                    {"content-type", 12, "", 0},
+                    {"cookie", 6, "", 0},
+                    {"date", 4, "", 0},
+                    {"etag", 4, "", 0},
+                    {"expect", 6, "", 0},
+                    {"expires", 7, "", 0},
+                    {"from", 4, "", 0},
+                    {"host", 4, "", 0},
+                    {"if-match", 8, "", 0},
+                    {"if-modified-since", 17, "", 0},
+                    {"if-none-match", 13, "", 0},
+                    {"if-range", 8, "", 0},
+                    {"if-unmodified-since", 19, "", 0},
+                    {"last-modified", 13, "", 0},
+                    {"link", 4, "", 0},
+                    {"location", 8, "", 0},
+                    {"max-forwards", 12, "", 0},
+                    {"proxy-authenticate", 18, "", 0},
+                    {"proxy-authorization", 19, "", 0},
+                    {"range", 5, "", 0},
+                    {"referer", 7, "", 0},
+                    {"refresh", 7, "", 0},
+                    {"retry-after", 11, "", 0},
+                    {"server", 6, "", 0},
+                    {"set-cookie", 10, "", 0},
+                    {"strict-transport-security", 25, "", 0},
+                    {"transfer-encoding", 17, "", 0},
+                    {"user-agent", 10, "", 0},
+                    {"vary", 4, "", 0},
+                    {"via", 3, "", 0},
+                    {"www-authenticate", 16, "", 0}};
+
+// Index of the first static table entry with the name @a name, or 0. Only pseudo headers have more than one entry, and
+// those are next to each other. Like the rest of the table this has to be kept in line with RFC 7541 Appendix A.
+static int
+hpack_static_table_name_index(const char *name, int name_len)
+{
+  switch (name_len) {
+  case 3:
+    switch (ParseRules::ink_tolower(name[2])) {
+    case 'e':
+      if (strncasecmp(name, "age", 2) == 0)
+        return TS_HPACK_STATIC_TABLE_AGE;
+      break;
+    case 'a':
+      if (strncasecmp(name, "via", 2) == 0)
+        return TS_HPACK_STATIC_TABLE_VIA;
+      break;
+    }
+    break;
+  case 4:
+    switch (ParseRules::ink_tolower(name[3])) {
+    case 'e':
+      if (strncasecmp(name, "date", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_DATE;
+      break;
+    case 'g':
+      if (strncasecmp(name, "etag", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_ETAG;
+      break;
+    case 'm':
+      if (strncasecmp(name, "from", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_FROM;
+      break;
+    case 't':
+      if (strncasecmp(name, "host", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_HOST;
+      break;
+    case 'k':
+      if (strncasecmp(name, "link", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_LINK;
+      break;
+    case 'y':
+      if (strncasecmp(name, "vary", 3) == 0)
+        return TS_HPACK_STATIC_TABLE_VARY;
+      break;
+    }
+    break;
+  case 5:
+    switch (ParseRules::ink_tolower(name[4])) {
+    case 'h':
+      if (strncasecmp(name, ":path", 4) == 0)
+        return TS_HPACK_STATIC_TABLE_PATH_ROOT;
+      break;
+    case 'w':
+      if (strncasecmp(name, "allow", 4) == 0)
+        return TS_HPACK_STATIC_TABLE_ALLOW;
+      break;
+    case 'e':
+      if (strncasecmp(name, "range", 4) == 0)
+        return TS_HPACK_STATIC_TABLE_RANGE;
+      break;
+    }
+    break;
+  case 6:
+    switch (ParseRules::ink_tolower(name[5])) {
+    case 't':
+      if (strncasecmp(name, "accept", 5) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCEPT;
+      if (strncasecmp(name, "expect", 5) == 0)
+        return TS_HPACK_STATIC_TABLE_EXPECT;
+      break;
+    case 'e':
+      if (strncasecmp(name, "cookie", 5) == 0)
+        return TS_HPACK_STATIC_TABLE_COOKIE;
+      break;
+    case 'r':
+      if (strncasecmp(name, "server", 5) == 0)
+        return TS_HPACK_STATIC_TABLE_SERVER;
+      break;
+    }
+    break;
+  case 7:
+    switch (ParseRules::ink_tolower(name[6])) {
+    case 'd':
+      if (strncasecmp(name, ":method", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_METHOD_GET;
+      break;
+    case 'e':
+      if (strncasecmp(name, ":scheme", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_SCHEME_HTTP;
+      break;
+    case 's':
+      if (strncasecmp(name, ":status", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_STATUS_200;
+      if (strncasecmp(name, "expires", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_EXPIRES;
+      break;
+    case 'r':
+      if (strncasecmp(name, "referer", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_REFERER;
+      break;
+    case 'h':
+      if (strncasecmp(name, "refresh", 6) == 0)
+        return TS_HPACK_STATIC_TABLE_REFRESH;
+      break;
+    }
+    break;
+  case 8:
+    switch (ParseRules::ink_tolower(name[7])) {
+    case 'h':
+      if (strncasecmp(name, "if-match", 7) == 0)
+        return TS_HPACK_STATIC_TABLE_IF_MATCH;
+      break;
+    case 'e':
+      if (strncasecmp(name, "if-range", 7) == 0)
+        return TS_HPACK_STATIC_TABLE_IF_RANGE;
+      break;
+    case 'n':
+      if (strncasecmp(name, "location", 7) == 0)
+        return TS_HPACK_STATIC_TABLE_LOCATION;
+      break;
+    }
+    break;
+  case 10:
+    switch (ParseRules::ink_tolower(name[9])) {
+    case 'y':
+      if (strncasecmp(name, ":authority", 9) == 0)
+        return TS_HPACK_STATIC_TABLE_AUTHORITY;
+      break;
+    case 'e':
+      if (strncasecmp(name, "set-cookie", 9) == 0)
+        return TS_HPACK_STATIC_TABLE_SET_COOKIE;
+      break;
+    case 't':
+      if (strncasecmp(name, "user-agent", 9) == 0)
+        return TS_HPACK_STATIC_TABLE_USER_AGENT;
+      break;
+    }
+    break;
+  case 11:
+    switch (ParseRules::ink_tolower(name[10])) {
+    case 'r':
+      if (strncasecmp(name, "retry-after", 10) == 0)
+        return TS_HPACK_STATIC_TABLE_RETRY_AFTER;
+      break;
+    }
+    break;
+  case 12:
+    switch (ParseRules::ink_tolower(name[11])) {
+    case 'e':
+      if (strncasecmp(name, "content-type", 11) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_TYPE;
+      break;
+    case 's':
+      if (strncasecmp(name, "max-forwards", 11) == 0)
+        return TS_HPACK_STATIC_TABLE_MAX_FORWARDS;
+      break;
+    }
+    break;
+  case 13:
+    switch (ParseRules::ink_tolower(name[12])) {
+    case 's':
+      if (strncasecmp(name, "accept-ranges", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCEPT_RANGES;
+      break;
+    case 'n':
+      if (strncasecmp(name, "authorization", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_AUTHORIZATION;
+      break;
+    case 'l':
+      if (strncasecmp(name, "cache-control", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_CACHE_CONTROL;
+      break;
+    case 'e':
+      if (strncasecmp(name, "content-range", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_RANGE;
+      break;
+    case 'h':
+      if (strncasecmp(name, "if-none-match", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_IF_NONE_MATCH;
+      break;
+    case 'd':
+      if (strncasecmp(name, "last-modified", 12) == 0)
+        return TS_HPACK_STATIC_TABLE_LAST_MODIFIED;
+      break;
+    }
+    break;
+  case 14:
+    switch (ParseRules::ink_tolower(name[13])) {
+    case 't':
+      if (strncasecmp(name, "accept-charset", 13) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCEPT_CHARSET;
+      break;
+    case 'h':
+      if (strncasecmp(name, "content-length", 13) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_LENGTH;
+      break;
+    }
+    break;
+  case 15:
+    switch (ParseRules::ink_tolower(name[14])) {
+    case 'g':
+      if (strncasecmp(name, "accept-encoding", 14) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCEPT_ENCODING;
+      break;
+    case 'e':
+      if (strncasecmp(name, "accept-language", 14) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCEPT_LANGUAGE;
+      break;
+    }
+    break;
+  case 16:
+    switch (ParseRules::ink_tolower(name[15])) {
+    case 'g':
+      if (strncasecmp(name, "content-encoding", 15) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_ENCODING;
+      break;
+    case 'e':
+      if (strncasecmp(name, "content-language", 15) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_LANGUAGE;
+      if (strncasecmp(name, "www-authenticate", 15) == 0)
+        return TS_HPACK_STATIC_TABLE_WWW_AUTHENTICATE;
+      break;
+    case 'n':
+      if (strncasecmp(name, "content-location", 15) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_LOCATION;
+      break;
+    }
+    break;
+  case 17:
+    switch (ParseRules::ink_tolower(name[16])) {
+    case 'e':
+      if (strncasecmp(name, "if-modified-since", 16) == 0)
+        return TS_HPACK_STATIC_TABLE_IF_MODIFIED_SINCE;
+      break;
+    case 'g':
+      if (strncasecmp(name, "transfer-encoding", 16) == 0)
+        return TS_HPACK_STATIC_TABLE_TRANSFER_ENCODING;
+      break;
+    }
+    break;
+  case 18:
+    switch (ParseRules::ink_tolower(name[17])) {
+    case 'e':
+      if (strncasecmp(name, "proxy-authenticate", 17) == 0)
+        return TS_HPACK_STATIC_TABLE_PROXY_AUTHENTICATE;
+      break;
+    }
+    break;
+  case 19:
+    switch (ParseRules::ink_tolower(name[18])) {
+    case 'n':
+      if (strncasecmp(name, "content-disposition", 18) == 0)
+        return TS_HPACK_STATIC_TABLE_CONTENT_DISPOSITION;
+      if (strncasecmp(name, "proxy-authorization", 18) == 0)
+        return TS_HPACK_STATIC_TABLE_PROXY_AUTHORIZATION;
+      break;
+    case 'e':
+      if (strncasecmp(name, "if-unmodified-since", 18) == 0)
+        return TS_HPACK_STATIC_TABLE_IF_UNMODIFIED_SINCE;
+      break;
+    }
+    break;
+  case 25:
+    switch (ParseRules::ink_tolower(name[24])) {
+    case 'y':
+      if (strncasecmp(name, "strict-transport-security", 24) == 0)
+        return TS_HPACK_STATIC_TABLE_STRICT_TRANSPORT_SECURITY;
+      break;
+    }
+    break;
+  case 27:
+    switch (ParseRules::ink_tolower(name[26])) {
+    case 'n':
+      if (strncasecmp(name, "access-control-allow-origin", 26) == 0)
+        return TS_HPACK_STATIC_TABLE_ACCESS_CONTROL_ALLOW_ORIGIN;
+      break;
+    }
+    break;
+  }
+
+  return 0;
+}
 
 /******************
  * Local functions
@@ -214,46 +500,34 @@ HpackLookupResult
 HpackIndexingTable::lookup(const char *name, int name_len, const char *value, int value_len) const
 {
   HpackLookupResult result;
-  const int entry_num = TS_HPACK_STATIC_TABLE_ENTRY_NUM + _dynamic_table->length();
-
-  for (int index = 1; index < entry_num; ++index) {
-    const char *table_name, *table_value;
-    int table_name_len = 0, table_value_len = 0;
-
-    if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
-      // static table
-      table_name = STATIC_TABLE[index].name;
-      table_value = STATIC_TABLE[index].value;
-      table_name_len = strlen(table_name);
-      table_value_len = strlen(table_value);
-    } else {
-      // dynamic table
-      const MIMEField *m_field = _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM);
-
-      table_name = m_field->name_get(&table_name_len);
-      table_value = m_field->value_get(&table_value_len);
-    }
-
-    // Check whether name (and value) are matched
-    if (ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0) {
-      if (ptr_len_cmp(value, value_len, table_value, table_value_len) == 0) {
-        result.index = index;
-        result.match_type = HPACK_EXACT_MATCH;
-        break;
-      } else if (!result.index) {
-        result.index = index;
-        result.match_type = HPACK_NAME_MATCH;
-      }
-    }
-  }
-  if (result.match_type != HPACK_NO_MATCH) {
-    if (result.index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
+  HpackMatchType dynamic_match;
+  int index;
+
+  // An exact match in the static table, then in the dynamic one, then a name match, as a scan of the whole index
+  // address space would find them.
+  int static_index = hpack_static_table_name_index(name, name_len);
+  for (index = static_index; index && index < TS_HPACK_STATIC_TABLE_ENTRY_NUM && STATIC_TABLE[index].name_len == name_len &&
+                             memcmp(STATIC_TABLE[index].name, STATIC_TABLE[static_index].name, name_len) == 0;
+       ++index) {
+    if (ptr_len_cmp(value, value_len, STATIC_TABLE[index].value, STATIC_TABLE[index].value_len) == 0) {
+      result.index = index;
       result.index_type = HPACK_INDEX_TYPE_STATIC;
-    } else {
-      result.index_type = HPACK_INDEX_TYPE_DYNAMIC;
+      result.match_type = HPACK_EXACT_MATCH;
+      return result;
     }
   }
 
+  index = _dynamic_table->lookup(name, name_len, value, value_len, dynamic_match);
+  if (dynamic_match == HPACK_EXACT_MATCH || (dynamic_match == HPACK_NAME_MATCH && !static_index)) {
+    result.index = TS_HPACK_STATIC_TABLE_ENTRY_NUM + index;
+    result.index_type = HPACK_INDEX_TYPE_DYNAMIC;
+    result.match_type = dynamic_match;
+  } else if (static_index) {
+    result.index = static_index;
+    result.index_type = HPACK_INDEX_TYPE_STATIC;
+    result.match_type = HPACK_NAME_MATCH;
+  }
+
   return result;
 }
 
@@ -266,8 +540,8 @@ HpackIndexingTable::get_header_field(uint32_t index, MIMEFieldWrapper &field) co
 
   if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
     // static table
-    field.name_set(STATIC_TABLE[index].name, strlen(STATIC_TABLE[index].name));
-    field.value_set(STATIC_TABLE[index].value, strlen(STATIC_TABLE[index].value));
+    field.name_set(STATIC_TABLE[index].name, STATIC_TABLE[index].name_len);
+    field.value_set(STATIC_TABLE[index].value, STATIC_TABLE[index].value_len);
   } else if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM + _dynamic_table->length()) {
     // dynamic table
     const MIMEField *m_field = _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM);
@@ -306,10 +580,111 @@ HpackIndexingTable::update_maximum_size(uint32_t new_size)
   return _dynamic_table->update_maximum_size(new_size);
 }
 
+/************************
+ * HpackDynamicTable
+ ************************/
+// Slots the entry and bucket arrays start with, they double whenever the table fills up.
+const static uint32_t DYNAMIC_TABLE_INITIAL_SLOTS = 16;
+
+static inline uint32_t
+hpack_entry_size(const MIMEField *field)
+{
+  int name_len, value_len;
+  field->name_get(&name_len);
+  field->value_get(&value_len);
+  return ADDITIONAL_OCTETS + name_len + value_len;
+}
+
+// Bucket arrays start out pointing at @a empty, a number below the oldest entry.
+static uint32_t *
+hpack_buckets_alloc(uint32_t n, uint32_t empty)
+{
+  uint32_t *buckets = static_cast<uint32_t *>(ats_malloc(n * sizeof(uint32_t)));
+  for (uint32_t i = 0; i < n; ++i)
+    buckets[i] = empty;
+  return buckets;
+}
+
+static inline void
+hpack_hash_field(const char *name, int name_len, const char *value, int value_len, uint32_t &name_hash, uint32_t &field_hash)
+{
+  ATSHash32FNV1a hash;
+  hash.update(name, name_len, ATSHash::nocase());
+  name_hash = hash.get();
+  hash.update(value, value_len);
+  hash.final();
+  field_hash = hash.get();
+}
+
+HpackDynamicTable::HpackDynamicTable(uint32_t size)
+  : _current_size(0), _maximum_size(size), _mhdr_fields(0), _inserted(0), _evicted(0), _mask(DYNAMIC_TABLE_INITIAL_SLOTS - 1)
+{
+  _mhdr = new MIMEHdr();
+  _mhdr->create();
+  _entries = static_cast<Entry *>(ats_malloc((_mask + 1) * sizeof(Entry)));
+  _name_buckets = hpack_buckets_alloc(2 * (_mask + 1), _evicted - 1);
+  _field_buckets = hpack_buckets_alloc(2 * (_mask + 1), _evicted - 1);
+}
+
+HpackDynamicTable::~HpackDynamicTable()
+{
+  _mhdr->destroy();
+  delete _mhdr;
+  ats_free(_entries);
+  ats_free(_name_buckets);
+  ats_free(_field_buckets);
+}
+
+// Whether entry @a n is still in the table. Unsigned arithmetic keeps this right when the numbers wrap.
+inline bool
+HpackDynamicTable::_is_live(uint32_t n) const
+{
+  return n - _evicted < _inserted - _evicted;
+}
+
 const MIMEField *
 HpackDynamicTable::get_header_field(uint32_t index) const
 {
-  return _headers.get(index);
+  return _entries[(_inserted - 1 - index) & _mask].field;
+}
+
+// Returns the index of the newest entry matching both @a name and @a value or, failing that, @a name only.
+int
+HpackDynamicTable::lookup(const char *name, int name_len, const char *value, int value_len, HpackMatchType &match_type) const
+{
+  uint32_t name_hash, field_hash;
+  uint32_t bucket_mask = 2 * _mask + 1;
+
+  hpack_hash_field(name, name_len, value, value_len, name_hash, field_hash);
+
+  // Chains run from newer to older entries. Links to evicted entries are left behind, so a chain ends at the first
+  // entry which is not live, or not older, should the numbers have wrapped since the link was made.
+  for (uint32_t n = _field_buckets[field_hash & bucket_mask], prev = _inserted; _is_live(n) && n - _evicted < prev - _evicted;
+       prev = n, n = _entries[n & _mask].field_next) {
+    const Entry &e = _entries[n & _mask];
+    int table_name_len, table_value_len;
+    const char *table_name = e.field->name_get(&table_name_len);
+    const char *table_value = e.field->value_get(&table_value_len);
+    if (e.field_hash == field_hash && ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0 &&
+        ptr_len_cmp(value, value_len, table_value, table_value_len) == 0) {
+      match_type = HPACK_EXACT_MATCH;
+      return _inserted - 1 - n;
+    }
+  }
+
+  for (uint32_t n = _name_buckets[name_hash & bucket_mask], prev = _inserted; _is_live(n) && n - _evicted < prev - _evicted;
+       prev = n, n = _entries[n & _mask].name_next) {
+    const Entry &e = _entries[n & _mask];
+    int table_name_len;
+    const char *table_name = e.field->name_get(&table_name_len);
+    if (e.name_hash == name_hash && ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0) {
+      match_type = HPACK_NAME_MATCH;
+      return _inserted - 1 - n;
+    }
+  }
+
+  match_type = HPACK_NO_MATCH;
+  return -1;
 }
 
 void
@@ -325,29 +700,93 @@ HpackDynamicTable::add_header_field(const MIMEField *field)
     // It is not an error to attempt to add an entry that is larger than
     // the maximum size; an attempt to add an entry larger than the entire
     // table causes the table to be emptied of all existing entries.
-    _headers.clear();
-    _mhdr->fields_clear();
-    _current_size = 0;
+    while (_inserted != _evicted)
+      _evict();
   } else {
+    while (_current_size + header_size > _maximum_size)
+      _evict();
+    if (_inserted - _evicted > _mask)
+      _expand();
+    if (_mhdr_fields > 2 * _mask)
+      _compact();
+
+    // Fields are left detached, the hash chains are the only way they are found.
+    MIMEField *new_field = _mhdr->field_create(name, name_len);
+    new_field->value_set(_mhdr->m_heap, _mhdr->m_mime, value, value_len);
+    ++_mhdr_fields;
+
+    Entry &e = _entries[_inserted & _mask];
+    e.field = new_field;
+    hpack_hash_field(name, name_len, value, value_len, e.name_hash, e.field_hash);
+    _chain(_inserted++);
     _current_size += header_size;
-    while (_current_size > _maximum_size) {
-      int last_name_len, last_value_len;
-      MIMEField *last_field = _headers.last();
+  }
+}
 
-      last_field->name_get(&last_name_len);
-      last_field->value_get(&last_value_len);
-      _current_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
+// Put entry @a n at the head of its bucket chains.
+void
+HpackDynamicTable::_chain(uint32_t n)
+{
+  Entry &e = _entries[n & _mask];
+  uint32_t bucket_mask = 2 * _mask + 1;
 
-      _headers.remove_index(_headers.length() - 1);
-      _mhdr->field_delete(last_field, false);
-    }
+  e.name_next = _name_buckets[e.name_hash & bucket_mask];
+  _name_buckets[e.name_hash & bucket_mask] = n;
+  e.field_next = _field_buckets[e.field_hash & bucket_mask];
+  _field_buckets[e.field_hash & bucket_mask] = n;
+}
 
-    MIMEField *new_field = _mhdr->field_create(name, name_len);
-    new_field->value_set(_mhdr->m_heap, _mhdr->m_mime, value, value_len);
-    _mhdr->field_attach(new_field);
-    // XXX Because entire Vec instance is copied, Its too expensive!
-    _headers.insert(0, new_field);
+void
+HpackDynamicTable::_evict()
+{
+  MIMEField *field = _entries[_evicted & _mask].field;
+
+  _current_size -= hpack_entry_size(field);
+  ++_evicted;
+}
+
+// Evicted fields and their strings stay in _mhdr until it is rebuilt here from the live entries, once it holds about
+// twice as many fields as the table can, so the cost is spread over the entries added in between.
+void
+HpackDynamicTable::_compact()
+{
+  MIMEHdr *mhdr = new MIMEHdr();
+  mhdr->create();
+
+  for (uint32_t n = _evicted; n != _inserted; ++n) {
+    Entry &e = _entries[n & _mask];
+    int name_len, value_len;
+    const char *name = e.field->name_get(&name_len);
+    const char *value = e.field->value_get(&value_len);
+    e.field = mhdr->field_create(name, name_len);
+    e.field->value_set(mhdr->m_heap, mhdr->m_mime, value, value_len);
+  }
+
+  _mhdr->destroy();
+  delete _mhdr;
+  _mhdr = mhdr;
+  _mhdr_fields = _inserted - _evicted;
+}
+
+void
+HpackDynamicTable::_expand()
+{
+  uint32_t old_mask = _mask;
+  Entry *old_entries = _entries;
+
+  _mask = 2 * old_mask + 1;
+  _entries = static_cast<Entry *>(ats_malloc((_mask + 1) * sizeof(Entry)));
+  ats_free(_name_buckets);
+  ats_free(_field_buckets);
+  _name_buckets = hpack_buckets_alloc(2 * (_mask + 1), _evicted - 1);
+  _field_buckets = hpack_buckets_alloc(2 * (_mask + 1), _evicted - 1);
+
+  // Rechain from the oldest entry so the newest ends up at the head of each bucket.
+  for (uint32_t n = _evicted; n != _inserted; ++n) {
+    _entries[n & _mask] = old_entries[n & old_mask];
+    _chain(n);
   }
+  ats_free(old_entries);
 }
 
 uint32_t
@@ -367,18 +806,10 @@ bool
 HpackDynamicTable::update_maximum_size(uint32_t new_size)
 {
   while (_current_size > new_size) {
-    if (_headers.n <= 0) {
+    if (_inserted == _evicted) {
       return false;
     }
-    int last_name_len, last_value_len;
-    MIMEField *last_field = _headers.last();
-
-    last_field->name_get(&last_name_len);
-    last_field->value_get(&last_value_len);
-    _current_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
-
-    _headers.remove_index(_headers.length() - 1);
-    _mhdr->field_delete(last_field, false);
+    _evict();
   }
 
   _maximum_size = new_size;
@@ -388,7 +819,7 @@ HpackDynamicTable::update_maximum_size(uint32_t new_size)
 uint32_t
 HpackDynamicTable::length() const
 {
-  return _headers.length();
+  return _inserted - _evicted;
 }
 
 //
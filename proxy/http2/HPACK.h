@@ -101,25 +101,19 @@ private:
 };
 
 // [RFC 7541] 2.3.2. Dynamic Table
+//
+// Entries are numbered in the order they were added: the newest one is _inserted - 1 and the oldest one still in the table
+// is _evicted, so eviction is just a matter of moving _evicted forward. Entry n is kept in _entries[n & _mask] and chained
+// from the name and the name + value hash buckets, newest first, so a lookup stops at the first number below _evicted.
 class HpackDynamicTable
 {
 public:
-  HpackDynamicTable(uint32_t size) : _current_size(0), _maximum_size(size)
-  {
-    _mhdr = new MIMEHdr();
-    _mhdr->create();
-  }
-
-  ~HpackDynamicTable()
-  {
-    _headers.clear();
-    _mhdr->fields_clear();
-    _mhdr->destroy();
-    delete _mhdr;
-  }
+  HpackDynamicTable(uint32_t size);
+  ~HpackDynamicTable();
 
   const MIMEField *get_header_field(uint32_t index) const;
   void add_header_field(const MIMEField *field);
+  int lookup(const char *name, int name_len, const char *value, int value_len, HpackMatchType &match_type) const;
 
   uint32_t size() const;
   bool update_maximum_size(uint32_t new_size);
@@ -127,11 +121,31 @@ public:
   uint32_t length() const;
 
 private:
+  struct Entry {
+    MIMEField *field;
+    uint32_t name_hash;
+    uint32_t field_hash;
+    uint32_t name_next;  // next older entry with the same name bucket
+    uint32_t field_next; // next older entry with the same name + value bucket
+  };
+
+  bool _is_live(uint32_t n) const;
+  void _evict();
+  void _expand();
+  void _compact();
+  void _chain(uint32_t n);
+
   uint32_t _current_size;
   uint32_t _maximum_size;
 
   MIMEHdr *_mhdr;
-  Vec<MIMEField *> _headers;
+  uint32_t _mhdr_fields; // fields created in _mhdr, evicted ones included
+  uint32_t _inserted;
+  uint32_t _evicted;
+  uint32_t _mask; // _entries has _mask + 1 slots and each bucket array 2 * (_mask + 1)
+  Entry *_entries;
+  uint32_t *_name_buckets;
+  uint32_t *_field_buckets;
 };
 
 // [RFC 7541] 2.3. Indexing Table
@@ -325,6 +325,21 @@ http2_write_window_update(const uint32_t new_size, const IOVec &iov)
   return true;
 }
 
+bool
+http2_write_push_promise(const Http2PushPromise &push_promise, const uint8_t *src, size_t length, const IOVec &iov)
+{
+  byte_pointer ptr(iov.iov_base);
+
+  if (unlikely(iov.iov_len < sizeof(push_promise.promised_streamid) + length)) {
+    return false;
+  }
+
+  write_and_advance(ptr, push_promise.promised_streamid);
+  write_and_advance(ptr, src, length);
+
+  return true;
+}
+
 bool
 http2_parse_headers_parameter(IOVec iov, Http2HeadersParameter &params)
 {
@@ -343,7 +358,9 @@ http2_parse_priority_parameter(IOVec iov, Http2Priority &params)
   memcpy_and_advance(dependency.bytes, ptr);
   memcpy_and_advance(params.weight, ptr);
 
-  params.stream_dependency = ntohl(dependency.value);
+  dependency.value = ntohl(dependency.value);
+  params.exclusive_flag = dependency.value & HTTP2_PRIORITY_EXCLUSIVE_MASK;
+  params.stream_dependency = dependency.value & ~HTTP2_PRIORITY_EXCLUSIVE_MASK;
 
   return true;
 }
@@ -468,10 +485,6 @@ http2_convert_header_from_2_to_1_1(HTTPHdr *headers)
       headers->field_combine_dups(field, true, ';');
     }
 
-    // Convert HTTP version to 1.1
-    int32_t version = HTTP_VERSION(1, 1);
-    http_hdr_version_set(headers->m_http, version);
-
     // Remove HTTP/2 style headers
     headers->field_delete(HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME);
     headers->field_delete(HTTP2_VALUE_METHOD, HTTP2_LEN_METHOD);
@@ -492,6 +505,10 @@ http2_convert_header_from_2_to_1_1(HTTPHdr *headers)
     headers->field_delete(HTTP2_VALUE_STATUS, HTTP2_LEN_STATUS);
   }
 
+  // Convert HTTP version to 1.1
+  int32_t version = HTTP_VERSION(1, 1);
+  http_hdr_version_set(headers->m_http, version);
+
   // Check validity of all names and values
   MIMEFieldIter iter;
   for (const MIMEField *field = headers->iter_get_first(&iter); field != NULL; field = headers->iter_get_next(&iter)) {
@@ -503,43 +520,106 @@ http2_convert_header_from_2_to_1_1(HTTPHdr *headers)
   return PARSE_DONE;
 }
 
+static void
+http2_add_header_field(HTTPHdr *headers, const char *name, int name_len, const char *value, int value_len)
+{
+  MIMEField *field = headers->field_create(name, name_len);
+  field->value_set(headers->m_heap, headers->m_mime, value, value_len);
+  headers->field_attach(field);
+}
+
 void
 http2_generate_h2_header_from_1_1(HTTPHdr *headers, HTTPHdr *h2_headers)
 {
   h2_headers->create(http_hdr_type_get(headers->m_http));
 
+  // Pseudo-header fields must appear before regular header fields ([RFC 7540] 8.1.2.1.)
   if (http_hdr_type_get(headers->m_http) == HTTP_TYPE_RESPONSE) {
     char status_str[HTTP2_LEN_STATUS_VALUE_STR + 1];
     snprintf(status_str, sizeof(status_str), "%d", headers->status_get());
 
     // Add ':status' header field
-    MIMEField *status_field = h2_headers->field_create(HTTP2_VALUE_STATUS, HTTP2_LEN_STATUS);
-    status_field->value_set(h2_headers->m_heap, h2_headers->m_mime, status_str, HTTP2_LEN_STATUS_VALUE_STR);
-    h2_headers->field_attach(status_field);
-
-    MIMEFieldIter field_iter;
-    for (MIMEField *field = headers->iter_get_first(&field_iter); field != NULL; field = headers->iter_get_next(&field_iter)) {
-      // Intermediaries SHOULD remove connection-specific header fields.
-      const char *name;
-      int name_len;
-      const char *value;
-      int value_len;
-      name = field->name_get(&name_len);
-      if ((name_len == MIME_LEN_CONNECTION && strncasecmp(name, MIME_FIELD_CONNECTION, name_len) == 0) ||
-          (name_len == MIME_LEN_KEEP_ALIVE && strncasecmp(name, MIME_FIELD_KEEP_ALIVE, name_len) == 0) ||
-          (name_len == MIME_LEN_PROXY_CONNECTION && strncasecmp(name, MIME_FIELD_PROXY_CONNECTION, name_len) == 0) ||
-          (name_len == MIME_LEN_TRANSFER_ENCODING && strncasecmp(name, MIME_FIELD_TRANSFER_ENCODING, name_len) == 0) ||
-          (name_len == MIME_LEN_UPGRADE && strncasecmp(name, MIME_FIELD_UPGRADE, name_len) == 0)) {
-        continue;
-      }
+    http2_add_header_field(h2_headers, HTTP2_VALUE_STATUS, HTTP2_LEN_STATUS, status_str, HTTP2_LEN_STATUS_VALUE_STR);
+  } else {
+    // Requests for PUSH_PROMISE carry an absolute URL, requests to an origin server are in origin form with a Host
+    // field and only go over TLS.
+    URL *url = headers->url_get();
+    MIMEField *field;
+    const char *value;
+    int value_len;
+    Arena arena;
+
+    value = headers->method_get(&value_len);
+    http2_add_header_field(h2_headers, HTTP2_VALUE_METHOD, HTTP2_LEN_METHOD, value, value_len);
 
-      MIMEField *newfield;
-      name = field->name_get(&name_len);
-      newfield = h2_headers->field_create(name, name_len);
+    value = url->scheme_get(&value_len);
+    if (value_len == 0) {
+      value = URL_SCHEME_HTTPS;
+      value_len = URL_LEN_HTTPS;
+    }
+    http2_add_header_field(h2_headers, HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME, value, value_len);
+
+    // ':authority' is the host, with the port if the URL has one
+    int host_len;
+    const char *host = url->host_get(&host_len);
+    if (host_len > 0) {
+      bool ipv6 = memchr(host, ':', host_len) != NULL;
+      size_t authority_size = host_len + sizeof("[]:65535");
+      char *authority = arena.str_alloc(authority_size);
+      int authority_len = snprintf(authority, authority_size, ipv6 ? "[%.*s]" : "%.*s", host_len, host);
+      if (url->port_get_raw()) {
+        authority_len += snprintf(authority + authority_len, authority_size - authority_len, ":%d", url->port_get_raw());
+      }
+      http2_add_header_field(h2_headers, HTTP2_VALUE_AUTHORITY, HTTP2_LEN_AUTHORITY, authority, authority_len);
+    } else if ((field = headers->field_find(MIME_FIELD_HOST, MIME_LEN_HOST)) != NULL) {
       value = field->value_get(&value_len);
-      newfield->value_set(h2_headers->m_heap, h2_headers->m_mime, value, value_len);
-      h2_headers->field_attach(newfield);
+      http2_add_header_field(h2_headers, HTTP2_VALUE_AUTHORITY, HTTP2_LEN_AUTHORITY, value, value_len);
+    }
+
+    // ':path' is the path and query, always with the leading slash
+    int path_len, query_len;
+    const char *path = url->path_get(&path_len);
+    const char *query = url->query_get(&query_len);
+    char *path_query = arena.str_alloc(1 + path_len + 1 + query_len);
+    int path_query_len = 0;
+    path_query[path_query_len++] = '/';
+    memcpy(path_query + path_query_len, path, path_len);
+    path_query_len += path_len;
+    if (query_len > 0) {
+      path_query[path_query_len++] = '?';
+      memcpy(path_query + path_query_len, query, query_len);
+      path_query_len += query_len;
+    }
+    http2_add_header_field(h2_headers, HTTP2_VALUE_PATH, HTTP2_LEN_PATH, path_query, path_query_len);
+  }
+
+  MIMEFieldIter field_iter;
+  for (MIMEField *field = headers->iter_get_first(&field_iter); field != NULL; field = headers->iter_get_next(&field_iter)) {
+    // Intermediaries SHOULD remove connection-specific header fields.
+    const char *name;
+    int name_len;
+    const char *value;
+    int value_len;
+    name = field->name_get(&name_len);
+    if ((name_len == MIME_LEN_CONNECTION && strncasecmp(name, MIME_FIELD_CONNECTION, name_len) == 0) ||
+        (name_len == MIME_LEN_KEEP_ALIVE && strncasecmp(name, MIME_FIELD_KEEP_ALIVE, name_len) == 0) ||
+        (name_len == MIME_LEN_PROXY_CONNECTION && strncasecmp(name, MIME_FIELD_PROXY_CONNECTION, name_len) == 0) ||
+        (name_len == MIME_LEN_TRANSFER_ENCODING && strncasecmp(name, MIME_FIELD_TRANSFER_ENCODING, name_len) == 0) ||
+        (name_len == MIME_LEN_UPGRADE && strncasecmp(name, MIME_FIELD_UPGRADE, name_len) == 0)) {
+      continue;
+    }
+    // Host is carried by ':authority'
+    if (name_len == MIME_LEN_HOST && strncasecmp(name, MIME_FIELD_HOST, name_len) == 0) {
+      continue;
     }
+
+    value = field->value_get(&value_len);
+    // [RFC 7540] 8.1.2.2. TE may only say "trailers"
+    if (name_len == MIME_LEN_TE && strncasecmp(name, MIME_FIELD_TE, name_len) == 0 &&
+        !(value_len == 8 && strncasecmp(value, "trailers", 8) == 0)) {
+      continue;
+    }
+    http2_add_header_field(h2_headers, name, name_len, value, value_len);
   }
 }
 
@@ -581,7 +661,8 @@ http2_decode_header_blocks(HTTPHdr *hdr, const uint8_t *buf_start, const uint32_
   }
 
   MIMEFieldIter iter;
-  unsigned int expected_pseudo_header_count = 4;
+  bool is_response = http_hdr_type_get(hdr->m_http) == HTTP_TYPE_RESPONSE;
+  unsigned int expected_pseudo_header_count = is_response ? 1 : 4;
   unsigned int pseudo_header_count = 0;
 
   if (is_trailing_header) {
@@ -641,7 +722,12 @@ http2_decode_header_blocks(HTTPHdr *hdr, const uint8_t *buf_start, const uint32_
     }
   }
 
-  if (!is_trailing_header) {
+  if (!is_trailing_header && is_response) {
+    // [RFC 7540] 8.1.2.4. A response has just the ':status' pseudo header
+    if (hdr->field_find(HTTP2_VALUE_STATUS, HTTP2_LEN_STATUS) == NULL) {
+      return HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+  } else if (!is_trailing_header) {
     // Check psuedo headers
     if (hdr->fields_count() >= 4) {
       if (hdr->field_find(HTTP2_VALUE_SCHEME, HTTP2_LEN_SCHEME) == NULL ||
@@ -661,6 +747,66 @@ http2_decode_header_blocks(HTTPHdr *hdr, const uint8_t *buf_start, const uint32_
   return HTTP2_ERROR_NO_ERROR;
 }
 
+// Parse one value of a Link header field. Returns true if it is a preload to push, [W3C Preload] 3.3
+// Link: <uri>; rel=preload, with the URI reference in @a uri and @a uri_len. A "nopush" parameter means the client
+// probably has it already.
+bool
+http2_parse_link_preload(const char *value, int len, const char **uri, int *uri_len)
+{
+  const char *end = value + len;
+  const char *uri_end;
+  if (len < 3 || value[0] != '<' || (uri_end = static_cast<const char *>(memchr(value, '>', len))) == NULL ||
+      uri_end == value + 1) {
+    return false;
+  }
+
+  bool preload = false, nopush = false;
+  const char *param = uri_end + 1;
+  while (param < end) {
+    // Each parameter follows a ';', as name or name=value
+    while (param < end && (*param == ';' || ParseRules::is_ws(*param))) {
+      ++param;
+    }
+    const char *param_end = static_cast<const char *>(memchr(param, ';', end - param));
+    if (param_end == NULL) {
+      param_end = end;
+    }
+    const char *eq = static_cast<const char *>(memchr(param, '=', param_end - param));
+    const char *name_end = eq ? eq : param_end;
+    while (name_end > param && ParseRules::is_ws(name_end[-1])) {
+      --name_end;
+    }
+
+    if (name_end - param == 6 && strncasecmp(param, "nopush", 6) == 0) {
+      nopush = true;
+    } else if (eq && name_end - param == 3 && strncasecmp(param, "rel", 3) == 0) {
+      // The relation types are a space separated list, possibly quoted
+      const char *rel = eq + 1;
+      while (rel < param_end) {
+        while (rel < param_end && (*rel == '"' || ParseRules::is_ws(*rel))) {
+          ++rel;
+        }
+        const char *rel_end = rel;
+        while (rel_end < param_end && *rel_end != '"' && !ParseRules::is_ws(*rel_end)) {
+          ++rel_end;
+        }
+        if (rel_end - rel == 7 && strncasecmp(rel, "preload", 7) == 0) {
+          preload = true;
+        }
+        rel = rel_end;
+      }
+    }
+    param = param_end;
+  }
+
+  if (!preload || nopush) {
+    return false;
+  }
+  *uri = value + 1;
+  *uri_len = uri_end - value - 1;
+  return true;
+}
+
 // Initialize this subsystem with librecords configs (for now)
 uint32_t Http2::max_concurrent_streams_in = 100;
 uint32_t Http2::min_concurrent_streams_in = 10;
@@ -674,6 +820,12 @@ uint32_t Http2::max_request_header_size = 131072;
 uint32_t Http2::accept_no_activity_timeout = 120;
 uint32_t Http2::no_activity_timeout_in = 115;
 uint32_t Http2::active_timeout_in = 0;
+uint32_t Http2::write_buffer_watermark = 65536;
+uint32_t Http2::max_push_streams = 10;
+uint32_t Http2::push_link_preload = 0;
+uint32_t Http2::origin_enabled = 0;
+uint32_t Http2::max_concurrent_streams_out = 100;
+uint32_t Http2::no_activity_timeout_out = 120;
 
 void
 Http2::init()
@@ -689,6 +841,12 @@ Http2::init()
   REC_EstablishStaticConfigInt32U(accept_no_activity_timeout, "proxy.config.http2.accept_no_activity_timeout");
   REC_EstablishStaticConfigInt32U(no_activity_timeout_in, "proxy.config.http2.no_activity_timeout_in");
   REC_EstablishStaticConfigInt32U(active_timeout_in, "proxy.config.http2.active_timeout_in");
+  REC_EstablishStaticConfigInt32U(write_buffer_watermark, "proxy.config.http2.write_buffer_watermark");
+  REC_EstablishStaticConfigInt32U(max_push_streams, "proxy.config.http2.max_push_streams");
+  REC_EstablishStaticConfigInt32U(push_link_preload, "proxy.config.http2.push_link_preload");
+  REC_EstablishStaticConfigInt32U(origin_enabled, "proxy.config.http2.origin_enabled");
+  REC_EstablishStaticConfigInt32U(max_concurrent_streams_out, "proxy.config.http2.max_concurrent_streams_out");
+  REC_EstablishStaticConfigInt32U(no_activity_timeout_out, "proxy.config.http2.no_activity_timeout_out");
 
   // If any settings is broken, ATS should not start
   ink_release_assert(http2_settings_parameter_is_valid({HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, max_concurrent_streams_in}));
@@ -738,6 +896,7 @@ forceLinkRegressionHPACKCaller()
 }
 
 #include "ts/TestBox.h"
+#include "HdrUtils.h"
 
 /***********************************************************************************
  *                                                                                 *
@@ -862,4 +1021,88 @@ REGRESSION_TEST(HTTP2_FRAME_FLAGS)(RegressionTest *t, int, int *pstatus)
   }
 }
 
+
+const static struct {
+  const char *value;
+  const char *uri; // NULL if the value is not pushed
+} http2_link_preload_test_case[] = {{"</style.css>; rel=preload", "/style.css"},
+                                    {"</style.css>;rel=preload;as=style", "/style.css"},
+                                    {"<https://example.com/a.js> ; REL = PRELOAD", "https://example.com/a.js"},
+                                    {"</a.js>; rel=\"preload\"", "/a.js"},
+                                    {"</a.js>; rel=\"prefetch preload\"; as=script", "/a.js"},
+                                    {"</a.js>; title=\"x;y\"; rel=preload", "/a.js"},
+                                    {"</a.js>; rel=preload; nopush", NULL},
+                                    {"</a.js>; NoPush; rel=preload", NULL},
+                                    {"</a.js>; rel=prefetch", NULL},
+                                    {"</a.js>; rel=preloaded", NULL},
+                                    {"</a.js>; rel", NULL},
+                                    {"</a.js>; preload", NULL},
+                                    {"</a.js>", NULL},
+                                    {"<>; rel=preload", NULL},
+                                    {"/a.js; rel=preload", NULL},
+                                    {"</a.js; rel=preload", NULL},
+                                    {"<", NULL},
+                                    {"", NULL}};
+
+REGRESSION_TEST(HTTP2_LINK_PRELOAD)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  for (unsigned int i = 0; i < sizeof(http2_link_preload_test_case) / sizeof(http2_link_preload_test_case[0]); ++i) {
+    const char *value = http2_link_preload_test_case[i].value;
+    const char *expected = http2_link_preload_test_case[i].uri;
+    const char *uri = NULL;
+    int uri_len = 0;
+    bool pushed = http2_parse_link_preload(value, strlen(value), &uri, &uri_len);
+
+    if (expected == NULL) {
+      box.check(!pushed, "Link \"%s\" is expected not to be pushed, but is", value);
+    } else {
+      box.check(pushed && uri_len == static_cast<int>(strlen(expected)) && memcmp(uri, expected, uri_len) == 0,
+                "Link \"%s\" is expected to push \"%s\", but got \"%.*s\"", value, expected, pushed ? uri_len : 0, uri);
+    }
+  }
+
+  // The value is not NUL terminated when it comes from a list
+  const char *uri = NULL;
+  int uri_len = 0;
+  box.check(!http2_parse_link_preload("</a.js>; rel=preload", 19, &uri, &uri_len), "A truncated relation type is pushed");
+}
+
+REGRESSION_TEST(HTTP2_LINK_PRELOAD_LIST)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  static const char LINK[] = "Link";
+  static const char VALUE[] = "</a.css>; rel=preload, </b.js>; rel=preload; nopush, <http://example.com/>; rel=next; "
+                              "title=\"a, b\", </c.js>; rel=\"preload\", </d.js>; rel=prefetch";
+  static const char *const expected[] = {"/a.css", "/c.js"};
+
+  HTTPHdr hdr;
+  hdr.create(HTTP_TYPE_RESPONSE);
+  hdr.value_set(LINK, sizeof(LINK) - 1, VALUE, sizeof(VALUE) - 1);
+
+  HdrCsvIter iter;
+  unsigned int links = 0, pushed = 0;
+  int len;
+  for (const char *value = iter.get_first(hdr.field_find(LINK, sizeof(LINK) - 1), &len); value; value = iter.get_next(&len)) {
+    const char *uri;
+    int uri_len;
+    ++links;
+    if (http2_parse_link_preload(value, len, &uri, &uri_len)) {
+      if (pushed < sizeof(expected) / sizeof(expected[0])) {
+        box.check(uri_len == static_cast<int>(strlen(expected[pushed])) && memcmp(uri, expected[pushed], uri_len) == 0,
+                  "Link %u is expected to push \"%s\", but got \"%.*s\"", pushed, expected[pushed], uri_len, uri);
+      }
+      ++pushed;
+    }
+  }
+  box.check(links == 5, "Link header is expected to have 5 links, but has %u", links);
+  box.check(pushed == 2, "Link header is expected to push 2 links, but pushes %u", pushed);
+
+  hdr.destroy();
+}
+
 #endif /* TS_HAS_TESTS */
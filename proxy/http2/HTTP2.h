@@ -54,6 +54,7 @@ const size_t HTTP2_SETTINGS_PARAMETER_LEN = 6;
 // SETTINGS initial values. NOTE: These should not be modified
 // unless the protocol changes! Do not change this thinking you
 // are changing server defaults. that is done via RecordsConfig.cc
+const uint32_t HTTP2_ENABLE_PUSH = 1;
 const uint32_t HTTP2_MAX_CONCURRENT_STREAMS = UINT_MAX;
 const uint32_t HTTP2_INITIAL_WINDOW_SIZE = 65535;
 const uint32_t HTTP2_MAX_FRAME_SIZE = 16384;
@@ -87,6 +88,9 @@ extern RecRawStatBlock *http2_rsb; // Container for statistics.
 // [RFC 7540] 6.9.1. The Flow Control Window
 static const Http2WindowSize HTTP2_MAX_WINDOW_SIZE = 0x7FFFFFFF;
 
+// [RFC 7540] 6.3. PRIORITY, the E bit of the Stream Dependency field
+static const uint32_t HTTP2_PRIORITY_EXCLUSIVE_MASK = 0x80000000;
+
 // [RFC 7540] 5.4. Error Handling
 enum Http2ErrorClass {
   HTTP2_ERROR_CLASS_NONE,
@@ -253,9 +257,10 @@ struct Http2SettingsParameter {
 
 // [RFC 7540] 6.3 PRIORITY Format
 struct Http2Priority {
-  Http2Priority() : stream_dependency(0), weight(15) {}
+  Http2Priority() : exclusive_flag(false), stream_dependency(0), weight(15) {}
+  bool exclusive_flag;
   uint32_t stream_dependency;
-  uint8_t weight;
+  uint8_t weight; // One less than the weight, 0 - 255
 };
 
 // [RFC 7540] 6.2 HEADERS Format
@@ -278,6 +283,12 @@ struct Http2Goaway {
   // just complicates memory management.
 };
 
+// [RFC 7540] 6.6 PUSH_PROMISE Format
+struct Http2PushPromise {
+  Http2PushPromise() : promised_streamid(0) {}
+  Http2StreamId promised_streamid;
+};
+
 // [RFC 7540] 6.4 RST_STREAM Format
 struct Http2RstStream {
   uint32_t error_code;
@@ -313,6 +324,8 @@ bool http2_write_goaway(const Http2Goaway &, IOVec);
 
 bool http2_write_window_update(const uint32_t new_size, const IOVec &);
 
+bool http2_write_push_promise(const Http2PushPromise &, const uint8_t *, size_t, const IOVec &);
+
 bool http2_frame_header_is_valid(const Http2FrameHeader &, unsigned);
 
 bool http2_settings_parameter_is_valid(const Http2SettingsParameter &);
@@ -336,6 +349,8 @@ Http2ErrorCode http2_encode_header_blocks(HTTPHdr *, uint8_t *, uint32_t, uint32
 MIMEParseResult http2_convert_header_from_2_to_1_1(HTTPHdr *);
 void http2_generate_h2_header_from_1_1(HTTPHdr *headers, HTTPHdr *h2_headers);
 
+bool http2_parse_link_preload(const char *value, int len, const char **uri, int *uri_len);
+
 // Not sure where else to put this, but figure this is as good of a start as
 // anything else.
 // Right now, only the static init() is available, which sets up some basic
@@ -356,6 +371,12 @@ public:
   static uint32_t accept_no_activity_timeout;
   static uint32_t no_activity_timeout_in;
   static uint32_t active_timeout_in;
+  static uint32_t write_buffer_watermark;
+  static uint32_t max_push_streams;
+  static uint32_t push_link_preload;
+  static uint32_t origin_enabled;
+  static uint32_t max_concurrent_streams_out;
+  static uint32_t no_activity_timeout_out;
 
   static void init();
 };
@@ -280,10 +280,14 @@ Http2ClientSession::main_event_handler(int event, void *edata)
     return 0;
 
   case VC_EVENT_WRITE_READY:
-    return 0;
   case VC_EVENT_WRITE_COMPLETE:
     if (this->connection_state.is_state_closed()) {
-      this->do_io_close();
+      if (event == VC_EVENT_WRITE_COMPLETE) {
+        this->do_io_close();
+      }
+    } else {
+      // Room in the write buffer, carry on with the DATA frames held back for it
+      this->connection_state.send_data_frames();
     }
     return 0;
 
@@ -383,8 +387,10 @@ Http2ClientSession::state_start_frame_read(int event, void *edata)
       return 0;
     }
 
-    // Allow only stream id = 0 or streams started by client.
-    if (this->current_hdr.streamid != 0 && !http2_is_client_streamid(this->current_hdr.streamid)) {
+    // Allow only stream id = 0 or streams started by client, and the frames a client may send on pushed streams.
+    if (this->current_hdr.streamid != 0 && !http2_is_client_streamid(this->current_hdr.streamid) &&
+        this->current_hdr.type != HTTP2_FRAME_TYPE_RST_STREAM && this->current_hdr.type != HTTP2_FRAME_TYPE_PRIORITY &&
+        this->current_hdr.type != HTTP2_FRAME_TYPE_WINDOW_UPDATE) {
       SCOPED_MUTEX_LOCK(lock, this->connection_state.mutex, this_ethread());
       if (!this->connection_state.is_state_closed()) {
         this->connection_state.send_goaway_frame(this->current_hdr.streamid, HTTP2_ERROR_PROTOCOL_ERROR);
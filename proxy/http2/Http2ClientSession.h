@@ -195,6 +195,13 @@ public:
     write_vio->reenable();
   }
 
+  // Bytes of frames not yet written to the client
+  int64_t
+  get_pending_write_bytes() const
+  {
+    return sm_writer->read_avail();
+  }
+
   void set_upgrade_context(HTTPHdr *h);
   const Http2UpgradeContext &
   get_upgrade_context() const
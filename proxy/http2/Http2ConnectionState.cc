@@ -41,7 +41,7 @@ static const int buffer_size_index[HTTP2_FRAME_TYPE_MAX] = {
   -1,                    // HTTP2_FRAME_TYPE_PRIORITY
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_RST_STREAM
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_SETTINGS
-  -1,                    // HTTP2_FRAME_TYPE_PUSH_PROMISE
+  BUFFER_SIZE_INDEX_16K, // HTTP2_FRAME_TYPE_PUSH_PROMISE
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_PING
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_GOAWAY
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_WINDOW_UPDATE
@@ -239,7 +239,6 @@ rcv_headers_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
   }
 
   // NOTE: Parse priority parameters if exists
-  // TODO: Currently priority is NOT supported. TS-3535 will fix this.
   if (frame.header().flags & HTTP2_FLAGS_HEADERS_PRIORITY) {
     uint8_t buf[HTTP2_PRIORITY_LEN] = {0};
 
@@ -251,6 +250,7 @@ rcv_headers_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
     if (stream_id == params.priority.stream_dependency) {
       return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
     }
+    cstate.reprioritize_stream(stream_id, params.priority);
 
     header_block_fragment_offset += HTTP2_PRIORITY_LEN;
     header_block_fragment_length -= HTTP2_PRIORITY_LEN;
@@ -308,11 +308,13 @@ rcv_headers_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
 static Http2Error
 rcv_priority_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
 {
-  DebugHttp2Stream(cstate.ua_session, frame.header().streamid, "Received PRIORITY frame");
+  const Http2StreamId stream_id = frame.header().streamid;
+
+  DebugHttp2Stream(cstate.ua_session, stream_id, "Received PRIORITY frame");
 
   // If a PRIORITY frame is received with a stream identifier of 0x0, the
   // recipient MUST respond with a connection error of type PROTOCOL_ERROR.
-  if (frame.header().streamid == 0) {
+  if (stream_id == 0) {
     return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
   }
 
@@ -322,8 +324,23 @@ rcv_priority_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
     return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_FRAME_SIZE_ERROR);
   }
 
-  // TODO Pick stream dependencies and weight
-  // Supporting PRIORITY is not essential so its temporarily ignored.
+  uint8_t buf[HTTP2_PRIORITY_LEN] = {0};
+  Http2Priority priority;
+
+  frame.reader()->memcpy(buf, HTTP2_PRIORITY_LEN, 0);
+  if (!http2_parse_priority_parameter(make_iovec(buf, HTTP2_PRIORITY_LEN), priority)) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  // [RFC 7540] 5.3.1. A stream cannot depend on itself. An endpoint MUST treat
+  // this as a stream error of type PROTOCOL_ERROR.
+  if (stream_id == priority.stream_dependency) {
+    return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  // The stream may be idle or closed, its node is then kept for the streams
+  // which depend on it.
+  cstate.reprioritize_stream(stream_id, priority);
 
   return Http2Error(HTTP2_ERROR_CLASS_NONE);
 }
@@ -342,13 +359,14 @@ rcv_rst_stream_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
   // frame is received with a stream identifier of 0x0, the recipient MUST
   // treat this as a connection error (Section 5.4.1) of type
   // PROTOCOL_ERROR.
-  if (!http2_is_client_streamid(stream_id)) {
+  if (stream_id == 0) {
     return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
   }
 
+  // A client cancels a push by resetting the promised stream, [RFC 7540] 8.2.2.
   Http2Stream *stream = cstate.find_stream(stream_id);
   if (stream == NULL) {
-    if (stream_id <= cstate.get_latest_stream_id()) {
+    if (stream_id <= (http2_is_client_streamid(stream_id) ? cstate.get_latest_stream_id() : cstate.get_latest_push_stream_id())) {
       return Http2Error(HTTP2_ERROR_CLASS_NONE);
     } else {
       return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
@@ -579,7 +597,7 @@ rcv_window_update_frame(Http2ConnectionState &cstate, const Http2Frame &frame)
     Http2Stream *stream = cstate.find_stream(sid);
 
     if (stream == NULL) {
-      if (sid <= cstate.get_latest_stream_id()) {
+      if (sid <= (http2_is_client_streamid(sid) ? cstate.get_latest_stream_id() : cstate.get_latest_push_stream_id())) {
         return Http2Error(HTTP2_ERROR_CLASS_NONE);
       } else {
         return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
@@ -814,27 +832,49 @@ Http2ConnectionState::state_closed(int /* event */, void * /* edata */)
 Http2Stream *
 Http2ConnectionState::create_stream(Http2StreamId new_id)
 {
+  bool client_streamid = http2_is_client_streamid(new_id);
+
   // The identifier of a newly established stream MUST be numerically
   // greater than all streams that the initiating endpoint has opened or
   // reserved.
-  if (new_id <= latest_streamid) {
+  if (new_id <= (client_streamid ? latest_streamid : latest_push_streamid)) {
     return NULL;
   }
 
   // Endpoints MUST NOT exceed the limit set by their peer.  An endpoint
   // that receives a HEADERS frame that causes their advertised concurrent
   // stream limit to be exceeded MUST treat this as a stream error.
-  if (client_streams_count >= server_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
-    return NULL;
+  if (client_streamid) {
+    if (client_streams_count >= server_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
+      return NULL;
+    }
+  } else {
+    if (push_streams_count >= min(Http2::max_push_streams, client_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS))) {
+      return NULL;
+    }
   }
 
   Http2Stream *new_stream = THREAD_ALLOC_INIT(http2StreamAllocator, this_ethread());
   new_stream->init(new_id, client_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
   stream_list.push(new_stream);
-  latest_streamid = new_id;
 
-  ink_assert(client_streams_count < UINT32_MAX);
-  ++client_streams_count;
+  // The stream may already be in the dependency tree, from a PRIORITY frame sent while it was idle.
+  Http2StreamDependencyTree::Node *node = dependency_tree->find(new_id);
+  if (node) {
+    dependency_tree->claim(node, new_stream);
+  } else {
+    node = dependency_tree->add(HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY, new_id, HTTP2_PRIORITY_DEFAULT_WEIGHT, false, new_stream);
+  }
+  new_stream->priority_node = node;
+
+  if (client_streamid) {
+    latest_streamid = new_id;
+    ink_assert(client_streams_count < UINT32_MAX);
+    ++client_streams_count;
+  } else {
+    latest_push_streamid = new_id;
+    ++push_streams_count;
+  }
   new_stream->set_parent(ua_session);
   new_stream->mutex = ua_session->mutex;
   ua_session->get_netvc()->add_to_active_queue();
@@ -855,16 +895,12 @@ Http2ConnectionState::find_stream(Http2StreamId id) const
 void
 Http2ConnectionState::restart_streams()
 {
-  // Currently lookup retryable streams sequentially.
-  // TODO considering to stream weight and dependencies.
-  Http2Stream *s = stream_list.head;
-  while (s) {
-    Http2Stream *next = s->link.next;
-    if (s->get_state() == HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE && min(this->client_rwnd, s->client_rwnd) > 0) {
-      this->send_data_frame(s);
+  for (Http2Stream *s = stream_list.head; s; s = s->link.next) {
+    if (s->get_state() == HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE && s->client_rwnd > 0 && s->priority_node) {
+      dependency_tree->activate(s->priority_node);
     }
-    s = next;
   }
+  this->send_data_frames();
 }
 
 void
@@ -877,6 +913,7 @@ Http2ConnectionState::cleanup_streams()
     s = next;
   }
   client_streams_count = 0;
+  push_streams_count = 0;
   if (!is_state_closed()) {
     ua_session->get_netvc()->add_to_keep_alive_queue();
   }
@@ -886,12 +923,21 @@ void
 Http2ConnectionState::delete_stream(Http2Stream *stream)
 {
   stream_list.remove(stream);
+  if (stream->priority_node) {
+    dependency_tree->release(stream->priority_node);
+    stream->priority_node = NULL;
+  }
   stream->initiating_close();
 
-  ink_assert(client_streams_count > 0);
-  --client_streams_count;
+  if (http2_is_client_streamid(stream->get_id())) {
+    ink_assert(client_streams_count > 0);
+    --client_streams_count;
+  } else {
+    ink_assert(push_streams_count > 0);
+    --push_streams_count;
+  }
 
-  if (client_streams_count == 0 && ua_session) {
+  if (client_streams_count == 0 && push_streams_count == 0 && ua_session) {
     ua_session->get_netvc()->add_to_keep_alive_queue();
   }
 }
@@ -905,84 +951,242 @@ Http2ConnectionState::update_initial_rwnd(Http2WindowSize new_size)
   }
 }
 
+void
+Http2ConnectionState::reprioritize_stream(Http2StreamId id, const Http2Priority &priority)
+{
+  Http2StreamDependencyTree::Node *node = dependency_tree->find(id);
+
+  DebugHttp2Stream(ua_session, id, "Priority - dependency: %u weight: %u exclusive: %d", priority.stream_dependency,
+                   priority.weight + 1, priority.exclusive_flag);
+
+  if (node) {
+    dependency_tree->reprioritize(node, priority.stream_dependency, priority.weight + 1, priority.exclusive_flag);
+  } else {
+    dependency_tree->add(priority.stream_dependency, id, priority.weight + 1, priority.exclusive_flag, NULL);
+  }
+}
+
+// PUSH_PROMISE frames are only sent when the client has not disabled push, on a stream the client opened which is
+// "open" or "half-closed (remote)"
+bool
+Http2ConnectionState::push_allowed(const Http2Stream *stream) const
+{
+  return Http2::max_push_streams != 0 && client_settings.get(HTTP2_SETTINGS_ENABLE_PUSH) != 0 && !is_state_closed() &&
+         http2_is_client_streamid(stream->get_id()) &&
+         (stream->get_state() == HTTP2_STREAM_STATE_OPEN || stream->get_state() == HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE);
+}
+
+// Promise @a url to the client on @a stream, and run a GET for it on a new stream which sends the response once it is
+// ready, from the cache when it is fresh there. [RFC 7540] 8.2. Server Push
+bool
+Http2ConnectionState::push_promise(Http2Stream *stream, URL &url)
+{
+  if (!push_allowed(stream)) {
+    return false;
+  }
+
+  // Each URL is pushed once per connection
+  CryptoHash hash;
+  url.hash_get(&hash);
+  for (uint32_t i = 0; i < min(n_pushed_urls, HTTP2_MAX_REMEMBERED_PUSHES); ++i) {
+    if (pushed_urls[i] == hash) {
+      return false;
+    }
+  }
+
+  Http2Stream *pushed = create_stream(latest_push_streamid + 2);
+  if (pushed == NULL) {
+    return false;
+  }
+
+  // The promised request, with the fields of the associated request the response may vary on
+  static const struct {
+    const char *name;
+    const int *len;
+  } copied_fields[] = {
+    {MIME_FIELD_ACCEPT_ENCODING, &MIME_LEN_ACCEPT_ENCODING},
+    {MIME_FIELD_ACCEPT_LANGUAGE, &MIME_LEN_ACCEPT_LANGUAGE},
+    {MIME_FIELD_USER_AGENT, &MIME_LEN_USER_AGENT},
+  };
+  HTTPHdr request, h2_hdr;
+  HTTPHdr *associated = stream->get_request_header();
+
+  request.create(HTTP_TYPE_REQUEST);
+  request.url_set(&url);
+  request.method_set(HTTP_METHOD_GET, HTTP_LEN_GET);
+  request.version_set(HTTPVersion(1, 1));
+  for (unsigned i = 0; i < countof(copied_fields); ++i) {
+    MIMEField *field = associated->field_find(copied_fields[i].name, *copied_fields[i].len);
+    if (field) {
+      int value_len;
+      const char *value = field->value_get(&value_len);
+      request.value_set(copied_fields[i].name, *copied_fields[i].len, value, value_len);
+    }
+  }
+  http2_generate_h2_header_from_1_1(&request, &h2_hdr);
+  request.destroy();
+
+  DebugHttp2Stream(ua_session, stream->get_id(), "Push stream %d", pushed->get_id());
+
+  // [RFC 7540] 5.3.5. A pushed stream depends on its associated stream with the default weight
+  Http2Priority priority;
+  priority.stream_dependency = stream->get_id();
+  reprioritize_stream(pushed->get_id(), priority);
+
+  pushed->change_state(HTTP2_FRAME_TYPE_PUSH_PROMISE, 0);
+  if (!send_push_promise_frame(stream, pushed->get_id(), &h2_hdr)) {
+    h2_hdr.destroy();
+    delete_stream(pushed);
+    return false;
+  }
+
+  pushed_urls[n_pushed_urls++ % HTTP2_MAX_REMEMBERED_PUSHES] = hash;
+
+  // Set up the State Machine as for a request from the client
+  pushed->set_request_header(h2_hdr);
+  h2_hdr.destroy();
+  pushed->new_transaction();
+  pushed->send_request(*this);
+
+  return true;
+}
+
+// Queue @a stream to send DATA frames in its turn. The END_STREAM flag is sent right away, it takes no window and the
+// stream is deleted soon after.
 void
 Http2ConnectionState::send_data_frame(Http2Stream *stream)
+{
+  if (stream->get_state() == HTTP2_STREAM_STATE_CLOSED || stream->priority_node == NULL) {
+    return;
+  }
+
+  IOBufferReader *current_reader = stream->response_get_data_reader();
+  if (stream->is_body_done() && current_reader && !current_reader->is_read_avail_more_than(0)) {
+    size_t payload_length;
+    this->_send_a_data_frame(stream, payload_length);
+    return;
+  }
+
+  dependency_tree->activate(stream->priority_node);
+  this->send_data_frames();
+}
+
+// Send DATA frames from the streams the dependency tree picks until none has anything to send, the connection window
+// is used up or the client is not keeping up with what is already written.
+void
+Http2ConnectionState::send_data_frames()
+{
+  if (sending_data_frames) {
+    return;
+  }
+  sending_data_frames = true;
+
+  while (!dependency_tree->empty() && !is_state_closed() && this->client_rwnd > 0) {
+    // Carry on from VC_EVENT_WRITE_READY once the client has read some
+    if (Http2::write_buffer_watermark > 0 && ua_session->get_pending_write_bytes() > Http2::write_buffer_watermark) {
+      break;
+    }
+
+    Http2StreamDependencyTree::Node *node = dependency_tree->top();
+    size_t payload_length = 0;
+
+    switch (this->_send_a_data_frame(node->t, payload_length)) {
+    case HTTP2_SEND_DATA_FRAME_NO_ERROR:
+      dependency_tree->update(node, payload_length);
+      break;
+    case HTTP2_SEND_DATA_FRAME_NO_WINDOW:
+    case HTTP2_SEND_DATA_FRAME_NO_PAYLOAD:
+      // Back in the tree from send_data_frame() or restart_streams()
+      dependency_tree->deactivate(node);
+      break;
+    case HTTP2_SEND_DATA_FRAME_DONE:
+      // The stream has been deleted and its node released
+      break;
+    }
+  }
+
+  sending_data_frames = false;
+}
+
+Http2SendDataFrameResult
+Http2ConnectionState::_send_a_data_frame(Http2Stream *stream, size_t &payload_length)
 {
   size_t buf_len = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_DATA]) - HTTP2_FRAME_HEADER_LEN;
   uint8_t payload_buffer[buf_len];
+  uint8_t flags = 0x00;
+  IOBufferReader *current_reader = stream->response_get_data_reader();
+
+  payload_length = 0;
 
   if (stream->get_state() == HTTP2_STREAM_STATE_CLOSED) {
-    return;
+    return HTTP2_SEND_DATA_FRAME_NO_PAYLOAD;
   }
 
-  for (;;) {
-    uint8_t flags = 0x00;
+  // Are we at the end?
+  // If we break here, we never send the END_STREAM in the case of a
+  // early terminating OS.  Ok if there is no body yet.  Otherwise
+  // continue on to delete the stream
+  if (stream->is_body_done() && current_reader && !current_reader->is_read_avail_more_than(0)) {
+    Debug("http2_con", "End of Stream id=%d no more data and body done", stream->get_id());
+    flags |= HTTP2_FLAGS_DATA_END_STREAM;
+  } else {
+    if (this->client_rwnd <= 0 || stream->client_rwnd <= 0) {
+      return HTTP2_SEND_DATA_FRAME_NO_WINDOW;
+    }
 
+    // Select appropriate payload size
     size_t window_size = min(this->client_rwnd, stream->client_rwnd);
     size_t send_size = min(buf_len, window_size);
-    size_t payload_length;
-    IOBufferReader *current_reader = stream->response_get_data_reader();
-
-    // Are we at the end?
-    // If we break here, we never send the END_STREAM in the case of a
-    // early terminating OS.  Ok if there is no body yet.  Otherwise
-    // continue on to delete the stream
-    if (stream->is_body_done() && current_reader && !current_reader->is_read_avail_more_than(0)) {
-      Debug("http2_con", "End of Stream id=%d no more data and body done", stream->get_id());
-      flags |= HTTP2_FLAGS_DATA_END_STREAM;
-      payload_length = 0;
-    } else {
-      // Select appropriate payload size
-      if (this->client_rwnd <= 0 || stream->client_rwnd <= 0)
-        break;
-      // Copy into the payload buffer.  Seems like we should be able to skip this
-      // copy step
-      payload_length = current_reader ? current_reader->read(payload_buffer, send_size) : 0;
-
-      if (payload_length == 0 && !stream->is_body_done()) {
-        break;
-      }
 
-      // Update window size
-      this->client_rwnd -= payload_length;
-      stream->client_rwnd -= payload_length;
+    // Copy into the payload buffer.  Seems like we should be able to skip this
+    // copy step
+    payload_length = current_reader ? current_reader->read(payload_buffer, send_size) : 0;
 
-      if (stream->is_body_done() && payload_length < send_size) {
-        flags |= HTTP2_FLAGS_DATA_END_STREAM;
-      }
+    if (payload_length == 0 && !stream->is_body_done()) {
+      return HTTP2_SEND_DATA_FRAME_NO_PAYLOAD;
     }
 
-    // Create frame
-    DebugHttp2Stream(ua_session, stream->get_id(), "Send DATA frame - client window con: %zd stream: %zd payload: %zd", client_rwnd,
-                     stream->client_rwnd, payload_length);
-    Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->get_id(), flags);
-    data.alloc(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
-    http2_write_data(payload_buffer, payload_length, data.write());
-    data.finalize(payload_length);
-
-    stream->update_sent_count(payload_length);
-
-    // Change state to 'closed' if its end of DATAs.
-    if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
-      DebugHttp2Stream(ua_session, stream->get_id(), "End of DATA frame");
-      // Setting to the same state shouldn't be erroneous
-      stream->change_state(data.header().type, data.header().flags);
-    }
+    // Update window size
+    this->client_rwnd -= payload_length;
+    stream->client_rwnd -= payload_length;
 
-    // xmit event
-    SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
-    this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &data);
-
-    if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
-      // Delete a stream immediately
-      // TODO its should not be deleted for a several time to handling
-      // RST_STREAM and WINDOW_UPDATE.
-      // See 'closed' state written at [RFC 7540] 5.1.
-      DebugSsn(this->ua_session, "http2_cs", "Shutdown stream %d", stream->get_id());
-      this->delete_stream(stream);
-      break;
+    if (stream->is_body_done() && payload_length < send_size) {
+      flags |= HTTP2_FLAGS_DATA_END_STREAM;
     }
   }
+
+  // Create frame
+  DebugHttp2Stream(ua_session, stream->get_id(), "Send DATA frame - client window con: %zd stream: %zd payload: %zd", client_rwnd,
+                   stream->client_rwnd, payload_length);
+  Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->get_id(), flags);
+  data.alloc(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
+  http2_write_data(payload_buffer, payload_length, data.write());
+  data.finalize(payload_length);
+
+  stream->update_sent_count(payload_length);
+
+  // Change state to 'closed' if its end of DATAs.
+  if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    DebugHttp2Stream(ua_session, stream->get_id(), "End of DATA frame");
+    // Setting to the same state shouldn't be erroneous
+    stream->change_state(data.header().type, data.header().flags);
+  }
+
+  // xmit event
+  SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
+  this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &data);
+
+  if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    // Delete a stream immediately
+    // TODO its should not be deleted for a several time to handling
+    // RST_STREAM and WINDOW_UPDATE.
+    // See 'closed' state written at [RFC 7540] 5.1.
+    DebugSsn(this->ua_session, "http2_cs", "Shutdown stream %d", stream->get_id());
+    this->delete_stream(stream);
+    return HTTP2_SEND_DATA_FRAME_DONE;
+  }
+
+  return HTTP2_SEND_DATA_FRAME_NO_ERROR;
 }
 
 void
@@ -999,6 +1203,11 @@ Http2ConnectionState::send_headers_frame(Http2Stream *stream)
 
   DebugHttp2Stream(ua_session, stream->get_id(), "Send HEADERS frame");
 
+  // The response to a push opens the promised stream
+  if (stream->get_state() == HTTP2_STREAM_STATE_RESERVED_LOCAL) {
+    stream->change_state(HTTP2_FRAME_TYPE_HEADERS, 0);
+  }
+
   HTTPHdr h2_hdr;
   http2_generate_h2_header_from_1_1(resp_header, &h2_hdr);
 
@@ -1057,6 +1266,69 @@ Http2ConnectionState::send_headers_frame(Http2Stream *stream)
   ats_free(buf);
 }
 
+// Send the request @a hdr promised on @a stream as a PUSH_PROMISE frame and any CONTINUATION frames it needs.
+bool
+Http2ConnectionState::send_push_promise_frame(Http2Stream *stream, Http2StreamId promised_id, HTTPHdr *hdr)
+{
+  uint32_t buf_len = 0;
+  uint32_t header_blocks_size = 0;
+  int payload_length = 0;
+  uint64_t sent = 0;
+  uint8_t flags = 0x00;
+  Http2PushPromise push_promise;
+
+  DebugHttp2Stream(ua_session, stream->get_id(), "Send PUSH_PROMISE frame");
+
+  buf_len = hdr->length_get() * 2; // Make it double just in case
+  uint8_t *buf = (uint8_t *)ats_malloc(buf_len);
+  Http2ErrorCode result = http2_encode_header_blocks(hdr, buf, buf_len, &header_blocks_size, *(this->remote_hpack_handle));
+  if (result != HTTP2_ERROR_NO_ERROR) {
+    ats_free(buf);
+    return false;
+  }
+
+  // Send a PUSH_PROMISE frame, the promised stream id comes before the header block fragment
+  const uint32_t max_payload_length = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]) -
+                                      HTTP2_FRAME_HEADER_LEN - sizeof(push_promise.promised_streamid);
+  if (header_blocks_size <= max_payload_length) {
+    payload_length = header_blocks_size;
+    flags |= HTTP2_FLAGS_PUSH_PROMISE_END_HEADERS;
+  } else {
+    payload_length = max_payload_length;
+  }
+  push_promise.promised_streamid = promised_id;
+  Http2Frame frame(HTTP2_FRAME_TYPE_PUSH_PROMISE, stream->get_id(), flags);
+  frame.alloc(buffer_size_index[HTTP2_FRAME_TYPE_PUSH_PROMISE]);
+  http2_write_push_promise(push_promise, buf, payload_length, frame.write());
+  frame.finalize(sizeof(push_promise.promised_streamid) + payload_length);
+  // xmit event
+  SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
+  this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &frame);
+  sent += payload_length;
+
+  // Send CONTINUATION frames
+  flags = 0;
+  while (sent < header_blocks_size) {
+    DebugHttp2Stream(ua_session, stream->get_id(), "Send CONTINUATION frame");
+    payload_length = MIN(BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION]) - HTTP2_FRAME_HEADER_LEN,
+                         header_blocks_size - sent);
+    if (sent + payload_length == header_blocks_size) {
+      flags |= HTTP2_FLAGS_CONTINUATION_END_HEADERS;
+    }
+    Http2Frame continuation(HTTP2_FRAME_TYPE_CONTINUATION, stream->get_id(), flags);
+    continuation.alloc(buffer_size_index[HTTP2_FRAME_TYPE_CONTINUATION]);
+    http2_write_headers(buf + sent, payload_length, continuation.write());
+    continuation.finalize(payload_length);
+    // xmit event
+    SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
+    this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &continuation);
+    sent += payload_length;
+  }
+
+  ats_free(buf);
+  return true;
+}
+
 void
 Http2ConnectionState::send_rst_stream_frame(Http2StreamId id, Http2ErrorCode ec)
 {
@@ -1220,3 +1492,77 @@ Http2ConnectionState::_adjust_concurrent_stream()
 
   return Http2::max_concurrent_streams_in;
 }
+
+#if TS_HAS_TESTS
+
+#include "ts/TestBox.h"
+
+REGRESSION_TEST(HTTP2_PUSH_PROMISE_STATE)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // The promised stream is "reserved (local)" until its HEADERS are sent
+  Http2Stream *pushed = THREAD_ALLOC_INIT(http2StreamAllocator, this_ethread());
+  pushed->init(2, Http2::initial_window_size);
+  box.check(pushed->change_state(HTTP2_FRAME_TYPE_PUSH_PROMISE, 0), "PUSH_PROMISE is refused on an idle stream");
+  box.check(pushed->get_state() == HTTP2_STREAM_STATE_RESERVED_LOCAL, "Promised stream is in state %d, not reserved (local)",
+            pushed->get_state());
+  box.check(!pushed->change_state(HTTP2_FRAME_TYPE_DATA, 0), "DATA is accepted on a reserved stream");
+  box.check(pushed->change_state(HTTP2_FRAME_TYPE_HEADERS, HTTP2_FLAGS_HEADERS_END_HEADERS), "HEADERS is refused");
+  box.check(pushed->get_state() == HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE,
+            "Promised stream is in state %d after HEADERS, not half-closed (remote)", pushed->get_state());
+  pushed->destroy();
+
+  pushed = THREAD_ALLOC_INIT(http2StreamAllocator, this_ethread());
+  pushed->init(4, Http2::initial_window_size);
+  pushed->change_state(HTTP2_FRAME_TYPE_PUSH_PROMISE, 0);
+  pushed->change_state(HTTP2_FRAME_TYPE_HEADERS, HTTP2_FLAGS_HEADERS_END_HEADERS | HTTP2_FLAGS_HEADERS_END_STREAM);
+  box.check(pushed->get_state() == HTTP2_STREAM_STATE_CLOSED, "Promised stream is in state %d after END_STREAM, not closed",
+            pushed->get_state());
+  pushed->destroy();
+}
+
+REGRESSION_TEST(HTTP2_PUSH_PROMISE_DISABLED)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  uint32_t max_push_streams = Http2::max_push_streams;
+  Http2::max_push_streams = 100;
+
+  Http2ClientSession session;
+  Http2ConnectionState cstate;
+  cstate.ua_session = &session;
+
+  Http2Stream *stream = THREAD_ALLOC_INIT(http2StreamAllocator, this_ethread());
+  stream->init(1, Http2::initial_window_size);
+  stream->change_state(HTTP2_FRAME_TYPE_HEADERS, HTTP2_FLAGS_HEADERS_END_HEADERS);
+  box.check(cstate.push_allowed(stream), "Push is refused on an open stream of a client which allows it");
+
+  // SETTINGS_ENABLE_PUSH = 0, [RFC 7540] 6.5.2
+  cstate.client_settings.set(HTTP2_SETTINGS_ENABLE_PUSH, 0);
+  box.check(!cstate.push_allowed(stream), "Push is allowed after the client disabled it");
+
+  URL url;
+  url.create(NULL);
+  url.parse("https://example.com/a.css", 25);
+  box.check(!cstate.push_promise(stream, url), "PUSH_PROMISE is sent after the client disabled push");
+  box.check(cstate.get_latest_push_stream_id() == 0, "Stream %d is promised after the client disabled push",
+            cstate.get_latest_push_stream_id());
+  url.destroy();
+
+  cstate.client_settings.set(HTTP2_SETTINGS_ENABLE_PUSH, 1);
+  Http2::max_push_streams = 0;
+  box.check(!cstate.push_allowed(stream), "Push is allowed with proxy.config.http2.max_push_streams 0");
+  Http2::max_push_streams = 100;
+
+  stream->change_state(HTTP2_FRAME_TYPE_RST_STREAM, 0);
+  box.check(!cstate.push_allowed(stream), "Push is allowed on a closed stream");
+  stream->destroy();
+
+  cstate.ua_session = NULL;
+  Http2::max_push_streams = max_push_streams;
+}
+
+#endif /* TS_HAS_TESTS */
@@ -30,6 +30,19 @@
 
 class Http2ClientSession;
 
+// Number of nodes of idle and closed streams kept in the dependency tree, see [RFC 7540] 5.3.4.
+const uint32_t HTTP2_MAX_RETAINED_PRIORITY_NODES = 100;
+
+// Number of URLs remembered per connection so that each is pushed at most once.
+const uint32_t HTTP2_MAX_REMEMBERED_PUSHES = 64;
+
+enum Http2SendDataFrameResult {
+  HTTP2_SEND_DATA_FRAME_NO_ERROR,
+  HTTP2_SEND_DATA_FRAME_NO_WINDOW,
+  HTTP2_SEND_DATA_FRAME_NO_PAYLOAD,
+  HTTP2_SEND_DATA_FRAME_DONE,
+};
+
 class Http2ConnectionSettings
 {
 public:
@@ -38,7 +51,7 @@ public:
     // 6.5.2.  Defined SETTINGS Parameters. These should generally not be
     // modified,
     // only if the protocol changes should these change.
-    settings[indexof(HTTP2_SETTINGS_ENABLE_PUSH)] = 0; // Disabled for now
+    settings[indexof(HTTP2_SETTINGS_ENABLE_PUSH)] = 0; // The server never accepts pushes
 
     settings[indexof(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)] = HTTP2_MAX_CONCURRENT_STREAMS;
     settings[indexof(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE)] = HTTP2_INITIAL_WINDOW_SIZE;
@@ -105,9 +118,12 @@ class Http2ConnectionState : public Continuation
 public:
   Http2ConnectionState()
     : Continuation(NULL), ua_session(NULL), client_rwnd(HTTP2_INITIAL_WINDOW_SIZE), server_rwnd(Http2::initial_window_size),
-      stream_list(), latest_streamid(0), client_streams_count(0), continued_stream_id(0)
+      stream_list(), latest_streamid(0), latest_push_streamid(0), client_streams_count(0), push_streams_count(0),
+      continued_stream_id(0), dependency_tree(NULL), sending_data_frames(false), n_pushed_urls(0)
   {
     SET_HANDLER(&Http2ConnectionState::main_event_handler);
+    // [RFC 7540] 6.5.2. Push is enabled until the client says otherwise
+    client_settings.set(HTTP2_SETTINGS_ENABLE_PUSH, HTTP2_ENABLE_PUSH);
   }
 
   Http2ClientSession *ua_session;
@@ -123,6 +139,7 @@ public:
   {
     local_hpack_handle = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
     remote_hpack_handle = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
+    dependency_tree = new Http2StreamDependencyTree(HTTP2_MAX_RETAINED_PRIORITY_NODES);
 
     continued_buffer.iov_base = NULL;
     continued_buffer.iov_len = 0;
@@ -136,6 +153,7 @@ public:
     mutex = NULL; // magic happens - assigning to NULL frees the ProxyMutex
     delete local_hpack_handle;
     delete remote_hpack_handle;
+    delete dependency_tree;
 
     ats_free(continued_buffer.iov_base);
   }
@@ -152,6 +170,7 @@ public:
   void cleanup_streams();
 
   void update_initial_rwnd(Http2WindowSize new_size);
+  void reprioritize_stream(Http2StreamId id, const Http2Priority &priority);
 
   Http2StreamId
   get_latest_stream_id() const
@@ -159,6 +178,16 @@ public:
     return latest_streamid;
   }
 
+  Http2StreamId
+  get_latest_push_stream_id() const
+  {
+    return latest_push_streamid;
+  }
+
+  // Server push, [RFC 7540] 8.2
+  bool push_allowed(const Http2Stream *stream) const;
+  bool push_promise(Http2Stream *stream, URL &url);
+
   // Continuated header decoding
   Http2StreamId
   get_continued_stream_id() const
@@ -181,7 +210,9 @@ public:
 
   // HTTP/2 frame sender
   void send_data_frame(Http2Stream *stream);
+  void send_data_frames();
   void send_headers_frame(Http2Stream *stream);
+  bool send_push_promise_frame(Http2Stream *stream, Http2StreamId promised_id, HTTPHdr *hdr);
   void send_rst_stream_frame(Http2StreamId id, Http2ErrorCode ec);
   void send_settings_frame(const Http2ConnectionSettings &new_settings);
   void send_ping_frame(Http2StreamId id, uint8_t flag, const uint8_t *opaque_data);
@@ -199,6 +230,7 @@ private:
   Http2ConnectionState &operator=(const Http2ConnectionState &); // noncopyable
 
   unsigned _adjust_concurrent_stream();
+  Http2SendDataFrameResult _send_a_data_frame(Http2Stream *stream, size_t &payload_length);
 
   // NOTE: 'stream_list' has only active streams.
   //   If given Stream Identifier is not found in stream_list and it is less
@@ -208,10 +240,14 @@ private:
   //   than latest_streamid, the state of Stream is IDLE.
   DLL<Http2Stream> stream_list;
   Http2StreamId latest_streamid;
+  Http2StreamId latest_push_streamid;
 
   // Counter for current acive streams which is started by client
   uint32_t client_streams_count;
 
+  // Counter for current active streams which are pushed by the server
+  uint32_t push_streams_count;
+
   // NOTE: Id of stream which MUST receive CONTINUATION frame.
   //   - [RFC 7540] 6.2 HEADERS
   //     "A HEADERS frame without the END_HEADERS flag set MUST be followed by a
@@ -221,6 +257,14 @@ private:
   //     another CONTINUATION frame."
   Http2StreamId continued_stream_id;
   IOVec continued_buffer;
+
+  // Streams with DATA frames to send, in the order of [RFC 7540] 5.3. Stream Priority
+  Http2StreamDependencyTree *dependency_tree;
+  bool sending_data_frames;
+
+  // URLs pushed on this connection, the oldest is forgotten first
+  CryptoHash pushed_urls[HTTP2_MAX_REMEMBERED_PUSHES];
+  uint32_t n_pushed_urls;
 };
 
 #endif // __HTTP2_CONNECTION_STATE_H__
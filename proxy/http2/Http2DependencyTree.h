@@ -0,0 +1,383 @@
+/** @file
+
+  HTTP/2 Dependency Tree
+
+  The stream dependency tree of [RFC 7540] 5.3, and a deficit round robin
+  scheduler over it which decides which stream sends the next DATA frame.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HTTP2_DEPENDENCY_TREE_H__
+#define __HTTP2_DEPENDENCY_TREE_H__
+
+#include "ts/ink_assert.h"
+#include "ts/List.h"
+
+// [RFC 7540] 5.3.5. Default Priority
+const static uint32_t HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY = 0;
+const static uint32_t HTTP2_PRIORITY_DEFAULT_WEIGHT = 16;
+
+// Bytes a node of weight 1 may send per round. A node of weight w gets w times this, so with the default weight a
+// stream gets a 16KB frame out per round.
+const static int64_t HTTP2_PRIORITY_QUANTUM = 1024;
+
+// Http2DependencyTree
+//
+// Each node is a stream, or a stream which is idle or closed but still useful as a dependency. A node is active when
+// its stream has a frame to send. Each node keeps a queue of the children which are active or have an active
+// descendant, and top() walks down from the root taking the first of these at each level until it meets an active
+// node: a parent is always served before its dependents, and siblings share what their parent does not use.
+//
+// Siblings are served by deficit round robin. A child joins its parent's queue with its weight worth of quantum, stays
+// at the head until it has sent that, then goes to the back with another quantum added for its next turn. Bytes sent
+// are charged to the node and all its ancestors, so each level shares out what the subtrees below it actually sent.
+// A node leaving its parent's queue loses its deficit, credit is not kept while idle.
+//
+// Nodes without a stream (T is NULL) are kept in the order they were released, and the oldest is removed once there
+// are more than the given number of them.
+template <typename T> class Http2DependencyTree
+{
+public:
+  class Node
+  {
+  public:
+    Node(uint32_t i = 0, uint32_t w = HTTP2_PRIORITY_DEFAULT_WEIGHT, T tt = NULL)
+      : id(i), weight(w), deficit(0), active(false), queued(false), parent(NULL), t(tt)
+    {
+    }
+
+    LINK(Node, link);         // All nodes of the tree
+    LINK(Node, retain_link);  // Nodes without a stream
+    LINK(Node, sibling_link); // Children of the parent
+    LINK(Node, queue_link);   // Queue of the parent
+
+    uint32_t id;
+    uint32_t weight; // 1 - 256
+    int64_t deficit;
+    bool active;
+    bool queued;
+    Node *parent;
+    DLL<Node, typename Node::Link_sibling_link> children;
+    Queue<Node, typename Node::Link_queue_link> queue;
+    T t;
+  };
+
+  Http2DependencyTree(uint32_t max_retained) : _root(new Node()), _n_retained(0), _max_retained(max_retained)
+  {
+    ink_assert(max_retained > 0);
+  }
+  ~Http2DependencyTree();
+
+  Node *find(uint32_t id) const;
+  Node *add(uint32_t parent_id, uint32_t id, uint32_t weight, bool exclusive, T t);
+  void reprioritize(Node *node, uint32_t parent_id, uint32_t weight, bool exclusive);
+  void claim(Node *node, T t);
+  void release(Node *node);
+  void remove(Node *node);
+
+  void activate(Node *node);
+  void deactivate(Node *node);
+  Node *top();
+  void update(Node *node, uint32_t sent);
+
+  bool
+  empty() const
+  {
+    return _root->queue.empty();
+  }
+
+  Node *
+  root() const
+  {
+    return _root;
+  }
+
+private:
+  void _attach(Node *parent, Node *node, bool exclusive);
+  void _detach(Node *node);
+  void _update_queued(Node *node);
+  bool _in_subtree(const Node *node, const Node *top) const;
+  void _retain(Node *node);
+
+  Node *_root;
+  DLL<Node, typename Node::Link_link> _nodes;
+  Queue<Node, typename Node::Link_retain_link> _retained;
+  uint32_t _n_retained;
+  uint32_t _max_retained;
+};
+
+template <typename T> Http2DependencyTree<T>::~Http2DependencyTree()
+{
+  while (Node *node = _nodes.pop()) {
+    delete node;
+  }
+  delete _root;
+}
+
+template <typename T>
+typename Http2DependencyTree<T>::Node *
+Http2DependencyTree<T>::find(uint32_t id) const
+{
+  for (Node *node = _nodes.head; node; node = node->link.next) {
+    if (node->id == id) {
+      return node;
+    }
+  }
+  return NULL;
+}
+
+// [RFC 7540] 5.3.1. A dependency on a stream that is not in the tree results in the default priority.
+template <typename T>
+typename Http2DependencyTree<T>::Node *
+Http2DependencyTree<T>::add(uint32_t parent_id, uint32_t id, uint32_t weight, bool exclusive, T t)
+{
+  Node *parent = parent_id == HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY ? _root : find(parent_id);
+  Node *node = new Node(id, weight, t);
+
+  if (parent == NULL) {
+    parent = _root;
+    node->weight = HTTP2_PRIORITY_DEFAULT_WEIGHT;
+    exclusive = false;
+  }
+
+  _nodes.push(node);
+  _attach(parent, node, exclusive);
+  if (t == NULL) {
+    _retain(node);
+  }
+
+  return node;
+}
+
+// [RFC 7540] 5.3.3. If the new parent depends on @a node, it is first moved up to where @a node was.
+template <typename T>
+void
+Http2DependencyTree<T>::reprioritize(Node *node, uint32_t parent_id, uint32_t weight, bool exclusive)
+{
+  Node *parent = parent_id == HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY ? _root : find(parent_id);
+
+  if (parent == NULL) {
+    parent = _root;
+    weight = HTTP2_PRIORITY_DEFAULT_WEIGHT;
+    exclusive = false;
+  }
+  ink_assert(parent != node);
+
+  if (_in_subtree(parent, node)) {
+    Node *old_parent = node->parent;
+    _detach(parent);
+    _attach(old_parent, parent, false);
+  }
+
+  _detach(node);
+  node->weight = weight;
+  _attach(parent, node, exclusive);
+}
+
+// Give a node kept for an idle stream its stream.
+template <typename T>
+void
+Http2DependencyTree<T>::claim(Node *node, T t)
+{
+  ink_assert(node->t == NULL);
+  _retained.remove(node);
+  --_n_retained;
+  node->t = t;
+}
+
+// The stream of @a node is closed, keep the node for a while in case other streams depend on it.
+template <typename T>
+void
+Http2DependencyTree<T>::release(Node *node)
+{
+  deactivate(node);
+  node->t = NULL;
+  _retain(node);
+}
+
+// [RFC 7540] 5.3.4. The children of a removed node take its place, sharing its weight in proportion to their own.
+template <typename T>
+void
+Http2DependencyTree<T>::remove(Node *node)
+{
+  Node *parent = node->parent;
+  uint32_t total = 0;
+
+  for (Node *child = node->children.head; child; child = child->sibling_link.next) {
+    total += child->weight;
+  }
+
+  while (Node *child = node->children.head) {
+    uint32_t weight = node->weight * child->weight / total;
+    _detach(child);
+    child->weight = weight > 0 ? weight : 1;
+    _attach(parent, child, false);
+  }
+
+  node->active = false;
+  _detach(node);
+  if (node->t == NULL) {
+    _retained.remove(node);
+    --_n_retained;
+  }
+  _nodes.remove(node);
+  delete node;
+}
+
+template <typename T>
+void
+Http2DependencyTree<T>::activate(Node *node)
+{
+  if (!node->active) {
+    node->active = true;
+    _update_queued(node);
+  }
+}
+
+template <typename T>
+void
+Http2DependencyTree<T>::deactivate(Node *node)
+{
+  if (node->active) {
+    node->active = false;
+    _update_queued(node);
+  }
+}
+
+// The node to send the next frame from, or NULL if no node is active.
+template <typename T>
+typename Http2DependencyTree<T>::Node *
+Http2DependencyTree<T>::top()
+{
+  Node *node = _root;
+
+  while (node == _root || !node->active) {
+    Node *child = node->queue.head;
+    if (child == NULL) {
+      ink_assert(node == _root);
+      return NULL;
+    }
+    while (child->deficit <= 0) {
+      child->deficit += HTTP2_PRIORITY_QUANTUM * child->weight;
+      node->queue.remove(child);
+      node->queue.enqueue(child);
+      child = node->queue.head;
+    }
+    node = child;
+  }
+
+  return node;
+}
+
+// Charge @a sent bytes to @a node and its ancestors.
+template <typename T>
+void
+Http2DependencyTree<T>::update(Node *node, uint32_t sent)
+{
+  for (; node != _root; node = node->parent) {
+    node->deficit -= sent;
+  }
+}
+
+template <typename T>
+void
+Http2DependencyTree<T>::_attach(Node *parent, Node *node, bool exclusive)
+{
+  node->parent = parent;
+  parent->children.push(node);
+  _update_queued(node);
+
+  // [RFC 7540] 5.3.1. An exclusive dependency makes the node the sole child of its parent, and the parent of its
+  // former siblings.
+  if (exclusive) {
+    Node *child = parent->children.head;
+    while (child) {
+      Node *next = child->sibling_link.next;
+      if (child != node) {
+        _detach(child);
+        child->parent = node;
+        node->children.push(child);
+        _update_queued(child);
+      }
+      child = next;
+    }
+  }
+}
+
+template <typename T>
+void
+Http2DependencyTree<T>::_detach(Node *node)
+{
+  Node *parent = node->parent;
+
+  if (node->queued) {
+    parent->queue.remove(node);
+    node->queued = false;
+    node->deficit = 0;
+    _update_queued(parent);
+  }
+  parent->children.remove(node);
+  node->parent = NULL;
+}
+
+// A node is in the queue of its parent when it is active or has a queued child. Fix that up from @a node to the root.
+template <typename T>
+void
+Http2DependencyTree<T>::_update_queued(Node *node)
+{
+  for (; node != _root; node = node->parent) {
+    bool queued = node->active || !node->queue.empty();
+    if (queued == node->queued) {
+      break;
+    }
+    node->queued = queued;
+    if (queued) {
+      node->deficit = HTTP2_PRIORITY_QUANTUM * node->weight;
+      node->parent->queue.enqueue(node);
+    } else {
+      node->parent->queue.remove(node);
+      node->deficit = 0;
+    }
+  }
+}
+
+template <typename T>
+bool
+Http2DependencyTree<T>::_in_subtree(const Node *node, const Node *top) const
+{
+  for (; node; node = node->parent) {
+    if (node == top) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename T>
+void
+Http2DependencyTree<T>::_retain(Node *node)
+{
+  _retained.enqueue(node);
+  if (++_n_retained > _max_retained) {
+    remove(_retained.head);
+  }
+}
+
+#endif // __HTTP2_DEPENDENCY_TREE_H__
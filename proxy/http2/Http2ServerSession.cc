@@ -0,0 +1,1992 @@
+/** @file
+
+  Http2ServerSession.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "Http2ServerSession.h"
+#include "Http2DebugNames.h"
+#include "HttpDebugNames.h"
+
+#define DebugHttp2Ssn(fmt, ...) Debug("http2_ss", "[%" PRId64 "] " fmt, this->con_id, ##__VA_ARGS__)
+#define DebugHttp2SsnStream(id, fmt, ...) Debug("http2_ss", "[%" PRId64 "] [%u] " fmt, this->con_id, id, ##__VA_ARGS__)
+#define DebugHttp2Stream(fmt, ...) Debug("http2_ss", "[%u] " fmt, this->id, ##__VA_ARGS__)
+
+#define HTTP2_SET_SESSION_HANDLER(handler) \
+  do {                                     \
+    this->session_handler = (handler);     \
+  } while (0)
+
+ClassAllocator<Http2ServerSession> http2ServerSessionAllocator("http2ServerSessionAllocator");
+ClassAllocator<Http2ServerStream> http2ServerStreamAllocator("http2ServerStreamAllocator");
+
+// Frames with a header block or data, and the small control frames.
+static const int HTTP2_FRAME_SIZE_INDEX = BUFFER_SIZE_INDEX_16K;
+static const int HTTP2_CONTROL_FRAME_SIZE_INDEX = BUFFER_SIZE_INDEX_128;
+
+// How much of the request body a stream takes from the state machine ahead of the DATA frames.
+static const int64_t HTTP2_STREAM_BODY_BUFFER_SIZE = 65536;
+
+static int64_t next_ss_id = 0;
+
+//
+// Http2ServerStream
+//
+
+Http2ServerStream::Http2ServerStream()
+  : id(0), session(NULL), closed(false), reentrancy_count(0), event_pending(0), request_state(REQUEST_HEADER),
+    request_chunked(false), request_body_left(0), body_buffer(NULL), body_reader(NULL), peer_rwnd(0), local_rwnd(0),
+    response_header_ready(false), response_header_sent(false), recv_buffer(NULL), recv_reader(NULL), recv_end(false),
+    error_event(VC_EVENT_NONE), active_timeout(0), active_event(NULL), inactive_timeout(0), inactive_timeout_at(0),
+    inactive_event(NULL)
+{
+}
+
+void
+Http2ServerStream::init(Http2ServerSession *ssn, ProxyMutex *m)
+{
+  mutex = m;
+  thread = this_ethread();
+  session = ssn;
+  session_mutex = ssn->mutex;
+  ats_ip_copy(&server_addr, ssn->server_vc->get_remote_addr());
+  ats_ip_copy(&client_addr, ssn->server_vc->get_local_addr());
+
+  http_parser_init(&http_parser);
+  request_header.create(HTTP_TYPE_REQUEST);
+  body_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+  body_reader = body_buffer->alloc_reader();
+
+  response_header.create(HTTP_TYPE_RESPONSE);
+  recv_buffer = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+  recv_reader = recv_buffer->alloc_reader();
+
+  SET_HANDLER(&Http2ServerStream::main_event_handler);
+}
+
+void
+Http2ServerStream::destroy()
+{
+  DebugHttp2Stream("stream destroy");
+  ink_release_assert(session == NULL);
+
+  clear_timers();
+  http_parser_clear(&http_parser);
+  request_header.destroy();
+  response_header.destroy();
+  chunked_handler.clear();
+  free_MIOBuffer(body_buffer);
+  free_MIOBuffer(recv_buffer);
+
+  read_vio.mutex.clear();
+  write_vio.mutex.clear();
+  session_mutex.clear();
+  mutex.clear();
+  THREAD_FREE(this, http2ServerStreamAllocator, this_ethread());
+}
+
+void
+Http2ServerStream::signal()
+{
+  if (ink_atomic_swap(&event_pending, 1) == 0) {
+    thread->schedule_imm(this, HTTP2_SERVER_STREAM_EVENT_UPDATE);
+  }
+}
+
+int
+Http2ServerStream::main_event_handler(int event, void *edata)
+{
+  Event *e = static_cast<Event *>(edata);
+
+  ++reentrancy_count;
+  if (e != NULL && e == active_event) {
+    event = VC_EVENT_ACTIVE_TIMEOUT;
+    active_event = NULL;
+  } else if (e != NULL && e == inactive_event) {
+    if (inactive_timeout_at && inactive_timeout_at < Thread::get_hrtime()) {
+      event = VC_EVENT_INACTIVITY_TIMEOUT;
+      clear_timers();
+    }
+  }
+
+  switch (event) {
+  case VC_EVENT_ACTIVE_TIMEOUT:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+    if (closed) {
+      break;
+    }
+    if (read_vio._cont && read_vio.ntodo() > 0) {
+      SCOPED_MUTEX_LOCK(lock, read_vio.mutex, this_ethread());
+      read_vio._cont->handleEvent(event, &read_vio);
+    } else if (write_vio._cont && write_vio.ntodo() > 0) {
+      SCOPED_MUTEX_LOCK(lock, write_vio.mutex, this_ethread());
+      write_vio._cont->handleEvent(event, &write_vio);
+    }
+    break;
+
+  case HTTP2_SERVER_STREAM_EVENT_UPDATE:
+    event_pending = 0;
+    if (!closed) {
+      update();
+    } else if (!release_session()) {
+      signal();
+    }
+    break;
+
+  default:
+    break;
+  }
+  --reentrancy_count;
+
+  if (closed && reentrancy_count == 0 && event_pending == 0) {
+    destroy();
+  }
+  return 0;
+}
+
+// Move the request to the connection and the response to the state machine, then tell the state machine about it. If
+// the connection is busy on another thread, try again from another update event.
+void
+Http2ServerStream::update()
+{
+  int event = VC_EVENT_CONT;
+
+  {
+    MUTEX_TRY_LOCK(lock, session_mutex, this_ethread());
+    if (!lock.is_locked()) {
+      signal();
+      return;
+    }
+    if (session) {
+      event = update_write(session);
+    }
+    // An error goes to the read side if the state machine is reading, otherwise to the write side
+    if (event == VC_EVENT_CONT && error_event != VC_EVENT_NONE && !(read_vio._cont && read_vio.ntodo() > 0) &&
+        write_vio._cont && write_vio.ntodo() > 0) {
+      event = error_event;
+    }
+  }
+  if (event != VC_EVENT_CONT) {
+    if (inactive_timeout > 0) {
+      inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+    }
+    SCOPED_MUTEX_LOCK(lock, write_vio.mutex, this_ethread());
+    write_vio._cont->handleEvent(event, &write_vio);
+    if (closed) {
+      return;
+    }
+  }
+
+  {
+    MUTEX_TRY_LOCK(lock, session_mutex, this_ethread());
+    if (!lock.is_locked()) {
+      signal();
+      return;
+    }
+    event = update_read(session);
+  }
+  if (event != VC_EVENT_CONT) {
+    if (inactive_timeout > 0) {
+      inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+    }
+    SCOPED_MUTEX_LOCK(lock, read_vio.mutex, this_ethread());
+    read_vio._cont->handleEvent(event, &read_vio);
+  }
+}
+
+// Take the request from the write VIO, the header first and then the body, and send it as frames.
+int
+Http2ServerStream::update_write(Http2ServerSession *ssn)
+{
+  IOBufferReader *reader = NULL;
+  int64_t moved = 0;
+
+  if (write_vio._cont && write_vio.ntodo() > 0) {
+    reader = write_vio.get_reader();
+  }
+
+  if (request_state == REQUEST_HEADER) {
+    if (reader == NULL) {
+      return VC_EVENT_CONT;
+    }
+
+    int bytes_used = 0;
+    MIMEParseResult result = request_header.parse_req(&http_parser, reader, &bytes_used, false);
+    moved += bytes_used;
+
+    if (result == PARSE_ERROR) {
+      DebugHttp2Stream("request header parse failure");
+      error_event = VC_EVENT_ERROR;
+      write_vio.ndone += moved;
+      return VC_EVENT_ERROR;
+    } else if (result != PARSE_DONE) {
+      write_vio.ndone += moved;
+      return moved > 0 ? VC_EVENT_WRITE_READY : VC_EVENT_CONT;
+    }
+
+    MIMEField *field = request_header.field_find(MIME_FIELD_TRANSFER_ENCODING, MIME_LEN_TRANSFER_ENCODING);
+    if (field && field->value_get_index(HTTP_VALUE_CHUNKED, HTTP_LEN_CHUNKED) >= 0) {
+      request_chunked = true;
+      chunked_handler.init_by_action(body_reader, ChunkedHandler::ACTION_DECHUNK);
+      chunked_handler.state = ChunkedHandler::CHUNK_READ_SIZE;
+      chunked_handler.dechunked_reader = chunked_handler.dechunked_buffer->alloc_reader();
+      body_reader->dealloc();
+      body_reader = NULL;
+    } else {
+      request_body_left = request_header.get_content_length();
+    }
+
+    bool end_stream = !request_chunked && request_body_left <= 0;
+    if (!ssn->send_headers(this, &request_header, end_stream)) {
+      error_event = VC_EVENT_ERROR;
+      write_vio.ndone += moved;
+      return VC_EVENT_ERROR;
+    }
+    request_state = end_stream ? REQUEST_DONE : REQUEST_BODY;
+  }
+
+  if (request_state == REQUEST_BODY && reader) {
+    int64_t buffered = body_buffer->max_read_avail();
+    if (request_chunked) {
+      buffered += chunked_handler.dechunked_reader->read_avail();
+    }
+
+    int64_t nbytes = std::min(write_vio.ntodo() - moved, reader->read_avail());
+    nbytes = std::min(nbytes, HTTP2_STREAM_BODY_BUFFER_SIZE - buffered);
+    if (!request_chunked) {
+      nbytes = std::min(nbytes, request_body_left);
+    }
+
+    if (nbytes > 0) {
+      body_buffer->write(reader, nbytes);
+      reader->consume(nbytes);
+      moved += nbytes;
+
+      if (request_chunked) {
+        bool done = false;
+        do {
+          if (chunked_handler.state == ChunkedHandler::CHUNK_FLOW_CONTROL) {
+            chunked_handler.state = ChunkedHandler::CHUNK_READ_SIZE_START;
+          }
+          done = chunked_handler.process_chunked_content();
+        } while (chunked_handler.state == ChunkedHandler::CHUNK_FLOW_CONTROL);
+        if (done) {
+          request_state = REQUEST_FLUSH;
+        }
+      } else {
+        request_body_left -= nbytes;
+        if (request_body_left <= 0) {
+          request_state = REQUEST_FLUSH;
+        }
+      }
+    }
+  }
+
+  if (request_state == REQUEST_BODY || request_state == REQUEST_FLUSH) {
+    IOBufferReader *data_reader = request_chunked ? chunked_handler.dechunked_reader : body_reader;
+    bool end_stream = request_state == REQUEST_FLUSH;
+
+    if (ssn->send_data(this, data_reader, end_stream) && end_stream) {
+      request_state = REQUEST_DONE;
+    }
+  }
+
+  if (moved > 0) {
+    write_vio.ndone += moved;
+    return write_vio.ntodo() > 0 ? VC_EVENT_WRITE_READY : VC_EVENT_WRITE_COMPLETE;
+  }
+  return VC_EVENT_CONT;
+}
+
+// Give the response to the read VIO as HTTP/1.1, the header first and then the body.
+int
+Http2ServerStream::update_read(Http2ServerSession *ssn)
+{
+  if (read_vio._cont == NULL || read_vio.ntodo() <= 0) {
+    return VC_EVENT_CONT;
+  }
+
+  MIOBuffer *writer = read_vio.get_writer();
+  int64_t moved = 0;
+
+  if (response_header_ready && !response_header_sent) {
+    http2_convert_header_from_2_to_1_1(&response_header);
+
+    // Write header to a buffer, as Http2Stream does for the request of a client.
+    int bufindex;
+    int dumpoffset = 0;
+    int done, tmp;
+    IOBufferBlock *block;
+    do {
+      bufindex = 0;
+      tmp = dumpoffset;
+      block = writer->get_current_block();
+      if (!block || block->write_avail() == 0) {
+        writer->add_block();
+        block = writer->get_current_block();
+      }
+      done = response_header.print(block->end(), block->write_avail(), &bufindex, &tmp);
+      dumpoffset += bufindex;
+      writer->fill(bufindex);
+      if (!done) {
+        writer->add_block();
+      }
+    } while (!done);
+
+    moved += dumpoffset;
+    response_header_sent = true;
+  }
+
+  if (response_header_sent) {
+    int64_t room = std::max(writer->water_mark, HTTP2_STREAM_BODY_BUFFER_SIZE) - writer->max_read_avail();
+    int64_t nbytes = std::min(std::min(read_vio.ntodo() - moved, recv_reader->read_avail()), room);
+
+    if (nbytes > 0) {
+      writer->write(recv_reader, nbytes);
+      recv_reader->consume(nbytes);
+      moved += nbytes;
+      if (ssn) {
+        ssn->update_window(this);
+      }
+    }
+  }
+
+  bool drained = !recv_reader->is_read_avail_more_than(0);
+  if (moved > 0) {
+    read_vio.ndone += moved;
+    if (read_vio.ntodo() <= 0) {
+      return VC_EVENT_READ_COMPLETE;
+    }
+    // Come back for the end of the response
+    if (drained && (recv_end || error_event != VC_EVENT_NONE)) {
+      signal();
+    }
+    return VC_EVENT_READ_READY;
+  }
+
+  if (drained && response_header_sent && recv_end) {
+    return VC_EVENT_EOS;
+  }
+  if (drained && error_event != VC_EVENT_NONE) {
+    return error_event;
+  }
+  return VC_EVENT_CONT;
+}
+
+VIO *
+Http2ServerStream::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
+{
+  if (buf) {
+    read_vio.buffer.writer_for(buf);
+  } else {
+    read_vio.buffer.clear();
+  }
+
+  read_vio.mutex = c ? c->mutex : this->mutex;
+  read_vio._cont = c;
+  read_vio.nbytes = nbytes;
+  read_vio.ndone = 0;
+  read_vio.vc_server = this;
+  read_vio.op = VIO::READ;
+
+  if (c && nbytes > 0) {
+    signal();
+  }
+  return &read_vio;
+}
+
+VIO *
+Http2ServerStream::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *abuffer, bool owner)
+{
+  ink_assert(!owner);
+
+  if (abuffer) {
+    write_vio.buffer.reader_for(abuffer);
+  } else {
+    write_vio.buffer.clear();
+  }
+
+  write_vio.mutex = c ? c->mutex : this->mutex;
+  write_vio._cont = c;
+  write_vio.nbytes = nbytes;
+  write_vio.ndone = 0;
+  write_vio.vc_server = this;
+  write_vio.op = VIO::WRITE;
+
+  if (c && nbytes > 0) {
+    signal();
+  }
+  return &write_vio;
+}
+
+void
+Http2ServerStream::do_io_close(int /* lerrno ATS_UNUSED */)
+{
+  if (closed) {
+    return;
+  }
+
+  DebugHttp2Stream("stream close");
+  closed = true;
+  clear_timers();
+  read_vio._cont = NULL;
+  write_vio._cont = NULL;
+
+  if (!release_session()) {
+    signal();
+    return;
+  }
+  if (reentrancy_count == 0 && event_pending == 0) {
+    destroy();
+  }
+}
+
+// Take a closed stream off the connection, returns false if the connection is busy on another thread.
+bool
+Http2ServerStream::release_session()
+{
+  MUTEX_TRY_LOCK(lock, session_mutex, this_ethread());
+  if (!lock.is_locked()) {
+    return false;
+  }
+  if (session) {
+    // Cancel the stream unless the origin server is done with it
+    session->close_stream(this, request_state != REQUEST_DONE || !recv_end);
+    session = NULL;
+  }
+  return true;
+}
+
+void
+Http2ServerStream::do_io_shutdown(ShutdownHowTo_t howto)
+{
+  if (howto == IO_SHUTDOWN_READ || howto == IO_SHUTDOWN_READWRITE) {
+    read_vio.buffer.clear();
+    read_vio.nbytes = read_vio.ndone;
+  }
+  if (howto == IO_SHUTDOWN_WRITE || howto == IO_SHUTDOWN_READWRITE) {
+    write_vio.buffer.clear();
+    write_vio.nbytes = write_vio.ndone;
+  }
+}
+
+void
+Http2ServerStream::reenable(VIO * /* vio ATS_UNUSED */)
+{
+  signal();
+}
+
+void
+Http2ServerStream::reenable_re(VIO *vio)
+{
+  reenable(vio);
+}
+
+void
+Http2ServerStream::set_active_timeout(ink_hrtime timeout_in)
+{
+  active_timeout = timeout_in;
+  cancel_active_timeout();
+  if (active_timeout > 0) {
+    active_event = this_ethread()->schedule_in(this, active_timeout);
+  }
+}
+
+void
+Http2ServerStream::set_inactivity_timeout(ink_hrtime timeout_in)
+{
+  inactive_timeout = timeout_in;
+  if (inactive_timeout > 0) {
+    inactive_timeout_at = Thread::get_hrtime() + inactive_timeout;
+    if (!inactive_event) {
+      inactive_event = this_ethread()->schedule_every(this, HRTIME_SECONDS(1));
+    }
+  } else {
+    cancel_inactivity_timeout();
+  }
+}
+
+void
+Http2ServerStream::cancel_active_timeout()
+{
+  if (active_event) {
+    active_event->cancel();
+    active_event = NULL;
+  }
+}
+
+void
+Http2ServerStream::cancel_inactivity_timeout()
+{
+  inactive_timeout_at = 0;
+  if (inactive_event) {
+    inactive_event->cancel();
+    inactive_event = NULL;
+  }
+}
+
+void
+Http2ServerStream::clear_timers()
+{
+  cancel_active_timeout();
+  cancel_inactivity_timeout();
+}
+
+void
+Http2ServerStream::set_local_addr()
+{
+  ats_ip_copy(&local_addr, &client_addr);
+}
+
+void
+Http2ServerStream::set_remote_addr()
+{
+  ats_ip_copy(&remote_addr, &server_addr);
+}
+
+//
+// Http2ServerSession
+//
+
+Http2ServerSession::Http2ServerSession()
+  : server_vc(NULL), con_id(0), pool(NULL), fini_event(NULL), read_buffer(NULL), sm_reader(NULL), write_buffer(NULL),
+    sm_writer(NULL), write_vio(NULL), total_write_len(0), write_blocked(false), local_hpack_handle(NULL),
+    remote_hpack_handle(NULL), header_blocks(NULL), header_blocks_length(0), headers_end_stream(false), continued_streamid(0),
+    stream_count(0), latest_streamid(0), peer_rwnd(HTTP2_INITIAL_WINDOW_SIZE), local_rwnd(HTTP2_INITIAL_WINDOW_SIZE),
+    goaway(false), closed(false)
+{
+}
+
+void
+Http2ServerSession::new_connection(NetVConnection *new_vc, sockaddr const *addr, INK_MD5 const &host_hash)
+{
+  this->con_id = ink_atomic_increment(&next_ss_id, 1);
+  this->server_vc = new_vc;
+  this->mutex = new_ProxyMutex();
+  ats_ip_copy(&this->server_ip, addr);
+  this->hostname_hash = host_hash;
+
+  DebugHttp2Ssn("session born, netvc %p", this->server_vc);
+
+  // The proxy takes no pushes, and advertises the windows and frame size configured for clients.
+  this->local_settings.set(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, Http2::initial_window_size);
+  this->local_settings.set(HTTP2_SETTINGS_MAX_FRAME_SIZE, Http2::max_frame_size);
+
+  this->read_buffer = new_MIOBuffer(HTTP2_HEADER_BUFFER_SIZE_INDEX);
+  this->read_buffer->water_mark = this->local_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE);
+  this->sm_reader = this->read_buffer->alloc_reader();
+  this->write_buffer = new_MIOBuffer(HTTP2_HEADER_BUFFER_SIZE_INDEX);
+  this->sm_writer = this->write_buffer->alloc_reader();
+
+  this->local_hpack_handle = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
+  this->remote_hpack_handle = new HpackHandle(HTTP2_HEADER_TABLE_SIZE);
+}
+
+Http2ServerStream *
+Http2ServerSession::start(Http2ServerSessionPool *p, ProxyMutex *m)
+{
+  VIO *read_vio;
+  uint32_t initial_rwnd = this->local_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+
+  SCOPED_MUTEX_LOCK(lock, this->mutex, this_ethread());
+
+  SET_HANDLER(&Http2ServerSession::main_event_handler);
+  HTTP2_SET_SESSION_HANDLER(&Http2ServerSession::state_start_frame_read);
+
+  read_vio = this->server_vc->do_io_read(this, INT64_MAX, this->read_buffer);
+  this->write_vio = this->server_vc->do_io_write(this, INT64_MAX, this->sm_writer);
+
+  // [RFC 7540] 3.5. The client connection preface starts with the magic string, followed by a SETTINGS frame.
+  this->write_buffer->write(HTTP2_CONNECTION_PREFACE, HTTP2_CONNECTION_PREFACE_LEN);
+  this->total_write_len += HTTP2_CONNECTION_PREFACE_LEN;
+  this->send_settings_frame();
+
+  // The connection window is not set by SETTINGS, open it up to the stream window
+  if (initial_rwnd > HTTP2_INITIAL_WINDOW_SIZE) {
+    this->send_window_update_frame(0, initial_rwnd - HTTP2_INITIAL_WINDOW_SIZE);
+    this->local_rwnd = initial_rwnd;
+  }
+
+  Http2ServerStream *stream = this->new_stream(m);
+
+  this->pool = p;
+  this->pool->add(this);
+
+  if (this->sm_reader->is_read_avail_more_than(0)) {
+    this->handleEvent(VC_EVENT_READ_READY, read_vio);
+  }
+  return stream;
+}
+
+void
+Http2ServerSession::destroy()
+{
+  DebugHttp2Ssn("session destroy");
+  ink_release_assert(this->server_vc == NULL);
+
+  ats_free(this->header_blocks);
+  delete this->local_hpack_handle;
+  delete this->remote_hpack_handle;
+  free_MIOBuffer(this->read_buffer);
+  free_MIOBuffer(this->write_buffer);
+
+  this->mutex.clear();
+  THREAD_FREE(this, http2ServerSessionAllocator, this_ethread());
+}
+
+// Let go of the streams and the connection. The streams which have the whole response still deliver it.
+void
+Http2ServerSession::close(int event)
+{
+  if (this->closed) {
+    return;
+  }
+
+  DebugHttp2Ssn("session closed by %s", HttpDebugNames::get_event_name(event));
+  this->closed = true;
+
+  if (this->pool) {
+    this->pool->remove(this);
+    this->pool = NULL;
+  }
+  if (this->fini_event) {
+    this->fini_event->cancel();
+    this->fini_event = NULL;
+  }
+
+  while (this->streams.head) {
+    this->detach_stream(this->streams.head, VC_EVENT_ERROR);
+  }
+
+  this->server_vc->do_io_close();
+  this->server_vc = NULL;
+  this->destroy();
+}
+
+bool
+Http2ServerSession::is_available() const
+{
+  uint32_t max_streams =
+    std::min(this->peer_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS), Http2::max_concurrent_streams_out);
+
+  return !this->closed && !this->goaway && this->stream_count < max_streams;
+}
+
+Http2ServerStream *
+Http2ServerSession::new_stream(ProxyMutex *m)
+{
+  Http2ServerStream *stream = THREAD_ALLOC_INIT(http2ServerStreamAllocator, this_ethread());
+
+  stream->init(this, m);
+  stream->peer_rwnd = this->peer_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+  stream->local_rwnd = this->local_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+
+  this->streams.push(stream);
+  ++this->stream_count;
+  this->update_idle_timeout();
+
+  DebugHttp2Ssn("new stream, %u streams", this->stream_count);
+  return stream;
+}
+
+void
+Http2ServerSession::close_stream(Http2ServerStream *stream, bool reset)
+{
+  if (reset && stream->id != 0 && !this->closed) {
+    this->send_rst_stream_frame(stream->id, HTTP2_ERROR_CANCEL);
+  }
+  this->detach_stream(stream, VC_EVENT_NONE);
+
+  // Once the origin server is going away, the last stream closes the connection, on the thread of the connection
+  if (this->goaway && this->stream_count == 0 && !this->closed && this->fini_event == NULL) {
+    this->fini_event = this->server_vc->thread->schedule_imm(this, HTTP2_SESSION_EVENT_FINI);
+  }
+}
+
+void
+Http2ServerSession::detach_stream(Http2ServerStream *stream, int event)
+{
+  DebugHttp2SsnStream(stream->id, "detach stream");
+
+  if (event != VC_EVENT_NONE && !stream->recv_end && stream->error_event == VC_EVENT_NONE) {
+    stream->error_event = event;
+  }
+  this->streams.remove(stream);
+  --this->stream_count;
+  stream->session = NULL;
+  stream->signal();
+
+  this->update_idle_timeout();
+}
+
+Http2ServerStream *
+Http2ServerSession::find_stream(Http2StreamId id) const
+{
+  for (Http2ServerStream *s = this->streams.head; s; s = s->link.next) {
+    if (s->id == id) {
+      return s;
+    }
+  }
+  return NULL;
+}
+
+void
+Http2ServerSession::signal_streams()
+{
+  for (Http2ServerStream *s = this->streams.head; s; s = s->link.next) {
+    s->signal();
+  }
+}
+
+// The connection only times out when no stream is using it, the streams have the timeouts of their state machines.
+void
+Http2ServerSession::update_idle_timeout()
+{
+  if (this->closed) {
+    return;
+  }
+  if (this->stream_count == 0) {
+    this->server_vc->set_inactivity_timeout(HRTIME_SECONDS(Http2::no_activity_timeout_out));
+  } else {
+    this->server_vc->cancel_inactivity_timeout();
+  }
+}
+
+int
+Http2ServerSession::main_event_handler(int event, void *edata)
+{
+  ink_assert(this->mutex->thread_holding == this_ethread());
+
+  switch (event) {
+  case VC_EVENT_READ_COMPLETE:
+  case VC_EVENT_READ_READY:
+    return (this->*session_handler)(event, edata);
+
+  case VC_EVENT_WRITE_READY:
+  case VC_EVENT_WRITE_COMPLETE:
+    // Room in the write buffer, carry on with the DATA frames held back for it
+    if (this->write_blocked &&
+        (Http2::write_buffer_watermark == 0 || this->sm_writer->read_avail() <= Http2::write_buffer_watermark)) {
+      this->write_blocked = false;
+      this->signal_streams();
+    }
+    return 0;
+
+  case HTTP2_SESSION_EVENT_FINI:
+    this->fini_event = NULL;
+    if (this->stream_count == 0) {
+      this->close(event);
+    }
+    return 0;
+
+  case VC_EVENT_ACTIVE_TIMEOUT:
+  case VC_EVENT_INACTIVITY_TIMEOUT:
+  case VC_EVENT_ERROR:
+  case VC_EVENT_EOS:
+    this->close(event);
+    return 0;
+
+  default:
+    DebugHttp2Ssn("unexpected event=%d edata=%p", event, edata);
+    return 0;
+  }
+}
+
+int
+Http2ServerSession::state_start_frame_read(int /* event ATS_UNUSED */, void *edata)
+{
+  VIO *vio = (VIO *)edata;
+
+  if (this->sm_reader->read_avail() >= (int64_t)HTTP2_FRAME_HEADER_LEN) {
+    uint8_t buf[HTTP2_FRAME_HEADER_LEN];
+
+    this->sm_reader->memcpy(buf, sizeof(buf), 0);
+    if (!http2_parse_frame_header(make_iovec(buf), this->current_hdr)) {
+      DebugHttp2Ssn("frame header parse failure");
+      this->close(VC_EVENT_ERROR);
+      return 0;
+    }
+
+    DebugHttp2Ssn("frame header length=%u, type=%u, flags=0x%x, streamid=%u", (unsigned)this->current_hdr.length,
+                  (unsigned)this->current_hdr.type, (unsigned)this->current_hdr.flags, this->current_hdr.streamid);
+
+    this->sm_reader->consume(sizeof(buf));
+
+    const unsigned max_frame_size = this->local_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE);
+    Http2ErrorCode error = HTTP2_ERROR_NO_ERROR;
+
+    if (!http2_frame_header_is_valid(this->current_hdr, max_frame_size)) {
+      error = HTTP2_ERROR_PROTOCOL_ERROR;
+    } else if (this->current_hdr.length > max_frame_size) {
+      error = HTTP2_ERROR_FRAME_SIZE_ERROR;
+    } else if (this->current_hdr.streamid != 0 && !http2_is_client_streamid(this->current_hdr.streamid)) {
+      // The proxy opens every stream, and takes no pushes.
+      error = HTTP2_ERROR_PROTOCOL_ERROR;
+    } else if (this->continued_streamid != 0 && (this->continued_streamid != this->current_hdr.streamid ||
+                                                 this->current_hdr.type != HTTP2_FRAME_TYPE_CONTINUATION)) {
+      // CONTINUATIONs MUST follow behind HEADERS which doesn't have END_HEADERS
+      error = HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+
+    if (error != HTTP2_ERROR_NO_ERROR) {
+      this->send_goaway_frame(0, error);
+      this->close(VC_EVENT_ERROR);
+      return 0;
+    }
+
+    HTTP2_SET_SESSION_HANDLER(&Http2ServerSession::state_complete_frame_read);
+    if (this->sm_reader->read_avail() >= this->current_hdr.length) {
+      return this->handleEvent(VC_EVENT_READ_READY, vio);
+    }
+  }
+
+  vio->reenable();
+  return 0;
+}
+
+int
+Http2ServerSession::state_complete_frame_read(int /* event ATS_UNUSED */, void *edata)
+{
+  VIO *vio = (VIO *)edata;
+
+  if (this->sm_reader->read_avail() < this->current_hdr.length) {
+    vio->reenable();
+    return 0;
+  }
+
+  Http2Frame frame(this->current_hdr, this->sm_reader);
+  Http2Error error = this->recv_frame(frame);
+  this->sm_reader->consume(this->current_hdr.length);
+
+  if (error.cls == HTTP2_ERROR_CLASS_CONNECTION) {
+    this->send_goaway_frame(0, error.code);
+    this->close(VC_EVENT_ERROR);
+    return 0;
+  } else if (error.cls == HTTP2_ERROR_CLASS_STREAM) {
+    this->send_rst_stream_frame(this->current_hdr.streamid, error.code);
+    Http2ServerStream *stream = this->find_stream(this->current_hdr.streamid);
+    if (stream) {
+      this->detach_stream(stream, VC_EVENT_ERROR);
+    }
+  }
+
+  if (this->goaway && this->stream_count == 0) {
+    this->close(VC_EVENT_EOS);
+    return 0;
+  }
+
+  HTTP2_SET_SESSION_HANDLER(&Http2ServerSession::state_start_frame_read);
+  if (this->sm_reader->is_read_avail_more_than(0)) {
+    return this->handleEvent(VC_EVENT_READ_READY, vio);
+  }
+
+  vio->reenable();
+  return 0;
+}
+
+Http2Error
+Http2ServerSession::recv_frame(const Http2Frame &frame)
+{
+  switch (frame.header().type) {
+  case HTTP2_FRAME_TYPE_DATA:
+    return this->rcv_data_frame(frame);
+  case HTTP2_FRAME_TYPE_HEADERS:
+    return this->rcv_headers_frame(frame);
+  case HTTP2_FRAME_TYPE_CONTINUATION:
+    return this->rcv_continuation_frame(frame);
+  case HTTP2_FRAME_TYPE_RST_STREAM:
+    return this->rcv_rst_stream_frame(frame);
+  case HTTP2_FRAME_TYPE_SETTINGS:
+    return this->rcv_settings_frame(frame);
+  case HTTP2_FRAME_TYPE_PING:
+    return this->rcv_ping_frame(frame);
+  case HTTP2_FRAME_TYPE_GOAWAY:
+    return this->rcv_goaway_frame(frame);
+  case HTTP2_FRAME_TYPE_WINDOW_UPDATE:
+    return this->rcv_window_update_frame(frame);
+  case HTTP2_FRAME_TYPE_PUSH_PROMISE:
+    // [RFC 7540] 8.2. Pushes were disabled by the SETTINGS of the proxy.
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  default:
+    // PRIORITY is advisory, and a client has nothing to prioritize for a server.
+    return Http2Error(HTTP2_ERROR_CLASS_NONE);
+  }
+}
+
+Http2Error
+Http2ServerSession::rcv_headers_frame(const Http2Frame &frame)
+{
+  const Http2StreamId stream_id = frame.header().streamid;
+  const uint32_t payload_length = frame.header().length;
+  uint32_t offset = 0;
+  uint32_t length = payload_length;
+
+  DebugHttp2SsnStream(stream_id, "Received HEADERS frame");
+
+  // Responses, and trailers, only come on the streams the proxy opened
+  if (stream_id == 0 || stream_id > this->latest_streamid) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  if (frame.header().flags & HTTP2_FLAGS_HEADERS_PADDED) {
+    Http2HeadersParameter params;
+    uint8_t buf[HTTP2_HEADERS_PADLEN_LEN] = {0};
+
+    frame.reader()->memcpy(buf, HTTP2_HEADERS_PADLEN_LEN);
+    if (!http2_parse_headers_parameter(make_iovec(buf, HTTP2_HEADERS_PADLEN_LEN), params) ||
+        HTTP2_HEADERS_PADLEN_LEN + params.pad_length > length) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    offset += HTTP2_HEADERS_PADLEN_LEN;
+    length -= HTTP2_HEADERS_PADLEN_LEN + params.pad_length;
+  }
+
+  if (frame.header().flags & HTTP2_FLAGS_HEADERS_PRIORITY) {
+    if (length < HTTP2_PRIORITY_LEN) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    offset += HTTP2_PRIORITY_LEN;
+    length -= HTTP2_PRIORITY_LEN;
+  }
+
+  if (length > Http2::max_request_header_size) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  ats_free(this->header_blocks);
+  this->header_blocks = static_cast<uint8_t *>(ats_malloc(length));
+  frame.reader()->memcpy(this->header_blocks, length, offset);
+  this->header_blocks_length = length;
+  this->headers_end_stream = frame.header().flags & HTTP2_FLAGS_HEADERS_END_STREAM;
+
+  if (frame.header().flags & HTTP2_FLAGS_HEADERS_END_HEADERS) {
+    return this->decode_header_blocks(this->find_stream(stream_id));
+  }
+
+  DebugHttp2SsnStream(stream_id, "No END_HEADERS flag, expecting CONTINUATION frame");
+  this->continued_streamid = stream_id;
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_continuation_frame(const Http2Frame &frame)
+{
+  const Http2StreamId stream_id = frame.header().streamid;
+  const uint32_t payload_length = frame.header().length;
+
+  DebugHttp2SsnStream(stream_id, "Received CONTINUATION frame");
+
+  if (this->continued_streamid == 0) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (this->header_blocks_length + payload_length > Http2::max_request_header_size) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  uint32_t header_blocks_offset = this->header_blocks_length;
+  this->header_blocks_length += payload_length;
+  this->header_blocks = static_cast<uint8_t *>(ats_realloc(this->header_blocks, this->header_blocks_length));
+  frame.reader()->memcpy(this->header_blocks + header_blocks_offset, payload_length);
+
+  if (frame.header().flags & HTTP2_FLAGS_CONTINUATION_END_HEADERS) {
+    this->continued_streamid = 0;
+    return this->decode_header_blocks(this->find_stream(stream_id));
+  }
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+// Decode the header block just received for @a stream. A block is decoded even when there is no stream for it any
+// more, or it has trailers nobody wants, to keep the HPACK dynamic table in step with the server.
+Http2Error
+Http2ServerSession::decode_header_blocks(Http2ServerStream *stream)
+{
+  HTTPHdr scratch;
+  HTTPHdr *hdr = &scratch;
+  bool trailers = stream != NULL && stream->response_header_ready;
+  bool trailing_header = trailers;
+  bool end_stream = this->headers_end_stream;
+
+  if (stream != NULL && !trailers) {
+    hdr = &stream->response_header;
+  } else {
+    scratch.create(HTTP_TYPE_RESPONSE);
+  }
+
+  Http2ErrorCode result = http2_decode_header_blocks(hdr, this->header_blocks, this->header_blocks_length, NULL,
+                                                     *this->local_hpack_handle, trailing_header);
+
+  if (hdr == &scratch) {
+    scratch.destroy();
+  }
+  ats_free(this->header_blocks);
+  this->header_blocks = NULL;
+  this->header_blocks_length = 0;
+  this->headers_end_stream = false;
+
+  if (result == HTTP2_ERROR_COMPRESSION_ERROR) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_COMPRESSION_ERROR);
+  }
+  if (stream == NULL) {
+    return Http2Error(HTTP2_ERROR_CLASS_NONE);
+  }
+  if (result != HTTP2_ERROR_NO_ERROR || (trailers && !end_stream)) {
+    return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  if (!trailers) {
+    // An interim response is followed by the final one on the same stream
+    int len = 0;
+    const MIMEField *field = stream->response_header.field_find(":status", countof(":status") - 1);
+    const char *status = field->value_get(&len);
+    if (len > 0 && status[0] == '1') {
+      if (end_stream) {
+        return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_PROTOCOL_ERROR);
+      }
+      stream->response_header.destroy();
+      stream->response_header.create(HTTP_TYPE_RESPONSE);
+      return Http2Error(HTTP2_ERROR_CLASS_NONE);
+    }
+    stream->response_header_ready = true;
+  }
+
+  // Trailers are dropped, there is nowhere to put them in the HTTP/1.1 response without chunking it.
+  if (end_stream) {
+    stream->recv_end = true;
+  }
+  stream->signal();
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_data_frame(const Http2Frame &frame)
+{
+  const Http2StreamId stream_id = frame.header().streamid;
+  const uint32_t payload_length = frame.header().length;
+  uint32_t offset = 0;
+  uint8_t pad_length = 0;
+
+  DebugHttp2SsnStream(stream_id, "Received DATA frame");
+
+  if (stream_id == 0 || stream_id > this->latest_streamid) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  if (frame.header().flags & HTTP2_FLAGS_DATA_PADDED) {
+    if (payload_length < HTTP2_DATA_PADLEN_LEN) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    frame.reader()->memcpy(&pad_length, HTTP2_DATA_PADLEN_LEN, 0);
+    offset = HTTP2_DATA_PADLEN_LEN;
+    if (offset + pad_length > payload_length) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+  }
+
+  // The whole frame counts against the windows, padding included. The connection window is opened again right
+  // away, the streams bound what is buffered.
+  if (this->local_rwnd < (Http2WindowSize)payload_length) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FLOW_CONTROL_ERROR);
+  }
+  this->local_rwnd -= payload_length;
+
+  uint32_t initial_rwnd =
+    std::max(this->local_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE), (unsigned)HTTP2_INITIAL_WINDOW_SIZE);
+  uint32_t min_rwnd = std::min(initial_rwnd, this->local_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE));
+  if (this->local_rwnd <= (Http2WindowSize)min_rwnd) {
+    Http2WindowSize diff_size = initial_rwnd - this->local_rwnd;
+    this->local_rwnd += diff_size;
+    this->send_window_update_frame(0, diff_size);
+  }
+
+  // The stream was cancelled by the proxy
+  Http2ServerStream *stream = this->find_stream(stream_id);
+  if (stream == NULL) {
+    return Http2Error(HTTP2_ERROR_CLASS_NONE);
+  }
+
+  if (!stream->response_header_ready) {
+    return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (stream->recv_end) {
+    return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_STREAM_CLOSED);
+  }
+  if (stream->local_rwnd < (Http2WindowSize)payload_length) {
+    return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_FLOW_CONTROL_ERROR);
+  }
+  stream->local_rwnd -= payload_length;
+
+  const uint32_t data_length = payload_length - offset - pad_length;
+  if (data_length > 0) {
+    IOBufferReader *reader = frame.reader()->clone();
+    reader->consume(offset);
+    stream->recv_buffer->write(reader, data_length);
+    reader->dealloc();
+  }
+
+  if (frame.header().flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    stream->recv_end = true;
+  }
+
+  this->update_window(stream);
+  stream->signal();
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_rst_stream_frame(const Http2Frame &frame)
+{
+  Http2RstStream rst_stream;
+  char buf[HTTP2_RST_STREAM_LEN];
+  char *end;
+  const Http2StreamId stream_id = frame.header().streamid;
+
+  DebugHttp2SsnStream(stream_id, "Received RST_STREAM frame");
+
+  if (stream_id == 0 || stream_id > this->latest_streamid) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (frame.header().length != HTTP2_RST_STREAM_LEN) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+  }
+
+  end = frame.reader()->memcpy(buf, sizeof(buf), 0);
+  if (!http2_parse_rst_stream(make_iovec(buf, end - buf), rst_stream)) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  Http2ServerStream *stream = this->find_stream(stream_id);
+  if (stream != NULL) {
+    DebugHttp2SsnStream(stream_id, "RST_STREAM: Error Code: %u", rst_stream.error_code);
+    this->detach_stream(stream, VC_EVENT_ERROR);
+  }
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_settings_frame(const Http2Frame &frame)
+{
+  Http2SettingsParameter param;
+  char buf[HTTP2_SETTINGS_PARAMETER_LEN];
+  uint32_t nbytes = 0;
+
+  DebugHttp2SsnStream(frame.header().streamid, "Received SETTINGS frame");
+
+  if (frame.header().streamid != 0) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (frame.header().flags & HTTP2_FLAGS_SETTINGS_ACK) {
+    if (frame.header().length != 0) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+    }
+    return Http2Error(HTTP2_ERROR_CLASS_NONE);
+  }
+  if (frame.header().length % HTTP2_SETTINGS_PARAMETER_LEN != 0) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+  }
+
+  while (nbytes < frame.header().length) {
+    char *end = frame.reader()->memcpy(buf, sizeof(buf), nbytes);
+    nbytes += end - buf;
+
+    if (!http2_parse_settings_parameter(make_iovec(buf, end - buf), param)) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    if (!http2_settings_parameter_is_valid(param)) {
+      if (param.id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE) {
+        return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FLOW_CONTROL_ERROR);
+      } else {
+        return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+      }
+    }
+
+    DebugHttp2Ssn("   %s : %u", Http2DebugNames::get_settings_param_name(param.id), param.value);
+
+    // [RFC 7540] 6.9.2. The windows of the open streams move by the change of SETTINGS_INITIAL_WINDOW_SIZE
+    if (param.id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE) {
+      Http2WindowSize delta = param.value - this->peer_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+      for (Http2ServerStream *s = this->streams.head; s; s = s->link.next) {
+        s->peer_rwnd += delta;
+      }
+    }
+    if (param.id < HTTP2_SETTINGS_MAX) {
+      this->peer_settings.set((Http2SettingsIdentifier)param.id, param.value);
+    }
+  }
+
+  Http2Frame ack_frame(HTTP2_FRAME_TYPE_SETTINGS, 0, HTTP2_FLAGS_SETTINGS_ACK);
+  this->xmit(ack_frame);
+  this->signal_streams();
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_ping_frame(const Http2Frame &frame)
+{
+  uint8_t opaque_data[HTTP2_PING_LEN];
+
+  DebugHttp2SsnStream(frame.header().streamid, "Received PING frame");
+
+  if (frame.header().streamid != 0) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (frame.header().length != HTTP2_PING_LEN) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+  }
+  if (frame.header().flags & HTTP2_FLAGS_PING_ACK) {
+    return Http2Error(HTTP2_ERROR_CLASS_NONE);
+  }
+
+  frame.reader()->memcpy(opaque_data, HTTP2_PING_LEN, 0);
+
+  Http2Frame ping(HTTP2_FRAME_TYPE_PING, 0, HTTP2_FLAGS_PING_ACK);
+  ping.alloc(HTTP2_CONTROL_FRAME_SIZE_INDEX);
+  http2_write_ping(opaque_data, ping.write());
+  ping.finalize(HTTP2_PING_LEN);
+  this->xmit(ping);
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+// The origin server takes no more streams. The ones it did not get to fail, so their state machines can retry them.
+Http2Error
+Http2ServerSession::rcv_goaway_frame(const Http2Frame &frame)
+{
+  Http2Goaway goaway_frame;
+  char buf[HTTP2_GOAWAY_LEN];
+
+  DebugHttp2SsnStream(frame.header().streamid, "Received GOAWAY frame");
+
+  if (frame.header().streamid != 0) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+  if (frame.header().length < HTTP2_GOAWAY_LEN) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+  }
+
+  frame.reader()->memcpy(buf, sizeof(buf), 0);
+  if (!http2_parse_goaway(make_iovec(buf, sizeof(buf)), goaway_frame)) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+  }
+
+  DebugHttp2Ssn("GOAWAY: last stream id=%d, error code=%d", goaway_frame.last_streamid, goaway_frame.error_code);
+
+  this->goaway = true;
+  if (this->pool) {
+    this->pool->remove(this);
+    this->pool = NULL;
+  }
+
+  Http2ServerStream *next;
+  for (Http2ServerStream *s = this->streams.head; s; s = next) {
+    next = s->link.next;
+    if (s->id == 0 || s->id > goaway_frame.last_streamid) {
+      this->detach_stream(s, VC_EVENT_ERROR);
+    }
+  }
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+Http2Error
+Http2ServerSession::rcv_window_update_frame(const Http2Frame &frame)
+{
+  char buf[HTTP2_WINDOW_UPDATE_LEN];
+  uint32_t size;
+  const Http2StreamId sid = frame.header().streamid;
+
+  if (frame.header().length != HTTP2_WINDOW_UPDATE_LEN) {
+    return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FRAME_SIZE_ERROR);
+  }
+
+  frame.reader()->memcpy(buf, sizeof(buf), 0);
+  http2_parse_window_update(make_iovec(buf, sizeof(buf)), size);
+
+  DebugHttp2SsnStream(sid, "Received WINDOW_UPDATE frame - delta: %u", size);
+
+  if (sid == 0) {
+    if (size == 0) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    if (size > (uint32_t)(HTTP2_MAX_WINDOW_SIZE - this->peer_rwnd)) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_FLOW_CONTROL_ERROR);
+    }
+    this->peer_rwnd += size;
+    this->signal_streams();
+  } else {
+    if (sid > this->latest_streamid) {
+      return Http2Error(HTTP2_ERROR_CLASS_CONNECTION, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    Http2ServerStream *stream = this->find_stream(sid);
+    if (stream == NULL) {
+      return Http2Error(HTTP2_ERROR_CLASS_NONE);
+    }
+    if (size == 0) {
+      return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_PROTOCOL_ERROR);
+    }
+    if (size > (uint32_t)(HTTP2_MAX_WINDOW_SIZE - stream->peer_rwnd)) {
+      return Http2Error(HTTP2_ERROR_CLASS_STREAM, HTTP2_ERROR_FLOW_CONTROL_ERROR);
+    }
+    stream->peer_rwnd += size;
+    stream->signal();
+  }
+
+  return Http2Error(HTTP2_ERROR_CLASS_NONE);
+}
+
+void
+Http2ServerSession::xmit(Http2Frame &frame)
+{
+  this->total_write_len += frame.size();
+  this->write_vio->nbytes = this->total_write_len;
+  frame.xmit(this->write_buffer);
+  this->write_vio->reenable();
+}
+
+// Give @a stream the next stream id and send @a hdr on it, as a HEADERS frame and any CONTINUATION frames it needs.
+bool
+Http2ServerSession::send_headers(Http2ServerStream *stream, HTTPHdr *hdr, bool end_stream)
+{
+  uint32_t header_blocks_size = 0;
+  uint32_t payload_length = 0;
+  uint32_t sent = 0;
+  uint8_t flags = end_stream ? HTTP2_FLAGS_HEADERS_END_STREAM : 0;
+  const uint32_t max_payload_length = BUFFER_SIZE_FOR_INDEX(HTTP2_FRAME_SIZE_INDEX) - HTTP2_FRAME_HEADER_LEN;
+
+  if (this->closed || this->goaway || this->latest_streamid >= HTTP2_MAX_WINDOW_SIZE - 2) {
+    return false;
+  }
+
+  HTTPHdr h2_hdr;
+  http2_generate_h2_header_from_1_1(hdr, &h2_hdr);
+
+  uint32_t buf_len = hdr->length_get() * 2; // Make it double just in case
+  uint8_t *buf = (uint8_t *)ats_malloc(buf_len);
+  Http2ErrorCode result = http2_encode_header_blocks(&h2_hdr, buf, buf_len, &header_blocks_size, *this->remote_hpack_handle);
+  h2_hdr.destroy();
+  if (result != HTTP2_ERROR_NO_ERROR) {
+    ats_free(buf);
+    return false;
+  }
+
+  // [RFC 7540] 5.1.1. Streams are opened in increasing order, so the id goes with the first frame sent on the stream.
+  this->latest_streamid = this->latest_streamid == 0 ? 1 : this->latest_streamid + 2;
+  stream->id = this->latest_streamid;
+  DebugHttp2SsnStream(stream->id, "Send HEADERS frame");
+
+  if (header_blocks_size <= max_payload_length) {
+    payload_length = header_blocks_size;
+    flags |= HTTP2_FLAGS_HEADERS_END_HEADERS;
+  } else {
+    payload_length = max_payload_length;
+  }
+  Http2Frame headers(HTTP2_FRAME_TYPE_HEADERS, stream->id, flags);
+  headers.alloc(HTTP2_FRAME_SIZE_INDEX);
+  http2_write_headers(buf, payload_length, headers.write());
+  headers.finalize(payload_length);
+  this->xmit(headers);
+  sent += payload_length;
+
+  while (sent < header_blocks_size) {
+    DebugHttp2SsnStream(stream->id, "Send CONTINUATION frame");
+    payload_length = std::min(max_payload_length, header_blocks_size - sent);
+    flags = sent + payload_length == header_blocks_size ? HTTP2_FLAGS_CONTINUATION_END_HEADERS : 0;
+    Http2Frame continuation(HTTP2_FRAME_TYPE_CONTINUATION, stream->id, flags);
+    continuation.alloc(HTTP2_FRAME_SIZE_INDEX);
+    http2_write_headers(buf + sent, payload_length, continuation.write());
+    continuation.finalize(payload_length);
+    this->xmit(continuation);
+    sent += payload_length;
+  }
+
+  ats_free(buf);
+  return true;
+}
+
+// Send what @a reader has for @a stream as DATA frames, as far as the windows of the origin server and the write
+// buffer watermark allow. Return true if all of it went, with END_STREAM if @a end_stream.
+bool
+Http2ServerSession::send_data(Http2ServerStream *stream, IOBufferReader *reader, bool end_stream)
+{
+  const int64_t max_payload_length = BUFFER_SIZE_FOR_INDEX(HTTP2_FRAME_SIZE_INDEX) - HTTP2_FRAME_HEADER_LEN;
+
+  while (!this->closed) {
+    int64_t avail = reader->read_avail();
+    if (avail == 0 && !end_stream) {
+      return true;
+    }
+    if (Http2::write_buffer_watermark > 0 && this->sm_writer->read_avail() > Http2::write_buffer_watermark) {
+      this->write_blocked = true;
+      return false;
+    }
+
+    int64_t window = std::min(this->peer_rwnd, stream->peer_rwnd);
+    if (avail > 0 && window <= 0) {
+      return false;
+    }
+
+    int64_t payload_length = std::min(std::min(avail, max_payload_length), std::max(window, (int64_t)0));
+    uint8_t flags = end_stream && payload_length == avail ? HTTP2_FLAGS_DATA_END_STREAM : 0;
+
+    Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->id, flags);
+    data.alloc(HTTP2_FRAME_SIZE_INDEX);
+    payload_length = reader->read(data.write().iov_base, payload_length);
+    data.finalize(payload_length);
+    this->peer_rwnd -= payload_length;
+    stream->peer_rwnd -= payload_length;
+
+    DebugHttp2SsnStream(stream->id, "Send DATA frame - server window con: %d stream: %d payload: %" PRId64, this->peer_rwnd,
+                        stream->peer_rwnd, payload_length);
+    this->xmit(data);
+
+    if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Open the window of @a stream again as the state machine takes the response, keeping what the stream holds and what
+// the origin server may still send within the initial window.
+void
+Http2ServerSession::update_window(Http2ServerStream *stream)
+{
+  if (stream->recv_end || this->closed) {
+    return;
+  }
+
+  uint32_t initial_rwnd = this->local_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
+  uint32_t min_rwnd = std::min(initial_rwnd, this->local_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE));
+
+  if (stream->local_rwnd <= (Http2WindowSize)min_rwnd) {
+    int64_t diff_size = initial_rwnd - stream->recv_reader->read_avail() - stream->local_rwnd;
+    if (diff_size > 0) {
+      stream->local_rwnd += diff_size;
+      this->send_window_update_frame(stream->id, diff_size);
+    }
+  }
+}
+
+void
+Http2ServerSession::send_settings_frame()
+{
+  const Http2SettingsParameter params[] = {
+    {HTTP2_SETTINGS_ENABLE_PUSH, 0},
+    {HTTP2_SETTINGS_INITIAL_WINDOW_SIZE, this->local_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE)},
+    {HTTP2_SETTINGS_MAX_FRAME_SIZE, this->local_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE)},
+  };
+
+  DebugHttp2Ssn("Send SETTINGS frame");
+
+  Http2Frame settings(HTTP2_FRAME_TYPE_SETTINGS, 0, 0);
+  settings.alloc(HTTP2_CONTROL_FRAME_SIZE_INDEX);
+
+  IOVec iov = settings.write();
+  uint32_t settings_length = 0;
+  for (unsigned i = 0; i < countof(params); ++i) {
+    http2_write_settings(params[i], iov);
+    iov.iov_base = reinterpret_cast<uint8_t *>(iov.iov_base) + HTTP2_SETTINGS_PARAMETER_LEN;
+    iov.iov_len -= HTTP2_SETTINGS_PARAMETER_LEN;
+    settings_length += HTTP2_SETTINGS_PARAMETER_LEN;
+  }
+
+  settings.finalize(settings_length);
+  this->xmit(settings);
+}
+
+void
+Http2ServerSession::send_window_update_frame(Http2StreamId id, uint32_t size)
+{
+  DebugHttp2SsnStream(id, "Send WINDOW_UPDATE frame - delta: %u", size);
+
+  Http2Frame window_update(HTTP2_FRAME_TYPE_WINDOW_UPDATE, id, 0x0);
+  window_update.alloc(HTTP2_CONTROL_FRAME_SIZE_INDEX);
+  http2_write_window_update(size, window_update.write());
+  window_update.finalize(sizeof(uint32_t));
+  this->xmit(window_update);
+}
+
+void
+Http2ServerSession::send_rst_stream_frame(Http2StreamId id, Http2ErrorCode ec)
+{
+  DebugHttp2SsnStream(id, "Send RST_STREAM frame");
+
+  if (ec != HTTP2_ERROR_NO_ERROR && ec != HTTP2_ERROR_CANCEL) {
+    HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_STREAM_ERRORS_COUNT, this_ethread());
+  }
+
+  Http2Frame rst_stream(HTTP2_FRAME_TYPE_RST_STREAM, id, 0);
+  rst_stream.alloc(HTTP2_CONTROL_FRAME_SIZE_INDEX);
+  http2_write_rst_stream(static_cast<uint32_t>(ec), rst_stream.write());
+  rst_stream.finalize(HTTP2_RST_STREAM_LEN);
+  this->xmit(rst_stream);
+}
+
+void
+Http2ServerSession::send_goaway_frame(Http2StreamId id, Http2ErrorCode ec)
+{
+  Http2Goaway goaway_frame;
+
+  DebugHttp2Ssn("Send GOAWAY frame");
+
+  if (ec != HTTP2_ERROR_NO_ERROR) {
+    HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_CONNECTION_ERRORS_COUNT, this_ethread());
+  }
+
+  goaway_frame.last_streamid = id;
+  goaway_frame.error_code = ec;
+
+  Http2Frame frame(HTTP2_FRAME_TYPE_GOAWAY, 0, 0);
+  frame.alloc(HTTP2_CONTROL_FRAME_SIZE_INDEX);
+  http2_write_goaway(goaway_frame, frame.write());
+  frame.finalize(HTTP2_GOAWAY_LEN);
+  this->xmit(frame);
+}
+
+//
+// Http2ServerSessionPool
+//
+
+Http2ServerSessionPool::Http2ServerSessionPool() : mutex(new_ProxyMutex()), m_ip_pool(1023)
+{
+  m_ip_pool.setExpansionPolicy(IPHashTable::MANUAL);
+}
+
+// Take a stream on a connection to @a addr which was made for the host with @a host_hash, for the state machine with
+// the mutex @a m. If there is none, @a retry is set when one may turn up shortly: the pool or a connection was busy on
+// another thread, or, with @a wait_for_handshake, a connection to the origin server is still in its handshake.
+Http2ServerStream *
+Http2ServerSessionPool::acquire_stream(sockaddr const *addr, INK_MD5 const &host_hash, ProxyMutex *m, bool wait_for_handshake,
+                                       bool &retry)
+{
+  EThread *ethread = this_ethread();
+
+  retry = false;
+  MUTEX_TRY_LOCK(lock, mutex, ethread);
+  if (!lock.is_locked()) {
+    retry = true;
+    return NULL;
+  }
+
+  for (IPHashTable::Location loc = m_ip_pool.find(addr); loc.isValid(); ++loc) {
+    Http2ServerSession *ssn = loc;
+    if (ssn->hostname_hash != host_hash) {
+      continue;
+    }
+    MUTEX_TRY_LOCK(ssn_lock, ssn->mutex, ethread);
+    if (!ssn_lock.is_locked()) {
+      retry = true;
+    } else if (ssn->is_available()) {
+      return ssn->new_stream(m);
+    }
+  }
+
+  if (wait_for_handshake && this->handshake_pending(addr, host_hash)) {
+    retry = true;
+  }
+  return NULL;
+}
+
+// Call @a cont back with EVENT_INTERVAL, on this thread, once a stream to @a addr for the host with @a host_hash may be
+// available: when a handshake to the origin server ends or expires, a connection to it is added, or at @a wait_until.
+// Unless a handshake is pending it is called back right away, as after acquire_stream() missed a lock.
+Action *
+Http2ServerSessionPool::wait_for_stream(sockaddr const *addr, INK_MD5 const &host_hash, Continuation *cont, ink_hrtime wait_until)
+{
+  EThread *ethread = this_ethread();
+  MUTEX_TRY_LOCK(lock, mutex, ethread);
+  Handshake *h = lock.is_locked() ? this->handshake_pending(addr, host_hash) : NULL;
+
+  if (h == NULL) {
+    return ethread->schedule_in(cont, HRTIME_MSECONDS(1));
+  }
+
+  Waiter *w = new Waiter(this, cont);
+  ats_ip_copy(&w->addr, addr);
+  w->host_hash = host_hash;
+  w->timeout = ethread->schedule_at(w, MIN(wait_until, h->expire_at));
+  w->queued = true;
+  m_waiters.push(w);
+  return &w->action;
+}
+
+void
+Http2ServerSessionPool::add(Http2ServerSession *ssn)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  m_ip_pool.insert(ssn);
+  this->wake_waiters(&ssn->server_ip.sa, ssn->hostname_hash);
+}
+
+void
+Http2ServerSessionPool::remove(Http2ServerSession *ssn)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  m_ip_pool.remove(m_ip_pool.find(ssn));
+}
+
+// A connection which offered HTTP/2 to @a addr is being opened, it ends with end_handshake() or after @a timeout.
+void
+Http2ServerSessionPool::begin_handshake(sockaddr const *addr, INK_MD5 const &host_hash, ink_hrtime timeout)
+{
+  Handshake *h = new Handshake;
+
+  ats_ip_copy(&h->addr, addr);
+  h->host_hash = host_hash;
+  h->expire_at = Thread::get_hrtime() + timeout;
+
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  m_handshakes.push(h);
+}
+
+void
+Http2ServerSessionPool::end_handshake(sockaddr const *addr, INK_MD5 const &host_hash)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread());
+  for (Handshake *h = m_handshakes.head; h; h = h->link.next) {
+    if (h->host_hash == host_hash && ats_ip_addr_port_eq(&h->addr.sa, addr)) {
+      m_handshakes.remove(h);
+      this->wake_waiters(&h->addr.sa, h->host_hash);
+      delete h;
+      return;
+    }
+  }
+}
+
+// Called with the pool mutex held. Handshakes past their time are dropped on the way, and their waiters woken.
+Http2ServerSessionPool::Handshake *
+Http2ServerSessionPool::handshake_pending(sockaddr const *addr, INK_MD5 const &host_hash)
+{
+  ink_hrtime now = Thread::get_hrtime();
+  Handshake *next;
+  Handshake *pending = NULL;
+
+  for (Handshake *h = m_handshakes.head; h; h = next) {
+    next = h->link.next;
+    if (h->expire_at <= now) {
+      m_handshakes.remove(h);
+      this->wake_waiters(&h->addr.sa, h->host_hash);
+      delete h;
+    } else if (pending == NULL && h->host_hash == host_hash && ats_ip_addr_port_eq(&h->addr.sa, addr)) {
+      pending = h;
+    }
+  }
+  return pending;
+}
+
+// Called with the pool mutex held.
+void
+Http2ServerSessionPool::wake_waiters(sockaddr const *addr, INK_MD5 const &host_hash)
+{
+  Waiter *next;
+
+  for (Waiter *w = m_waiters.head; w; w = next) {
+    next = w->link.next;
+    if (w->host_hash == host_hash && ats_ip_addr_port_eq(&w->addr.sa, addr)) {
+      m_waiters.remove(w);
+      w->queued = false;
+      w->thread->schedule_imm(w);
+    }
+  }
+}
+
+Http2ServerSessionPool::Waiter::Waiter(Http2ServerSessionPool *p, Continuation *cont)
+  : Continuation(cont->mutex), pool(p), thread(this_ethread()), timeout(NULL), queued(false)
+{
+  action = cont;
+  SET_HANDLER(&Http2ServerSessionPool::Waiter::main_event);
+}
+
+// Woken by the pool, or at the end of the wait. Either way the waiter leaves the pool before its request is called.
+int
+Http2ServerSessionPool::Waiter::main_event(int /* event ATS_UNUSED */, Event *e)
+{
+  if (e == timeout) {
+    MUTEX_TRY_LOCK(lock, pool->mutex, e->ethread);
+    if (!lock.is_locked()) {
+      timeout = e->ethread->schedule_in(this, HRTIME_MSECONDS(1));
+      return EVENT_DONE;
+    }
+    timeout = NULL;
+    if (!queued) {
+      return EVENT_DONE; // Woken by the pool at the same time, that event is on its way
+    }
+    pool->m_waiters.remove(this);
+    queued = false;
+  } else if (timeout) {
+    timeout->cancel();
+  }
+
+  if (!action.cancelled) {
+    action.continuation->handleEvent(EVENT_INTERVAL, NULL);
+  }
+  delete this;
+  return EVENT_DONE;
+}
+
+#if TS_HAS_TESTS
+
+#include "ts/TestBox.h"
+
+// Sessions on connections which are never opened, which is all the pool looks at.
+struct Http2ServerSessionPoolTest {
+  static Http2ServerSession *
+  new_session(Http2ServerSessionPool *pool, sockaddr const *addr, INK_MD5 const &host_hash)
+  {
+    NetVConnection *vc = netProcessor.allocate_vc(this_ethread());
+    Http2ServerSession *ssn = THREAD_ALLOC_INIT(http2ServerSessionAllocator, this_ethread());
+
+    vc->thread = this_ethread();
+    ssn->new_connection(vc, addr, host_hash);
+    ssn->pool = pool;
+    pool->add(ssn);
+    return ssn;
+  }
+
+  static void
+  close_session(Http2ServerSession *ssn)
+  {
+    SCOPED_MUTEX_LOCK(lock, ssn->mutex, this_ethread());
+    ssn->server_vc->thread = this_ethread();
+    ssn->close(VC_EVENT_EOS);
+  }
+
+  static uint32_t
+  stream_count(Http2ServerSession *ssn)
+  {
+    return ssn->stream_count;
+  }
+
+  static void
+  set_max_streams(Http2ServerSession *ssn, uint32_t n)
+  {
+    ssn->peer_settings.set(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, n);
+  }
+
+  static int
+  waiter_count(Http2ServerSessionPool *pool)
+  {
+    int n = 0;
+    for (Http2ServerSessionPool::Waiter *w = pool->m_waiters.head; w; w = w->link.next) {
+      ++n;
+    }
+    return n;
+  }
+};
+
+static void
+http2_test_host_hash(const char *host, INK_MD5 &hash)
+{
+  ink_code_md5((unsigned char *)host, strlen(host), (unsigned char *)&hash);
+}
+
+REGRESSION_TEST(Http2ServerSessionPool)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Http2ServerSessionPool pool;
+  Ptr<ProxyMutex> sm_mutex(new_ProxyMutex());
+  SCOPED_MUTEX_LOCK(sm_lock, sm_mutex, this_ethread());
+  IpEndpoint addr, other_addr;
+  INK_MD5 host, other_host;
+  Http2ServerStream *stream;
+  bool retry;
+
+  ats_ip_pton("127.0.0.1:443", &addr);
+  ats_ip_pton("127.0.0.2:443", &other_addr);
+  http2_test_host_hash("origin.example.com", host);
+  http2_test_host_hash("other.example.com", other_host);
+
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "An empty pool has a stream, or asks for a retry");
+
+  // A connection in its handshake holds back the requests which wait for it, and only those to its origin
+  pool.begin_handshake(&addr.sa, host, HRTIME_SECONDS(30));
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && retry, "A request is not held back by a handshake to its origin");
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, false, retry);
+  box.check(stream == NULL && !retry, "A request which is done waiting is held back by a handshake");
+  stream = pool.acquire_stream(&addr.sa, other_host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "A request is held back by a handshake for another host");
+  stream = pool.acquire_stream(&other_addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "A request is held back by a handshake to another address");
+  pool.end_handshake(&addr.sa, host);
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "A request is held back by a handshake which ended");
+
+  // A handshake which is never ended stops holding requests back after its time
+  pool.begin_handshake(&addr.sa, host, 0);
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "A request is held back by a handshake past its time");
+
+  // A request waiting for a handshake is woken when it ends, or when a connection to its origin is added. The wake up
+  // events still come, to requests which are gone by then.
+  Continuation request(sm_mutex);
+  ink_hrtime wait_until = Thread::get_hrtime() + HRTIME_SECONDS(30);
+  pool.begin_handshake(&addr.sa, host, HRTIME_SECONDS(30));
+  Action *wait = pool.wait_for_stream(&addr.sa, host, &request, wait_until);
+  Action *other_wait = pool.wait_for_stream(&addr.sa, other_host, &request, wait_until);
+  box.check(Http2ServerSessionPoolTest::waiter_count(&pool) == 1, "Requests do not wait for the handshake to their origin only");
+  pool.end_handshake(&addr.sa, host);
+  box.check(Http2ServerSessionPoolTest::waiter_count(&pool) == 0, "A waiting request is not woken when the handshake ends");
+  wait->cancel();
+  other_wait->cancel();
+
+  pool.begin_handshake(&addr.sa, host, HRTIME_SECONDS(30));
+  wait = pool.wait_for_stream(&addr.sa, host, &request, wait_until);
+
+  // Attach: the connection in the pool takes streams for its origin
+  Http2ServerSession *ssn = Http2ServerSessionPoolTest::new_session(&pool, &addr.sa, host);
+  box.check(Http2ServerSessionPoolTest::waiter_count(&pool) == 0, "A waiting request is not woken when a connection is added");
+  wait->cancel();
+  pool.end_handshake(&addr.sa, host);
+  stream = pool.acquire_stream(&other_addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL, "A stream is taken on a connection to another address");
+  stream = pool.acquire_stream(&addr.sa, other_host, sm_mutex, true, retry);
+  box.check(stream == NULL, "A stream is taken on a connection for another host");
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream != NULL && Http2ServerSessionPoolTest::stream_count(ssn) == 1, "No stream is taken on the connection");
+
+  // A full connection turns requests away, until a stream is released
+  Http2ServerSessionPoolTest::set_max_streams(ssn, 1);
+  Http2ServerStream *full = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(full == NULL && !retry, "A stream is taken on a full connection, or it asks for a retry");
+  if (stream) {
+    stream->do_io_close();
+  }
+  box.check(Http2ServerSessionPoolTest::stream_count(ssn) == 0, "The released stream is still on the connection");
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream != NULL, "No stream is taken on the connection after one was released");
+  if (stream) {
+    stream->do_io_close();
+  }
+
+  // A closed connection leaves the pool
+  Http2ServerSessionPoolTest::close_session(ssn);
+  stream = pool.acquire_stream(&addr.sa, host, sm_mutex, true, retry);
+  box.check(stream == NULL && !retry, "A stream is taken on a closed connection");
+}
+
+// Requests on all the net threads take streams on one connection at once, while another thread holds the connection
+// for a while. None of them may be turned away to open a connection of its own.
+struct Http2ServerSessionPoolRace {
+  RegressionTest *test;
+  int *pstatus;
+  Http2ServerSessionPool pool;
+  Http2ServerSession *ssn;
+  IpEndpoint addr;
+  INK_MD5 host;
+  volatile int running;
+  volatile int acquired;
+  volatile int retried;
+  volatile int refused;
+};
+
+struct Http2ServerSessionPoolRaceHolder : public Continuation {
+  Http2ServerSessionPoolRaceHolder(ProxyMutex *m) : Continuation(m) { SET_HANDLER(&Http2ServerSessionPoolRaceHolder::hold); }
+
+  int
+  hold(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    // Called with the connection mutex held
+    ink_hrtime_sleep(HRTIME_MSECONDS(50));
+    delete this;
+    return EVENT_DONE;
+  }
+};
+
+struct Http2ServerSessionPoolRaceWorker : public Continuation {
+  static const int ROUNDS = 100;
+
+  Http2ServerSessionPoolRace *race;
+  int left;
+
+  Http2ServerSessionPoolRaceWorker(Http2ServerSessionPoolRace *r) : Continuation(new_ProxyMutex()), race(r), left(ROUNDS)
+  {
+    SET_HANDLER(&Http2ServerSessionPoolRaceWorker::run);
+  }
+
+  int
+  run(int /* event ATS_UNUSED */, Event *e)
+  {
+    bool retry;
+
+    while (left > 0) {
+      Http2ServerStream *stream = race->pool.acquire_stream(&race->addr.sa, race->host, mutex, true, retry);
+      if (stream) {
+        ink_atomic_increment(&race->acquired, 1);
+        stream->do_io_close();
+      } else if (retry) {
+        ink_atomic_increment(&race->retried, 1);
+        e->ethread->schedule_in(this, HRTIME_MSECONDS(1));
+        return EVENT_DONE;
+      } else {
+        ink_atomic_increment(&race->refused, 1);
+      }
+      --left;
+    }
+
+    if (ink_atomic_increment(&race->running, -1) == 1) {
+      finish();
+    }
+    delete this;
+    return EVENT_DONE;
+  }
+
+  void
+  finish()
+  {
+    int expected = eventProcessor.n_threads_for_type[ET_NET] * ROUNDS;
+
+    rprintf(race->test, "%d streams taken, %d retries, %d turned away\n", race->acquired, race->retried, race->refused);
+    *race->pstatus = race->refused == 0 && race->acquired == expected ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+
+    Http2ServerSessionPoolTest::close_session(race->ssn);
+    delete race;
+  }
+};
+
+REGRESSION_TEST(Http2ServerSessionPool_concurrent)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  Http2ServerSessionPoolRace *race = new Http2ServerSessionPoolRace;
+  int workers = eventProcessor.n_threads_for_type[ET_NET];
+
+  race->test = t;
+  race->pstatus = pstatus;
+  ats_ip_pton("127.0.0.1:443", &race->addr);
+  http2_test_host_hash("origin.example.com", race->host);
+  race->running = workers;
+  race->acquired = race->retried = race->refused = 0;
+  race->ssn = Http2ServerSessionPoolTest::new_session(&race->pool, &race->addr.sa, race->host);
+
+  *pstatus = REGRESSION_TEST_INPROGRESS;
+  eventProcessor.schedule_imm(new Http2ServerSessionPoolRaceHolder(race->ssn->mutex), ET_NET);
+  for (int i = 0; i < workers; ++i) {
+    eventProcessor.schedule_in(new Http2ServerSessionPoolRaceWorker(race), HRTIME_MSECONDS(10), ET_NET);
+  }
+}
+
+#endif /* TS_HAS_TESTS */
@@ -0,0 +1,373 @@
+/** @file
+
+  Http2ServerSession.
+
+  HTTP/2 connections to origin servers, the streams of transactions on them,
+  and the pool which shares the connections between transactions.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HTTP2_SERVER_SESSION_H__
+#define __HTTP2_SERVER_SESSION_H__
+
+#include "HTTP2.h"
+#include "HPACK.h"
+#include "Http2ClientSession.h"
+#include "../http/HttpTunnel.h" // To get ChunkedHandler
+#include "ts/Map.h"
+
+// Name                               Edata   Description
+// HTTP2_SERVER_STREAM_EVENT_UPDATE   NULL    Something changed for the stream, sent on its own thread
+
+#define HTTP2_SERVER_STREAM_EVENT_UPDATE (HTTP2_SESSION_EVENTS_START + 5)
+
+class Http2ServerSession;
+class Http2ServerSessionPool;
+
+/** A transaction on an HTTP/2 connection to an origin server.
+
+    To the state machine this is the network connection of an @c HttpServerSession: the request is written to it as
+    HTTP/1.1 and the response read back as HTTP/1.1, while the stream sends and receives them as frames on the shared
+    connection. A stream runs on the thread and under the mutex of its state machine, and only touches the connection
+    with the connection mutex held, which it tries for rather than blocks on. The connection hands things over to the
+    stream under that mutex and sends it an update event, it never takes the mutex of a state machine.
+*/
+class Http2ServerStream : public NetVConnection
+{
+public:
+  Http2ServerStream();
+
+  void init(Http2ServerSession *ssn, ProxyMutex *m);
+
+  // Implement the NetVConnection interface.
+  VIO *do_io_read(Continuation *c, int64_t nbytes = INT64_MAX, MIOBuffer *buf = 0);
+  VIO *do_io_write(Continuation *c = NULL, int64_t nbytes = INT64_MAX, IOBufferReader *buf = 0, bool owner = false);
+  void do_io_close(int lerrno = -1);
+  void do_io_shutdown(ShutdownHowTo_t howto);
+  void reenable(VIO *vio);
+  void reenable_re(VIO *vio);
+
+  void set_active_timeout(ink_hrtime timeout_in);
+  void set_inactivity_timeout(ink_hrtime timeout_in);
+  void cancel_active_timeout();
+  void cancel_inactivity_timeout();
+  ink_hrtime
+  get_active_timeout()
+  {
+    return active_timeout;
+  }
+  ink_hrtime
+  get_inactivity_timeout()
+  {
+    return inactive_timeout;
+  }
+  void
+  add_to_keep_alive_queue()
+  {
+  }
+  void
+  remove_from_keep_alive_queue()
+  {
+  }
+  bool
+  add_to_active_queue()
+  {
+    return false;
+  }
+
+  SOCKET
+  get_socket()
+  {
+    return ts::NO_FD;
+  }
+  void set_local_addr();
+  void set_remote_addr();
+  int
+  set_tcp_init_cwnd(int /* init_cwnd ATS_UNUSED */)
+  {
+    return -1;
+  }
+  int
+  set_tcp_congestion_control(const char * /* name ATS_UNUSED */, int /* len ATS_UNUSED */)
+  {
+    return -1;
+  }
+  void
+  apply_options()
+  {
+  }
+
+  Http2StreamId
+  get_id() const
+  {
+    return id;
+  }
+
+  // Wake the stream up on its own thread, from any thread.
+  void signal();
+
+  LINK(Http2ServerStream, link);
+
+private:
+  friend class Http2ServerSession;
+
+  Http2ServerStream(Http2ServerStream &);                  // noncopyable
+  Http2ServerStream &operator=(const Http2ServerStream &); // noncopyable
+
+  enum RequestState {
+    REQUEST_HEADER, // Waiting for the request header
+    REQUEST_BODY,   // Taking the request body from the state machine
+    REQUEST_FLUSH,  // All of the request taken, sending what is left of it
+    REQUEST_DONE,   // END_STREAM sent
+  };
+
+  int main_event_handler(int event, void *edata);
+  void update();
+  int update_write(Http2ServerSession *ssn);
+  int update_read(Http2ServerSession *ssn);
+  bool release_session();
+  void destroy();
+  void clear_timers();
+
+  Http2StreamId id; // 0 until the HEADERS frame is sent
+  Ptr<ProxyMutex> session_mutex;
+  Http2ServerSession *session; // NULL once the connection has let go of the stream, under session_mutex
+  IpEndpoint server_addr;
+  IpEndpoint client_addr;
+  bool closed;
+  int reentrancy_count;
+  volatile int event_pending;
+
+  VIO read_vio;
+  VIO write_vio;
+
+  // The request, on the thread of the state machine
+  RequestState request_state;
+  HTTPParser http_parser;
+  HTTPHdr request_header;
+  bool request_chunked;
+  int64_t request_body_left;
+  ChunkedHandler chunked_handler;
+  MIOBuffer *body_buffer;
+  IOBufferReader *body_reader;
+
+  // Flow control windows and the response, both under session_mutex
+  Http2WindowSize peer_rwnd;
+  Http2WindowSize local_rwnd;
+  HTTPHdr response_header;
+  bool response_header_ready;
+  bool response_header_sent;
+  MIOBuffer *recv_buffer;
+  IOBufferReader *recv_reader;
+  bool recv_end;
+  int error_event;
+
+  ink_hrtime active_timeout;
+  Event *active_event;
+  ink_hrtime inactive_timeout;
+  ink_hrtime inactive_timeout_at;
+  Event *inactive_event;
+};
+
+/** An HTTP/2 connection to an origin server.
+
+    The connection is opened by a state machine, which takes the first stream on it, and goes into the pool for other
+    state machines to take streams from, on any thread. It stays open until the origin closes it or it has been idle
+    for proxy.config.http2.no_activity_timeout_out.
+*/
+class Http2ServerSession : public Continuation
+{
+public:
+  typedef int (Http2ServerSession::*SessionHandler)(int, void *);
+
+  Http2ServerSession();
+
+  void new_connection(NetVConnection *new_vc, sockaddr const *addr, INK_MD5 const &host_hash);
+  Http2ServerStream *start(Http2ServerSessionPool *p, ProxyMutex *m);
+
+  // The rest is called with the session mutex held.
+  bool is_available() const;
+  Http2ServerStream *new_stream(ProxyMutex *m);
+  void close_stream(Http2ServerStream *stream, bool reset);
+
+  bool send_headers(Http2ServerStream *stream, HTTPHdr *hdr, bool end_stream);
+  bool send_data(Http2ServerStream *stream, IOBufferReader *reader, bool end_stream);
+  void update_window(Http2ServerStream *stream);
+
+  IpEndpoint server_ip;
+  INK_MD5 hostname_hash;
+  NetVConnection *server_vc;
+
+  LINK(Http2ServerSession, ip_hash_link);
+
+private:
+  friend struct Http2ServerSessionPoolTest;
+
+  Http2ServerSession(Http2ServerSession &);                  // noncopyable
+  Http2ServerSession &operator=(const Http2ServerSession &); // noncopyable
+
+  int main_event_handler(int event, void *edata);
+  int state_start_frame_read(int event, void *edata);
+  int state_complete_frame_read(int event, void *edata);
+
+  Http2Error recv_frame(const Http2Frame &frame);
+  Http2Error rcv_headers_frame(const Http2Frame &frame);
+  Http2Error rcv_continuation_frame(const Http2Frame &frame);
+  Http2Error rcv_data_frame(const Http2Frame &frame);
+  Http2Error rcv_rst_stream_frame(const Http2Frame &frame);
+  Http2Error rcv_settings_frame(const Http2Frame &frame);
+  Http2Error rcv_ping_frame(const Http2Frame &frame);
+  Http2Error rcv_goaway_frame(const Http2Frame &frame);
+  Http2Error rcv_window_update_frame(const Http2Frame &frame);
+  Http2Error decode_header_blocks(Http2ServerStream *stream);
+
+  Http2ServerStream *find_stream(Http2StreamId id) const;
+  void detach_stream(Http2ServerStream *stream, int event);
+  void signal_streams();
+  void xmit(Http2Frame &frame);
+  void send_settings_frame();
+  void send_window_update_frame(Http2StreamId id, uint32_t size);
+  void send_rst_stream_frame(Http2StreamId id, Http2ErrorCode ec);
+  void send_goaway_frame(Http2StreamId id, Http2ErrorCode ec);
+  void update_idle_timeout();
+  void close(int event);
+  void destroy();
+
+  int64_t con_id;
+  SessionHandler session_handler;
+  Http2ServerSessionPool *pool;
+  Event *fini_event;
+  MIOBuffer *read_buffer;
+  IOBufferReader *sm_reader;
+  MIOBuffer *write_buffer;
+  IOBufferReader *sm_writer;
+  VIO *write_vio;
+  int64_t total_write_len;
+  bool write_blocked;
+  Http2FrameHeader current_hdr;
+
+  // Settings sent by the proxy and by the origin server
+  Http2ConnectionSettings local_settings;
+  Http2ConnectionSettings peer_settings;
+  HpackHandle *local_hpack_handle;
+  HpackHandle *remote_hpack_handle;
+
+  // The header block being received, HEADERS and any CONTINUATION frames
+  uint8_t *header_blocks;
+  uint32_t header_blocks_length;
+  bool headers_end_stream;
+  Http2StreamId continued_streamid;
+
+  DLL<Http2ServerStream> streams;
+  uint32_t stream_count;
+  Http2StreamId latest_streamid;
+  Http2WindowSize peer_rwnd;
+  Http2WindowSize local_rwnd;
+  bool goaway;
+  bool closed;
+};
+
+/** The HTTP/2 connections to origin servers, shared by all threads.
+
+    A connection is matched on both the address and the host name of the origin, since it was authenticated for that
+    name. Take the pool mutex before looking for a stream.
+
+    The pool also knows about the connections which offered HTTP/2 and are still in their handshake, so that the
+    requests to the same origin can wait for it rather than each opening a connection of their own. Those requests are
+    woken when a handshake to their origin ends or expires, or a connection to it is added.
+*/
+class Http2ServerSessionPool
+{
+public:
+  Http2ServerSessionPool();
+
+  Http2ServerStream *acquire_stream(sockaddr const *addr, INK_MD5 const &host_hash, ProxyMutex *m, bool wait_for_handshake,
+                                    bool &retry);
+  void add(Http2ServerSession *ssn);
+  void remove(Http2ServerSession *ssn);
+
+  Action *wait_for_stream(sockaddr const *addr, INK_MD5 const &host_hash, Continuation *cont, ink_hrtime wait_until);
+
+  void begin_handshake(sockaddr const *addr, INK_MD5 const &host_hash, ink_hrtime timeout);
+  void end_handshake(sockaddr const *addr, INK_MD5 const &host_hash);
+
+  Ptr<ProxyMutex> mutex;
+
+private:
+  friend struct Http2ServerSessionPoolTest;
+
+  struct Handshake {
+    IpEndpoint addr;
+    INK_MD5 host_hash;
+    ink_hrtime expire_at; // In case the connection is never heard from again
+    LINK(Handshake, link);
+  };
+
+  // A request waiting for a handshake, run under the mutex and on the thread of the request.
+  struct Waiter : public Continuation {
+    Waiter(Http2ServerSessionPool *p, Continuation *cont);
+    int main_event(int event, Event *e);
+
+    Http2ServerSessionPool *pool;
+    IpEndpoint addr;
+    INK_MD5 host_hash;
+    Action action;
+    EThread *thread;
+    Event *timeout;
+    bool queued; // In m_waiters, under the pool mutex
+    LINK(Waiter, link);
+  };
+
+  Handshake *handshake_pending(sockaddr const *addr, INK_MD5 const &host_hash);
+  void wake_waiters(sockaddr const *addr, INK_MD5 const &host_hash);
+
+  struct IPHashing {
+    typedef uint32_t ID;
+    typedef sockaddr const *Key;
+    typedef Http2ServerSession Value;
+    typedef DList(Http2ServerSession, ip_hash_link) ListHead;
+
+    static ID
+    hash(Key key)
+    {
+      return ats_ip_hash(key);
+    }
+    static Key
+    key(Value const *value)
+    {
+      return &value->server_ip.sa;
+    }
+    static bool
+    equal(Key lhs, Key rhs)
+    {
+      return ats_ip_addr_port_eq(lhs, rhs);
+    }
+  };
+
+  typedef TSHashTable<IPHashing> IPHashTable;
+  IPHashTable m_ip_pool;
+  DLL<Handshake> m_handshakes;
+  DLL<Waiter> m_waiters;
+};
+
+extern ClassAllocator<Http2ServerSession> http2ServerSessionAllocator;
+extern ClassAllocator<Http2ServerStream> http2ServerStreamAllocator;
+
+#endif // __HTTP2_SERVER_SESSION_H__
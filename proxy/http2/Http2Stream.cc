@@ -24,6 +24,7 @@
 #include "HTTP2.h"
 #include "Http2Stream.h"
 #include "Http2ClientSession.h"
+#include "HdrUtils.h"
 #include "../http/HttpSM.h"
 
 ClassAllocator<Http2Stream> http2StreamAllocator("http2StreamAllocator");
@@ -127,6 +128,87 @@ Http2Stream::send_request(Http2ConnectionState &cstate)
   this->update_read_request(INT64_MAX, true);
 }
 
+// Promise @a uri, a URI reference resolved against the request of this stream. Only resources of the same origin are
+// pushed, since the client can only trust the proxy to speak for its authority.
+bool
+Http2Stream::push_promise(const char *uri, int uri_len)
+{
+  Http2ClientSession *parent = static_cast<Http2ClientSession *>(this->get_parent());
+  if (parent == NULL || uri_len <= 0) {
+    return false;
+  }
+
+  URL *req_url = _req_header.url_get();
+  int scheme_len, host_len;
+  const char *scheme = req_url->scheme_get(&scheme_len);
+  const char *host = req_url->host_get(&host_len);
+  if (scheme == NULL || host == NULL) {
+    return false;
+  }
+
+  // Absolute URIs are taken as they are, network-path and absolute-path references are completed from the request.
+  // Relative-path references are not pushed.
+  Arena arena;
+  char *absolute = arena.str_alloc(scheme_len + host_len + uri_len + sizeof("://[]:65535"));
+  int absolute_len;
+  if (uri_len > 1 && uri[0] == '/' && uri[1] == '/') {
+    absolute_len = sprintf(absolute, "%.*s:%.*s", scheme_len, scheme, uri_len, uri);
+  } else if (uri[0] == '/') {
+    bool ipv6 = memchr(host, ':', host_len) != NULL;
+    absolute_len = sprintf(absolute, ipv6 ? "%.*s://[%.*s]" : "%.*s://%.*s", scheme_len, scheme, host_len, host);
+    if (req_url->port_get_raw()) {
+      absolute_len += sprintf(absolute + absolute_len, ":%d", req_url->port_get_raw());
+    }
+    absolute_len += sprintf(absolute + absolute_len, "%.*s", uri_len, uri);
+  } else if (memchr(uri, ':', uri_len) != NULL) {
+    absolute_len = sprintf(absolute, "%.*s", uri_len, uri);
+  } else {
+    return false;
+  }
+
+  URL url;
+  bool pushed = false;
+  url.create(NULL);
+  if (url.parse(absolute, absolute_len) == PARSE_DONE) {
+    int push_host_len;
+    const char *push_host = url.host_get(&push_host_len);
+    if (url.scheme_get_wksidx() == req_url->scheme_get_wksidx() && push_host_len == host_len &&
+        strncasecmp(push_host, host, host_len) == 0 && url.port_get() == req_url->port_get()) {
+      SCOPED_MUTEX_LOCK(lock, parent->mutex, this_ethread());
+      pushed = parent->connection_state.push_promise(this, url);
+    }
+  }
+  url.destroy();
+
+  return pushed;
+}
+
+// Push what the origin marks for preload, see http2_parse_link_preload().
+void
+Http2Stream::push_link_preloads()
+{
+  static const char LINK[] = "Link";
+
+  if (!Http2::push_link_preload || !http2_is_client_streamid(_id) || response_header.status_get() != HTTP_STATUS_OK) {
+    return;
+  }
+
+  MIMEField *field = response_header.field_find(LINK, sizeof(LINK) - 1);
+  if (field == NULL) {
+    return;
+  }
+
+  HdrCsvIter iter;
+  int len;
+  for (const char *value = iter.get_first(field, &len); value; value = iter.get_next(&len)) {
+    const char *uri;
+    int uri_len;
+    if (http2_parse_link_preload(value, len, &uri, &uri_len)) {
+      this->push_promise(uri, uri_len);
+    }
+  }
+}
+
 bool
 Http2Stream::change_state(uint8_t type, uint8_t flags)
 {
@@ -145,7 +227,7 @@ Http2Stream::change_state(uint8_t type, uint8_t flags)
         _state = HTTP2_STREAM_STATE_OPEN;
       }
     } else if (type == HTTP2_FRAME_TYPE_PUSH_PROMISE) {
-      // XXX Server Push have been supported yet.
+      _state = HTTP2_STREAM_STATE_RESERVED_LOCAL;
     } else {
       return false;
     }
@@ -163,8 +245,18 @@ Http2Stream::change_state(uint8_t type, uint8_t flags)
     break;
 
   case HTTP2_STREAM_STATE_RESERVED_LOCAL:
-    // Currently ATS supports only HTTP/2 server features
-    return false;
+    if (type == HTTP2_FRAME_TYPE_HEADERS) {
+      if (flags & HTTP2_FLAGS_HEADERS_END_STREAM) {
+        _state = HTTP2_STREAM_STATE_CLOSED;
+      } else {
+        _state = HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE;
+      }
+    } else if (type == HTTP2_FRAME_TYPE_RST_STREAM) {
+      _state = HTTP2_STREAM_STATE_CLOSED;
+    } else {
+      return false;
+    }
+    break;
 
   case HTTP2_STREAM_STATE_RESERVED_REMOTE:
     // XXX Server Push have been supported yet.
@@ -428,6 +520,9 @@ Http2Stream::update_write_request(IOBufferReader *buf_reader, int64_t write_len,
       case PARSE_DONE: {
         this->response_header_done = true;
 
+        // Promise the resources the response links to before the client sees the links
+        this->push_link_preloads();
+
         // Send the response header back
         parent->connection_state.send_headers_frame(this);
 
@@ -27,9 +27,13 @@
 #include "HTTP2.h"
 #include "../ProxyClientTransaction.h"
 #include "Http2DebugNames.h"
+#include "Http2DependencyTree.h"
 #include "../http/HttpTunnel.h" // To get ChunkedHandler
 
 class Http2ConnectionState;
+class Http2Stream;
+
+typedef Http2DependencyTree<Http2Stream *> Http2StreamDependencyTree;
 
 class Http2Stream : public ProxyClientTransaction
 {
@@ -37,7 +41,7 @@ public:
   typedef ProxyClientTransaction super; ///< Parent type.
   Http2Stream(Http2StreamId sid = 0, ssize_t initial_rwnd = Http2::initial_window_size)
     : client_rwnd(initial_rwnd), server_rwnd(Http2::initial_window_size), header_blocks(NULL), header_blocks_length(0),
-      request_header_length(0), end_stream(false), response_reader(NULL), request_reader(NULL),
+      request_header_length(0), end_stream(false), priority_node(NULL), response_reader(NULL), request_reader(NULL),
       request_buffer(CLIENT_CONNECTION_FIRST_READ_BUFFER_SIZE_INDEX), _id(sid), _state(HTTP2_STREAM_STATE_IDLE),
       trailing_header(false), body_done(false), data_length(0), closed(false), sent_delete(false), bytes_sent(0), chunked(false),
       cross_thread_event(NULL), active_event(NULL), inactive_event(NULL)
@@ -131,7 +135,22 @@ public:
     return content_length == 0 || content_length == data_length;
   }
 
+  // Request of a pushed stream, in HTTP/2 form
+  void
+  set_request_header(HTTPHdr &h2_hdr)
+  {
+    _req_header.copy(&h2_hdr);
+  }
+
+  HTTPHdr *
+  get_request_header()
+  {
+    return &_req_header;
+  }
+
   void send_request(Http2ConnectionState &cstate);
+  bool push_promise(const char *uri, int uri_len);
+  void push_link_preloads();
   VIO *do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf);
   VIO *do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *abuffer, bool owner = false);
   void do_io_close(int lerrno = -1);
@@ -153,6 +172,9 @@ public:
                                   // and other fields)
   bool end_stream;
 
+  // Node of this stream in the dependency tree of the connection
+  Http2StreamDependencyTree::Node *priority_node;
+
   bool sent_request_header;
   bool response_header_done;
   bool request_sent;
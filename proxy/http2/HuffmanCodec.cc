@@ -25,6 +25,7 @@
 #include "ts/ink_platform.h"
 #include "ts/ink_memory.h"
 #include "ts/ink_defs.h"
+#include "ts/ink_assert.h"
 
 struct huffman_entry {
   uint32_t code_as_hex;
@@ -70,106 +71,128 @@ static const huffman_entry huffman_table[] = {
   {0x7ffffe8, 27}, {0x7ffffe9, 27},  {0x7ffffea, 27}, {0x7ffffeb, 27},  {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
   {0x7ffffee, 27}, {0x7ffffef, 27},  {0x7fffff0, 27}, {0x3ffffee, 26},  {0x3fffffff, 30}};
 
-typedef struct node {
-  node *left, *right;
-  char ascii_code;
-  bool leaf_node;
-} Node;
+// The decoder is a finite state machine which consumes 4 bits per step. A
+// state is an internal node of the Huffman tree, that is the bits of a code
+// read so far, and state 0 is the root. Since the shortest code is 5 bits
+// long each step emits at most one symbol.
 
-Node *HUFFMAN_TREE_ROOT;
+#define HUFFMAN_DECODE_BITS 4
+#define HUFFMAN_DECODE_STATES 256 // internal nodes of a tree with 257 leaves
+#define HUFFMAN_EOS 256
 
-static Node *
-make_huffman_tree_node()
-{
-  Node *n = static_cast<Node *>(ats_malloc(sizeof(Node)));
-  n->left = NULL;
-  n->right = NULL;
-  n->ascii_code = '\0';
-  n->leaf_node = false;
-  return n;
-}
+enum {
+  HUFFMAN_DECODE_EMIT = 1,   // the step completed a symbol
+  HUFFMAN_DECODE_ACCEPT = 2, // input may end here, the bits pending are valid padding
+  HUFFMAN_DECODE_FAIL = 4,   // the step decoded EOS
+};
 
-static Node *
-make_huffman_tree()
+struct huffman_decode_entry {
+  uint8_t state;
+  uint8_t flags;
+  uint8_t symbol;
+  uint8_t pad; // keeps the table index a shift
+};
+
+static huffman_decode_entry huffman_decode_table[HUFFMAN_DECODE_STATES][1 << HUFFMAN_DECODE_BITS];
+static bool huffman_decode_table_built = false;
+
+static void
+make_huffman_decode_table()
 {
-  Node *root = make_huffman_tree_node();
-  Node *current;
-  uint32_t bit_len;
-  // insert leafs for each ascii code
+  // The tree, as the children of each internal node. Leaves are stored as ~symbol.
+  int child[HUFFMAN_DECODE_STATES][2];
+  // Whether the bits leading to an internal node could be padding: all ones and shorter than a byte.
+  bool padding[HUFFMAN_DECODE_STATES];
+  int n_states = 1;
+
+  memset(child, 0, sizeof(child));
+  padding[0] = true;
   for (unsigned i = 0; i < countof(huffman_table); i++) {
-    bit_len = huffman_table[i].bit_len;
-    current = root;
-    while (bit_len > 0) {
-      if (huffman_table[i].code_as_hex & (1 << (bit_len - 1))) {
-        if (!current->right)
-          current->right = make_huffman_tree_node();
-        current = current->right;
+    int current = 0;
+    for (uint32_t bit_len = huffman_table[i].bit_len; bit_len > 0; bit_len--) {
+      int bit = (huffman_table[i].code_as_hex >> (bit_len - 1)) & 1;
+      if (bit_len == 1) {
+        child[current][bit] = ~(int)i;
       } else {
-        if (!current->left)
-          current->left = make_huffman_tree_node();
-        current = current->left;
+        if (!child[current][bit]) {
+          ink_release_assert(n_states < HUFFMAN_DECODE_STATES);
+          padding[n_states] = padding[current] && bit && (huffman_table[i].bit_len - bit_len) < 7;
+          child[current][bit] = n_states++;
+        }
+        current = child[current][bit];
       }
-      bit_len--;
     }
-    current->ascii_code = i;
-    current->leaf_node = true;
   }
-  return root;
-}
-
-static void
-free_huffman_tree(Node *node)
-{
-  if (node->left)
-    free_huffman_tree(node->left);
-  if (node->right)
-    free_huffman_tree(node->right);
-
-  ats_free(node);
+  ink_release_assert(n_states == HUFFMAN_DECODE_STATES);
+
+  for (int state = 0; state < HUFFMAN_DECODE_STATES; state++) {
+    for (int bits = 0; bits < (1 << HUFFMAN_DECODE_BITS); bits++) {
+      huffman_decode_entry &e = huffman_decode_table[state][bits];
+      int current = state;
+      e.flags = 0;
+      e.symbol = 0;
+      for (int i = HUFFMAN_DECODE_BITS - 1; i >= 0; i--) {
+        int next = child[current][(bits >> i) & 1];
+        if (next < 0) {
+          if (~next == HUFFMAN_EOS) {
+            e.flags = HUFFMAN_DECODE_FAIL;
+            break;
+          }
+          e.flags |= HUFFMAN_DECODE_EMIT;
+          e.symbol = ~next;
+          next = 0;
+        }
+        current = next;
+      }
+      e.state = current;
+      if (!(e.flags & HUFFMAN_DECODE_FAIL) && padding[current])
+        e.flags |= HUFFMAN_DECODE_ACCEPT;
+    }
+  }
 }
 
 void
 hpack_huffman_init()
 {
-  if (!HUFFMAN_TREE_ROOT)
-    HUFFMAN_TREE_ROOT = make_huffman_tree();
+  if (!huffman_decode_table_built) {
+    make_huffman_decode_table();
+    huffman_decode_table_built = true;
+  }
 }
 
 void
 hpack_huffman_fin()
 {
-  if (HUFFMAN_TREE_ROOT)
-    free_huffman_tree(HUFFMAN_TREE_ROOT);
 }
 
+// Returns the decoded length, or -1 if @a src decodes EOS or ends with anything but up to 7 bits of EOS padding (RFC 7541 5.2).
 int64_t
 huffman_decode(char *dst_start, const uint8_t *src, uint32_t src_len)
 {
   char *dst_end = dst_start;
-  uint8_t shift = 7;
-  Node *current = HUFFMAN_TREE_ROOT;
-
-  while (src_len) {
-    if (*src & (1 << shift)) {
-      current = current->right;
-    } else {
-      current = current->left;
-    }
-
-    if (current->leaf_node == true) {
-      *dst_end = current->ascii_code;
-      ++dst_end;
-      current = HUFFMAN_TREE_ROOT;
-    }
-    if (shift) {
-      --shift;
-    } else {
-      shift = 7;
-      ++src;
-      --src_len;
-    }
+  uint8_t state = 0;
+  uint8_t flags = HUFFMAN_DECODE_ACCEPT;
+
+  // Whether a step emits a symbol is close to random, so rather than branch the symbol is always stored and only kept
+  // by advancing the output when HUFFMAN_DECODE_EMIT (1) is set. The entries are copied out first, a store through
+  // char * could alias the table and force a reload.
+  for (const uint8_t *end = src + src_len; src < end; ++src) {
+    huffman_decode_entry hi = huffman_decode_table[state][*src >> 4];
+    huffman_decode_entry lo = huffman_decode_table[hi.state][*src & 0xf];
+
+    *dst_end = hi.symbol;
+    dst_end += hi.flags & HUFFMAN_DECODE_EMIT;
+    *dst_end = lo.symbol;
+    dst_end += lo.flags & HUFFMAN_DECODE_EMIT;
+    if ((hi.flags | lo.flags) & HUFFMAN_DECODE_FAIL)
+      return -1;
+    state = lo.state;
+    flags = lo.flags;
   }
 
+  if (!(flags & HUFFMAN_DECODE_ACCEPT))
+    return -1;
+
   return dst_end - dst_start;
 }
 
@@ -29,6 +29,7 @@
 
 void hpack_huffman_init();
 void hpack_huffman_fin();
+// @a dst_start must have room for 2 * @a src_len bytes. Returns the decoded length or -1 on a decoding error.
 int64_t huffman_decode(char *dst_start, const uint8_t *src, uint32_t src_len);
 uint8_t *huffman_encode_append(uint8_t *dst, uint32_t src, int n);
 int64_t huffman_encode(uint8_t *dst_start, const uint8_t *src, uint32_t src_len);
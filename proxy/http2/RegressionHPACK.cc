@@ -583,6 +583,160 @@ REGRESSION_TEST(HPACK_Decode)(RegressionTest *t, int, int *pstatus)
   }
 }
 
+// Check lookups against a scan of the whole index address space, while entries are added, evicted and the table resized.
+REGRESSION_TEST(HPACK_IndexingTableLookup)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  static const char *names[] = {"x-a", "x-b", "X-C", "cache-control", "etag", ":status"};
+  HpackIndexingTable indexing_table(4096);
+  ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
+  headers->create(HTTP_TYPE_RESPONSE);
+  MIMEField *field = mime_field_create(headers->m_heap, headers->m_http->m_fields_impl);
+  MIMEFieldWrapper entry(field, headers->m_heap, headers->m_http->m_fields_impl);
+
+  srand48(7);
+  for (int i = 0; i < 2000; i++) {
+    char value[32];
+    const char *name = names[lrand48() % countof(names)];
+    int name_len = strlen(name);
+    int value_len = snprintf(value, sizeof(value), "%ld", lrand48() % 50);
+
+    if (i % 500 == 499)
+      indexing_table.update_maximum_size(128 + lrand48() % 4096);
+
+    // The first exact match, or else the first name match, in index order.
+    HpackLookupResult expected;
+    for (uint32_t index = 1; indexing_table.get_header_field(index, entry) == 0; index++) {
+      int entry_name_len, entry_value_len;
+      const char *entry_name = entry.name_get(&entry_name_len);
+      const char *entry_value = entry.value_get(&entry_value_len);
+      if (ptr_len_casecmp(name, name_len, entry_name, entry_name_len) == 0) {
+        if (ptr_len_cmp(value, value_len, entry_value, entry_value_len) == 0) {
+          expected.index = index;
+          expected.match_type = HPACK_EXACT_MATCH;
+          break;
+        } else if (!expected.index) {
+          expected.index = index;
+          expected.match_type = HPACK_NAME_MATCH;
+        }
+      }
+    }
+
+    HpackLookupResult result = indexing_table.lookup(name, name_len, value, value_len);
+    box.check(result.index == expected.index && result.match_type == expected.match_type,
+              "lookup of %s: %s returned %d/%d, expecting %d/%d", name, value, result.index, result.match_type, expected.index,
+              expected.match_type);
+
+    MIMEField *add = mime_field_create(headers->m_heap, headers->m_http->m_fields_impl);
+    add->name_set(headers->m_heap, headers->m_http->m_fields_impl, name, name_len);
+    add->value_set(headers->m_heap, headers->m_http->m_fields_impl, value, value_len);
+    indexing_table.add_header_field(add);
+  }
+}
+
+// Encode and decode a typical response header block, with a few values changing each time, through
+// 4KB and 64KB tables. Run with -R 3.
+REGRESSION_TEST(HPACK_Throughput)(RegressionTest *t, int level, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  if (REGRESSION_TEST_EXTENDED > level)
+    return;
+
+  static const struct {
+    const char *name;
+    const char *value;
+  } fields[] = {{":status", "200"},
+                {"date", NULL},
+                {"content-type", "text/html; charset=utf-8"},
+                {"content-length", NULL},
+                {"cache-control", "public, max-age=3600"},
+                {"expires", NULL},
+                {"last-modified", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                {"etag", NULL},
+                {"accept-ranges", "bytes"},
+                {"age", NULL},
+                {"vary", "Accept-Encoding"},
+                {"content-encoding", "gzip"},
+                {"server", "ATS"},
+                {"via", "http/1.1 cache.example.com (ApacheTrafficServer)"},
+                {"strict-transport-security", "max-age=31536000; includeSubDomains"},
+                {"x-content-type-options", "nosniff"},
+                {"x-frame-options", "SAMEORIGIN"},
+                {"x-xss-protection", "1; mode=block"},
+                {"access-control-allow-origin", "*"},
+                {"timing-allow-origin", "*"},
+                {"x-request-id", NULL},
+                {"x-cache", "HIT"},
+                {"x-cache-hits", NULL},
+                {"x-served-by", "cache-lax1234-LAX"},
+                {"x-timer", NULL},
+                {"link", "</style.css>; rel=preload; as=style"},
+                {"p3p", "CP=\"This is not a P3P policy\""},
+                {"alt-svc", "h2=\":443\"; ma=86400"},
+                {"set-cookie", NULL},
+                {"content-security-policy", "default-src 'self'; img-src *; script-src 'self' cdn.example.com"}};
+  const int n_fields = countof(fields);
+  const int rounds = 20000;
+  const uint32_t table_sizes[] = {4096, 65536};
+  uint8_t buf[16384];
+
+  hpack_huffman_init();
+
+  for (unsigned s = 0; s < countof(table_sizes); s++) {
+    HpackIndexingTable encoder(table_sizes[s]);
+    HpackIndexingTable decoder(table_sizes[s]);
+    ink_hrtime encode_time = 0, decode_time = 0;
+    int64_t encoded_bytes = 0;
+    int decoded_fields = 0;
+
+    for (int r = 0; r < rounds; r++) {
+      ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
+      headers->create(HTTP_TYPE_RESPONSE);
+      for (int i = 0; i < n_fields; i++) {
+        char value[64];
+        const char *v = fields[i].value;
+        // Values which change with every response, or every so often, as a date or a count would.
+        if (!v) {
+          snprintf(value, sizeof(value), "%s-%d", fields[i].name, (i & 1) ? r : r / 16);
+          v = value;
+        }
+        MIMEField *field = mime_field_create(headers->m_heap, headers->m_http->m_fields_impl);
+        field->name_set(headers->m_heap, headers->m_http->m_fields_impl, fields[i].name, strlen(fields[i].name));
+        field->value_set(headers->m_heap, headers->m_http->m_fields_impl, v, strlen(v));
+        mime_hdr_field_attach(headers->m_http->m_fields_impl, field, 1, NULL);
+      }
+
+      ink_hrtime start = ink_get_hrtime_internal();
+      int64_t len = hpack_encode_header_block(encoder, buf, sizeof(buf), headers);
+      encode_time += ink_get_hrtime_internal() - start;
+      if (len < 0) {
+        box.check(false, "hpack_encode_header_block returned %" PRId64, len);
+        return;
+      }
+      encoded_bytes += len;
+
+      ats_scoped_obj<HTTPHdr> decoded(new HTTPHdr);
+      decoded->create(HTTP_TYPE_RESPONSE);
+      start = ink_get_hrtime_internal();
+      int64_t result = hpack_decode_header_block(decoder, decoded, buf, len);
+      decode_time += ink_get_hrtime_internal() - start;
+      if (result < 0) {
+        box.check(false, "hpack_decode_header_block returned %" PRId64, result);
+        return;
+      }
+      decoded_fields += decoded->fields_count();
+    }
+
+    box.check(decoded_fields == rounds * n_fields, "decoded %d fields, expecting %d", decoded_fields, rounds * n_fields);
+    rprintf(t, "HPACK %u byte table: %" PRId64 " bytes/block, encode %.0f ns/block, decode %.0f ns/block\n", table_sizes[s],
+            encoded_bytes / rounds, (double)encode_time / rounds, (double)decode_time / rounds);
+  }
+}
+
 void
 forceLinkRegressionHPACK()
 {
@@ -0,0 +1,287 @@
+/** @file
+
+    Test cases for the HTTP/2 dependency tree and its scheduler.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one
+    or more contributor license agreements.  See the NOTICE file
+    distributed with this work for additional information
+    regarding copyright ownership.  The ASF licenses this file
+    to you under the Apache License, Version 2.0 (the
+    "License"); you may not use this file except in compliance
+    with the License.  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <cstring>
+#include <string>
+#include <set>
+#include <map>
+
+#include "ts/TestBox.h"
+#include "Http2DependencyTree.h"
+
+using namespace std;
+
+typedef Http2DependencyTree<const char *> Tree;
+
+// Children of stream @a id as a sorted list of names, "" for none and "?" if there is no such stream.
+static string
+children(Tree &tree, uint32_t id)
+{
+  Tree::Node *node = id ? tree.find(id) : tree.root();
+  if (node == NULL) {
+    return "?";
+  }
+
+  set<string> names;
+  for (Tree::Node *child = node->children.head; child; child = child->sibling_link.next) {
+    names.insert(child->t ? child->t : "-");
+  }
+
+  string s;
+  for (set<string>::iterator i = names.begin(); i != names.end(); ++i) {
+    s += (s.empty() ? "" : ",") + *i;
+  }
+  return s;
+}
+
+// Send @a frames frames of @a frame_size bytes and count the bytes sent by each stream.
+static void
+run(Tree &tree, int frames, uint32_t frame_size, map<string, uint64_t> &sent)
+{
+  for (int i = 0; i < frames; ++i) {
+    Tree::Node *node = tree.top();
+    if (node == NULL) {
+      break;
+    }
+    sent[node->t] += frame_size;
+    tree.update(node, frame_size);
+  }
+}
+
+static bool
+share_is(map<string, uint64_t> &sent, const char *name, double expected)
+{
+  uint64_t total = 0;
+  for (map<string, uint64_t>::iterator i = sent.begin(); i != sent.end(); ++i) {
+    total += i->second;
+  }
+  double share = static_cast<double>(sent[name]) / total;
+  return share > expected - 0.01 && share < expected + 0.01;
+}
+
+/* [RFC 7540] 5.3.1. Stream Dependencies
+
+       A                 A
+      / \      ==>       |
+     B   C               D
+                        / \
+                       B   C
+*/
+REGRESSION_TEST(Http2DependencyTree_Exclusive)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Tree tree(100);
+  tree.add(0, 1, 16, false, "A");
+  tree.add(1, 3, 16, false, "B");
+  tree.add(1, 5, 16, false, "C");
+  box.check(children(tree, 1) == "B,C", "A has children %s", children(tree, 1).c_str());
+
+  tree.add(1, 7, 16, true, "D");
+  box.check(children(tree, 1) == "D", "A has children %s after exclusive D", children(tree, 1).c_str());
+  box.check(children(tree, 7) == "B,C", "D has children %s", children(tree, 7).c_str());
+
+  // A dependency on a stream not in the tree gets the default priority.
+  Tree::Node *node = tree.add(99, 9, 200, true, "E");
+  box.check(node->parent == tree.root() && node->weight == HTTP2_PRIORITY_DEFAULT_WEIGHT, "E does not have the default priority");
+  box.check(children(tree, 0) == "A,E", "root has children %s", children(tree, 0).c_str());
+}
+
+/* [RFC 7540] 5.3.3. Reprioritization, A is made to depend on its descendant D
+
+       x                x                x
+       |                |                |
+       A                D                D
+      / \              / \               |
+     B   C     ==>    F   A      or      A
+        / \              / \            /|\
+       D   E            B   C          B C F
+       |                    |              |
+       F                    E              E
+                 (non-exclusive)     (exclusive)
+*/
+REGRESSION_TEST(Http2DependencyTree_Reprioritize)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  for (int exclusive = 0; exclusive < 2; ++exclusive) {
+    Tree tree(100);
+    tree.add(0, 1, 16, false, "A");
+    tree.add(1, 3, 16, false, "B");
+    tree.add(1, 5, 16, false, "C");
+    tree.add(5, 7, 16, false, "D");
+    tree.add(5, 9, 16, false, "E");
+    tree.add(7, 11, 16, false, "F");
+
+    tree.reprioritize(tree.find(1), 7, 16, exclusive);
+
+    box.check(children(tree, 0) == "D", "%d: root has children %s", exclusive, children(tree, 0).c_str());
+    box.check(children(tree, 5) == "E", "%d: C has children %s", exclusive, children(tree, 5).c_str());
+    if (exclusive) {
+      box.check(children(tree, 7) == "A", "%d: D has children %s", exclusive, children(tree, 7).c_str());
+      box.check(children(tree, 1) == "B,C,F", "%d: A has children %s", exclusive, children(tree, 1).c_str());
+    } else {
+      box.check(children(tree, 7) == "A,F", "%d: D has children %s", exclusive, children(tree, 7).c_str());
+      box.check(children(tree, 1) == "B,C", "%d: A has children %s", exclusive, children(tree, 1).c_str());
+    }
+  }
+}
+
+// [RFC 7540] 5.3.4. Prioritization State Management, the children of a removed stream share its weight.
+REGRESSION_TEST(Http2DependencyTree_Remove)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Tree tree(100);
+  tree.add(0, 1, 32, false, "A");
+  tree.add(1, 3, 16, false, "B");
+  tree.add(1, 5, 48, false, "C");
+  tree.activate(tree.find(5));
+
+  tree.remove(tree.find(1));
+  box.check(children(tree, 0) == "B,C", "root has children %s", children(tree, 0).c_str());
+  box.check(tree.find(3)->weight == 8 && tree.find(5)->weight == 24, "B and C have weights %u and %u", tree.find(3)->weight,
+            tree.find(5)->weight);
+  box.check(tree.top() == tree.find(5), "C is not scheduled after A is removed");
+}
+
+// Siblings share in proportion to their weights, a parent comes before its dependents.
+REGRESSION_TEST(Http2DependencyTree_Weights)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  /*     root
+        /    \
+      A(16)  B(16)
+      /  \
+    C(16) D(48)
+  */
+  Tree tree(100);
+  tree.add(0, 1, 16, false, "A");
+  tree.add(0, 3, 16, false, "B");
+  tree.add(1, 5, 16, false, "C");
+  tree.add(1, 7, 48, false, "D");
+  tree.activate(tree.find(3));
+  tree.activate(tree.find(5));
+  tree.activate(tree.find(7));
+
+  map<string, uint64_t> sent;
+  run(tree, 10000, 1000, sent);
+  box.check(share_is(sent, "B", 0.5) && share_is(sent, "C", 0.125) && share_is(sent, "D", 0.375),
+            "B, C and D sent %" PRIu64 ", %" PRIu64 " and %" PRIu64 " bytes", sent["B"], sent["C"], sent["D"]);
+
+  // Frames of different sizes do not change the shares.
+  sent.clear();
+  for (int i = 0; i < 10000; ++i) {
+    Tree::Node *node = tree.top();
+    uint32_t size = node->id == 3 ? 16384 : 1000;
+    sent[node->t] += size;
+    tree.update(node, size);
+  }
+  box.check(share_is(sent, "B", 0.5) && share_is(sent, "C", 0.125) && share_is(sent, "D", 0.375),
+            "B, C and D sent %" PRIu64 ", %" PRIu64 " and %" PRIu64 " bytes with large frames from B", sent["B"], sent["C"],
+            sent["D"]);
+
+  // Once A has something to send it goes first.
+  tree.activate(tree.find(1));
+  sent.clear();
+  run(tree, 10000, 1000, sent);
+  box.check(sent["C"] == 0 && sent["D"] == 0 && share_is(sent, "A", 0.5), "C and D sent while A was active");
+
+  // Deactivating everything empties the schedule.
+  tree.deactivate(tree.find(1));
+  tree.deactivate(tree.find(3));
+  tree.deactivate(tree.find(5));
+  tree.deactivate(tree.find(7));
+  box.check(tree.empty() && tree.top() == NULL, "the tree is not empty");
+}
+
+// A stream which had nothing to send does not catch up afterwards, and one which starts sending while a sibling is
+// busy is served in the next turn.
+REGRESSION_TEST(Http2DependencyTree_Idle)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Tree tree(100);
+  tree.add(0, 1, 16, false, "A");
+  tree.add(0, 3, 256, false, "B");
+  tree.activate(tree.find(1));
+
+  map<string, uint64_t> sent;
+  run(tree, 1000, 1000, sent);
+
+  // A has at most one turn left, 16 frames.
+  tree.activate(tree.find(3));
+  int frames = 0;
+  for (Tree::Node *node = tree.top(); node != tree.find(3); node = tree.top()) {
+    tree.update(node, 1000);
+    ++frames;
+  }
+  box.check(frames <= 17, "B waited %d frames for its turn", frames);
+
+  sent.clear();
+  run(tree, 2000, 1000, sent);
+  box.check(share_is(sent, "A", 16.0 / 272), "A sent %" PRIu64 " of %" PRIu64 " bytes after being alone", sent["A"],
+            sent["A"] + sent["B"]);
+}
+
+// Nodes of idle and closed streams are kept, up to a limit, for other streams to depend on.
+REGRESSION_TEST(Http2DependencyTree_Retain)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Tree tree(2);
+
+  // Idle streams as placeholders, as some clients group their requests.
+  tree.add(0, 3, 201, false, NULL);
+  tree.add(0, 5, 101, false, NULL);
+  tree.add(0, 7, 1, false, NULL);
+  box.check(tree.find(3) == NULL && tree.find(5) && tree.find(7), "the oldest placeholder is not the one removed");
+
+  Tree::Node *a = tree.add(5, 9, 16, false, "A");
+  Tree::Node *b = tree.find(7);
+  tree.claim(b, "B");
+  box.check(children(tree, 5) == "A" && b->t && !strcmp(b->t, "B"), "A does not depend on 5, or 7 is not B");
+
+  // Once A closes, its dependents still depend on it.
+  tree.add(9, 11, 16, false, "C");
+  tree.release(a);
+  box.check(tree.find(9) && children(tree, 9) == "C", "C no longer depends on A");
+
+  // Releasing B leaves 5, A and B without a stream, so 5 goes and A takes its place.
+  tree.release(b);
+  box.check(tree.find(5) == NULL && tree.find(9)->parent == tree.root(), "5 was not removed");
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char ** /* argv ATS_UNUSED */)
+{
+  RegressionTest::run();
+  return RegressionTest::final_status == REGRESSION_TEST_PASSED ? 0 : 1;
+}
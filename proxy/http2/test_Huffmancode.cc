@@ -22,6 +22,8 @@
 */
 
 #include "HuffmanCodec.h"
+#include "ts/ink_hrtime.h"
+#include "ts/ink_assert.h"
 #include <stdlib.h>
 #include <iostream>
 #include <assert.h>
@@ -135,6 +137,10 @@ values_test()
     encoded_mapped.y[3] = encoded.y[0];
 
     int bytes = huffman_decode(dst_start, encoded_mapped.y, encoded_size);
+    if (i / 2 == 256) { // EOS must be treated as a decoding error
+      assert(bytes == -1);
+      continue;
+    }
     char ascii_value = i / 2;
     assert(dst_start[0] == ascii_value);
     assert(bytes == 1);
@@ -171,6 +177,155 @@ encode_test()
   }
 }
 
+// The bit at a time tree walk huffman_decode() used to do, as a reference for the state machine.
+struct Node {
+  Node *left, *right;
+  int symbol;
+};
+
+static Node *
+make_tree()
+{
+  Node *root = new Node();
+  for (int i = 0; i < (int)(sizeof(test_values) / 4); i += 2) {
+    Node *current = root;
+    for (uint32_t bit_len = test_values[i + 1]; bit_len > 0; bit_len--) {
+      Node *&next = (test_values[i] & (1 << (bit_len - 1))) ? current->right : current->left;
+      if (!next)
+        next = new Node();
+      current = next;
+    }
+    current->symbol = i / 2;
+  }
+  return root;
+}
+
+static void
+free_tree(Node *node)
+{
+  if (node) {
+    free_tree(node->left);
+    free_tree(node->right);
+    delete node;
+  }
+}
+
+static int64_t
+tree_decode(Node *root, char *dst_start, const uint8_t *src, uint32_t src_len)
+{
+  char *dst_end = dst_start;
+  Node *current = root;
+
+  for (uint32_t i = 0; i < src_len; i++) {
+    for (int shift = 7; shift >= 0; shift--) {
+      current = (src[i] & (1 << shift)) ? current->right : current->left;
+      if (!current->left && !current->right) {
+        *dst_end++ = current->symbol;
+        current = root;
+      }
+    }
+  }
+  return dst_end - dst_start;
+}
+
+// Round trip random strings through the encoder and both decoders.
+void
+decode_test(Node *root)
+{
+  const int size = 256;
+  uint8_t src[size];
+  uint8_t encoded[size * 4];
+  char decoded[size * 2];
+  char reference[size * 2];
+
+  for (int n = 0; n < 1000; n++) {
+    int len = lrand48() % size;
+    for (int i = 0; i < len; i++)
+      src[i] = (uint8_t)lrand48();
+
+    int64_t encoded_len = huffman_encode(encoded, src, len);
+    int64_t decoded_len = huffman_decode(decoded, encoded, encoded_len);
+    assert(decoded_len == len);
+    assert(memcmp(decoded, src, len) == 0);
+    int64_t reference_len = tree_decode(root, reference, encoded, encoded_len);
+    assert(reference_len == len);
+    assert(memcmp(reference, src, len) == 0);
+  }
+}
+
+// RFC 7541 5.2: padding longer than 7 bits, padding which isn't the EOS prefix and EOS itself are errors.
+const static struct {
+  const char *src;
+  uint32_t src_len;
+  int64_t expect_len;
+} huffman_padding_test_data[] = {
+  {"\x07", 1, 1},                 // "0" + 111
+  {"\x00", 1, -1},                // "0" + 000
+  {"\x06", 1, -1},                // "0" + 110
+  {"\xff", 1, -1},                // 8 bits of padding
+  {"\x07\xff", 2, -1},            // "0" + 11 bits of padding
+  {"\xff\xc7", 2, 1},             // '\0' (1111111111000) + 111
+  {"\xff\xff\xff\xfc", 4, -1},    // EOS + 00
+  {"\xff\xff\xff\xff", 4, -1},    // EOS + 11
+  {"\xfe", 1, -1},                // incomplete '!' (1111111000)
+};
+
+void
+padding_test()
+{
+  char dst[16];
+  for (unsigned i = 0; i < sizeof(huffman_padding_test_data) / sizeof(huffman_padding_test_data[0]); i++) {
+    int64_t len = huffman_decode(dst, (const uint8_t *)huffman_padding_test_data[i].src, huffman_padding_test_data[i].src_len);
+    assert(len == huffman_padding_test_data[i].expect_len);
+  }
+}
+
+// Decode a set of cookie and user agent like values, different ones so the branches of the tree walk are not learned.
+void
+benchmark(Node *root)
+{
+  const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789=;._-/() ";
+  const int n_values = 64;
+  const int value_len = 256;
+  const int rounds = 2000;
+  uint8_t *encoded[n_values];
+  int64_t encoded_len[n_values];
+  int64_t total = 0;
+  char decoded[value_len * 2];
+
+  for (int i = 0; i < n_values; i++) {
+    uint8_t value[value_len];
+    for (int j = 0; j < value_len; j++)
+      value[j] = alphabet[lrand48() % (sizeof(alphabet) - 1)];
+    encoded[i] = (uint8_t *)malloc(value_len * 4);
+    encoded_len[i] = huffman_encode(encoded[i], value, value_len);
+    total += encoded_len[i];
+  }
+
+  // The decoded lengths are checked with ink_release_assert, so the calls are timed in release builds too.
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < n_values; i++) {
+      int64_t len = tree_decode(root, decoded, encoded[i], encoded_len[i]);
+      ink_release_assert(len == value_len);
+    }
+  ink_hrtime tree = ink_get_hrtime_internal() - start;
+
+  start = ink_get_hrtime_internal();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < n_values; i++) {
+      int64_t len = huffman_decode(decoded, encoded[i], encoded_len[i]);
+      ink_release_assert(len == value_len);
+    }
+  ink_hrtime table = ink_get_hrtime_internal() - start;
+
+  cout << "decode: tree " << (double)tree / (rounds * total) << " ns/byte, table " << (double)table / (rounds * total) << " ns/byte"
+       << endl;
+
+  for (int i = 0; i < n_values; i++)
+    free(encoded[i]);
+}
+
 int
 main()
 {
@@ -180,6 +335,12 @@ main()
     random_test();
   }
   values_test();
+  padding_test();
+
+  Node *root = make_tree();
+  decode_test(root);
+  benchmark(root);
+  free_tree(root);
 
   hpack_huffman_fin();
 
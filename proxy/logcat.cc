@@ -41,6 +41,7 @@
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogUtils.h"
 #include "LogSock.h"
 #include "Log.h"
@@ -53,7 +54,10 @@ static int elf_flag = 0;
 static int elf2_flag = 0;
 static int auto_filenames = 0;
 static int overwrite_existing_file = 0;
+static int columnar_flag = 0;
 static char output_file[1024];
+static char field_symbol[256];
+static LogField *field = NULL;
 int auto_clear_cache_flag = 0;
 
 static const ArgumentDescription argument_descriptions[] = {
@@ -67,15 +71,146 @@ static const ArgumentDescription argument_descriptions[] = {
   {"debug_tags", 'T', "Colon-Separated Debug Tags", "S1023", error_tags, NULL, NULL},
   {"overwrite_output", 'w', "Overwrite existing output file(s)", "T", &overwrite_existing_file, NULL, NULL},
   {"elf2", '2', "Convert to Extended2 Logging Format", "T", &elf2_flag, NULL, NULL},
+  {"columnar", 'c', "Rewrite binary logs in the columnar format", "T", &columnar_flag, NULL, NULL},
+  {"field", 'F', "Print only the field with this symbol", "S255", field_symbol, NULL, NULL},
   HELP_ARGUMENT_DESCRIPTION(),
   VERSION_ARGUMENT_DESCRIPTION()};
 
+static int
+write_segment(const char *segment, uint32_t len, int out_fd)
+{
+  uint32_t written = 0;
+
+  while (written < len) {
+    int rc = write(out_fd, segment + written, len - written);
+    if (rc < 0) {
+      perror("Error writing segment");
+      return 1;
+    }
+    written += rc;
+  }
+  return 0;
+}
+
+/*-------------------------------------------------------------------------
+  print_field
+
+  Write the values of the requested field in a columnar segment, one per
+  line, decoding only its column.
+  -------------------------------------------------------------------------*/
+
+static int
+print_field(const LogColumnarSegment &segment, int out_fd)
+{
+  int col = segment.find_column(field_symbol);
+  if (col < 0) {
+    return 0; // the format of this segment does not have the field
+  }
+
+  LogColumn column;
+  if (!segment.decode_column(col, &column)) {
+    fprintf(stderr, "Bad columnar segment!\n");
+    return 1;
+  }
+
+  char fmt_buf[LOG_MAX_FORMATTED_BUFFER];
+  int64_t value[LOG_MAX_FORMATTED_LINE / sizeof(int64_t)]; // aligned for the unmarshalling
+  int fmt_buf_bytes = 0;
+
+  for (int row = 0; row < column.rows(); row++) {
+    int len;
+    const char *data = column.data(row, &len);
+
+    if (len >= (int)sizeof(value)) {
+      continue;
+    }
+    memcpy(value, data, len);
+    ((char *)value)[len] = '\0';
+
+    if (fmt_buf_bytes + LOG_MAX_FORMATTED_LINE >= LOG_MAX_FORMATTED_BUFFER) {
+      LogFile::writeln(fmt_buf, fmt_buf_bytes, out_fd, ".");
+      fmt_buf_bytes = 0;
+    }
+    char *read_from = (char *)value;
+    int n = field->unmarshal(&read_from, &fmt_buf[fmt_buf_bytes], LOG_MAX_FORMATTED_LINE - 1);
+    if (n > 0) {
+      fmt_buf_bytes += n;
+    }
+    fmt_buf[fmt_buf_bytes++] = '\n';
+  }
+  if (fmt_buf_bytes > 0) {
+    LogFile::writeln(fmt_buf, fmt_buf_bytes, out_fd, ".");
+  }
+  return 0;
+}
+
+/*-------------------------------------------------------------------------
+  process_segment
+
+  Convert one segment of a binary log, LogBuffer or columnar, to ASCII or
+  to the columnar format, or print a field of it.
+  -------------------------------------------------------------------------*/
+
+static int
+process_segment(const char *segment, uint32_t len, int out_fd)
+{
+  static char columnar[MAX_LOGBUFFER_SIZE];
+  static char buffer[MAX_LOGBUFFER_SIZE];
+  LogColumnarSegment columnar_segment;
+  LogBufferHeader *header = NULL;
+
+  if (LogColumnarSegment::is_columnar(segment)) {
+    if (!columnar_segment.init(segment, len)) {
+      fprintf(stderr, "Bad columnar segment!\n");
+      return 1;
+    }
+    if (field) {
+      return print_field(columnar_segment, out_fd);
+    }
+    if (columnar_flag) {
+      return write_segment(segment, len, out_fd);
+    }
+    if (columnar_segment.to_buffer(buffer, sizeof(buffer)) == 0) {
+      fprintf(stderr, "Bad columnar segment!\n");
+      return 1;
+    }
+    header = (LogBufferHeader *)buffer;
+  } else {
+    header = (LogBufferHeader *)segment;
+    if (field) {
+      // encode the buffer, to print the field the same way
+      int bytes = LogColumnarSegment::encode(header, NULL, LOG_COLUMNAR_COMPRESS_NONE, columnar, sizeof(columnar));
+      if (bytes == 0 || !columnar_segment.init(columnar, bytes)) {
+        return 0;
+      }
+      return print_field(columnar_segment, out_fd);
+    }
+    if (columnar_flag) {
+      // buffers which do not get smaller are kept as they are
+      int bytes = LogColumnarSegment::encode(header, NULL, LOG_COLUMNAR_COMPRESS_FASTLZ, columnar, MIN(len, sizeof(columnar)));
+      return bytes > 0 ? write_segment(columnar, bytes, out_fd) : write_segment(segment, len, out_fd);
+    }
+  }
+
+  // see if there is an alternate format request from the command
+  // line
+  //
+  const char *alt_format = NULL;
+  // convert the buffer to ascii entries and place onto stdout
+  //
+  if (header->fmt_fieldlist()) {
+    LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format);
+  } else {
+    // TODO investigate why this buffer goes wonky
+  }
+  return 0;
+}
+
 static int
 process_file(int in_fd, int out_fd)
 {
   char buffer[MAX_LOGBUFFER_SIZE];
   int nread, buffer_bytes;
-  unsigned bytes = 0;
 
   while (true) {
     // read the next buffer from file descriptor
@@ -94,9 +229,10 @@ process_file(int in_fd, int out_fd)
     if (!nread || nread == EOF)
       return 0;
 
-    // ensure that this is a valid logbuffer header
+    // ensure that this is a valid logbuffer header, columnar segments
+    // are always bigger than one and have the byte count in the same place
     //
-    if (header->cookie != LOG_SEGMENT_COOKIE) {
+    if (header->cookie != LOG_SEGMENT_COOKIE && !LogColumnarSegment::is_columnar(header)) {
       fprintf(stderr, "Bad LogBuffer!\n");
       return 1;
     }
@@ -145,18 +281,39 @@ process_file(int in_fd, int out_fd)
       fprintf(stderr, "Read too many bytes!\n");
       return 1;
     }
-    // see if there is an alternate format request from the command
-    // line
-    //
-    const char *alt_format = NULL;
-    // convert the buffer to ascii entries and place onto stdout
-    //
-    if (header->fmt_fieldlist()) {
-      bytes += LogFile::write_ascii_logbuffer(header, out_fd, ".", alt_format);
-    } else {
-      // TODO investigate why this buffer goes wonky
+    if (process_segment(buffer, byte_count, out_fd) != 0) {
+      return 1;
+    }
+  }
+}
+
+/*-------------------------------------------------------------------------
+  process_mapped_file
+
+  Like process_file, for a log file which is not being followed, mapped
+  into memory rather than read.  Returns -1 if it can not be mapped.
+  -------------------------------------------------------------------------*/
+
+static int
+process_mapped_file(int in_fd, int out_fd)
+{
+  LogSegmentReader reader;
+  const char *segment;
+  uint32_t len;
+
+  if (!reader.open(in_fd)) {
+    return -1;
+  }
+  while ((segment = reader.next(&len))) {
+    if (process_segment(segment, len, out_fd) != 0) {
+      return 1;
     }
   }
+  if (reader.error()) {
+    fprintf(stderr, "Bad LogBuffer!\n");
+    return 1;
+  }
+  return 0;
 }
 
 static int
@@ -221,12 +378,23 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
     fprintf(stderr, "Error: specify only one of -o <file> and -a\n");
     _exit(CMD_LINE_OPTION_ERROR);
   }
+  // the automatic names are for ASCII output
+  //
+  if ((columnar_flag || field_symbol[0] != 0) && auto_filenames) {
+    fprintf(stderr, "Error: -a can not be used with -c or -F\n");
+    _exit(CMD_LINE_OPTION_ERROR);
+  }
   // initialize this application for standalone logging operation
   //
   init_log_standalone_basic(PROGRAM_NAME);
 
   Log::init(Log::NO_REMOTE_MANAGEMENT | Log::LOGCAT);
 
+  if (field_symbol[0] != 0 && (field = Log::global_field_list.find_by_symbol(field_symbol)) == NULL) {
+    fprintf(stderr, "Error: unknown field symbol %s\n", field_symbol);
+    _exit(CMD_LINE_OPTION_ERROR);
+  }
+
   // setup output file
   //
   int out_fd = STDOUT_FILENO;
@@ -282,6 +450,14 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
         }
         if (follow_flag)
           lseek(in_fd, 0, SEEK_END);
+        else {
+          int rc = process_mapped_file(in_fd, out_fd);
+          if (rc >= 0) {
+            if (rc != 0)
+              error = DATA_PROCESSING_ERROR;
+            continue;
+          }
+        }
 
         while (true) {
           if (process_file(in_fd, out_fd) != 0) {
@@ -1214,14 +1214,15 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
       bytes_written = 0;
       logfile = fdata->m_logfile;
 
-      if (logfile->m_file_format == LOG_FILE_BINARY) {
+      if (logfile->m_file_format == LOG_FILE_BINARY && fdata->m_len < 0) {
         logbuffer = (LogBuffer *)fdata->m_data;
         LogBufferHeader *buffer_header = logbuffer->header();
 
         buf = (char *)buffer_header;
         total_bytes = buffer_header->byte_count;
 
-      } else if (logfile->m_file_format == LOG_FILE_ASCII || logfile->m_file_format == LOG_FILE_PIPE) {
+      } else if (logfile->m_file_format == LOG_FILE_BINARY || logfile->m_file_format == LOG_FILE_ASCII ||
+                 logfile->m_file_format == LOG_FILE_PIPE) {
         buf = (char *)fdata->m_data;
         total_bytes = fdata->m_len;
 
@@ -329,8 +329,13 @@ public:
   {
     switch (m_logfile->m_file_format) {
     case LOG_FILE_BINARY:
-      logbuffer = (LogBuffer *)m_data;
-      LogBuffer::destroy(logbuffer);
+      // a columnar segment comes with its length
+      if (m_len < 0) {
+        logbuffer = (LogBuffer *)m_data;
+        LogBuffer::destroy(logbuffer);
+      } else {
+        ats_free(m_data);
+      }
       break;
     case LOG_FILE_ASCII:
     case LOG_FILE_PIPE:
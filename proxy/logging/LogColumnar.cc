@@ -0,0 +1,698 @@
+/** @file
+
+  Columnar segments of binary log files.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "ts/ink_platform.h"
+#include "ts/HashFNV.h"
+#include "ts/fastlz.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if TS_HAS_LIBZ
+#include <zlib.h>
+#endif
+#include "Error.h"
+#include "P_EventSystem.h"
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogColumnar.h"
+
+// Where the bytes of one field of one entry are, in the LogBuffer.
+struct LogColumnSpan {
+  uint32_t offset;
+  uint32_t len;
+};
+
+static inline char *
+put_varint(char *p, uint64_t v)
+{
+  while (v >= 0x80) {
+    *p++ = (char)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (char)v;
+  return p;
+}
+
+// Returns NULL if the varint runs past @a end.
+static inline const char *
+get_varint(const char *p, const char *end, uint64_t *v)
+{
+  uint64_t val = 0;
+
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    uint8_t b = *p++;
+    val |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      *v = val;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+static inline uint64_t
+zigzag(int64_t v)
+{
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t
+unzigzag(uint64_t v)
+{
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static int
+encode_delta(const int64_t *values, int rows, char *out)
+{
+  char *p = out;
+  int64_t prev = 0;
+
+  for (int i = 0; i < rows; i++) {
+    p = put_varint(p, zigzag(values[i] - prev));
+    prev = values[i];
+  }
+  return p - out;
+}
+
+/*-------------------------------------------------------------------------
+  encode_bytes
+
+  Lays down the values of a column which is not delta encoded, as a
+  dictionary if no more than half of them are distinct.  @a table has room
+  for twice the rows, rounded up to a power of two, and @a index for the
+  rows.
+  -------------------------------------------------------------------------*/
+
+static int
+encode_bytes(const char *base, const LogColumnSpan *spans, int rows, int32_t *table, int table_size, int32_t *index, char *out,
+             LogColumnEncoding *encoding)
+{
+  char *p = out;
+  int distinct = 0;
+
+  memset(table, -1, table_size * sizeof(int32_t));
+  for (int i = 0; i < rows; i++) {
+    ATSHash32FNV1a hash;
+    hash.update(base + spans[i].offset, spans[i].len);
+    hash.final();
+
+    int slot = hash.get() & (table_size - 1);
+    for (;;) {
+      int32_t first = table[slot];
+      if (first < 0) {
+        table[slot] = i;
+        index[i] = distinct++;
+        break;
+      }
+      if (spans[first].len == spans[i].len && memcmp(base + spans[first].offset, base + spans[i].offset, spans[i].len) == 0) {
+        index[i] = index[first];
+        break;
+      }
+      slot = (slot + 1) & (table_size - 1);
+    }
+  }
+
+  if (distinct * 2 > rows) {
+    *encoding = LOG_COLUMN_PLAIN;
+    for (int i = 0; i < rows; i++) {
+      p = put_varint(p, spans[i].len);
+      memcpy(p, base + spans[i].offset, spans[i].len);
+      p += spans[i].len;
+    }
+  } else {
+    *encoding = LOG_COLUMN_DICTIONARY;
+    p = put_varint(p, distinct);
+    for (int i = 0, next = 0; i < rows; i++) {
+      if (index[i] == next) {
+        p = put_varint(p, spans[i].len);
+        memcpy(p, base + spans[i].offset, spans[i].len);
+        p += spans[i].len;
+        ++next;
+      }
+    }
+    for (int i = 0; i < rows; i++) {
+      p = put_varint(p, index[i]);
+    }
+  }
+  return p - out;
+}
+
+static int
+compressed_bound(int len)
+{
+  int bound = (int)((double)len * 1.05 + 66); // fastlz
+#if TS_HAS_LIBZ
+  bound = MAX(bound, (int)compressBound(len));
+#endif
+  return bound;
+}
+
+// Returns the compressed length, or 0 if @a in is not worth compressing.
+static int
+compress_column(LogColumnarCompression compression, const char *in, int in_len, char *out, int out_len)
+{
+  switch (compression) {
+  case LOG_COLUMNAR_COMPRESS_FASTLZ:
+    if (in_len >= 16) { // fastlz minimum
+      return fastlz_compress(in, in_len, out);
+    }
+    break;
+#if TS_HAS_LIBZ
+  case LOG_COLUMNAR_COMPRESS_LIBZ: {
+    uLongf len = out_len;
+    if (compress2((Bytef *)out, &len, (const Bytef *)in, in_len, Z_BEST_SPEED) == Z_OK) {
+      return len;
+    }
+    break;
+  }
+#endif
+  default:
+    break;
+  }
+  return 0;
+}
+
+static bool
+decompress_column(LogColumnarCompression compression, const char *in, int in_len, char *out, int out_len)
+{
+  switch (compression) {
+  case LOG_COLUMNAR_COMPRESS_FASTLZ:
+    return fastlz_decompress(in, in_len, out, out_len) == out_len;
+#if TS_HAS_LIBZ
+  case LOG_COLUMNAR_COMPRESS_LIBZ: {
+    uLongf len = out_len;
+    return uncompress((Bytef *)out, &len, (const Bytef *)in, in_len) == Z_OK && (int)len == out_len;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+/*-------------------------------------------------------------------------
+  LogColumn
+  -------------------------------------------------------------------------*/
+
+LogColumn::LogColumn() : m_encoding(LOG_COLUMN_DELTA), m_rows(0), m_values(NULL), m_data(NULL), m_lens(NULL), m_raw(NULL)
+{
+}
+
+LogColumn::~LogColumn()
+{
+  clear();
+}
+
+void
+LogColumn::clear()
+{
+  ats_free(m_values);
+  ats_free(m_data);
+  ats_free(m_lens);
+  ats_free(m_raw);
+  m_values = NULL;
+  m_data = NULL;
+  m_lens = NULL;
+  m_raw = NULL;
+  m_rows = 0;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnarSegment::encode
+
+  Splits each entry into its fields by unmarshalling them, as to_ascii
+  would.  Fields the unmarshalling can not account for, such as ones whose
+  symbol this build does not know, end up in the trailing column, so the
+  segment still holds every byte of the buffer.
+  -------------------------------------------------------------------------*/
+
+int
+LogColumnarSegment::encode(LogBufferHeader *header, LogFieldList *fieldlist, LogColumnarCompression compression, char *out,
+                           int out_len)
+{
+  if (header->cookie != LOG_SEGMENT_COOKIE || header->version != LOG_SEGMENT_VERSION || header->entry_count == 0 ||
+      header->data_offset < sizeof(LogBufferHeader) || header->data_offset > header->byte_count ||
+      header->fmt_fieldlist() == NULL) {
+    return 0;
+  }
+
+  LogFieldList parsed_fieldlist;
+  if (!fieldlist) {
+    bool contains_aggregates = false;
+    LogFormat::parse_symbol_string(header->fmt_fieldlist(), &parsed_fieldlist, &contains_aggregates);
+    fieldlist = &parsed_fieldlist;
+  }
+
+  int nfields = fieldlist->count();
+  int ncolumns = LOG_COLUMN_FIRST_FIELD + nfields + 1;
+  int rows = header->entry_count;
+  char *buffer = (char *)header;
+  char *end = buffer + header->byte_count;
+  LogField **fields = (LogField **)ats_malloc(nfields * sizeof(LogField *));
+  LogColumnSpan *spans = (LogColumnSpan *)ats_malloc((nfields + 1) * rows * sizeof(LogColumnSpan));
+  int64_t *ints = (int64_t *)ats_malloc(2 * rows * sizeof(int64_t)); // the timestamps, then field values
+  int table_size = 1;
+  while (table_size < 2 * rows) {
+    table_size <<= 1;
+  }
+  int32_t *table = (int32_t *)ats_malloc((table_size + rows) * sizeof(int32_t));
+  int raw_room = header->byte_count + 10 * rows + 16;
+  char *raw = (char *)ats_malloc(raw_room + compressed_bound(raw_room));
+  char *packed = raw + raw_room;
+  char scratch[LOG_MAX_FORMATTED_LINE];
+  int bytes = 0;
+
+  int i = 0;
+  for (LogField *f = fieldlist->first(); f; f = fieldlist->next(f)) {
+    fields[i++] = f;
+  }
+
+  // Find the fields of every entry.
+  char *entry = buffer + header->data_offset;
+  for (int row = 0; row < rows; row++) {
+    LogEntryHeader *entry_header = (LogEntryHeader *)entry;
+    if (entry + sizeof(LogEntryHeader) > end || entry_header->entry_len < sizeof(LogEntryHeader) ||
+        entry + entry_header->entry_len > end) {
+      goto Lfail;
+    }
+
+    char *entry_end = entry + entry_header->entry_len;
+    char *read_from = entry + sizeof(LogEntryHeader);
+    bool lost = false;
+
+    ints[row] = entry_header->timestamp;
+    ints[rows + row] = entry_header->timestamp_usec;
+    for (int col = 0; col < nfields; col++) {
+      char *next = read_from;
+      if (!lost) {
+        fields[col]->unmarshal(&next, scratch, sizeof(scratch));
+        if (next <= read_from || next > entry_end) {
+          lost = true;
+          next = read_from;
+        }
+      }
+      spans[col * rows + row].offset = read_from - buffer;
+      spans[col * rows + row].len = next - read_from;
+      read_from = next;
+    }
+    spans[nfields * rows + row].offset = read_from - buffer;
+    spans[nfields * rows + row].len = entry_end - read_from;
+    entry = entry_end;
+  }
+  if (entry != end) {
+    goto Lfail;
+  }
+
+  {
+    LogColumnarHeader *columnar = (LogColumnarHeader *)out;
+    LogColumnDesc *columns = (LogColumnDesc *)(out + sizeof(LogColumnarHeader));
+    uint32_t header_offset = buffer_header_offset(ncolumns);
+    uint32_t names_offset = INK_ALIGN_DEFAULT(header_offset + header->data_offset);
+    int offset = names_offset;
+
+    if (names_offset > (uint32_t)out_len) {
+      goto Lfail;
+    }
+    memset(out, 0, names_offset);
+    memcpy(out + header_offset, buffer, header->data_offset);
+
+    for (i = 0; i < nfields; i++) {
+      int len = strlen(fields[i]->symbol());
+      if (offset + len + 1 > out_len) {
+        goto Lfail;
+      }
+      if (i) {
+        out[offset++] = ',';
+      }
+      memcpy(out + offset, fields[i]->symbol(), len);
+      offset += len;
+    }
+    if (offset >= out_len) {
+      goto Lfail;
+    }
+    out[offset++] = '\0';
+
+    for (int col = 0; col < ncolumns; col++) {
+      LogColumnEncoding encoding = LOG_COLUMN_DELTA;
+      int raw_len;
+
+      if (col < LOG_COLUMN_FIRST_FIELD) {
+        raw_len = encode_delta(ints + col * rows, rows, raw);
+      } else {
+        int field = col - LOG_COLUMN_FIRST_FIELD;
+        const LogColumnSpan *column_spans = spans + field * rows;
+        bool is_int = field < nfields && (fields[field]->type() == LogField::sINT || fields[field]->type() == LogField::dINT);
+
+        for (int row = 0; is_int && row < rows; row++) {
+          if (column_spans[row].len == sizeof(int64_t)) {
+            memcpy(&ints[row], buffer + column_spans[row].offset, sizeof(int64_t));
+          } else {
+            is_int = false;
+          }
+        }
+        if (is_int) {
+          raw_len = encode_delta(ints, rows, raw);
+        } else {
+          raw_len = encode_bytes(buffer, column_spans, rows, table, table_size, table + table_size, raw, &encoding);
+        }
+      }
+
+      int packed_len = compress_column(compression, raw, raw_len, packed, compressed_bound(raw_len));
+      bool use_packed = packed_len > 0 && packed_len < raw_len;
+      int stored_len = use_packed ? packed_len : raw_len;
+
+      if (offset + stored_len > out_len) {
+        goto Lfail;
+      }
+      memcpy(out + offset, use_packed ? packed : raw, stored_len);
+      columns[col].encoding = encoding;
+      columns[col].compression = use_packed ? compression : LOG_COLUMNAR_COMPRESS_NONE;
+      columns[col].offset = offset;
+      columns[col].stored_bytes = stored_len;
+      columns[col].raw_bytes = raw_len;
+      offset += stored_len;
+    }
+
+    // Keep the segments which follow aligned.
+    bytes = INK_ALIGN_DEFAULT(offset);
+    if (bytes > out_len) {
+      bytes = 0;
+      goto Lfail;
+    }
+    memset(out + offset, 0, bytes - offset);
+
+    columnar->cookie = LOG_COLUMNAR_COOKIE;
+    columnar->version = LOG_COLUMNAR_VERSION;
+    columnar->entry_count = rows;
+    columnar->byte_count = bytes;
+    columnar->buffer_bytes = header->byte_count;
+    columnar->header_bytes = header->data_offset;
+    columnar->column_count = ncolumns;
+    columnar->names_offset = names_offset;
+  }
+
+Lfail:
+  ats_free(raw);
+  ats_free(table);
+  ats_free(ints);
+  ats_free(spans);
+  ats_free(fields);
+  return bytes;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnarSegment::init
+  -------------------------------------------------------------------------*/
+
+bool
+LogColumnarSegment::init(const char *data, uint32_t len)
+{
+  LogColumnarHeader *header = (LogColumnarHeader *)data;
+
+  m_header = NULL;
+  m_columns = NULL;
+  if (len < sizeof(LogColumnarHeader) || header->cookie != LOG_COLUMNAR_COOKIE || header->version != LOG_COLUMNAR_VERSION ||
+      header->byte_count > len || header->column_count < LOG_COLUMN_FIRST_FIELD + 1 || header->column_count > len ||
+      header->header_bytes < sizeof(LogBufferHeader)) {
+    return false;
+  }
+
+  uint32_t header_offset = buffer_header_offset(header->column_count);
+  if (header_offset + header->header_bytes > header->byte_count ||
+      ((LogBufferHeader *)(data + header_offset))->data_offset != header->header_bytes ||
+      ((LogBufferHeader *)(data + header_offset))->byte_count != header->buffer_bytes ||
+      header->names_offset >= header->byte_count ||
+      memchr(data + header->names_offset, '\0', header->byte_count - header->names_offset) == NULL) {
+    return false;
+  }
+
+  // The buffer holds its header and then the entries, each at least a LogEntryHeader, so this also keeps the row
+  // count an int.
+  if (header->header_bytes > header->buffer_bytes ||
+      header->entry_count > (header->buffer_bytes - header->header_bytes) / sizeof(LogEntryHeader)) {
+    return false;
+  }
+
+  // Every row takes at least a byte of each column, and no column decodes to more than the encoder could have made of
+  // the buffer, so a corrupt count can not make decode_column allocate without bound.
+  uint64_t max_raw_bytes = (uint64_t)header->buffer_bytes * 2 + 10 * (uint64_t)header->entry_count + 16;
+  LogColumnDesc *columns = (LogColumnDesc *)(data + sizeof(LogColumnarHeader));
+  for (uint32_t i = 0; i < header->column_count; i++) {
+    if (columns[i].encoding >= N_LOG_COLUMN_ENCODINGS || columns[i].compression >= N_LOG_COLUMNAR_COMPRESS ||
+        columns[i].offset > header->byte_count || columns[i].stored_bytes > header->byte_count - columns[i].offset ||
+        columns[i].raw_bytes < header->entry_count || columns[i].raw_bytes > max_raw_bytes) {
+      return false;
+    }
+  }
+  if (columns[LOG_COLUMN_TIMESTAMP].encoding != LOG_COLUMN_DELTA ||
+      columns[LOG_COLUMN_TIMESTAMP_USEC].encoding != LOG_COLUMN_DELTA) {
+    return false;
+  }
+
+  m_header = header;
+  m_columns = columns;
+  return true;
+}
+
+int
+LogColumnarSegment::find_column(const char *symbol) const
+{
+  const char *names = (const char *)m_header + m_header->names_offset;
+  int len = strlen(symbol);
+
+  for (int col = LOG_COLUMN_FIRST_FIELD; col < (int)m_header->column_count - 1; col++) {
+    const char *comma = strchr(names, ',');
+    int name_len = comma ? comma - names : strlen(names);
+
+    if (name_len == len && memcmp(names, symbol, len) == 0) {
+      return col;
+    }
+    if (!comma) {
+      break;
+    }
+    names = comma + 1;
+  }
+  return -1;
+}
+
+bool
+LogColumnarSegment::decode_column(int idx, LogColumn *column) const
+{
+  const LogColumnDesc *desc = &m_columns[idx];
+  int rows = m_header->entry_count;
+  const char *p = (const char *)m_header + desc->offset;
+  const char *end;
+  uint64_t v;
+
+  column->clear();
+  if (desc->compression == LOG_COLUMNAR_COMPRESS_NONE) {
+    if (desc->stored_bytes != desc->raw_bytes) {
+      return false;
+    }
+  } else {
+    column->m_raw = (char *)ats_malloc(desc->raw_bytes);
+    if (!decompress_column((LogColumnarCompression)desc->compression, p, desc->stored_bytes, column->m_raw, desc->raw_bytes)) {
+      column->clear();
+      return false;
+    }
+    p = column->m_raw;
+  }
+  end = p + desc->raw_bytes;
+
+  column->m_encoding = (LogColumnEncoding)desc->encoding;
+  column->m_rows = rows;
+  if (column->m_encoding == LOG_COLUMN_DELTA) {
+    int64_t prev = 0;
+
+    column->m_values = (int64_t *)ats_malloc(rows * sizeof(int64_t));
+    for (int i = 0; i < rows; i++) {
+      if ((p = get_varint(p, end, &v)) == NULL) {
+        goto Lbad;
+      }
+      prev += unzigzag(v);
+      column->m_values[i] = prev;
+    }
+  } else {
+    column->m_data = (const char **)ats_malloc(rows * sizeof(const char *));
+    column->m_lens = (int *)ats_malloc(rows * sizeof(int));
+    if (column->m_encoding == LOG_COLUMN_DICTIONARY) {
+      uint64_t distinct;
+
+      if ((p = get_varint(p, end, &distinct)) == NULL || distinct > (uint64_t)rows) {
+        goto Lbad;
+      }
+      const char **dict_data = (const char **)ats_malloc(distinct * sizeof(const char *));
+      int *dict_lens = (int *)ats_malloc(distinct * sizeof(int));
+      bool ok = true;
+
+      for (uint64_t i = 0; ok && i < distinct; i++) {
+        ok = (p = get_varint(p, end, &v)) != NULL && v <= (uint64_t)(end - p);
+        if (ok) {
+          dict_data[i] = p;
+          dict_lens[i] = v;
+          p += v;
+        }
+      }
+      for (int i = 0; ok && i < rows; i++) {
+        ok = (p = get_varint(p, end, &v)) != NULL && v < distinct;
+        if (ok) {
+          column->m_data[i] = dict_data[v];
+          column->m_lens[i] = dict_lens[v];
+        }
+      }
+      ats_free(dict_lens);
+      ats_free(dict_data);
+      if (!ok) {
+        goto Lbad;
+      }
+    } else {
+      for (int i = 0; i < rows; i++) {
+        if ((p = get_varint(p, end, &v)) == NULL || v > (uint64_t)(end - p)) {
+          goto Lbad;
+        }
+        column->m_data[i] = p;
+        column->m_lens[i] = v;
+        p += v;
+      }
+    }
+  }
+  if (p == end) {
+    return true;
+  }
+
+Lbad:
+  column->clear();
+  return false;
+}
+
+int
+LogColumnarSegment::to_buffer(char *buf, int len) const
+{
+  int ncolumns = m_header->column_count;
+  int rows = m_header->entry_count;
+  int bytes = 0;
+
+  if (m_header->buffer_bytes > (uint32_t)len) {
+    return 0;
+  }
+
+  LogColumn *columns = new LogColumn[ncolumns];
+  for (int col = 0; col < ncolumns; col++) {
+    if (!decode_column(col, &columns[col])) {
+      goto Ldone;
+    }
+  }
+
+  {
+    char *p = buf + m_header->header_bytes;
+    char *end = buf + m_header->buffer_bytes;
+
+    memcpy(buf, buffer_header(), m_header->header_bytes);
+    for (int row = 0; row < rows; row++) {
+      LogEntryHeader *entry_header = (LogEntryHeader *)p;
+      char *q = p + sizeof(LogEntryHeader);
+
+      if (q > end) {
+        goto Ldone;
+      }
+      for (int col = LOG_COLUMN_FIRST_FIELD; col < ncolumns; col++) {
+        int field_len;
+        const char *field = columns[col].data(row, &field_len);
+        if (field_len > end - q) {
+          goto Ldone;
+        }
+        memcpy(q, field, field_len);
+        q += field_len;
+      }
+      entry_header->timestamp = columns[LOG_COLUMN_TIMESTAMP].value(row);
+      entry_header->timestamp_usec = columns[LOG_COLUMN_TIMESTAMP_USEC].value(row);
+      entry_header->entry_len = q - p;
+      p = q;
+    }
+    if (p == end) {
+      bytes = m_header->buffer_bytes;
+    }
+  }
+
+Ldone:
+  delete[] columns;
+  return bytes;
+}
+
+/*-------------------------------------------------------------------------
+  LogSegmentReader
+  -------------------------------------------------------------------------*/
+
+LogSegmentReader::~LogSegmentReader()
+{
+  if (m_base) {
+    munmap(m_base, m_size);
+  }
+}
+
+bool
+LogSegmentReader::open(int fd)
+{
+  struct stat st;
+
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    return false;
+  }
+
+  void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+#if HAVE_POSIX_MADVISE
+  posix_madvise(base, st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+  m_base = (char *)base;
+  m_size = st.st_size;
+  m_offset = 0;
+  m_error = false;
+  return true;
+}
+
+const char *
+LogSegmentReader::next(uint32_t *len)
+{
+  if (m_error || m_size - m_offset < sizeof(LogColumnarHeader)) {
+    return NULL;
+  }
+
+  const char *segment = m_base + m_offset;
+  const LogColumnarHeader *header = (const LogColumnarHeader *)segment;
+
+  if ((header->cookie != LOG_SEGMENT_COOKIE && header->cookie != LOG_COLUMNAR_COOKIE) ||
+      header->byte_count < sizeof(LogColumnarHeader)) {
+    m_error = true;
+    return NULL;
+  }
+  if (header->byte_count > m_size - m_offset) {
+    return NULL;
+  }
+
+  *len = header->byte_count;
+  m_offset += header->byte_count;
+  return segment;
+}
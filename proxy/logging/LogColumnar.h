@@ -0,0 +1,243 @@
+/** @file
+
+  Columnar segments of binary log files.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef LOG_COLUMNAR_H
+#define LOG_COLUMNAR_H
+
+#include "LogBuffer.h"
+
+#define LOG_COLUMNAR_COOKIE 0xacec01
+#define LOG_COLUMNAR_VERSION 1
+
+/*-------------------------------------------------------------------------
+  A columnar segment holds the entries of one LogBuffer, stored a column at
+  a time rather than an entry at a time: the seconds and microseconds of the
+  entry timestamps, then the marshalled bytes of each field of the format,
+  then whatever bytes of each entry follow its last field.  Integer columns
+  are delta encoded, the others are dictionary encoded when their values
+  repeat, and each column is compressed on its own, so that one field can
+  be read without decoding the others.  Putting the columns back together
+  gives the LogBuffer byte for byte.
+
+  On disk, a segment is the LogColumnarHeader, a LogColumnDesc for each
+  column, the LogBufferHeader of the buffer with its strings, the symbols
+  of the field columns, and the column data.  Columnar and LogBuffer
+  segments can be mixed in a file.
+  -------------------------------------------------------------------------*/
+
+enum LogColumnarCompression {
+  LOG_COLUMNAR_COMPRESS_NONE = 0,
+  LOG_COLUMNAR_COMPRESS_FASTLZ,
+  LOG_COLUMNAR_COMPRESS_LIBZ,
+  N_LOG_COLUMNAR_COMPRESS
+};
+
+enum LogColumnEncoding {
+  LOG_COLUMN_DELTA = 0, // zigzag varint of the difference from the previous value
+  LOG_COLUMN_DICTIONARY,
+  LOG_COLUMN_PLAIN, // varint length and bytes of each value
+  N_LOG_COLUMN_ENCODINGS
+};
+
+// The columns before and after the fields.
+enum {
+  LOG_COLUMN_TIMESTAMP = 0,
+  LOG_COLUMN_TIMESTAMP_USEC,
+  LOG_COLUMN_FIRST_FIELD,
+};
+
+// The first four words are where they are in LogBufferHeader, so readers can tell the segments apart and skip them
+// the same way.
+struct LogColumnarHeader {
+  uint32_t cookie;       // LOG_COLUMNAR_COOKIE
+  uint32_t version;      // LOG_COLUMNAR_VERSION
+  uint32_t entry_count;  // entries in the segment
+  uint32_t byte_count;   // bytes in the segment, this header included
+  uint32_t buffer_bytes; // byte_count of the LogBuffer the segment was encoded from
+  uint32_t header_bytes; // bytes of its LogBufferHeader and strings
+  uint32_t column_count; // fields, plus the timestamp and trailing columns
+  uint32_t names_offset; // comma separated symbols of the field columns
+};
+
+struct LogColumnDesc {
+  uint32_t encoding;     // LogColumnEncoding
+  uint32_t compression;  // LogColumnarCompression
+  uint32_t offset;       // of the column data, from the start of the segment
+  uint32_t stored_bytes; // of the column data
+  uint32_t raw_bytes;    // of the column data once decompressed
+};
+
+/*-------------------------------------------------------------------------
+  LogColumn
+
+  One column of a segment, decoded.  Every value can be had as the bytes it
+  was marshalled to in the entry, and delta encoded values as integers.
+  -------------------------------------------------------------------------*/
+
+class LogColumn
+{
+public:
+  LogColumn();
+  ~LogColumn();
+
+  int
+  rows() const
+  {
+    return m_rows;
+  }
+  LogColumnEncoding
+  encoding() const
+  {
+    return m_encoding;
+  }
+
+  int64_t
+  value(int row) const
+  {
+    ink_assert(m_encoding == LOG_COLUMN_DELTA && row < m_rows);
+    return m_values[row];
+  }
+
+  const char *
+  data(int row, int *len) const
+  {
+    ink_assert(row < m_rows);
+    if (m_encoding == LOG_COLUMN_DELTA) {
+      *len = sizeof(int64_t);
+      return (const char *)&m_values[row];
+    }
+    *len = m_lens[row];
+    return m_data[row];
+  }
+
+private:
+  friend class LogColumnarSegment;
+
+  void clear();
+
+  LogColumnEncoding m_encoding;
+  int m_rows;
+  int64_t *m_values;    // delta encoded columns
+  const char **m_data;  // the other columns, point into the segment or m_raw
+  int *m_lens;
+  char *m_raw;          // the column data, when it had to be decompressed
+
+  // -- member functions not allowed --
+  LogColumn(const LogColumn &);
+  LogColumn &operator=(const LogColumn &);
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnarSegment
+
+  A columnar segment, read in place.
+  -------------------------------------------------------------------------*/
+
+class LogColumnarSegment
+{
+public:
+  LogColumnarSegment() : m_header(NULL), m_columns(NULL) {}
+
+  // Point at the segment at @a data, false if it is not a well formed columnar segment.
+  bool init(const char *data, uint32_t len);
+
+  LogBufferHeader *
+  buffer_header() const
+  {
+    return (LogBufferHeader *)((char *)m_header + buffer_header_offset(m_header->column_count));
+  }
+  int
+  entry_count() const
+  {
+    return m_header->entry_count;
+  }
+  int
+  column_count() const
+  {
+    return m_header->column_count;
+  }
+
+  // The column of the first field with @a symbol, or -1.
+  int find_column(const char *symbol) const;
+  bool decode_column(int idx, LogColumn *column) const;
+
+  // Rebuild the LogBuffer the segment was encoded from in @a buf, returns its size, or 0 if it does not fit or the
+  // segment is bad.
+  int to_buffer(char *buf, int len) const;
+
+  // Encode the LogBuffer at @a header in @a out, returns the bytes used, or 0 if it can not be encoded in @a out_len
+  // bytes, in which case the LogBuffer is better written as it is. The fields are split by @a fieldlist, which must
+  // be the one of the buffer's format, or parsed from the buffer header if it is NULL.
+  static int encode(LogBufferHeader *header, LogFieldList *fieldlist, LogColumnarCompression compression, char *out,
+                    int out_len);
+
+  static bool
+  is_columnar(const void *data)
+  {
+    return ((const LogColumnarHeader *)data)->cookie == LOG_COLUMNAR_COOKIE;
+  }
+
+private:
+  static uint32_t
+  buffer_header_offset(uint32_t column_count)
+  {
+    return INK_ALIGN_DEFAULT(sizeof(LogColumnarHeader) + column_count * sizeof(LogColumnDesc));
+  }
+
+  LogColumnarHeader *m_header;
+  LogColumnDesc *m_columns;
+};
+
+/*-------------------------------------------------------------------------
+  LogSegmentReader
+
+  Walks the segments, LogBuffer or columnar, of a binary log file mapped
+  into memory.
+  -------------------------------------------------------------------------*/
+
+class LogSegmentReader
+{
+public:
+  LogSegmentReader() : m_base(NULL), m_size(0), m_offset(0), m_error(false) {}
+  ~LogSegmentReader();
+
+  // Map the file open at @a fd, false if it is not a regular file or can not be mapped.
+  bool open(int fd);
+
+  // The next segment and its length, or NULL at the end of the file or at a segment which is not whole.
+  const char *next(uint32_t *len);
+
+  bool
+  error() const
+  {
+    return m_error;
+  }
+
+private:
+  char *m_base;
+  size_t m_size;
+  size_t m_offset;
+  bool m_error;
+};
+
+#endif
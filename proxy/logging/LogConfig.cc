@@ -41,6 +41,7 @@
 #include "LogFormat.h"
 #include "LogFile.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogHost.h"
 #include "LogObject.h"
 #include "LogConfig.h"
@@ -107,6 +108,9 @@ LogConfig::setup_default_values()
 
   ascii_buffer_size = 4 * 9216;
   max_line_size = 9216; // size of pipe buffer for SunOS 5.6
+
+  columnar_binary = false;
+  columnar_compress = LOG_COLUMNAR_COMPRESS_FASTLZ;
 }
 
 void *
@@ -262,6 +266,20 @@ LogConfig::read_configuration_variables()
   if (val > 0) {
     max_line_size = val;
   }
+
+  // COLUMNAR BINARY LOGS
+  columnar_binary = REC_ConfigReadInteger("proxy.config.log.columnar_binary") != 0;
+
+  val = (int)REC_ConfigReadInteger("proxy.config.log.columnar_compress");
+  if (val >= LOG_COLUMNAR_COMPRESS_NONE && val < N_LOG_COLUMNAR_COMPRESS) {
+    columnar_compress = val;
+  }
+#if !TS_HAS_LIBZ
+  if (columnar_compress == LOG_COLUMNAR_COMPRESS_LIBZ) {
+    Warning("libz not available for columnar log compression, using fastlz");
+    columnar_compress = LOG_COLUMNAR_COMPRESS_FASTLZ;
+  }
+#endif
 }
 
 /*-------------------------------------------------------------------------
@@ -465,6 +483,8 @@ LogConfig::display(FILE *fd)
   fprintf(fd, "   sampling_frequency = %d\n", sampling_frequency);
   fprintf(fd, "   file_stat_frequency = %d\n", file_stat_frequency);
   fprintf(fd, "   space_used_frequency = %d\n", space_used_frequency);
+  fprintf(fd, "   columnar_binary = %d\n", columnar_binary);
+  fprintf(fd, "   columnar_compress = %d\n", columnar_compress);
 
   fprintf(fd, "\n");
   fprintf(fd, "************ Log Objects (%u objects) ************\n", (unsigned int)log_object_manager.get_num_objects());
@@ -566,6 +586,8 @@ LogConfig::register_config_callbacks()
     "proxy.config.log.sampling_frequency",
     "proxy.config.log.file_stat_frequency",
     "proxy.config.log.space_used_frequency",
+    "proxy.config.log.columnar_binary",
+    "proxy.config.log.columnar_compress",
   };
 
   for (unsigned i = 0; i < countof(names); ++i) {
@@ -635,6 +657,10 @@ LogConfig::register_stat_callbacks()
                      (int)log_stat_bytes_written_to_disk_stat, RecRawStatSyncSum);
   RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.bytes_lost_before_written_to_disk", RECD_INT, RECP_PERSISTENT,
                      (int)log_stat_bytes_lost_before_written_to_disk_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.entries_retried", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)log_stat_entries_retried_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.entries_dropped", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)log_stat_entries_dropped_stat, RecRawStatSyncSum);
   //
   // I/O
   //
@@ -62,6 +62,10 @@ enum {
   log_stat_bytes_written_to_disk_stat,
   log_stat_bytes_lost_before_written_to_disk_stat,
 
+  // Log buffers
+  log_stat_entries_retried_stat,
+  log_stat_entries_dropped_stat,
+
   // Logging I/O
   log_stat_log_files_open_stat,
   log_stat_log_files_space_used_stat,
@@ -196,6 +200,9 @@ public:
   int ascii_buffer_size;
   int max_line_size;
 
+  bool columnar_binary;  // write binary logs as LogColumnarSegments
+  int columnar_compress; // LogColumnarCompression of their columns
+
   char *hostname;
   char *logfile_dir;
   char *collation_host;
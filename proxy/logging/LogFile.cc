@@ -47,6 +47,7 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogBuffer.h"
+#include "LogColumnar.h"
 #include "LogFile.h"
 #include "LogHost.h"
 #include "LogObject.h"
@@ -302,13 +303,43 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
     // don't change between buffers), it's not worth trying to separate
     // out the buffer-dependent data from the buffer-independent data.
     //
-    LogFlushData *flush_data = new LogFlushData(this, lb);
+    // Columnar segments are encoded here rather than in the flush thread,
+    // which only writes bytes, and handed over like ASCII data.  Buffers
+    // which do not encode smaller are written as they are.
+    //
+    LogFlushData *flush_data = NULL;
+    int columnar_bytes = 0;
+
+    if (Log::config->columnar_binary) {
+      char *columnar = (char *)ats_malloc(buffer_header->byte_count);
+      LogFormat *format = lb->get_owner() ? lb->get_owner()->m_format : NULL;
+      LogFieldList *fieldlist = NULL;
+
+      // the fields of the object's format save parsing them from the buffer for each one
+      if (format && buffer_header->fmt_fieldlist() && strcmp(format->fieldlist(), buffer_header->fmt_fieldlist()) == 0) {
+        fieldlist = &format->m_field_list;
+      }
+
+      columnar_bytes = LogColumnarSegment::encode(buffer_header, fieldlist, (LogColumnarCompression)Log::config->columnar_compress,
+                                                  columnar, buffer_header->byte_count);
+      if (columnar_bytes > 0) {
+        flush_data = new LogFlushData(this, columnar, columnar_bytes);
+      } else {
+        ats_free(columnar);
+      }
+    }
 
     ProxyMutex *mutex = this_thread()->mutex;
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_num_flush_to_disk_stat, lb->header()->entry_count);
 
-    RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, lb->header()->byte_count);
+    if (flush_data) {
+      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, columnar_bytes);
+      LogBuffer::destroy(lb);
+    } else {
+      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, lb->header()->byte_count);
+      flush_data = new LogFlushData(this, lb);
+    }
 
     ink_atomiclist_push(Log::flush_data_list, flush_data);
 
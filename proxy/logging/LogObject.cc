@@ -65,6 +65,7 @@ LogBufferManager::preproc_buffers(LogBufferSink *sink)
       Warning("Dropping log buffer, can't keep up.");
       RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_bytes_lost_before_preproc_stat,
                      b->header()->byte_count);
+      RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_entries_dropped_stat, b->m_state.s.num_entries);
       delete b;
     } else {
       new_q.push(b);
@@ -92,7 +93,7 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
                      int rolling_offset_hr, int rolling_size_mb, bool auto_created)
   : m_auto_created(auto_created), m_alt_filename(NULL), m_flags(0), m_signature(0), m_flush_threads(flush_threads),
     m_rolling_interval_sec(rolling_interval_sec), m_rolling_offset_hr(rolling_offset_hr), m_rolling_size_mb(rolling_size_mb),
-    m_last_roll_time(0), m_buffer_manager_idx(0)
+    m_last_roll_time(0), m_buffer_slots(NULL), m_num_buffer_slots(0), m_buffer_manager_idx(0)
 {
   ink_release_assert(format);
   m_format = new LogFormat(*format);
@@ -114,9 +115,7 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
   //
   m_logFile = new LogFile(m_filename, header, file_format, m_signature, Log::config->ascii_buffer_size, Log::config->max_line_size);
 
-  LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
-  ink_assert(b);
-  SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _create_buffer_slots();
 
   _setup_rolling(rolling_enabled, rolling_interval_sec, rolling_offset_hr, rolling_size_mb);
 
@@ -147,11 +146,9 @@ LogObject::LogObject(LogObject &rhs)
     add_loghost(host);
   }
 
-  // copy gets a fresh log buffer
+  // copy gets fresh log buffers
   //
-  LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
-  ink_assert(b);
-  SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _create_buffer_slots();
 
   Debug("log-config", "exiting LogObject copy constructor, "
                       "filename=%s this=%p",
@@ -175,7 +172,10 @@ LogObject::~LogObject()
   ats_free(m_alt_filename);
   delete m_format;
   delete[] m_buffer_manager;
-  delete (LogBuffer *)FREELIST_POINTER(m_log_buffer);
+  for (int i = 0; i < m_num_buffer_slots; i++) {
+    delete (LogBuffer *)FREELIST_POINTER(m_buffer_slots[i].buffer);
+  }
+  ats_memalign_free(m_buffer_slots);
 }
 
 //-----------------------------------------------------------------------------
@@ -368,13 +368,60 @@ LogObject::displayAsXML(FILE *fd, bool extended)
   fprintf(fd, "</LogObject>\n");
 }
 
+void
+LogObject::_create_buffer_slots()
+{
+  m_num_buffer_slots = 1 + eventProcessor.n_ethreads;
+  m_buffer_slots = (LogBufferSlot *)ats_memalign(sizeof(LogBufferSlot), m_num_buffer_slots * sizeof(LogBufferSlot));
+  for (int i = 0; i < m_num_buffer_slots; i++) {
+    SET_FREELIST_POINTER_VERSION(m_buffer_slots[i].buffer, NULL, 0);
+  }
+}
+
+LogObject::LogBufferSlot *
+LogObject::_buffer_slot()
+{
+  EThread *t = this_ethread();
+
+  if (t && t->tt == REGULAR && t->id + 1 < m_num_buffer_slots) {
+    return &m_buffer_slots[t->id + 1];
+  }
+  return &m_buffer_slots[0];
+}
+
+static inline void
+log_object_stat_incr(int stat)
+{
+  EThread *t = this_ethread();
+
+  if (t) {
+    RecIncrRawStat(log_rsb, t, stat, 1);
+  }
+}
+
 LogBuffer *
-LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
+LogObject::_checkout_write(LogBufferSlot *slot, size_t *write_offset, size_t bytes_needed)
 {
   LogBuffer::LB_ResultCode result_code;
   LogBuffer *buffer;
   LogBuffer *new_buffer;
   bool retry = true;
+  bool retried = false;
+
+  if (FREELIST_POINTER(slot->buffer) == NULL) {
+    // no thread wrote to this slot yet, so there is nothing to force out
+    if (!write_offset) {
+      return NULL;
+    }
+    head_p old_h, new_h;
+    new_buffer = new LogBuffer(this, Log::config->log_buffer_size);
+    SET_FREELIST_POINTER_VERSION(new_h, new_buffer, 0);
+    INK_QUEUE_LD(old_h, slot->buffer);
+    if (FREELIST_POINTER(old_h) != NULL || !ink_atomic_cas(&slot->buffer.data, old_h.data, new_h.data)) {
+      // another thread sharing the slot got there first
+      delete new_buffer;
+    }
+  }
 
   do {
     // To avoid a race condition, we keep a count of held references in
@@ -382,10 +429,11 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
     head_p h;
     int result = 0;
     do {
-      INK_QUEUE_LD(h, m_log_buffer);
+      INK_QUEUE_LD(h, slot->buffer);
       head_p new_h;
       SET_FREELIST_POINTER_VERSION(new_h, FREELIST_POINTER(h), FREELIST_VERSION(h) + 1);
-      result = ink_atomic_cas(&m_log_buffer.data, h.data, new_h.data);
+      result = ink_atomic_cas(&slot->buffer.data, h.data, new_h.data);
+      retried = retried || !result;
     } while (!result);
     buffer = (LogBuffer *)FREELIST_POINTER(h);
     result_code = buffer->checkout_write(write_offset, bytes_needed);
@@ -407,18 +455,19 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       INK_WRITE_MEMORY_BARRIER;
       head_p old_h;
       do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+        INK_QUEUE_LD(old_h, slot->buffer);
         if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h)) {
           ink_atomic_increment(&buffer->m_references, -1);
 
           // another thread should be taking care of creating a new
           // buffer, so delete new_buffer and try again
           delete new_buffer;
+          retried = true;
           break;
         }
         head_p tmp_h;
         SET_FREELIST_POINTER_VERSION(tmp_h, new_buffer, 0);
-        result = ink_atomic_cas(&m_log_buffer.data, old_h.data, tmp_h.data);
+        result = ink_atomic_cas(&slot->buffer.data, old_h.data, tmp_h.data);
       } while (!result);
       if (FREELIST_POINTER(old_h) == FREELIST_POINTER(h)) {
         ink_atomic_increment(&buffer->m_references, FREELIST_VERSION(old_h) - 1);
@@ -435,6 +484,7 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       // no more room, but another thread should be taking care of
       // creating a new buffer, so try again
       //
+      retried = true;
       break;
 
     case LogBuffer::LB_BUFFER_TOO_SMALL:
@@ -451,12 +501,12 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
     if (!decremented) {
       head_p old_h;
       do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+        INK_QUEUE_LD(old_h, slot->buffer);
         if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h))
           break;
         head_p tmp_h;
         SET_FREELIST_POINTER_VERSION(tmp_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1);
-        result = ink_atomic_cas(&m_log_buffer.data, old_h.data, tmp_h.data);
+        result = ink_atomic_cas(&slot->buffer.data, old_h.data, tmp_h.data);
       } while (!result);
       if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h))
         ink_atomic_increment(&buffer->m_references, -1);
@@ -465,6 +515,9 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
   // not retry because we really do
   // not want to write to the buffer
   // only to set it as full
+  if (retried && write_offset) {
+    log_object_stat_incr(log_stat_entries_retried_stat);
+  }
   if (result_code == LogBuffer::LB_BUFFER_TOO_SMALL) {
     buffer = NULL;
   }
@@ -577,9 +630,10 @@ LogObject::log(LogAccess *lad, const char *text_entry)
   }
 
   // Now try to place this entry in the current LogBuffer.
-  buffer = _checkout_write(&offset, bytes_needed);
+  buffer = _checkout_write(_buffer_slot(), &offset, bytes_needed);
 
   if (!buffer) {
+    log_object_stat_incr(log_stat_entries_dropped_stat);
     Note("Skipping the current log entry for %s because its size (%zu) exceeds "
          "the maximum payload space in a log buffer",
          m_basename, bytes_needed);
@@ -760,9 +814,11 @@ LogObject::_roll_files(long last_roll_time, long time_now)
 void
 LogObject::check_buffer_expiration(long time_now)
 {
-  LogBuffer *b = (LogBuffer *)FREELIST_POINTER(m_log_buffer);
-  if (b && time_now > b->expiration_time()) {
-    force_new_buffer();
+  for (int i = 0; i < m_num_buffer_slots; i++) {
+    LogBuffer *b = (LogBuffer *)FREELIST_POINTER(m_buffer_slots[i].buffer);
+    if (b && time_now > b->expiration_time()) {
+      _checkout_write(&m_buffer_slots[i], NULL, 0);
+    }
   }
 }
 
@@ -260,7 +260,9 @@ public:
   void
   force_new_buffer()
   {
-    _checkout_write(NULL, 0);
+    for (int i = 0; i < m_num_buffer_slots; i++) {
+      _checkout_write(&m_buffer_slots[i], NULL, 0);
+    }
   }
 
   bool operator==(LogObject &rhs);
@@ -296,7 +298,15 @@ private:
   long m_last_roll_time;   // the last time this object rolled
   // its files
 
-  volatile head_p m_log_buffer; // current work buffer
+  // The buffer entries are written to. Each event thread has a slot of its own, so that writers do not share a buffer
+  // or its cache lines, and all other threads share the first one. Slots get a buffer when first written to.
+  struct LogBufferSlot {
+    volatile head_p buffer;
+    char pad[64 - sizeof(head_p)]; // one slot per cache line
+  };
+
+  LogBufferSlot *m_buffer_slots;
+  int m_num_buffer_slots;
   unsigned m_buffer_manager_idx;
   LogBufferManager *m_buffer_manager;
 
@@ -305,7 +315,9 @@ private:
                       int rolling_size_mb);
   unsigned _roll_files(long interval_start, long interval_end);
 
-  LogBuffer *_checkout_write(size_t *write_offset, size_t write_size);
+  void _create_buffer_slots();
+  LogBufferSlot *_buffer_slot();
+  LogBuffer *_checkout_write(LogBufferSlot *slot, size_t *write_offset, size_t write_size);
 
 private:
   // -- member functions not allowed --
@@ -33,6 +33,7 @@
 #include "LogStandalone.cc"
 
 #include "LogObject.h"
+#include "LogColumnar.h"
 #include "hdrs/HTTP.h"
 
 #include <math.h>
@@ -1120,19 +1121,30 @@ update_schemes(OriginStats *stat, int scheme, int size)
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// Parse a log buffer
-int
-parse_log_buff(LogBufferHeader *buf_header, bool summary = false)
+// The fields of the log format, parsed from the first buffer.
+LogFieldList *
+log_fieldlist(LogBufferHeader *buf_header)
 {
   static LogFieldList *fieldlist = NULL;
 
-  LogEntryHeader *entry;
-  LogBufferIterator buf_iter(buf_header);
+  if (!fieldlist) {
+    fieldlist = new LogFieldList;
+    ink_assert(fieldlist != NULL);
+    bool agg = false;
+    LogFormat::parse_symbol_string(buf_header->fmt_fieldlist(), fieldlist, &agg);
+  }
+  return fieldlist;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse the fields of a log entry, which start at read_from
+void
+parse_log_entry(char *read_from, LogFieldList *fieldlist, bool summary)
+{
   LogField *field;
   OriginStorage::iterator o_iter;
   ParseStates state;
 
-  char *read_from;
   char *tok;
   char *ptr;
   int tok_len;
@@ -1145,449 +1157,541 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false)
   HTTPMethod method;
   URLScheme scheme;
 
-  if (!fieldlist) {
-    fieldlist = new LogFieldList;
-    ink_assert(fieldlist != NULL);
-    bool agg = false;
-    LogFormat::parse_symbol_string(buf_header->fmt_fieldlist(), fieldlist, &agg);
-  }
-  // Loop over all entries
-  while ((entry = buf_iter.next())) {
-    read_from = (char *)entry + sizeof(LogEntryHeader);
-    // We read and skip over the first field, which is the timestamp.
-    if ((field = fieldlist->first()))
+  // We read and skip over the first field, which is the timestamp.
+  if ((field = fieldlist->first()))
+    read_from += INK_MIN_ALIGN;
+  else // This shouldn't happen, buffer must be messed up.
+    return;
+
+  state = P_STATE_ELAPSED;
+  o_stats = NULL;
+  o_server = NULL;
+  method = METHOD_OTHER;
+  scheme = SCHEME_OTHER;
+
+  while ((field = fieldlist->next(field))) {
+    switch (state) {
+    case P_STATE_ELAPSED:
+      state = P_STATE_IP;
+      elapsed = *((int64_t *)(read_from));
       read_from += INK_MIN_ALIGN;
-    else // This shouldn't happen, buffer must be messed up.
       break;
 
-    state = P_STATE_ELAPSED;
-    o_stats = NULL;
-    o_server = NULL;
-    method = METHOD_OTHER;
-    scheme = SCHEME_OTHER;
-
-    while ((field = fieldlist->next(field))) {
-      switch (state) {
-      case P_STATE_ELAPSED:
-        state = P_STATE_IP;
-        elapsed = *((int64_t *)(read_from));
-        read_from += INK_MIN_ALIGN;
-        break;
-
-      case P_STATE_IP:
-        state = P_STATE_RESULT;
-        // Just skip the IP, we no longer assume it's always the same.
-        {
-          LogFieldIp *ip = reinterpret_cast<LogFieldIp *>(read_from);
-          int len = sizeof(LogFieldIp);
-          if (AF_INET == ip->_family)
-            len = sizeof(LogFieldIp4);
-          else if (AF_INET6 == ip->_family)
-            len = sizeof(LogFieldIp6);
-          read_from += INK_ALIGN_DEFAULT(len);
-        }
-        break;
+    case P_STATE_IP:
+      state = P_STATE_RESULT;
+      // Just skip the IP, we no longer assume it's always the same.
+      {
+        LogFieldIp *ip = reinterpret_cast<LogFieldIp *>(read_from);
+        int len = sizeof(LogFieldIp);
+        if (AF_INET == ip->_family)
+          len = sizeof(LogFieldIp4);
+        else if (AF_INET6 == ip->_family)
+          len = sizeof(LogFieldIp6);
+        read_from += INK_ALIGN_DEFAULT(len);
+      }
+      break;
 
-      case P_STATE_RESULT:
-        state = P_STATE_CODE;
-        result = *((int64_t *)(read_from));
-        read_from += INK_MIN_ALIGN;
-        if ((result < 32) || (result > 255)) {
-          flag = 1;
-          state = P_STATE_END;
-        }
-        break;
+    case P_STATE_RESULT:
+      state = P_STATE_CODE;
+      result = *((int64_t *)(read_from));
+      read_from += INK_MIN_ALIGN;
+      if ((result < 32) || (result > 255)) {
+        flag = 1;
+        state = P_STATE_END;
+      }
+      break;
 
-      case P_STATE_CODE:
-        state = P_STATE_SIZE;
-        http_code = *((int64_t *)(read_from));
-        read_from += INK_MIN_ALIGN;
-        if ((http_code < 0) || (http_code > 999)) {
-          flag = 1;
-          state = P_STATE_END;
-        }
-        break;
+    case P_STATE_CODE:
+      state = P_STATE_SIZE;
+      http_code = *((int64_t *)(read_from));
+      read_from += INK_MIN_ALIGN;
+      if ((http_code < 0) || (http_code > 999)) {
+        flag = 1;
+        state = P_STATE_END;
+      }
+      break;
 
-      case P_STATE_SIZE:
-        // Warning: This is not 64-bit safe, when converting the log format,
-        // this needs to be fixed as well.
-        state = P_STATE_METHOD;
-        size = *((int64_t *)(read_from));
-        read_from += INK_MIN_ALIGN;
-        break;
+    case P_STATE_SIZE:
+      // Warning: This is not 64-bit safe, when converting the log format,
+      // this needs to be fixed as well.
+      state = P_STATE_METHOD;
+      size = *((int64_t *)(read_from));
+      read_from += INK_MIN_ALIGN;
+      break;
 
-      case P_STATE_METHOD:
-        state = P_STATE_URL;
-        flag = 0;
+    case P_STATE_METHOD:
+      state = P_STATE_URL;
+      flag = 0;
 
-        // Small optimization for common (3-4 char) cases
-        switch (*reinterpret_cast<int *>(read_from)) {
-        case GET_AS_INT:
-          method = METHOD_GET;
-          read_from += LogAccess::round_strlen(3 + 1);
-          break;
-        case PUT_AS_INT:
-          method = METHOD_PUT;
-          read_from += LogAccess::round_strlen(3 + 1);
-          break;
-        case HEAD_AS_INT:
-          method = METHOD_HEAD;
-          read_from += LogAccess::round_strlen(4 + 1);
-          break;
-        case POST_AS_INT:
-          method = METHOD_POST;
-          read_from += LogAccess::round_strlen(4 + 1);
-          break;
-        default:
-          tok_len = strlen(read_from);
-          if ((5 == tok_len) && (0 == strncmp(read_from, "PURGE", 5)))
-            method = METHOD_PURGE;
-          else if ((6 == tok_len) && (0 == strncmp(read_from, "DELETE", 6)))
-            method = METHOD_DELETE;
-          else if ((7 == tok_len) && (0 == strncmp(read_from, "OPTIONS", 7)))
-            method = METHOD_OPTIONS;
-          else if ((1 == tok_len) && ('-' == *read_from)) {
-            method = METHOD_NONE;
-            flag = 1; // No method, so no need to parse the URL
-          } else {
-            ptr = read_from;
-            while (*ptr && isupper(*ptr))
-              ++ptr;
-            // Skip URL if it doesn't look like an HTTP method
-            if (*ptr != '\0')
-              flag = 1;
-          }
-          read_from += LogAccess::round_strlen(tok_len + 1);
-          break;
+      // Small optimization for common (3-4 char) cases
+      switch (*reinterpret_cast<int *>(read_from)) {
+      case GET_AS_INT:
+        method = METHOD_GET;
+        read_from += LogAccess::round_strlen(3 + 1);
+        break;
+      case PUT_AS_INT:
+        method = METHOD_PUT;
+        read_from += LogAccess::round_strlen(3 + 1);
+        break;
+      case HEAD_AS_INT:
+        method = METHOD_HEAD;
+        read_from += LogAccess::round_strlen(4 + 1);
+        break;
+      case POST_AS_INT:
+        method = METHOD_POST;
+        read_from += LogAccess::round_strlen(4 + 1);
+        break;
+      default:
+        tok_len = strlen(read_from);
+        if ((5 == tok_len) && (0 == strncmp(read_from, "PURGE", 5)))
+          method = METHOD_PURGE;
+        else if ((6 == tok_len) && (0 == strncmp(read_from, "DELETE", 6)))
+          method = METHOD_DELETE;
+        else if ((7 == tok_len) && (0 == strncmp(read_from, "OPTIONS", 7)))
+          method = METHOD_OPTIONS;
+        else if ((1 == tok_len) && ('-' == *read_from)) {
+          method = METHOD_NONE;
+          flag = 1; // No method, so no need to parse the URL
+        } else {
+          ptr = read_from;
+          while (*ptr && isupper(*ptr))
+            ++ptr;
+          // Skip URL if it doesn't look like an HTTP method
+          if (*ptr != '\0')
+            flag = 1;
         }
+        read_from += LogAccess::round_strlen(tok_len + 1);
         break;
+      }
+      break;
 
-      case P_STATE_URL:
-        state = P_STATE_RFC931;
-        if (urls)
-          urls->add_stat(read_from, size, elapsed, result, http_code, cl.as_object);
-
-        // TODO check for read_from being empty string
-        if (0 == flag) {
-          tok = read_from;
-          if (HTTP_AS_INT == *reinterpret_cast<int *>(tok)) {
+    case P_STATE_URL:
+      state = P_STATE_RFC931;
+      if (urls)
+        urls->add_stat(read_from, size, elapsed, result, http_code, cl.as_object);
+
+      // TODO check for read_from being empty string
+      if (0 == flag) {
+        tok = read_from;
+        if (HTTP_AS_INT == *reinterpret_cast<int *>(tok)) {
+          tok += 4;
+          if (':' == *tok) {
+            scheme = SCHEME_HTTP;
+            tok += 3;
+            tok_len = strlen(tok) + 7;
+          } else if ('s' == *tok) {
+            scheme = SCHEME_HTTPS;
             tok += 4;
-            if (':' == *tok) {
-              scheme = SCHEME_HTTP;
-              tok += 3;
-              tok_len = strlen(tok) + 7;
-            } else if ('s' == *tok) {
-              scheme = SCHEME_HTTPS;
-              tok += 4;
-              tok_len = strlen(tok) + 8;
-            } else
-              tok_len = strlen(tok) + 4;
-          } else {
-            if ('/' == *tok)
-              scheme = SCHEME_NONE;
-            tok_len = strlen(tok);
-          }
-          if ('/' == *tok) // This is to handle crazy stuff like http:///origin.com
-            tok++;
-          ptr = strchr(tok, '/');
-          if (ptr && !summary) { // Find the origin
-            *ptr = '\0';
-
-            // TODO: If we save state (struct) for a run, we probably need to always
-            // update the origin data, no matter what the origin_set is.
-            if (origin_set->empty() || (origin_set->find(tok) != origin_set->end())) {
-              o_iter = origins.find(tok);
-              if (origins.end() == o_iter) {
-                o_stats = (OriginStats *)ats_malloc(sizeof(OriginStats));
-                memset(o_stats, 0, sizeof(OriginStats));
-                init_elapsed(o_stats);
-                o_server = ats_strdup(tok);
-                if (o_stats && o_server) {
-                  o_stats->server = o_server;
-                  origins[o_server] = o_stats;
-                }
-              } else
-                o_stats = o_iter->second;
-            }
-          }
+            tok_len = strlen(tok) + 8;
+          } else
+            tok_len = strlen(tok) + 4;
         } else {
-          // No method given
-          if ('/' == *read_from)
+          if ('/' == *tok)
             scheme = SCHEME_NONE;
-          tok_len = strlen(read_from);
+          tok_len = strlen(tok);
         }
-        read_from += LogAccess::round_strlen(tok_len + 1);
+        if ('/' == *tok) // This is to handle crazy stuff like http:///origin.com
+          tok++;
+        ptr = strchr(tok, '/');
+        if (ptr && !summary) { // Find the origin
+          *ptr = '\0';
+
+          // TODO: If we save state (struct) for a run, we probably need to always
+          // update the origin data, no matter what the origin_set is.
+          if (origin_set->empty() || (origin_set->find(tok) != origin_set->end())) {
+            o_iter = origins.find(tok);
+            if (origins.end() == o_iter) {
+              o_stats = (OriginStats *)ats_malloc(sizeof(OriginStats));
+              memset(o_stats, 0, sizeof(OriginStats));
+              init_elapsed(o_stats);
+              o_server = ats_strdup(tok);
+              if (o_stats && o_server) {
+                o_stats->server = o_server;
+                origins[o_server] = o_stats;
+              }
+            } else
+              o_stats = o_iter->second;
+          }
+        }
+      } else {
+        // No method given
+        if ('/' == *read_from)
+          scheme = SCHEME_NONE;
+        tok_len = strlen(read_from);
+      }
+      read_from += LogAccess::round_strlen(tok_len + 1);
+
+      // Update the stats so far, since now we have the Origin (maybe)
+      update_results_elapsed(&totals, result, elapsed, size);
+      update_codes(&totals, http_code, size);
+      update_methods(&totals, method, size);
+      update_schemes(&totals, scheme, size);
+      update_counter(totals.total, size);
+      if (o_stats != NULL) {
+        update_results_elapsed(o_stats, result, elapsed, size);
+        update_codes(o_stats, http_code, size);
+        update_methods(o_stats, method, size);
+        update_schemes(o_stats, scheme, size);
+        update_counter(o_stats->total, size);
+      }
+      break;
+
+    case P_STATE_RFC931:
+      state = P_STATE_HIERARCHY;
+      if ('-' == *read_from)
+        read_from += LogAccess::round_strlen(1 + 1);
+      else
+        read_from += LogAccess::strlen(read_from);
+      break;
 
-        // Update the stats so far, since now we have the Origin (maybe)
-        update_results_elapsed(&totals, result, elapsed, size);
-        update_codes(&totals, http_code, size);
-        update_methods(&totals, method, size);
-        update_schemes(&totals, scheme, size);
-        update_counter(totals.total, size);
-        if (o_stats != NULL) {
-          update_results_elapsed(o_stats, result, elapsed, size);
-          update_codes(o_stats, http_code, size);
-          update_methods(o_stats, method, size);
-          update_schemes(o_stats, scheme, size);
-          update_counter(o_stats->total, size);
+    case P_STATE_HIERARCHY:
+      state = P_STATE_PEER;
+      hier = *((int64_t *)(read_from));
+      switch (hier) {
+      case SQUID_HIER_NONE:
+        update_counter(totals.hierarchies.none, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->hierarchies.none, size);
+        break;
+      case SQUID_HIER_DIRECT:
+        update_counter(totals.hierarchies.direct, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->hierarchies.direct, size);
+        break;
+      case SQUID_HIER_SIBLING_HIT:
+        update_counter(totals.hierarchies.sibling, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->hierarchies.sibling, size);
+        break;
+      case SQUID_HIER_PARENT_HIT:
+        update_counter(totals.hierarchies.parent, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->hierarchies.direct, size);
+        break;
+      case SQUID_HIER_EMPTY:
+        update_counter(totals.hierarchies.empty, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->hierarchies.empty, size);
+        break;
+      default:
+        if ((hier >= SQUID_HIER_EMPTY) && (hier < SQUID_HIER_INVALID_ASSIGNED_CODE)) {
+          update_counter(totals.hierarchies.other, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->hierarchies.other, size);
+        } else {
+          update_counter(totals.hierarchies.invalid, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->hierarchies.invalid, size);
         }
         break;
+      }
+      read_from += INK_MIN_ALIGN;
+      break;
 
-      case P_STATE_RFC931:
-        state = P_STATE_HIERARCHY;
-        if ('-' == *read_from)
-          read_from += LogAccess::round_strlen(1 + 1);
-        else
-          read_from += LogAccess::strlen(read_from);
-        break;
+    case P_STATE_PEER:
+      state = P_STATE_TYPE;
+      if ('-' == *read_from)
+        read_from += LogAccess::round_strlen(1 + 1);
+      else
+        read_from += LogAccess::strlen(read_from);
+      break;
 
-      case P_STATE_HIERARCHY:
-        state = P_STATE_PEER;
-        hier = *((int64_t *)(read_from));
-        switch (hier) {
-        case SQUID_HIER_NONE:
-          update_counter(totals.hierarchies.none, size);
+    case P_STATE_TYPE:
+      state = P_STATE_END;
+      if (IMAG_AS_INT == *reinterpret_cast<int *>(read_from)) {
+        update_counter(totals.content.image.total, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.image.total, size);
+        tok = read_from + 6;
+        switch (*reinterpret_cast<int *>(tok)) {
+        case JPEG_AS_INT:
+          tok_len = 10;
+          update_counter(totals.content.image.jpeg, size);
           if (o_stats != NULL)
-            update_counter(o_stats->hierarchies.none, size);
+            update_counter(o_stats->content.image.jpeg, size);
           break;
-        case SQUID_HIER_DIRECT:
-          update_counter(totals.hierarchies.direct, size);
+        case JPG_AS_INT:
+          tok_len = 9;
+          update_counter(totals.content.image.jpeg, size);
           if (o_stats != NULL)
-            update_counter(o_stats->hierarchies.direct, size);
+            update_counter(o_stats->content.image.jpeg, size);
           break;
-        case SQUID_HIER_SIBLING_HIT:
-          update_counter(totals.hierarchies.sibling, size);
+        case GIF_AS_INT:
+          tok_len = 9;
+          update_counter(totals.content.image.gif, size);
           if (o_stats != NULL)
-            update_counter(o_stats->hierarchies.sibling, size);
+            update_counter(o_stats->content.image.gif, size);
           break;
-        case SQUID_HIER_PARENT_HIT:
-          update_counter(totals.hierarchies.parent, size);
+        case PNG_AS_INT:
+          tok_len = 9;
+          update_counter(totals.content.image.png, size);
           if (o_stats != NULL)
-            update_counter(o_stats->hierarchies.direct, size);
+            update_counter(o_stats->content.image.png, size);
           break;
-        case SQUID_HIER_EMPTY:
-          update_counter(totals.hierarchies.empty, size);
+        case BMP_AS_INT:
+          tok_len = 9;
+          update_counter(totals.content.image.bmp, size);
           if (o_stats != NULL)
-            update_counter(o_stats->hierarchies.empty, size);
+            update_counter(o_stats->content.image.bmp, size);
           break;
         default:
-          if ((hier >= SQUID_HIER_EMPTY) && (hier < SQUID_HIER_INVALID_ASSIGNED_CODE)) {
-            update_counter(totals.hierarchies.other, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->hierarchies.other, size);
-          } else {
-            update_counter(totals.hierarchies.invalid, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->hierarchies.invalid, size);
-          }
+          tok_len = 6 + strlen(tok);
+          update_counter(totals.content.image.other, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.image.other, size);
           break;
         }
-        read_from += INK_MIN_ALIGN;
-        break;
-
-      case P_STATE_PEER:
-        state = P_STATE_TYPE;
-        if ('-' == *read_from)
-          read_from += LogAccess::round_strlen(1 + 1);
-        else
-          read_from += LogAccess::strlen(read_from);
-        break;
-
-      case P_STATE_TYPE:
-        state = P_STATE_END;
-        if (IMAG_AS_INT == *reinterpret_cast<int *>(read_from)) {
-          update_counter(totals.content.image.total, size);
+      } else if (TEXT_AS_INT == *reinterpret_cast<int *>(read_from)) {
+        tok = read_from + 5;
+        update_counter(totals.content.text.total, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.text.total, size);
+        switch (*reinterpret_cast<int *>(tok)) {
+        case JAVA_AS_INT:
+          // TODO verify if really "javascript"
+          tok_len = 15;
+          update_counter(totals.content.text.javascript, size);
           if (o_stats != NULL)
-            update_counter(o_stats->content.image.total, size);
-          tok = read_from + 6;
-          switch (*reinterpret_cast<int *>(tok)) {
-          case JPEG_AS_INT:
-            tok_len = 10;
-            update_counter(totals.content.image.jpeg, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.jpeg, size);
-            break;
-          case JPG_AS_INT:
-            tok_len = 9;
-            update_counter(totals.content.image.jpeg, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.jpeg, size);
-            break;
-          case GIF_AS_INT:
-            tok_len = 9;
-            update_counter(totals.content.image.gif, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.gif, size);
-            break;
-          case PNG_AS_INT:
-            tok_len = 9;
-            update_counter(totals.content.image.png, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.png, size);
-            break;
-          case BMP_AS_INT:
-            tok_len = 9;
-            update_counter(totals.content.image.bmp, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.bmp, size);
-            break;
-          default:
-            tok_len = 6 + strlen(tok);
-            update_counter(totals.content.image.other, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.image.other, size);
-            break;
-          }
-        } else if (TEXT_AS_INT == *reinterpret_cast<int *>(read_from)) {
-          tok = read_from + 5;
-          update_counter(totals.content.text.total, size);
+            update_counter(o_stats->content.text.javascript, size);
+          break;
+        case CSS_AS_INT:
+          tok_len = 8;
+          update_counter(totals.content.text.css, size);
           if (o_stats != NULL)
-            update_counter(o_stats->content.text.total, size);
-          switch (*reinterpret_cast<int *>(tok)) {
-          case JAVA_AS_INT:
-            // TODO verify if really "javascript"
-            tok_len = 15;
-            update_counter(totals.content.text.javascript, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.javascript, size);
-            break;
-          case CSS_AS_INT:
-            tok_len = 8;
-            update_counter(totals.content.text.css, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.css, size);
-            break;
-          case XML_AS_INT:
-            tok_len = 8;
-            update_counter(totals.content.text.xml, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.xml, size);
-            break;
-          case HTML_AS_INT:
-            tok_len = 9;
-            update_counter(totals.content.text.html, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.html, size);
-            break;
-          case PLAI_AS_INT:
-            tok_len = 10;
-            update_counter(totals.content.text.plain, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.plain, size);
-            break;
-          default:
-            tok_len = 5 + strlen(tok);
-            ;
-            update_counter(totals.content.text.other, size);
-            if (o_stats != NULL)
-              update_counter(o_stats->content.text.other, size);
-            break;
-          }
-        } else if (0 == strncmp(read_from, "application", 11)) {
-          tok = read_from + 12;
-          update_counter(totals.content.application.total, size);
+            update_counter(o_stats->content.text.css, size);
+          break;
+        case XML_AS_INT:
+          tok_len = 8;
+          update_counter(totals.content.text.xml, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.text.xml, size);
+          break;
+        case HTML_AS_INT:
+          tok_len = 9;
+          update_counter(totals.content.text.html, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.text.html, size);
+          break;
+        case PLAI_AS_INT:
+          tok_len = 10;
+          update_counter(totals.content.text.plain, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.text.plain, size);
+          break;
+        default:
+          tok_len = 5 + strlen(tok);
+          ;
+          update_counter(totals.content.text.other, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.text.other, size);
+          break;
+        }
+      } else if (0 == strncmp(read_from, "application", 11)) {
+        tok = read_from + 12;
+        update_counter(totals.content.application.total, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.application.total, size);
+        switch (*reinterpret_cast<int *>(tok)) {
+        case ZIP_AS_INT:
+          tok_len = 15;
+          update_counter(totals.content.application.zip, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.application.zip, size);
+          break;
+        case JAVA_AS_INT:
+          update_counter(totals.content.application.javascript, size);
           if (o_stats != NULL)
-            update_counter(o_stats->content.application.total, size);
-          switch (*reinterpret_cast<int *>(tok)) {
-          case ZIP_AS_INT:
-            tok_len = 15;
-            update_counter(totals.content.application.zip, size);
+            update_counter(o_stats->content.application.javascript, size);
+        case X_JA_AS_INT:
+          tok_len = 24;
+          update_counter(totals.content.application.javascript, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.application.javascript, size);
+          break;
+        case RSSp_AS_INT:
+          if (0 == strcmp(tok + 4, "xml")) {
+            tok_len = 19;
+            update_counter(totals.content.application.rss_xml, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.application.zip, size);
-            break;
-          case JAVA_AS_INT:
-            update_counter(totals.content.application.javascript, size);
+              update_counter(o_stats->content.application.rss_xml, size);
+          } else if (0 == strcmp(tok + 4, "atom")) {
+            tok_len = 20;
+            update_counter(totals.content.application.rss_atom, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.application.javascript, size);
-          case X_JA_AS_INT:
-            tok_len = 24;
-            update_counter(totals.content.application.javascript, size);
+              update_counter(o_stats->content.application.rss_atom, size);
+          } else {
+            tok_len = 12 + strlen(tok);
+            update_counter(totals.content.application.rss_other, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.application.javascript, size);
-            break;
-          case RSSp_AS_INT:
-            if (0 == strcmp(tok + 4, "xml")) {
-              tok_len = 19;
-              update_counter(totals.content.application.rss_xml, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.rss_xml, size);
-            } else if (0 == strcmp(tok + 4, "atom")) {
-              tok_len = 20;
-              update_counter(totals.content.application.rss_atom, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.rss_atom, size);
-            } else {
-              tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.rss_other, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.rss_other, size);
-            }
-            break;
-          default:
-            if (0 == strcmp(tok, "x-shockwave-flash")) {
-              tok_len = 29;
-              update_counter(totals.content.application.shockwave_flash, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.shockwave_flash, size);
-            } else if (0 == strcmp(tok, "x-quicktimeplayer")) {
-              tok_len = 29;
-              update_counter(totals.content.application.quicktime, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.quicktime, size);
-            } else {
-              tok_len = 12 + strlen(tok);
-              update_counter(totals.content.application.other, size);
-              if (o_stats != NULL)
-                update_counter(o_stats->content.application.other, size);
-            }
+              update_counter(o_stats->content.application.rss_other, size);
           }
-        } else if (0 == strncmp(read_from, "audio", 5)) {
-          tok = read_from + 6;
-          tok_len = 6 + strlen(tok);
-          update_counter(totals.content.audio.total, size);
-          if (o_stats != NULL)
-            update_counter(o_stats->content.audio.total, size);
-          if ((0 == strcmp(tok, "x-wav")) || (0 == strcmp(tok, "wav"))) {
-            update_counter(totals.content.audio.wav, size);
+          break;
+        default:
+          if (0 == strcmp(tok, "x-shockwave-flash")) {
+            tok_len = 29;
+            update_counter(totals.content.application.shockwave_flash, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.audio.wav, size);
-          } else if ((0 == strcmp(tok, "x-mpeg")) || (0 == strcmp(tok, "mpeg"))) {
-            update_counter(totals.content.audio.mpeg, size);
+              update_counter(o_stats->content.application.shockwave_flash, size);
+          } else if (0 == strcmp(tok, "x-quicktimeplayer")) {
+            tok_len = 29;
+            update_counter(totals.content.application.quicktime, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.audio.mpeg, size);
+              update_counter(o_stats->content.application.quicktime, size);
           } else {
-            update_counter(totals.content.audio.other, size);
+            tok_len = 12 + strlen(tok);
+            update_counter(totals.content.application.other, size);
             if (o_stats != NULL)
-              update_counter(o_stats->content.audio.other, size);
+              update_counter(o_stats->content.application.other, size);
           }
-        } else if ('-' == *read_from) {
-          tok_len = 1;
-          update_counter(totals.content.none, size);
+        }
+      } else if (0 == strncmp(read_from, "audio", 5)) {
+        tok = read_from + 6;
+        tok_len = 6 + strlen(tok);
+        update_counter(totals.content.audio.total, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.audio.total, size);
+        if ((0 == strcmp(tok, "x-wav")) || (0 == strcmp(tok, "wav"))) {
+          update_counter(totals.content.audio.wav, size);
           if (o_stats != NULL)
-            update_counter(o_stats->content.none, size);
+            update_counter(o_stats->content.audio.wav, size);
+        } else if ((0 == strcmp(tok, "x-mpeg")) || (0 == strcmp(tok, "mpeg"))) {
+          update_counter(totals.content.audio.mpeg, size);
+          if (o_stats != NULL)
+            update_counter(o_stats->content.audio.mpeg, size);
         } else {
-          tok_len = strlen(read_from);
-          update_counter(totals.content.other, size);
+          update_counter(totals.content.audio.other, size);
           if (o_stats != NULL)
-            update_counter(o_stats->content.other, size);
+            update_counter(o_stats->content.audio.other, size);
         }
-        read_from += LogAccess::round_strlen(tok_len + 1);
-        flag = 0; // We exited this state without errors
-        break;
+      } else if ('-' == *read_from) {
+        tok_len = 1;
+        update_counter(totals.content.none, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.none, size);
+      } else {
+        tok_len = strlen(read_from);
+        update_counter(totals.content.other, size);
+        if (o_stats != NULL)
+          update_counter(o_stats->content.other, size);
+      }
+      read_from += LogAccess::round_strlen(tok_len + 1);
+      flag = 0; // We exited this state without errors
+      break;
+
+    case P_STATE_END:
+      // Nothing to do really
+      if (flag) {
+        parse_errors++;
+      }
+      break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse a log buffer
+int
+parse_log_buff(LogBufferHeader *buf_header, bool summary = false)
+{
+  LogFieldList *fieldlist = log_fieldlist(buf_header);
+  LogBufferIterator buf_iter(buf_header);
+  LogEntryHeader *entry;
 
-      case P_STATE_END:
-        // Nothing to do really
-        if (flag) {
-          parse_errors++;
+  // Loop over all entries
+  while ((entry = buf_iter.next())) {
+    parse_log_entry((char *)entry + sizeof(LogEntryHeader), fieldlist, summary);
+  }
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parse a columnar segment. Only the columns of the fields the parser uses
+// are decoded, and each entry is put back together from them, with
+// placeholders for the IP, the user and the peer, which it skips.
+int
+parse_columnar_segment(const LogColumnarSegment &segment, bool summary = false)
+{
+  static int64_t entry[MAX_LOGBUFFER_SIZE / sizeof(int64_t)]; // aligned for the integer fields
+  LogFieldList *fieldlist = log_fieldlist(segment.buffer_header());
+  // The fields are in the order of the states, after the timestamp.
+  int nfields = std::min(segment.column_count() - LOG_COLUMN_FIRST_FIELD - 1, P_STATE_END + 1);
+  LogColumn columns[P_STATE_END + 1];
+
+  for (int i = 1; i < nfields; i++) {
+    int state = i - 1;
+    if (state != P_STATE_IP && state != P_STATE_RFC931 && state != P_STATE_PEER &&
+        !segment.decode_column(LOG_COLUMN_FIRST_FIELD + i, &columns[i])) {
+      Debug("logstats", "Bad columnar segment.");
+      return 1;
+    }
+  }
+
+  for (int row = 0; row < segment.entry_count(); row++) {
+    char *p = (char *)entry + INK_MIN_ALIGN; // the timestamp is skipped
+    char *end = (char *)entry + sizeof(entry);
+
+    for (int i = 1; i < nfields; i++) {
+      int field_len;
+      const char *field;
+
+      switch (i - 1) {
+      case P_STATE_IP:
+        memset(p, 0, sizeof(LogFieldIp)); // AF_UNSPEC
+        p += INK_ALIGN_DEFAULT(sizeof(LogFieldIp));
+        break;
+      case P_STATE_RFC931:
+      case P_STATE_PEER:
+        memcpy(p, "-", 2);
+        p += LogAccess::round_strlen(1 + 1);
+        break;
+      default:
+        field = columns[i].data(row, &field_len);
+        if (field_len > end - p) {
+          Debug("logstats", "Bad columnar segment.");
+          return 1;
         }
+        memcpy(p, field, field_len);
+        p += field_len;
         break;
       }
     }
+    parse_log_entry((char *)entry, fieldlist, summary);
   }
 
   return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Parse a segment, LogBuffer or columnar, unless its entries are too old. A
+// LogBuffer is parsed in place, and must be writable.
+int
+parse_segment(char *data, uint32_t len, unsigned max_age)
+{
+  bool columnar = LogColumnarSegment::is_columnar(data);
+  LogBufferHeader *header = (LogBufferHeader *)data;
+  LogColumnarSegment segment;
+
+  if (columnar) {
+    if (!segment.init(data, len)) {
+      Debug("logstats", "Bad columnar segment.");
+      return 1;
+    }
+    header = segment.buffer_header();
+  }
+
+  // Possibly skip too old entries (the entire buffer is skipped)
+  if (header->high_timestamp < max_age) {
+    Debug("logstats", "Skipping old buffer (age=%d, max=%d)", header->high_timestamp, max_age);
+    return 0;
+  }
+  if ((columnar ? parse_columnar_segment(segment, cl.summary != 0) : parse_log_buff(header, cl.summary != 0)) != 0) {
+    Debug("logstats", "Failed to parse log buffer.");
+    return 1;
+  }
+  return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Process a file (FD)
 int
@@ -1622,7 +1726,7 @@ process_file(int in_fd, off_t offset, unsigned max_age)
           return 0;
         }
         // ensure that this is a valid logbuffer header
-        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie)) {
+        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie || LogColumnarSegment::is_columnar(header))) {
           offset = 0;
           break;
         }
@@ -1637,14 +1741,18 @@ process_file(int in_fd, off_t offset, unsigned max_age)
         return 0;
 
       // ensure that this is a valid logbuffer header
-      if (header->cookie != LOG_SEGMENT_COOKIE) {
+      if (header->cookie != LOG_SEGMENT_COOKIE && !LogColumnarSegment::is_columnar(header)) {
         Debug("logstats", "Invalid segment cookie (expected %d, got %d)", LOG_SEGMENT_COOKIE, header->cookie);
         return 1;
       }
     }
 
-    Debug("logstats", "LogBuffer version %d, current = %d", header->version, LOG_SEGMENT_VERSION);
-    if (header->version != LOG_SEGMENT_VERSION)
+    // A columnar segment has the byte count where a LogBuffer does, and is always bigger than a LogBufferHeader, so
+    // it is read the same way.
+    bool columnar = LogColumnarSegment::is_columnar(header);
+    Debug("logstats", "%s version %d, current = %d", columnar ? "Columnar segment" : "LogBuffer", header->version,
+          columnar ? LOG_COLUMNAR_VERSION : LOG_SEGMENT_VERSION);
+    if (header->version != (columnar ? LOG_COLUMNAR_VERSION : LOG_SEGMENT_VERSION))
       return 1;
 
     // read the rest of the header
@@ -1695,17 +1803,46 @@ process_file(int in_fd, off_t offset, unsigned max_age)
       }
     } while (total_read < buffer_bytes);
 
-    // Possibly skip too old entries (the entire buffer is skipped)
-    if (header->high_timestamp >= max_age) {
-      if (parse_log_buff(header, cl.summary != 0) != 0) {
-        Debug("logstats", "Failed to parse log buffer.");
+    if (parse_segment(buffer, header->byte_count, max_age) != 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Like process_file, for a log file which is not being followed, mapped
+// into memory rather than read. Returns -1 if it can not be mapped.
+int
+process_mapped_file(int in_fd, unsigned max_age)
+{
+  static char buffer[MAX_LOGBUFFER_SIZE];
+  LogSegmentReader reader;
+  const char *segment;
+  uint32_t len;
+
+  if (!reader.open(in_fd)) {
+    return -1;
+  }
+  while ((segment = reader.next(&len))) {
+    // Columnar segments are decoded from the mapping, LogBuffers are parsed in place, so they are copied.
+    if (!LogColumnarSegment::is_columnar(segment)) {
+      if (len > sizeof(buffer)) {
+        Debug("logstats", "Header byte count [%u] > expected [%zu]", len, sizeof(buffer));
         return 1;
       }
-    } else {
-      Debug("logstats", "Skipping old buffer (age=%d, max=%d)", header->high_timestamp, max_age);
+      memcpy(buffer, segment, len);
+      segment = buffer;
+    }
+    if (parse_segment((char *)segment, len, max_age) != 0) {
+      return 1;
     }
   }
-
+  if (reader.error()) {
+    Debug("logstats", "Invalid segment cookie.");
+    return 1;
+  }
   return 0;
 }
 
@@ -2486,7 +2623,11 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
       sleep(cl.tail);
     }
 
-    if (process_file(main_fd, 0, max_age) != 0) {
+    int rc = cl.tail > 0 ? -1 : process_mapped_file(main_fd, max_age);
+    if (rc < 0) {
+      rc = process_file(main_fd, 0, max_age);
+    }
+    if (rc != 0) {
       close(main_fd);
       exit_status.set(EXIT_CRITICAL, " can't parse log file ");
       exit_status.append(cl.log_file);
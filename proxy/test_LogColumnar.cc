@@ -0,0 +1,274 @@
+/** @file
+
+  Sizes and decoding times of columnar log segments, for LogBuffers of the
+  sizes traffic_server flushes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "ts/ink_platform.h"
+#include "ts/ink_hrtime.h"
+#include "ts/I_Layout.h"
+
+#define PROGRAM_NAME "test_LogColumnar"
+
+#include "LogStandalone.cc"
+
+#include "LogBuffer.h"
+#include "LogColumnar.h"
+#include "Log.h"
+
+// The LogBuffers of the sample log in proxy/tests hold one to seven entries each, where the ones traffic_server flushes
+// are proxy.config.log.log_buffer_size, 9216 bytes by default, and up to 64KB. Its entries are packed into buffers of
+// those sizes, in turn and with rising timestamps. A 64KB buffer then has each of them five or six times, which flatters
+// its dictionaries, so its size is a lower bound.
+static const int buffer_sizes[] = {9216, 65536};
+static const int NBUFFERS = 1000;
+static const int MAX_SAMPLE_BYTES = 65536;
+
+// The fields traffic_logstats reads.
+static const char *logstats_symbols[] = {"ttms", "crc", "pssc", "psql", "cqhm", "cquc", "phr", "psct"};
+
+static char *sample_header; // LogBufferHeader and strings of the first buffer of the sample
+static int sample_header_bytes;
+static char *sample_entries; // the entries of the sample, one after the other
+static int sample_entries_bytes;
+
+static void
+read_sample(const char *path)
+{
+  LogSegmentReader reader;
+  const char *segment;
+  uint32_t len;
+  int fd = open(path, O_RDONLY);
+
+  ink_release_assert(fd >= 0 && reader.open(fd));
+  sample_entries = (char *)ats_malloc(MAX_SAMPLE_BYTES);
+  while ((segment = reader.next(&len))) {
+    LogBufferHeader *header = (LogBufferHeader *)segment;
+    ink_release_assert(!LogColumnarSegment::is_columnar(segment));
+
+    if (sample_header == NULL) {
+      sample_header_bytes = header->data_offset;
+      sample_header = (char *)ats_malloc(sample_header_bytes);
+      memcpy(sample_header, segment, sample_header_bytes);
+    }
+
+    LogBufferIterator iter(header);
+    LogEntryHeader *entry;
+    while ((entry = iter.next())) {
+      ink_release_assert(sample_entries_bytes + entry->entry_len <= MAX_SAMPLE_BYTES);
+      memcpy(sample_entries + sample_entries_bytes, entry, entry->entry_len);
+      sample_entries_bytes += entry->entry_len;
+    }
+  }
+  ink_release_assert(!reader.error() && sample_header != NULL);
+  close(fd);
+}
+
+// Fill a LogBuffer of @a size bytes with the sample entries, from @a *next on, returns its byte count.
+static int
+make_buffer(char *buf, int size, int *next, int64_t *timestamp)
+{
+  LogBufferHeader *header = (LogBufferHeader *)buf;
+  int bytes = sample_header_bytes;
+
+  memcpy(buf, sample_header, sample_header_bytes);
+  header->entry_count = 0;
+  header->low_timestamp = *timestamp;
+  while (true) {
+    LogEntryHeader *entry = (LogEntryHeader *)(sample_entries + *next);
+
+    if (bytes + (int)entry->entry_len > size) {
+      break;
+    }
+    memcpy(buf + bytes, entry, entry->entry_len);
+    entry = (LogEntryHeader *)(buf + bytes);
+    entry->timestamp = *timestamp;
+    entry->timestamp_usec = (*next * 7919) % 1000000;
+    *(int64_t *)(entry + 1) = *timestamp; // cqtq, the first field of the sample format
+    bytes += entry->entry_len;
+    ++header->entry_count;
+    *timestamp += header->entry_count % 4 == 0; // some thousands of requests a second
+    *next += entry->entry_len;
+    if (*next == sample_entries_bytes) {
+      *next = 0;
+    }
+  }
+  header->high_timestamp = *timestamp;
+  header->byte_count = bytes;
+  return bytes;
+}
+
+static void
+measure(int size, LogColumnarCompression compression, const char *name)
+{
+  char *buffers = (char *)ats_malloc((size_t)NBUFFERS * size);
+  char *segments = (char *)ats_malloc((size_t)NBUFFERS * size);
+  char *rebuilt = (char *)ats_malloc(size);
+  int *segment_bytes = (int *)ats_malloc(NBUFFERS * sizeof(int));
+  int64_t timestamp = 1400000000;
+  int64_t buffer_total = 0, segment_total = 0, entries = 0;
+  int next = 0;
+  ink_hrtime start, encode_time, rebuild_time, columns_time;
+
+  for (int i = 0; i < NBUFFERS; i++) {
+    buffer_total += make_buffer(buffers + (size_t)i * size, size, &next, &timestamp);
+    entries += ((LogBufferHeader *)(buffers + (size_t)i * size))->entry_count;
+  }
+
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < NBUFFERS; i++) {
+    segment_bytes[i] = LogColumnarSegment::encode((LogBufferHeader *)(buffers + (size_t)i * size), NULL, compression,
+                                                  segments + (size_t)i * size, size);
+    ink_release_assert(segment_bytes[i] > 0);
+    segment_total += segment_bytes[i];
+  }
+  encode_time = ink_get_hrtime_internal() - start;
+
+  // Reading the whole entries back, as traffic_logcat does, gives the buffers byte for byte.
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < NBUFFERS; i++) {
+    LogColumnarSegment segment;
+    LogBufferHeader *header = (LogBufferHeader *)(buffers + (size_t)i * size);
+
+    ink_release_assert(segment.init(segments + (size_t)i * size, segment_bytes[i]));
+    ink_release_assert(segment.to_buffer(rebuilt, size) == (int)header->byte_count);
+    ink_release_assert(memcmp(rebuilt, header, header->byte_count) == 0);
+  }
+  rebuild_time = ink_get_hrtime_internal() - start;
+
+  // traffic_logstats only decodes the columns of the fields it reads.
+  start = ink_get_hrtime_internal();
+  for (int i = 0; i < NBUFFERS; i++) {
+    LogColumnarSegment segment;
+
+    ink_release_assert(segment.init(segments + (size_t)i * size, segment_bytes[i]));
+    for (unsigned j = 0; j < countof(logstats_symbols); j++) {
+      LogColumn column;
+      int col = segment.find_column(logstats_symbols[j]);
+
+      ink_release_assert(col >= 0 && segment.decode_column(col, &column));
+    }
+  }
+  columns_time = ink_get_hrtime_internal() - start;
+
+  printf("%d byte buffers, %" PRId64 " entries each, %s: %" PRId64 "%% of the size, encode %" PRId64 " ns, whole entries %" PRId64
+         " ns, logstats fields %" PRId64 " ns an entry\n",
+         size, entries / NBUFFERS, name, segment_total * 100 / buffer_total, encode_time / entries, rebuild_time / entries,
+         columns_time / entries);
+
+  ats_free(segment_bytes);
+  ats_free(rebuilt);
+  ats_free(segments);
+  ats_free(buffers);
+}
+
+// A segment cut short, or with counts and sizes which do not add up, must be turned down by init, and whatever init
+// lets through from random damage must decode without reading or writing out of bounds.
+static void
+corrupt_test()
+{
+  const int size = buffer_sizes[0];
+  char *buffer = (char *)ats_malloc(size);
+  char *good = (char *)ats_malloc(size);
+  char *bad = (char *)ats_malloc(size);
+  char *rebuilt = (char *)ats_malloc(size);
+  int64_t timestamp = 1400000000;
+  int next = 0;
+  LogColumnarSegment segment;
+
+  make_buffer(buffer, size, &next, &timestamp);
+  int bytes = LogColumnarSegment::encode((LogBufferHeader *)buffer, NULL, LOG_COLUMNAR_COMPRESS_FASTLZ, good, size);
+  ink_release_assert(bytes > 0 && segment.init(good, bytes));
+
+  LogColumnarHeader *header = (LogColumnarHeader *)bad;
+  LogColumnDesc *columns = (LogColumnDesc *)(bad + sizeof(LogColumnarHeader));
+  LogBufferHeader *buffer_header = (LogBufferHeader *)(bad + ((char *)segment.buffer_header() - good));
+
+  memcpy(bad, good, bytes);
+  ink_release_assert(!segment.init(bad, bytes - 1)); // truncated
+
+  // A header which claims more than the buffer it came from, with the data offset of the LogBufferHeader to match.
+  memcpy(bad, good, bytes);
+  header->header_bytes = header->buffer_bytes + 1;
+  buffer_header->data_offset = header->header_bytes;
+  ink_release_assert(!segment.init(bad, bytes));
+
+  memcpy(bad, good, bytes);
+  header->entry_count = 0x80000000;
+  ink_release_assert(!segment.init(bad, bytes));
+
+  memcpy(bad, good, bytes);
+  header->entry_count = header->buffer_bytes;
+  ink_release_assert(!segment.init(bad, bytes));
+
+  memcpy(bad, good, bytes);
+  columns[LOG_COLUMN_FIRST_FIELD].raw_bytes = 0xffffffff;
+  ink_release_assert(!segment.init(bad, bytes));
+
+  memcpy(bad, good, bytes);
+  columns[LOG_COLUMN_FIRST_FIELD].raw_bytes = header->entry_count - 1;
+  ink_release_assert(!segment.init(bad, bytes));
+
+  unsigned int seed = 1;
+  for (int i = 0; i < 10000; i++) {
+    memcpy(bad, good, bytes);
+    for (int j = 0; j < 4; j++) {
+      bad[rand_r(&seed) % bytes] ^= 1 << (rand_r(&seed) % 8);
+    }
+    if (segment.init(bad, bytes)) {
+      segment.to_buffer(rebuilt, size);
+      for (int col = 0; col < segment.column_count(); col++) {
+        LogColumn column;
+        segment.decode_column(col, &column);
+      }
+    }
+  }
+
+  ats_free(rebuilt);
+  ats_free(bad);
+  ats_free(good);
+  ats_free(buffer);
+  printf("corrupt segments turned down\n");
+}
+
+int
+main(int /* argc ATS_UNUSED */, const char * /* argv ATS_UNUSED */ [])
+{
+  const char *srcdir = getenv("srcdir");
+  char path[PATH_NAME_MAX];
+
+  Layout::create();
+  init_log_standalone_basic(PROGRAM_NAME);
+  Log::init(Log::NO_REMOTE_MANAGEMENT | Log::LOGCAT);
+
+  snprintf(path, sizeof(path), "%s/tests/logstats.blog", srcdir ? srcdir : ".");
+  read_sample(path);
+
+  corrupt_test();
+  for (unsigned i = 0; i < countof(buffer_sizes); i++) {
+    measure(buffer_sizes[i], LOG_COLUMNAR_COMPRESS_FASTLZ, "fastlz");
+#if TS_HAS_LIBZ
+    measure(buffer_sizes[i], LOG_COLUMNAR_COMPRESS_LIBZ, "libz");
+#endif
+  }
+  printf("test_LogColumnar PASSED\n");
+  return 0;
+}